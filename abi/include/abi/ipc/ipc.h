@@ -52,6 +52,12 @@ enum {
 	/** Maximum active async calls per phone */
 	IPC_MAX_ASYNC_CALLS = 64,
 
+	/**
+	 * Maximum number of calls made by SYS_IPC_CALL_ASYNC_BATCH or received
+	 * by SYS_IPC_WAIT_BATCH.
+	 */
+	IPC_BATCH_MAX = 64,
+
 	/**
 	 * Maximum buffer size allowed for IPC_M_DATA_WRITE and
 	 * IPC_M_DATA_READ requests.
@@ -122,6 +128,16 @@ typedef struct {
 	cap_call_handle_t cap_handle;
 } ipc_data_t;
 
+/** Call made by SYS_IPC_CALL_ASYNC_BATCH */
+typedef struct {
+	/** Phone to make the call on */
+	cap_phone_handle_t phone;
+	/** User-defined label associated with the answer */
+	sysarg_t label;
+	/** Interface, method and payload arguments */
+	sysarg_t args[IPC_CALL_LEN];
+} ipc_batch_call_t;
+
 /* Functions for manipulating calling data */
 
 static inline void ipc_set_retval(ipc_data_t *data, errno_t retval)
@@ -83,6 +83,18 @@ typedef struct {
 	uint64_t free;     /**< Free physical memory (bytes) */
 } stats_physmem_t;
 
+/** Physical frame allocator statistics
+ *
+ */
+typedef struct {
+	uint64_t cache_hits;       /**< Allocations served by per-CPU caches */
+	uint64_t cache_misses;     /**< Cacheable allocations not served */
+	uint64_t cache_refills;    /**< Batches moved from zones to caches */
+	uint64_t cache_drains;     /**< Batches moved from caches to zones */
+	uint64_t zones_contended;  /**< Refills and drains waiting for zones */
+	uint64_t cached;           /**< Memory held in per-CPU caches (bytes) */
+} stats_frames_t;
+
 /** IPC statistics
  *
  * Associated with a task.
@@ -95,6 +107,10 @@ typedef struct {
 	uint64_t answer_received;     /**< IPC answers received */
 	uint64_t irq_notif_received;  /**< IPC IRQ notifications */
 	uint64_t forwarded;           /**< IPC messages forwarded */
+	uint64_t queued;              /**< Calls waiting to be received */
+	uint64_t queued_max;          /**< Maximum number of waiting calls */
+	uint64_t queued_cycles;       /**< Cycles calls spent waiting */
+	uint64_t dispatched;          /**< Received calls not yet answered */
 } stats_ipc_t;
 
 /** Statistics about a single task
@@ -105,6 +121,8 @@ typedef struct {
 	char name[TASK_NAME_BUFLEN];  /**< Task name (in kernel) */
 	size_t virtmem;               /**< Size of VAS (bytes) */
 	size_t resmem;                /**< Size of resident (used) memory (bytes) */
+	size_t largemem;              /**< Memory mapped by large pages (bytes) */
+	uint64_t large_splits;        /**< Large pages split into small pages */
 	size_t threads;               /**< Number of threads */
 	uint64_t ucycles;             /**< Number of CPU cycles in user space */
 	uint64_t kcycles;             /**< Number of CPU cycles in kernel */
@@ -0,0 +1,259 @@
+/*
+ * Copyright (c) 2026 The HelenOS Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+/** @addtogroup kernel_generic_adt
+ * @{
+ */
+
+/** @file Pairing heap.
+ *
+ * A self-adjusting heap with O(1) insertion and O(log n) amortized removal
+ * of the minimum or of an arbitrary node. Nodes are embedded in the items,
+ * so the heap never allocates memory.
+ *
+ * Children of a node form a doubly-linked list. The leftmost child points
+ * back to its parent, which makes it possible to cut out any node.
+ */
+
+#include <adt/pheap.h>
+#include <assert.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/** Meld two heaps.
+ *
+ * @param pheap Heap providing the compare operation
+ * @param a Root of the first heap or @c NULL
+ * @param b Root of the second heap or @c NULL
+ * @return Root of the resulting heap
+ */
+static phlink_t *pheap_meld(pheap_t *pheap, phlink_t *a, phlink_t *b)
+{
+	if (a == NULL)
+		return b;
+	if (b == NULL)
+		return a;
+
+	if (pheap->cmp(b, a) < 0) {
+		phlink_t *t = a;
+		a = b;
+		b = t;
+	}
+
+	/* Make b the leftmost child of a */
+	b->next = a->child;
+	if (a->child != NULL)
+		a->child->prev = b;
+	b->prev = a;
+	a->child = b;
+	a->next = NULL;
+
+	return a;
+}
+
+/** Meld a list of siblings into one heap.
+ *
+ * Uses the standard two-pass scheme: siblings are first melded in pairs
+ * from left to right, then the pairs are melded from right to left.
+ *
+ * @param pheap Heap providing the compare operation
+ * @param first Leftmost sibling or @c NULL
+ * @return Root of the resulting heap
+ */
+static phlink_t *pheap_merge_pairs(pheap_t *pheap, phlink_t *first)
+{
+	phlink_t *pairs = NULL;
+
+	while (first != NULL) {
+		phlink_t *a = first;
+		phlink_t *b = a->next;
+
+		first = (b != NULL) ? b->next : NULL;
+
+		a->next = a->prev = NULL;
+		if (b != NULL) {
+			b->next = b->prev = NULL;
+			a = pheap_meld(pheap, a, b);
+		}
+
+		/* Stack the melded pair */
+		a->next = pairs;
+		pairs = a;
+	}
+
+	phlink_t *root = NULL;
+
+	while (pairs != NULL) {
+		phlink_t *next = pairs->next;
+
+		pairs->next = NULL;
+		root = pheap_meld(pheap, root, pairs);
+		pairs = next;
+	}
+
+	return root;
+}
+
+/** Set a new root of the heap.
+ *
+ * @param pheap Pairing heap
+ * @param root New root or @c NULL
+ */
+static void pheap_set_root(pheap_t *pheap, phlink_t *root)
+{
+	pheap->root = root;
+	if (root != NULL) {
+		root->next = NULL;
+		root->prev = root;
+	}
+}
+
+/** Initialize pairing heap.
+ *
+ * @param pheap Pairing heap
+ * @param cmp Compare operation, returns <0, 0, >0 if the first node is less
+ *            than, equal to or greater than the second
+ */
+void pheap_initialize(pheap_t *pheap, phcmp_t cmp)
+{
+	pheap->root = NULL;
+	pheap->count = 0;
+	pheap->cmp = cmp;
+}
+
+/** Initialize pairing heap node.
+ *
+ * @param phlink Pairing heap node
+ */
+void phlink_initialize(phlink_t *phlink)
+{
+	phlink->child = NULL;
+	phlink->next = NULL;
+	phlink->prev = NULL;
+}
+
+/** Insert node into pairing heap.
+ *
+ * @param pheap Pairing heap
+ * @param phlink Node, which must not be in any heap
+ */
+void pheap_insert(pheap_t *pheap, phlink_t *phlink)
+{
+	assert(!phlink_used(phlink));
+
+	phlink->child = NULL;
+	phlink->next = NULL;
+	pheap_set_root(pheap, pheap_meld(pheap, pheap->root, phlink));
+	pheap->count++;
+}
+
+/** Remove node from pairing heap.
+ *
+ * @param pheap Pairing heap
+ * @param phlink Node, which must be in @a pheap
+ */
+void pheap_remove(pheap_t *pheap, phlink_t *phlink)
+{
+	assert(phlink_used(phlink));
+
+	phlink_t *sub = pheap_merge_pairs(pheap, phlink->child);
+
+	if (phlink == pheap->root) {
+		pheap_set_root(pheap, sub);
+	} else {
+		/* Cut the node out of its list of siblings */
+		if (phlink->prev->child == phlink)
+			phlink->prev->child = phlink->next;
+		else
+			phlink->prev->next = phlink->next;
+		if (phlink->next != NULL)
+			phlink->next->prev = phlink->prev;
+
+		pheap_set_root(pheap, pheap_meld(pheap, pheap->root, sub));
+	}
+
+	phlink_initialize(phlink);
+	pheap->count--;
+}
+
+/** Return true if node is in a pairing heap.
+ *
+ * @param phlink Pairing heap node
+ * @return @c true if node is in a heap
+ */
+bool phlink_used(phlink_t *phlink)
+{
+	return phlink->prev != NULL;
+}
+
+/** Return true if pairing heap is empty.
+ *
+ * @param pheap Pairing heap
+ * @return @c true if @a pheap is empty
+ */
+bool pheap_empty(pheap_t *pheap)
+{
+	return pheap->root == NULL;
+}
+
+/** Return the number of nodes in pairing heap.
+ *
+ * @param pheap Pairing heap
+ * @return Number of nodes
+ */
+unsigned long pheap_count(pheap_t *pheap)
+{
+	return pheap->count;
+}
+
+/** Return the minimum node of pairing heap.
+ *
+ * @param pheap Pairing heap
+ * @return Minimum node or @c NULL if @a pheap is empty
+ */
+phlink_t *pheap_first(pheap_t *pheap)
+{
+	return pheap->root;
+}
+
+/** Remove and return the minimum node of pairing heap.
+ *
+ * @param pheap Pairing heap
+ * @return Minimum node or @c NULL if @a pheap is empty
+ */
+phlink_t *pheap_pop(pheap_t *pheap)
+{
+	phlink_t *root = pheap->root;
+
+	if (root != NULL)
+		pheap_remove(pheap, root);
+
+	return root;
+}
+
+/** @}
+ */
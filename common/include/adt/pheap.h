@@ -0,0 +1,58 @@
+/*
+ * Copyright (c) 2026 The HelenOS Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+/** @addtogroup kernel_generic_adt
+ * @{
+ */
+/** @file
+ */
+
+#ifndef _LIBC_PHEAP_H_
+#define _LIBC_PHEAP_H_
+
+#include <member.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <types/adt/pheap.h>
+
+#define pheap_get_instance(phlink, type, member) \
+	member_to_inst(phlink, type, member)
+
+extern void pheap_initialize(pheap_t *, phcmp_t);
+extern void phlink_initialize(phlink_t *);
+extern void pheap_insert(pheap_t *, phlink_t *);
+extern void pheap_remove(pheap_t *, phlink_t *);
+extern bool phlink_used(phlink_t *);
+extern bool pheap_empty(pheap_t *);
+extern unsigned long pheap_count(pheap_t *);
+extern phlink_t *pheap_first(pheap_t *);
+extern phlink_t *pheap_pop(pheap_t *);
+
+#endif
+
+/** @}
+ */
@@ -154,6 +154,20 @@
 #define PTE_EXECUTABLE_ARCH(p) \
 	((p)->no_execute == 0)
 
+/*
+ * Large pages. A PTL2 entry with the PS bit (bit 7, which is the PAT bit in
+ * the last-level PTEs) set maps a whole 2 MiB page instead of pointing to a
+ * PTL3 table.
+ */
+#define LARGE_PAGE_SIZE_ARCH  (1 << 21)
+
+#define GET_PTL3_LARGE_ARCH(ptl2, i) \
+	(((pte_t *) (ptl2))[(i)].pat != 0)
+#define SET_PTL3_LARGE_ARCH(ptl2, i) \
+	(((pte_t *) (ptl2))[(i)].pat = 1)
+#define CLEAR_PTL3_LARGE_ARCH(ptl2, i) \
+	(((pte_t *) (ptl2))[(i)].pat = 0)
+
 #ifndef __ASSEMBLER__
 
 #include <arch/interrupt.h>
@@ -139,6 +139,17 @@
 #define PTE_WRITABLE(p)    PTE_WRITABLE_ARCH((p))
 #define PTE_EXECUTABLE(p)  PTE_EXECUTABLE_ARCH((p))
 
+/*
+ * Macros for large pages mapped directly by PTL2 entries, if the architecture
+ * supports them.
+ *
+ */
+#ifdef LARGE_PAGE_SIZE_ARCH
+#define GET_PTL3_LARGE(ptl2, i)    GET_PTL3_LARGE_ARCH(ptl2, i)
+#define SET_PTL3_LARGE(ptl2, i)    SET_PTL3_LARGE_ARCH(ptl2, i)
+#define CLEAR_PTL3_LARGE(ptl2, i)  CLEAR_PTL3_LARGE_ARCH(ptl2, i)
+#endif
+
 extern const as_operations_t as_pt_operations;
 extern const page_mapping_operations_t pt_mapping_operations;
 
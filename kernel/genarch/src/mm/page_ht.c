@@ -91,7 +91,9 @@ const hash_table_ops_t ht_ops = {
 /** Page mapping operations for page hash table architectures. */
 const page_mapping_operations_t ht_mapping_operations = {
 	.mapping_insert = ht_mapping_insert,
+	.mapping_insert_large = NULL,
 	.mapping_remove = ht_mapping_remove,
+	.mapping_split = NULL,
 	.mapping_find = ht_mapping_find,
 	.mapping_update = ht_mapping_update,
 	.mapping_make_global = ht_mapping_make_global
@@ -52,37 +52,48 @@
 #include <bitops.h>
 
 static void pt_mapping_insert(as_t *, uintptr_t, uintptr_t, unsigned int);
+#ifdef LARGE_PAGE_SIZE_ARCH
+static bool pt_mapping_insert_large(as_t *, uintptr_t, uintptr_t,
+    unsigned int);
+#endif
 static void pt_mapping_remove(as_t *, uintptr_t);
+#ifdef LARGE_PAGE_SIZE_ARCH
+static void pt_mapping_split(as_t *, uintptr_t);
+#endif
 static bool pt_mapping_find(as_t *, uintptr_t, bool, pte_t *pte);
 static void pt_mapping_update(as_t *, uintptr_t, bool, pte_t *pte);
 static void pt_mapping_make_global(uintptr_t, size_t);
 
 const page_mapping_operations_t pt_mapping_operations = {
 	.mapping_insert = pt_mapping_insert,
+#ifdef LARGE_PAGE_SIZE_ARCH
+	.mapping_insert_large = pt_mapping_insert_large,
+#else
+	.mapping_insert_large = NULL,
+#endif
 	.mapping_remove = pt_mapping_remove,
+#ifdef LARGE_PAGE_SIZE_ARCH
+	.mapping_split = pt_mapping_split,
+#else
+	.mapping_split = NULL,
+#endif
 	.mapping_find = pt_mapping_find,
 	.mapping_update = pt_mapping_update,
 	.mapping_make_global = pt_mapping_make_global
 };
 
-/** Map page to frame using hierarchical page tables.
- *
- * Map virtual address page to physical address frame
- * using flags.
+/** Get PTL2 for a page, allocating any missing upper-level tables.
  *
  * @param as    Address space to wich page belongs.
- * @param page  Virtual address of the page to be mapped.
- * @param frame Physical address of memory frame to which the mapping is done.
- * @param flags Flags to be used for mapping.
+ * @param page  Virtual address of the page.
+ *
+ * @return PTL2 covering page.
  *
  */
-void pt_mapping_insert(as_t *as, uintptr_t page, uintptr_t frame,
-    unsigned int flags)
+static pte_t *pt_ptl2_get(as_t *as, uintptr_t page)
 {
 	pte_t *ptl0 = (pte_t *) PA2KA((uintptr_t) as->genarch.page_table);
 
-	assert(page_table_locked(as));
-
 	if (GET_PTL1_FLAGS(ptl0, PTL0_INDEX(page)) & PAGE_NOT_PRESENT) {
 		pte_t *newpt = (pte_t *)
 		    PA2KA(frame_alloc(PTL1_FRAMES, FRAME_LOWMEM, PTL1_SIZE - 1));
@@ -117,7 +128,31 @@ void pt_mapping_insert(as_t *as, uintptr_t page, uintptr_t frame,
 		SET_PTL2_PRESENT(ptl1, PTL1_INDEX(page));
 	}
 
-	pte_t *ptl2 = (pte_t *) PA2KA(GET_PTL2_ADDRESS(ptl1, PTL1_INDEX(page)));
+	return (pte_t *) PA2KA(GET_PTL2_ADDRESS(ptl1, PTL1_INDEX(page)));
+}
+
+/** Map page to frame using hierarchical page tables.
+ *
+ * Map virtual address page to physical address frame
+ * using flags.
+ *
+ * @param as    Address space to wich page belongs.
+ * @param page  Virtual address of the page to be mapped.
+ * @param frame Physical address of memory frame to which the mapping is done.
+ * @param flags Flags to be used for mapping.
+ *
+ */
+void pt_mapping_insert(as_t *as, uintptr_t page, uintptr_t frame,
+    unsigned int flags)
+{
+	assert(page_table_locked(as));
+
+	pte_t *ptl2 = pt_ptl2_get(as, page);
+
+#ifdef LARGE_PAGE_SIZE_ARCH
+	assert((GET_PTL3_FLAGS(ptl2, PTL2_INDEX(page)) & PAGE_NOT_PRESENT) ||
+	    !GET_PTL3_LARGE(ptl2, PTL2_INDEX(page)));
+#endif
 
 	if (GET_PTL3_FLAGS(ptl2, PTL2_INDEX(page)) & PAGE_NOT_PRESENT) {
 		pte_t *newpt = (pte_t *)
@@ -145,6 +180,89 @@ void pt_mapping_insert(as_t *as, uintptr_t page, uintptr_t frame,
 	SET_FRAME_PRESENT(ptl3, PTL3_INDEX(page));
 }
 
+#ifdef LARGE_PAGE_SIZE_ARCH
+
+/** Map a large page using a single PTL2 entry.
+ *
+ * @param as    Address space to wich page belongs.
+ * @param page  Virtual address of the large page to be mapped.
+ * @param frame Physical address of the first frame of the large page.
+ * @param flags Flags to be used for mapping.
+ *
+ * @return True on success, false if a part of the large page is already
+ *         mapped using a PTL3 table.
+ *
+ */
+bool pt_mapping_insert_large(as_t *as, uintptr_t page, uintptr_t frame,
+    unsigned int flags)
+{
+	static_assert(PTL3_ENTRIES * PAGE_SIZE == LARGE_PAGE_SIZE_ARCH, "");
+
+	assert(page_table_locked(as));
+
+	pte_t *ptl2 = pt_ptl2_get(as, page);
+
+	if (!(GET_PTL3_FLAGS(ptl2, PTL2_INDEX(page)) & PAGE_NOT_PRESENT))
+		return false;
+
+	SET_PTL3_ADDRESS(ptl2, PTL2_INDEX(page), frame);
+	SET_PTL3_FLAGS(ptl2, PTL2_INDEX(page), flags | PAGE_NOT_PRESENT);
+	SET_PTL3_LARGE(ptl2, PTL2_INDEX(page));
+	/*
+	 * Make the new mapping visible only after it is fully initialized.
+	 */
+	write_barrier();
+	SET_PTL3_PRESENT(ptl2, PTL2_INDEX(page));
+
+	atomic_inc(&as->large_pages);
+	return true;
+}
+
+/** Split a large page into a PTL3 table mapping the same frames.
+ *
+ * The translations do not change, so no TLB shootdown is needed on behalf of
+ * the split itself.
+ *
+ * @param as   Address space to wich page belongs.
+ * @param ptl2 PTL2 containing the large page.
+ * @param page Virtual address within the large page.
+ *
+ */
+static void pt_large_split(as_t *as, pte_t *ptl2, uintptr_t page)
+{
+	size_t idx = PTL2_INDEX(page);
+	uintptr_t frame = (uintptr_t) GET_PTL3_ADDRESS(ptl2, idx);
+	unsigned int flags = GET_PTL3_FLAGS(ptl2, idx);
+
+	uintptr_t newframe = frame_alloc(PTL3_FRAMES, FRAME_LOWMEM,
+	    PTL3_SIZE - 1);
+	pte_t *newpt = (pte_t *) PA2KA(newframe);
+	memsetb(newpt, PTL3_SIZE, 0);
+
+	for (unsigned int i = 0; i < PTL3_ENTRIES; i++) {
+		SET_FRAME_ADDRESS(newpt, i, frame + FRAMES2SIZE(i));
+		SET_FRAME_FLAGS(newpt, i, flags);
+	}
+
+	/*
+	 * Compose the new PTL2 entry aside so that a concurrent hardware page
+	 * table walk sees either the large page or the complete PTL3.
+	 */
+	pte_t entry;
+	memsetb(&entry, sizeof(entry), 0);
+	SET_PTL3_ADDRESS(&entry, 0, newframe);
+	SET_PTL3_FLAGS(&entry, 0, PAGE_USER | PAGE_EXEC | PAGE_CACHEABLE |
+	    PAGE_WRITE);
+
+	write_barrier();
+	ptl2[idx] = entry;
+
+	atomic_dec(&as->large_pages);
+	atomic_inc(&as->large_splits);
+}
+
+#endif /* LARGE_PAGE_SIZE_ARCH */
+
 /** Remove mapping of page from hierarchical page tables.
  *
  * Remove any mapping of page within address space as.
@@ -153,12 +271,19 @@ void pt_mapping_insert(as_t *as, uintptr_t page, uintptr_t frame,
  *
  * Empty page tables except PTL0 are freed.
  *
+ * A large page is removed as a whole when its last page is removed, so that
+ * its other pages can still be looked up until then. Large pages that are
+ * removed only partially must be split by pt_mapping_split() beforehand.
+ *
  * @param as   Address space to wich page belongs.
  * @param page Virtual address of the page to be demapped.
  *
  */
 void pt_mapping_remove(as_t *as, uintptr_t page)
 {
+	bool empty = true;
+	unsigned int i;
+
 	assert(page_table_locked(as));
 
 	/*
@@ -177,6 +302,22 @@ void pt_mapping_remove(as_t *as, uintptr_t page)
 	if (GET_PTL3_FLAGS(ptl2, PTL2_INDEX(page)) & PAGE_NOT_PRESENT)
 		return;
 
+#ifdef LARGE_PAGE_SIZE_ARCH
+	if (GET_PTL3_LARGE(ptl2, PTL2_INDEX(page))) {
+		if (PTL3_INDEX(page) != PTL3_ENTRIES - 1)
+			return;
+
+		/*
+		 * The last page of the large page is being removed, destroy
+		 * the whole PTL2 entry.
+		 */
+		SET_PTL3_FLAGS(ptl2, PTL2_INDEX(page), PAGE_NOT_PRESENT);
+		memsetb(&ptl2[PTL2_INDEX(page)], sizeof(pte_t), 0);
+		atomic_dec(&as->large_pages);
+		goto check_ptl2;
+	}
+#endif
+
 	pte_t *ptl3 = (pte_t *) PA2KA(GET_PTL3_ADDRESS(ptl2, PTL2_INDEX(page)));
 
 	/*
@@ -195,9 +336,6 @@ void pt_mapping_remove(as_t *as, uintptr_t page)
 	 */
 
 	/* Check PTL3 */
-	bool empty = true;
-
-	unsigned int i;
 	for (i = 0; i < PTL3_ENTRIES; i++) {
 		if (PTE_VALID(&ptl3[i])) {
 			empty = false;
@@ -232,6 +370,9 @@ void pt_mapping_remove(as_t *as, uintptr_t page)
 		return;
 	}
 
+#ifdef LARGE_PAGE_SIZE_ARCH
+check_ptl2:
+#endif
 	/* Check PTL2, empty is still true */
 #if (PTL2_ENTRIES != 0)
 	for (i = 0; i < PTL2_ENTRIES; i++) {
@@ -291,8 +432,21 @@ void pt_mapping_remove(as_t *as, uintptr_t page)
 #endif /* PTL1_ENTRIES != 0 */
 }
 
-static pte_t *pt_mapping_find_internal(as_t *as, uintptr_t page, bool nolock)
+/** Find the PTE mapping a page.
+ *
+ * @param as          Address space to which page belongs.
+ * @param page        Virtual page.
+ * @param nolock      True if the page tables need not be locked.
+ * @param[out] large  Set to true if the returned PTE is a PTL2 entry mapping
+ *                    a whole large page.
+ *
+ * @return PTE or NULL if there is no mapping.
+ */
+static pte_t *pt_mapping_find_internal(as_t *as, uintptr_t page, bool nolock,
+    bool *large)
 {
+	*large = false;
+
 	assert(nolock || page_table_locked(as));
 
 	pte_t *ptl0 = (pte_t *) PA2KA((uintptr_t) as->genarch.page_table);
@@ -316,6 +470,13 @@ static pte_t *pt_mapping_find_internal(as_t *as, uintptr_t page, bool nolock)
 	if (GET_PTL3_FLAGS(ptl2, PTL2_INDEX(page)) & PAGE_NOT_PRESENT)
 		return NULL;
 
+#ifdef LARGE_PAGE_SIZE_ARCH
+	if (GET_PTL3_LARGE(ptl2, PTL2_INDEX(page))) {
+		*large = true;
+		return &ptl2[PTL2_INDEX(page)];
+	}
+#endif
+
 #if (PTL2_ENTRIES != 0)
 	/*
 	 * Always read ptl3 only after we are sure it is present.
@@ -339,10 +500,25 @@ static pte_t *pt_mapping_find_internal(as_t *as, uintptr_t page, bool nolock)
  */
 bool pt_mapping_find(as_t *as, uintptr_t page, bool nolock, pte_t *pte)
 {
-	pte_t *t = pt_mapping_find_internal(as, page, nolock);
-	if (t)
-		*pte = *t;
-	return t != NULL;
+	bool large;
+	pte_t *t = pt_mapping_find_internal(as, page, nolock, &large);
+	if (!t)
+		return false;
+
+	*pte = *t;
+
+#ifdef LARGE_PAGE_SIZE_ARCH
+	if (large) {
+		/*
+		 * Present the part of the large page as an ordinary PTE.
+		 */
+		CLEAR_PTL3_LARGE(pte, 0);
+		SET_FRAME_ADDRESS(pte, 0, PTE_GET_FRAME(t) +
+		    FRAMES2SIZE(PTL3_INDEX(page)));
+	}
+#endif
+
+	return true;
 }
 
 /** Update mapping for virtual page in hierarchical page tables.
@@ -354,10 +530,24 @@ bool pt_mapping_find(as_t *as, uintptr_t page, bool nolock, pte_t *pte)
  */
 void pt_mapping_update(as_t *as, uintptr_t page, bool nolock, pte_t *pte)
 {
-	pte_t *t = pt_mapping_find_internal(as, page, nolock);
+	bool large;
+	pte_t *t = pt_mapping_find_internal(as, page, nolock, &large);
 	if (!t)
 		panic("Updating non-existent PTE");
 
+#ifdef LARGE_PAGE_SIZE_ARCH
+	if (large) {
+		/*
+		 * The accessed and dirty bits are tracked per page, split the
+		 * large page so that they can be.
+		 */
+		assert(!nolock);
+		pte_t *ptl2 = t - PTL2_INDEX(page);
+		pt_large_split(as, ptl2, page);
+		t = pt_mapping_find_internal(as, page, nolock, &large);
+	}
+#endif
+
 	assert(PTE_VALID(t) == PTE_VALID(pte));
 	assert(PTE_PRESENT(t) == PTE_PRESENT(pte));
 	assert(PTE_GET_FRAME(t) == PTE_GET_FRAME(pte));
@@ -367,6 +557,33 @@ void pt_mapping_update(as_t *as, uintptr_t page, bool nolock, pte_t *pte)
 	*t = *pte;
 }
 
+#ifdef LARGE_PAGE_SIZE_ARCH
+
+/** Split the large page containing page unless page is its first page.
+ *
+ * This is done before only a part of a large page is removed. The page table
+ * for the split large page is allocated in a blocking manner, so the page
+ * tables must not be modified within a TLB shootdown sequence yet.
+ *
+ * @param as   Address space to which page belongs.
+ * @param page Virtual page.
+ *
+ */
+void pt_mapping_split(as_t *as, uintptr_t page)
+{
+	assert(page_table_locked(as));
+
+	if (IS_ALIGNED(page, LARGE_PAGE_SIZE_ARCH))
+		return;
+
+	bool large;
+	pte_t *t = pt_mapping_find_internal(as, page, false, &large);
+	if ((t != NULL) && large)
+		pt_large_split(as, t - PTL2_INDEX(page), page);
+}
+
+#endif /* LARGE_PAGE_SIZE_ARCH */
+
 /** Return the size of the region mapped by a single PTL0 entry.
  *
  * @return Size of the region mapped by a single PTL0 entry.
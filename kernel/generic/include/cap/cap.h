@@ -97,6 +97,7 @@ typedef struct kobject {
 
 /*
  * A cap_t may only be accessed under the protection of the cap_info_t lock.
+ * Lock-free readers use the capability table instead, see cap_table_node_t.
  */
 typedef struct cap {
 	cap_state_t state;
@@ -110,19 +111,54 @@ typedef struct cap {
 	/* Link to the task's capabilities of the same kobject type. */
 	link_t type_link;
 
-	ht_link_t caps_link;
-
 	/* The underlying kernel object. */
 	kobject_t *kobject;
 } cap_t;
 
+/** Number of handle bits resolved by one level of the capability table */
+#define CAP_TABLE_BITS	6
+#define CAP_TABLE_FANOUT	(1 << CAP_TABLE_BITS)
+#define CAP_TABLE_MASK	(CAP_TABLE_FANOUT - 1)
+
+/*
+ * The capability table is a radix tree indexed directly by the capability
+ * handle. It only grows and its nodes are freed together with the task, so
+ * kobject_get() can walk it without taking the cap_info_t lock.
+ *
+ * Leaf nodes (shift == 0) hold the capabilities and, for lock-free readers,
+ * the kernel objects of the published ones. Everything else in the table is
+ * modified only under the cap_info_t lock.
+ */
+typedef struct cap_table_node {
+	/** Number of handle bits below the bits indexing this node */
+	unsigned int shift;
+
+	union {
+		/** Children of an interior node */
+		_Atomic(struct cap_table_node *) child[CAP_TABLE_FANOUT];
+
+		struct {
+			/** Capabilities of a leaf node */
+			cap_t *cap[CAP_TABLE_FANOUT];
+			/** Kernel objects of published capabilities */
+			_Atomic(kobject_t *) kobject[CAP_TABLE_FANOUT];
+		};
+	};
+} cap_table_node_t;
+
 typedef struct cap_info {
 	mutex_t lock;
 
 	list_t type_list[KOBJECT_TYPE_MAX];
 
-	hash_table_t caps;
+	/** Root of the capability table */
+	_Atomic(cap_table_node_t *) table;
 	ra_arena_t *handles;
+
+	/** Reader epoch, its parity selects the counter in readers */
+	atomic_uint epoch;
+	/** Number of lock-free readers inside kobject_get() per epoch parity */
+	atomic_size_t readers[2];
 } cap_info_t;
 
 extern void caps_init(void);
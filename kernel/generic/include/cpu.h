@@ -41,6 +41,7 @@
 #include <arch/cpu.h>
 #include <arch/context.h>
 #include <adt/list.h>
+#include <adt/pheap.h>
 #include <arch.h>
 
 #define CPU                  (CURRENT->cpu)
@@ -89,11 +90,32 @@ typedef struct cpu {
 	tlb_shootdown_msg_t tlb_messages[TLB_MESSAGE_QUEUE_LEN];
 	size_t tlb_messages_count;
 
+	/**
+	 * ASID of the address space in use by this processor. Messages for
+	 * other address spaces are processed lazily. Protected by tlb_lock.
+	 */
+	asid_t tlb_asid;
+
+	/**
+	 * A TLB shootdown sender waits for this processor to process its
+	 * messages. Protected by tlb_lock.
+	 */
+	volatile bool tlb_sync;
+
 	atomic_size_t nrdy;
 	runq_t rq[RQ_COUNT];
 
+	/**
+	 * Low half of the cycle counter when this processor last started
+	 * running a thread. Cycle counters of different processors need not
+	 * agree, so other processors compare cycle stamps of threads which
+	 * ran here against this instead of their own counter.
+	 */
+	atomic_uint_fast32_t run_cycle;
+
 	IRQ_SPINLOCK_DECLARE(timeoutlock);
-	list_t timeout_active_list;
+	/** Active timeouts ordered by deadline. */
+	pheap_t timeout_heap;
 
 	/**
 	 * Processor cycle accounting.
@@ -43,6 +43,7 @@
 #include <typedefs.h>
 #include <mm/slab.h>
 #include <cap/cap.h>
+#include <ipc/xfer.h>
 
 struct answerbox;
 struct task;
@@ -95,7 +96,23 @@ typedef struct answerbox {
 	list_t connected_phones;
 	/** Received calls. */
 	list_t calls;
-	list_t dispatched_calls;  /* Should be hash table in the future */
+
+	/**
+	 * Received calls which have not been answered or forwarded yet.
+	 *
+	 * Calls are found through their capabilities and unlinked through
+	 * ab_link, so this list is walked only on cleanup and for debugging.
+	 */
+	list_t dispatched_calls;
+
+	/** Number of calls in the calls list. */
+	size_t queued;
+	/** Number of calls in the dispatched_calls list. */
+	size_t dispatched;
+	/** Maximum number of calls ever seen in the calls list. */
+	size_t queued_max;
+	/** Cycles spent by received calls in the calls list. */
+	uint64_t queued_cycles;
 
 	/** Answered calls. */
 	list_t answers;
@@ -119,6 +136,9 @@ typedef struct call {
 	/** Answerbox link. */
 	link_t ab_link;
 
+	/** Cycle counter value when the call entered the calls list. */
+	uint64_t queued_cycle;
+
 	unsigned int flags;
 
 	/** Protects the forget member. */
@@ -165,6 +185,9 @@ typedef struct call {
 
 	/** Buffer for IPC_M_DATA_WRITE and IPC_M_DATA_READ. */
 	uint8_t *buffer;
+
+	/** Pinned caller's buffer for IPC_M_DATA_WRITE and IPC_M_DATA_READ. */
+	ipc_xfer_t *xfer;
 } call_t;
 
 extern slab_cache_t *phone_cache;
@@ -0,0 +1,61 @@
+/*
+ * Copyright (c) 2026 The HelenOS Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+/** @addtogroup kernel_generic_ipc
+ * @{
+ */
+/** @file
+ */
+
+#ifndef KERN_IPC_XFER_H_
+#define KERN_IPC_XFER_H_
+
+#include <typedefs.h>
+#include <arch/mm/page.h>
+
+/** Smallest IPC data transfer that is done through pinned pages */
+#define IPC_XFER_THRESHOLD  (4 * PAGE_SIZE)
+
+/** User buffer pinned for the duration of an IPC data transfer */
+typedef struct {
+	/** Size of the buffer */
+	size_t size;
+	/** Number of pinned pages */
+	size_t pages;
+	/** Physical addresses of the pinned frames */
+	uintptr_t frames[];
+} ipc_xfer_t;
+
+extern ipc_xfer_t *ipc_xfer_pin(uspace_addr_t, size_t, bool);
+extern void ipc_xfer_unpin(ipc_xfer_t *);
+extern errno_t ipc_xfer_copy_to_uspace(uspace_addr_t, ipc_xfer_t *, size_t);
+extern errno_t ipc_xfer_copy_from_uspace(ipc_xfer_t *, uspace_addr_t, size_t);
+
+#endif
+
+/** @}
+ */
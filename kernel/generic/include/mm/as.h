@@ -126,6 +126,12 @@ typedef struct as {
 	 */
 	odict_t as_areas;
 
+	/** Number of large pages currently mapped in this address space. */
+	atomic_size_t large_pages;
+
+	/** Number of large pages split into small pages so far. */
+	atomic_size_t large_splits;
+
 	/** Non-generic content. */
 	as_genarch_t genarch;
 
@@ -371,6 +377,11 @@ extern mem_backend_t elf_backend;
 extern mem_backend_t phys_backend;
 extern mem_backend_t user_backend;
 
+/** Page-in request made by the kernel on behalf of user_backend. */
+#define USER_PAGE_IN_KERNEL  0x1
+/** The faulting area is writable and needs a private copy of the page. */
+#define USER_PAGE_IN_COPY    0x2
+
 /* Address space area related syscalls. */
 extern sysarg_t sys_as_area_create(uintptr_t, size_t, unsigned int, uintptr_t,
     uspace_ptr_as_area_pager_info_t);
@@ -38,6 +38,8 @@
 
 #include <typedefs.h>
 #include <trace.h>
+#include <atomic.h>
+#include <abi/sysinfo.h>
 #include <adt/bitmap.h>
 #include <adt/list.h>
 #include <synch/spinlock.h>
@@ -90,7 +92,7 @@ typedef uint8_t zone_flags_t;
 	    (((zf) & ~ZONE_EF_MASK) & (f)))
 
 typedef struct {
-	size_t refcount;  /**< Tracking of shared frames */
+	atomic_size_t refcount;  /**< Tracking of shared frames */
 	void *parent;     /**< If allocated by slab, this points there */
 } frame_t;
 
@@ -130,6 +132,8 @@ typedef struct {
 extern zones_t zones;
 
 extern void frame_init(void);
+extern void frame_enable_cpucache(void);
+extern void frame_cache_stats(stats_frames_t *);
 extern bool frame_adjust_zone_bounds(bool, uintptr_t *, size_t *);
 extern uintptr_t frame_alloc_generic(size_t, frame_flags_t, uintptr_t,
     size_t *);
@@ -138,6 +142,7 @@ extern void frame_free_generic(uintptr_t, size_t, frame_flags_t);
 extern void frame_free(uintptr_t, size_t);
 extern void frame_free_noreserve(uintptr_t, size_t);
 extern void frame_reference_add(pfn_t);
+extern bool frame_reference_try_add(pfn_t);
 extern size_t frame_total_free_get(void);
 
 extern size_t find_zone(pfn_t, size_t, size_t);
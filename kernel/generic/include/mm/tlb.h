@@ -65,17 +65,47 @@ typedef struct {
 	size_t count;			/**< Number of pages to invalidate. */
 } tlb_shootdown_msg_t;
 
+/** Maximum number of page ranges in a TLB shootdown batch. */
+#define TLB_BATCH_RANGES	8
+
+/**
+ * Number of pages in a TLB shootdown batch above which the whole address space
+ * is invalidated instead of the individual pages.
+ */
+#define TLB_BATCH_MAX_PAGES	64
+
+/** Batch of TLB invalidations belonging to one address space.
+ *
+ * The batch accumulates the page ranges to be invalidated so that they can be
+ * shot down in a single round of TLB shootdown messages.
+ */
+typedef struct {
+	asid_t asid;			/**< Address space identifier. */
+	size_t pages;			/**< Number of pages in the batch. */
+	size_t count;			/**< Number of messages in the batch. */
+	/** Messages describing the batch. */
+	tlb_shootdown_msg_t msgs[TLB_BATCH_RANGES];
+} tlb_batch_t;
+
 extern void tlb_init(void);
 
+extern void tlb_batch_init(tlb_batch_t *, asid_t);
+extern void tlb_batch_add(tlb_batch_t *, uintptr_t, size_t);
+extern void tlb_batch_invalidate(tlb_batch_t *);
+
 #ifdef CONFIG_SMP
 extern ipl_t tlb_shootdown_start(tlb_invalidate_type_t, asid_t, uintptr_t,
     size_t);
+extern ipl_t tlb_batch_shootdown_start(tlb_batch_t *);
 extern void tlb_shootdown_finalize(ipl_t);
 extern void tlb_shootdown_ipi_recv(void);
+extern void tlb_shootdown_as_switch(asid_t);
 #else
 #define tlb_shootdown_start(w, x, y, z)	interrupts_disable()
+#define tlb_batch_shootdown_start(b)	interrupts_disable()
 #define tlb_shootdown_finalize(i)	(interrupts_restore(i));
 #define tlb_shootdown_ipi_recv()
+#define tlb_shootdown_as_switch(a)
 #endif /* CONFIG_SMP */
 
 /* Export TLB interface that each architecture must implement. */
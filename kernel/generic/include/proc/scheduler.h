@@ -45,6 +45,21 @@
 #define RQ_COUNT          16
 #define NEEDS_RELINK_MAX  (HZ)
 
+/** Maximum number of threads an idle CPU steals at once. */
+#define SCHED_STEAL_BATCH  4
+
+/** Threads which ran this recently are not migrated if avoidable. */
+#define SCHED_CACHE_HOT_USEC  500
+
+/** Period of the kcpulb load balancing thread. */
+#define KCPULB_INTERVAL_USEC  100000
+
+/** Fixed-point precision of thread_t.burst_avg (in bits). */
+#define SCHED_BURST_SHIFT  4
+
+/** Weight of the history in thread_t.burst_avg. */
+#define SCHED_BURST_DECAY  4
+
 /** Scheduler run queue structure. */
 typedef struct {
 	IRQ_SPINLOCK_DECLARE(lock);
@@ -204,6 +204,21 @@ typedef struct thread {
 	/** Thread's priority. Implemented as index to CPU->rq */
 	atomic_int_fast32_t priority;
 
+	/** Clock tick at which the thread was last scheduled in. */
+	uint64_t run_tick;
+
+	/** Clock ticks the thread has run since it last went to sleep. */
+	uint64_t burst_ticks;
+
+	/**
+	 * Decaying average of burst_ticks over the last few sleeps, scaled
+	 * by 2^SCHED_BURST_SHIFT. Interactive threads, which run briefly
+	 * between sleeps, keep it low and are woken up into the
+	 * highest-priority run queue; threads which compute for long
+	 * stretches are woken up into lower-priority ones.
+	 */
+	uint64_t burst_avg;
+
 	/** Last sampled cycle. */
 	uint64_t last_cycle;
 } thread_t;
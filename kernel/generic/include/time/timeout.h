@@ -35,7 +35,7 @@
 #ifndef KERN_TIMEOUT_H_
 #define KERN_TIMEOUT_H_
 
-#include <adt/list.h>
+#include <adt/pheap.h>
 #include <cpu.h>
 #include <stdint.h>
 
@@ -45,8 +45,8 @@ typedef uint64_t deadline_t;
 #define DEADLINE_NEVER ((deadline_t) UINT64_MAX)
 
 typedef struct {
-	/** Link to the list of active timeouts on timeout->cpu */
-	link_t link;
+	/** Link to the heap of active timeouts on timeout->cpu */
+	phlink_t link;
 	/** Timeout will be activated when current clock tick reaches this value. */
 	deadline_t deadline;
 	/** Function that will be called on timeout activation. */
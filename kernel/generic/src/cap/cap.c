@@ -73,6 +73,17 @@
  * kobject_get() or kobject_add_ref(). When the kernel object is removed from
  * the container, the reference count should go down via a call to
  * kobject_put().
+ *
+ * Capabilities are looked up in a radix tree indexed by the handle. Changes to
+ * capabilities are serialized by the per-task cap_info_t lock, but
+ * kobject_get(), which sits on the IPC fast path, walks the table without it.
+ * Such a reader announces itself in one of two per-task reader counters for
+ * the duration of the lookup and the refcount increment. Before the reference
+ * held by a published capability is handed over in cap_unpublish() or dropped
+ * in cap_revoke(), the kernel object is removed from the table and the writer
+ * waits in cap_readers_wait() until every reader that could have seen it is
+ * gone. The counters are used alternately, so that a steady stream of new
+ * readers cannot starve the writer.
  */
 
 #include <cap/cap.h>
@@ -86,6 +97,8 @@
 #include <ipc/ipcrsc.h>
 #include <ipc/ipc.h>
 #include <ipc/irq.h>
+#include <arch/asm.h>
+#include <preemption.h>
 
 #include <limits.h>
 #include <stdint.h>
@@ -105,30 +118,158 @@ kobject_ops_t *kobject_ops[KOBJECT_TYPE_MAX] = {
 	[KOBJECT_TYPE_WAITQ] = &waitq_kobject_ops
 };
 
-static size_t caps_hash(const ht_link_t *item)
+/** Check whether a capability table node covers a handle
+ *
+ * @param node  Capability table node.
+ * @param raw   Raw capability handle.
+ *
+ * @return True if @a raw can be stored in the subtree of @a node.
+ */
+static bool cap_table_covers(cap_table_node_t *node, uintptr_t raw)
 {
-	cap_t *cap = hash_table_get_inst(item, cap_t, caps_link);
-	return hash_mix(cap_handle_raw(cap->handle));
+	unsigned int bits = node->shift + CAP_TABLE_BITS;
+
+	if (bits >= sizeof(uintptr_t) * 8)
+		return true;
+	return (raw >> bits) == 0;
 }
 
-static size_t caps_key_hash(const void *key)
+/** Find the capability table leaf for a handle
+ *
+ * May be called without holding the cap_info_t lock.
+ *
+ * @param info  Capability info structure.
+ * @param raw   Raw capability handle.
+ *
+ * @return Leaf node covering @a raw or NULL if there is none.
+ */
+static cap_table_node_t *cap_table_leaf(cap_info_t *info, uintptr_t raw)
 {
-	const cap_handle_t *handle = key;
-	return hash_mix(cap_handle_raw(*handle));
+	cap_table_node_t *node = atomic_load_explicit(&info->table,
+	    memory_order_acquire);
+	if (!node || !cap_table_covers(node, raw))
+		return NULL;
+
+	while (node && node->shift > 0) {
+		node = atomic_load_explicit(
+		    &node->child[(raw >> node->shift) & CAP_TABLE_MASK],
+		    memory_order_acquire);
+	}
+
+	return node;
 }
 
-static bool caps_key_equal(const void *key, size_t hash, const ht_link_t *item)
+/** Allocate a capability table node
+ *
+ * @param shift  Number of handle bits below the bits indexing the node.
+ *
+ * @return New zero-filled node or NULL if out of memory.
+ */
+static cap_table_node_t *cap_table_node_alloc(unsigned int shift)
 {
-	const cap_handle_t *handle = key;
-	cap_t *cap = hash_table_get_inst(item, cap_t, caps_link);
-	return *handle == cap->handle;
+	cap_table_node_t *node = calloc(1, sizeof(cap_table_node_t));
+	if (node)
+		node->shift = shift;
+	return node;
 }
 
-static const hash_table_ops_t caps_ops = {
-	.hash = caps_hash,
-	.key_hash = caps_key_hash,
-	.key_equal = caps_key_equal
-};
+/** Make sure the capability table has a leaf for a handle
+ *
+ * Nodes are fully initialized before they are linked into the table, so
+ * concurrent lock-free readers either do not see them or see them complete.
+ *
+ * @param info  Capability info structure, its lock must be held.
+ * @param raw   Raw capability handle.
+ *
+ * @return Leaf node covering @a raw or NULL if out of memory.
+ */
+static cap_table_node_t *cap_table_grow(cap_info_t *info, uintptr_t raw)
+{
+	assert(mutex_locked(&info->lock));
+
+	cap_table_node_t *root = atomic_load_explicit(&info->table,
+	    memory_order_relaxed);
+	if (!root) {
+		root = cap_table_node_alloc(0);
+		if (!root)
+			return NULL;
+		atomic_store_explicit(&info->table, root, memory_order_release);
+	}
+
+	/* Add levels on top until the root covers the handle. */
+	while (!cap_table_covers(root, raw)) {
+		cap_table_node_t *top = cap_table_node_alloc(root->shift +
+		    CAP_TABLE_BITS);
+		if (!top)
+			return NULL;
+		atomic_store_explicit(&top->child[0], root,
+		    memory_order_relaxed);
+		atomic_store_explicit(&info->table, top, memory_order_release);
+		root = top;
+	}
+
+	/* Fill in the missing interior nodes and the leaf. */
+	cap_table_node_t *node = root;
+	while (node->shift > 0) {
+		_Atomic(cap_table_node_t *) *slot =
+		    &node->child[(raw >> node->shift) & CAP_TABLE_MASK];
+		cap_table_node_t *child = atomic_load_explicit(slot,
+		    memory_order_relaxed);
+		if (!child) {
+			child = cap_table_node_alloc(node->shift -
+			    CAP_TABLE_BITS);
+			if (!child)
+				return NULL;
+			atomic_store_explicit(slot, child,
+			    memory_order_release);
+		}
+		node = child;
+	}
+
+	return node;
+}
+
+/** Free a capability table subtree
+ *
+ * @param node  Root of the subtree.
+ */
+static void cap_table_destroy(cap_table_node_t *node)
+{
+	if (node->shift > 0) {
+		for (unsigned int i = 0; i < CAP_TABLE_FANOUT; i++) {
+			cap_table_node_t *child = atomic_load_explicit(
+			    &node->child[i], memory_order_relaxed);
+			if (child)
+				cap_table_destroy(child);
+		}
+	}
+
+	free(node);
+}
+
+/** Wait for lock-free readers that may still see a removed kernel object
+ *
+ * Must be called with the cap_info_t lock held, after the kernel object has
+ * been removed from the capability table. On return, no reader can obtain a
+ * new reference to the kernel object from the table.
+ *
+ * @param info  Capability info structure.
+ */
+static void cap_readers_wait(cap_info_t *info)
+{
+	assert(mutex_locked(&info->lock));
+
+	/*
+	 * A reader may have loaded the epoch just before the previous writer
+	 * advanced it, so it can be counted under either parity. Advance the
+	 * epoch twice and drain the counter of the old parity each time.
+	 */
+	for (int i = 0; i < 2; i++) {
+		unsigned int old = atomic_fetch_add(&info->epoch, 1) & 1;
+		while (atomic_load(&info->readers[old]) != 0)
+			cpu_spin_hint();
+	}
+}
 
 void caps_init(void)
 {
@@ -152,8 +293,10 @@ errno_t caps_task_alloc(task_t *task)
 		goto error_handles;
 	if (!ra_span_add(task->cap_info->handles, CAPS_START, CAPS_SIZE))
 		goto error_span;
-	if (!hash_table_create(&task->cap_info->caps, 0, 0, &caps_ops))
-		goto error_span;
+	atomic_store(&task->cap_info->table, NULL);
+	atomic_store(&task->cap_info->epoch, 0);
+	atomic_store(&task->cap_info->readers[0], 0);
+	atomic_store(&task->cap_info->readers[1], 0);
 	return EOK;
 
 error_span:
@@ -181,7 +324,9 @@ void caps_task_init(task_t *task)
  */
 void caps_task_free(task_t *task)
 {
-	hash_table_destroy(&task->cap_info->caps);
+	cap_table_node_t *table = atomic_load(&task->cap_info->table);
+	if (table)
+		cap_table_destroy(table);
 	ra_arena_destroy(task->cap_info->handles);
 	free(task->cap_info);
 }
@@ -245,11 +390,12 @@ static cap_t *cap_get(task_t *task, cap_handle_t handle, cap_state_t state)
 	if ((cap_handle_raw(handle) < CAPS_START) ||
 	    (cap_handle_raw(handle) > CAPS_LAST))
 		return NULL;
-	ht_link_t *link = hash_table_find(&task->cap_info->caps, &handle);
-	if (!link)
+	uintptr_t raw = cap_handle_raw(handle);
+	cap_table_node_t *leaf = cap_table_leaf(task->cap_info, raw);
+	if (!leaf)
 		return NULL;
-	cap_t *cap = hash_table_get_inst(link, cap_t, caps_link);
-	if (cap->state != state)
+	cap_t *cap = leaf->cap[raw & CAP_TABLE_MASK];
+	if (!cap || cap->state != state)
 		return NULL;
 	return cap;
 }
@@ -276,8 +422,15 @@ errno_t cap_alloc(task_t *task, cap_handle_t *handle)
 		mutex_unlock(&task->cap_info->lock);
 		return ENOMEM;
 	}
+	cap_table_node_t *leaf = cap_table_grow(task->cap_info, hbase);
+	if (!leaf) {
+		ra_free(task->cap_info->handles, hbase, 1);
+		slab_free(cap_cache, cap);
+		mutex_unlock(&task->cap_info->lock);
+		return ENOMEM;
+	}
 	cap_initialize(cap, task, (cap_handle_t) hbase);
-	hash_table_insert(&task->cap_info->caps, &cap->caps_link);
+	leaf->cap[hbase & CAP_TABLE_MASK] = cap;
 
 	cap->state = CAP_STATE_ALLOCATED;
 	*handle = cap->handle;
@@ -308,12 +461,28 @@ cap_publish(task_t *task, cap_handle_t handle, kobject_t *kobj)
 	cap->kobject = kobj;
 	list_append(&cap->kobj_link, &kobj->caps_list);
 	list_append(&cap->type_link, &task->cap_info->type_list[kobj->type]);
+
+	/* Make the kernel object visible to lock-free readers */
+	uintptr_t raw = cap_handle_raw(handle);
+	cap_table_node_t *leaf = cap_table_leaf(task->cap_info, raw);
+	atomic_store(&leaf->kobject[raw & CAP_TABLE_MASK], kobj);
 	mutex_unlock(&task->cap_info->lock);
 	mutex_unlock(&kobj->caps_list_lock);
 }
 
 static void cap_unpublish_unsafe(cap_t *cap)
 {
+	cap_info_t *info = cap->task->cap_info;
+	uintptr_t raw = cap_handle_raw(cap->handle);
+	cap_table_node_t *leaf = cap_table_leaf(info, raw);
+
+	/*
+	 * Hide the kernel object from lock-free readers before the capability's
+	 * reference to it can go away.
+	 */
+	atomic_store(&leaf->kobject[raw & CAP_TABLE_MASK], NULL);
+	cap_readers_wait(info);
+
 	cap->kobject = NULL;
 	list_remove(&cap->kobj_link);
 	list_remove(&cap->type_link);
@@ -401,7 +570,9 @@ void cap_free(task_t *task, cap_handle_t handle)
 
 	assert(cap);
 
-	hash_table_remove_item(&task->cap_info->caps, &cap->caps_link);
+	uintptr_t raw = cap_handle_raw(handle);
+	cap_table_node_t *leaf = cap_table_leaf(task->cap_info, raw);
+	leaf->cap[raw & CAP_TABLE_MASK] = NULL;
 	ra_free(task->cap_info->handles, cap_handle_raw(handle), 1);
 	slab_free(cap_cache, cap);
 	mutex_unlock(&task->cap_info->lock);
@@ -441,23 +612,42 @@ void kobject_initialize(kobject_t *kobj, kobject_type_t type, void *raw)
  * @param type    Kernel object type of the object associated with the
  *                capability referenced by handle.
  *
+ * This function does not take the cap_info_t lock, so that threads of the same
+ * task can look up their capabilities in parallel.
+ *
  * @return Kernel object with incremented reference count on success.
  * @return NULL if there is no matching capability or kernel object.
  */
 kobject_t *
 kobject_get(struct task *task, cap_handle_t handle, kobject_type_t type)
 {
-	kobject_t *kobj = NULL;
+	cap_info_t *info = task->cap_info;
 
-	mutex_lock(&task->cap_info->lock);
-	cap_t *cap = cap_get(task, handle, CAP_STATE_PUBLISHED);
-	if (cap) {
-		if (cap->kobject->type == type) {
-			kobj = cap->kobject;
+	if ((cap_handle_raw(handle) < CAPS_START) ||
+	    (cap_handle_raw(handle) > CAPS_LAST))
+		return NULL;
+	uintptr_t raw = cap_handle_raw(handle);
+
+	/*
+	 * Keep the read-side section short, cap_readers_wait() spins on it.
+	 */
+	preemption_disable();
+	unsigned int epoch = atomic_load(&info->epoch) & 1;
+	atomic_inc(&info->readers[epoch]);
+
+	kobject_t *kobj = NULL;
+	cap_table_node_t *leaf = cap_table_leaf(info, raw);
+	if (leaf)
+		kobj = atomic_load(&leaf->kobject[raw & CAP_TABLE_MASK]);
+	if (kobj) {
+		if (kobj->type == type)
 			atomic_inc(&kobj->refcnt);
-		}
+		else
+			kobj = NULL;
 	}
-	mutex_unlock(&task->cap_info->lock);
+
+	atomic_dec(&info->readers[epoch]);
+	preemption_enable();
 
 	return kobj;
 }
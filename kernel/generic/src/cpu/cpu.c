@@ -41,6 +41,7 @@
 #include <stdlib.h>
 #include <mm/page.h>
 #include <mm/frame.h>
+#include <mm/asid.h>
 #include <typedefs.h>
 #include <config.h>
 #include <panic.h>
@@ -87,6 +88,7 @@ void cpu_init(void)
 			irq_spinlock_initialize(&cpus[i].fpu_lock, "cpus[].fpu_lock");
 #endif
 			irq_spinlock_initialize(&cpus[i].tlb_lock, "cpus[].tlb_lock");
+			cpus[i].tlb_asid = ASID_KERNEL;
 
 			for (unsigned int j = 0; j < RQ_COUNT; j++) {
 				irq_spinlock_initialize(&cpus[i].rq[j].lock, "cpus[].rq[].lock");
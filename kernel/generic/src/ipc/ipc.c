@@ -58,7 +58,9 @@
 #include <console/console.h>
 #include <proc/thread.h>
 #include <arch/interrupt.h>
+#include <arch/cycle.h>
 #include <ipc/irq.h>
+#include <ipc/xfer.h>
 #include <cap/cap.h>
 #include <stdlib.h>
 
@@ -86,6 +88,7 @@ static void _ipc_call_init(call_t *call)
 	call->sender = NULL;
 	call->callerbox = NULL;
 	call->buffer = NULL;
+	call->xfer = NULL;
 }
 
 static void call_destroy(void *arg)
@@ -94,6 +97,8 @@ static void call_destroy(void *arg)
 
 	if (call->buffer)
 		free(call->buffer);
+	if (call->xfer)
+		ipc_xfer_unpin(call->xfer);
 	if (call->caller_phone)
 		kobject_put(call->caller_phone->kobject);
 	slab_free(call_cache, call);
@@ -149,6 +154,10 @@ void ipc_answerbox_init(answerbox_t *box, task_t *task)
 	list_initialize(&box->answers);
 	list_initialize(&box->irq_notifs);
 	atomic_store(&box->active_calls, 0);
+	box->queued = 0;
+	box->dispatched = 0;
+	box->queued_max = 0;
+	box->queued_cycles = 0;
 	box->task = task;
 }
 
@@ -339,6 +348,7 @@ void ipc_answer(answerbox_t *box, call_t *call)
 	/* Remove from active box */
 	irq_spinlock_lock(&box->lock, true);
 	list_remove(&call->ab_link);
+	box->dispatched--;
 	irq_spinlock_unlock(&box->lock, true);
 
 	/* Send back answer */
@@ -412,7 +422,10 @@ static void _ipc_call(phone_t *phone, answerbox_t *box, call_t *call,
 		_ipc_call_actions_internal(phone, call, preforget);
 
 	irq_spinlock_lock(&box->lock, true);
+	call->queued_cycle = get_cycle();
 	list_append(&call->ab_link, &box->calls);
+	if (++box->queued > box->queued_max)
+		box->queued_max = box->queued;
 	irq_spinlock_unlock(&box->lock, true);
 
 	waitq_wake_one(&box->wq);
@@ -518,6 +531,7 @@ errno_t ipc_forward(call_t *call, phone_t *newphone, answerbox_t *oldbox,
 	TASK->ipc_info.forwarded++;
 	irq_spinlock_pass(&TASK->lock, &oldbox->lock);
 	list_remove(&call->ab_link);
+	oldbox->dispatched--;
 	irq_spinlock_unlock(&oldbox->lock, true);
 
 	if (mode & IPC_FF_ROUTE_FROM_ME) {
@@ -589,9 +603,16 @@ errno_t ipc_wait_for_call(answerbox_t *box, uint32_t usec, unsigned int flags,
 		request = list_get_instance(list_first(&box->calls),
 		    call_t, ab_link);
 		list_remove(&request->ab_link);
+		box->queued--;
+
+		/* Account for the time the request spent in the queue */
+		uint64_t now = get_cycle();
+		if (now > request->queued_cycle)
+			box->queued_cycles += now - request->queued_cycle;
 
 		/* Append request to dispatch queue */
 		list_append(&request->ab_link, &box->dispatched_calls);
+		box->dispatched++;
 	} else {
 		/*
 		 * This can happen regularly after ipc_cleanup, or in
@@ -626,6 +647,10 @@ void ipc_cleanup_call_list(answerbox_t *box, list_t *lst)
 		    ab_link);
 
 		list_remove(&call->ab_link);
+		if (lst == &box->calls)
+			box->queued--;
+		else
+			box->dispatched--;
 
 		irq_spinlock_unlock(&box->lock, true);
 
@@ -980,6 +1005,9 @@ void ipc_print_task(task_id_t taskid)
 
 	printf("Active calls: %" PRIun "\n",
 	    atomic_load(&task->answerbox.active_calls));
+	printf("Queued calls: %zu (max %zu), dispatched calls: %zu\n",
+	    task->answerbox.queued, task->answerbox.queued_max,
+	    task->answerbox.dispatched);
 
 #ifdef __32_BITS__
 	printf("[call adr] [method] [arg1] [arg2] [arg3] [arg4] [arg5]"
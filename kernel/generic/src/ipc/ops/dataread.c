@@ -39,20 +39,30 @@
 #include <abi/errno.h>
 #include <syscall/copy.h>
 #include <config.h>
+#include <align.h>
 
 static errno_t request_preprocess(call_t *call, phone_t *phone)
 {
+	uspace_addr_t dst = ipc_get_arg1(&call->data);
 	size_t size = ipc_get_arg2(&call->data);
 
 	if (size > DATA_XFER_LIMIT) {
 		int flags = ipc_get_arg3(&call->data);
 
-		if (flags & IPC_XF_RESTRICT)
-			ipc_set_arg2(&call->data, DATA_XFER_LIMIT);
-		else
+		if (flags & IPC_XF_RESTRICT) {
+			size = DATA_XFER_LIMIT;
+			ipc_set_arg2(&call->data, size);
+		} else
 			return ELIMIT;
 	}
 
+	/*
+	 * Pin large page-aligned buffers, so that the data can be copied
+	 * directly into them when the call is answered.
+	 */
+	if ((size >= IPC_XFER_THRESHOLD) && IS_ALIGNED(dst, PAGE_SIZE))
+		call->xfer = ipc_xfer_pin(dst, size, true);
+
 	return EOK;
 }
 
@@ -67,7 +77,13 @@ static errno_t answer_preprocess(call_t *answer, ipc_data_t *olddata)
 		size_t max_size = ipc_get_arg2(olddata);
 		size_t size = ipc_get_arg2(&answer->data);
 
-		if (size && size <= max_size) {
+		if (size && size <= max_size && answer->xfer) {
+			/* Copy straight into the caller's pinned buffer. */
+			errno_t rc = ipc_xfer_copy_from_uspace(answer->xfer,
+			    src, size);
+			if (rc)
+				ipc_set_retval(&answer->data, rc);
+		} else if (size && size <= max_size) {
 			/*
 			 * Copy the destination VA so that this piece of
 			 * information is not lost.
@@ -96,6 +112,12 @@ static errno_t answer_preprocess(call_t *answer, ipc_data_t *olddata)
 		}
 	}
 
+	/* The caller's pages are no longer needed. */
+	if (answer->xfer) {
+		ipc_xfer_unpin(answer->xfer);
+		answer->xfer = NULL;
+	}
+
 	return EOK;
 }
 
@@ -39,6 +39,7 @@
 #include <abi/errno.h>
 #include <syscall/copy.h>
 #include <config.h>
+#include <align.h>
 
 static errno_t request_preprocess(call_t *call, phone_t *phone)
 {
@@ -55,6 +56,18 @@ static errno_t request_preprocess(call_t *call, phone_t *phone)
 			return ELIMIT;
 	}
 
+	/*
+	 * Large page-aligned buffers are not copied here, but pinned until
+	 * the data is copied directly to the recipient. Note that the data is
+	 * then read when the call is answered, not when it is sent, so the
+	 * sender must not modify the buffer until the call is answered.
+	 */
+	if ((size >= IPC_XFER_THRESHOLD) && IS_ALIGNED(src, PAGE_SIZE)) {
+		call->xfer = ipc_xfer_pin(src, size, false);
+		if (call->xfer)
+			return EOK;
+	}
+
 	call->buffer = (uint8_t *) malloc(size);
 	if (!call->buffer)
 		return ENOMEM;
@@ -72,7 +85,7 @@ static errno_t request_preprocess(call_t *call, phone_t *phone)
 
 static errno_t answer_preprocess(call_t *answer, ipc_data_t *olddata)
 {
-	assert(answer->buffer);
+	assert(answer->buffer || answer->xfer);
 
 	if (!ipc_get_retval(&answer->data)) {
 		/* The recipient agreed to receive data. */
@@ -81,8 +94,15 @@ static errno_t answer_preprocess(call_t *answer, ipc_data_t *olddata)
 		size_t max_size = ipc_get_arg2(olddata);
 
 		if (size <= max_size) {
-			errno_t rc = copy_to_uspace(dst,
-			    answer->buffer, size);
+			errno_t rc;
+
+			if (answer->xfer) {
+				rc = ipc_xfer_copy_to_uspace(dst,
+				    answer->xfer, size);
+			} else {
+				rc = copy_to_uspace(dst,
+				    answer->buffer, size);
+			}
 			if (rc)
 				ipc_set_retval(&answer->data, rc);
 		} else {
@@ -90,6 +110,12 @@ static errno_t answer_preprocess(call_t *answer, ipc_data_t *olddata)
 		}
 	}
 
+	/* The sender's pages are no longer needed. */
+	if (answer->xfer) {
+		ipc_xfer_unpin(answer->xfer);
+		answer->xfer = NULL;
+	}
+
 	return EOK;
 }
 
@@ -42,6 +42,8 @@
 #include <proc/task.h>
 #include <abi/errno.h>
 #include <arch.h>
+#include <align.h>
+#include <syscall/copy.h>
 
 static errno_t pagein_request_preprocess(call_t *call, phone_t *phone)
 {
@@ -67,6 +69,27 @@ static errno_t pagein_answer_preprocess(call_t *answer, ipc_data_t *olddata)
 	if (!answer->priv)
 		return EOK;
 
+	if (!ipc_get_retval(&answer->data) &&
+	    (answer->priv & USER_PAGE_IN_COPY)) {
+		/*
+		 * The faulting area is writable. Give it a private copy of the
+		 * page so that it cannot modify the page of the pager, which
+		 * may be shared with other clients.
+		 */
+		uintptr_t frame = frame_alloc(1, FRAME_LOWMEM, 0);
+		errno_t rc = copy_from_uspace((void *) PA2KA(frame),
+		    ALIGN_DOWN(ipc_get_arg1(&answer->data), PAGE_SIZE),
+		    PAGE_SIZE);
+		if (rc != EOK) {
+			frame_free(frame, 1);
+			ipc_set_retval(&answer->data, rc);
+		} else {
+			ipc_set_arg1(&answer->data, frame);
+		}
+
+		return EOK;
+	}
+
 	if (!ipc_get_retval(&answer->data)) {
 
 		pte_t pte;
@@ -458,6 +458,86 @@ sys_errno_t sys_ipc_call_async_slow(cap_phone_handle_t handle, uspace_ptr_ipc_da
 	return EOK;
 }
 
+/** Make a batch of asynchronous IPC calls.
+ *
+ * The calls are made in the order of the array, so calls made on the same
+ * phone are received in that order. Consecutive calls on the same phone
+ * share one lookup of the phone capability. The batch stops at the first
+ * call which cannot be made.
+ *
+ * @param calls     Userspace address of the array of calls.
+ * @param count     Number of calls in the array, at most IPC_BATCH_MAX.
+ * @param submitted Userspace address where to store the number of calls
+ *                  made.
+ *
+ * @return EOK if all calls were made, otherwise the error code of the
+ *         first call which was not made. See sys_ipc_call_async_fast().
+ *
+ */
+sys_errno_t sys_ipc_call_async_batch(uspace_ptr_ipc_batch_call_t calls,
+    size_t count, uspace_ptr_size_t submitted)
+{
+	if (count > IPC_BATCH_MAX)
+		return EINVAL;
+
+	kobject_t *kobj = NULL;
+	cap_phone_handle_t handle = CAP_NIL;
+	errno_t rc = EOK;
+	size_t done;
+
+	for (done = 0; done < count; done++) {
+		ipc_batch_call_t req;
+		rc = copy_from_uspace(&req,
+		    calls + done * sizeof(ipc_batch_call_t), sizeof(req));
+		if (rc != EOK)
+			break;
+
+		if ((kobj == NULL) || (req.phone != handle)) {
+			if (kobj != NULL)
+				kobject_put(kobj);
+
+			handle = req.phone;
+			kobj = kobject_get(TASK, handle, KOBJECT_TYPE_PHONE);
+			if (!kobj) {
+				rc = ENOENT;
+				break;
+			}
+		}
+
+		if (check_call_limit(kobj->phone)) {
+			rc = ELIMIT;
+			break;
+		}
+
+		call_t *call = ipc_call_alloc();
+		if (!call) {
+			rc = ENOMEM;
+			break;
+		}
+
+		memcpy(call->data.args, req.args, sizeof(call->data.args));
+
+		/* Set the user-defined label */
+		call->data.answer_label = req.label;
+
+		errno_t res = request_preprocess(call, kobj->phone);
+
+		if (!res)
+			ipc_call(kobj->phone, call);
+		else
+			ipc_backsend_err(kobj->phone, call, res);
+	}
+
+	if (kobj != NULL)
+		kobject_put(kobj);
+
+	errno_t crc = copy_to_uspace(submitted, &done, sizeof(done));
+	if (crc != EOK)
+		return (sys_errno_t) crc;
+
+	return (sys_errno_t) rc;
+}
+
 /** Forward a received call to another destination
  *
  * Common code for both the fast and the slow version.
@@ -757,6 +837,8 @@ sys_errno_t sys_ipc_hangup(cap_phone_handle_t handle)
 }
 
 /** Wait for an incoming IPC call or an answer.
+ *
+ * Common code for sys_ipc_wait_for_call() and sys_ipc_wait_batch().
  *
  * @param calldata Pointer to buffer where the call/answer data is stored.
  * @param usec     Timeout. See waitq_sleep_timeout() for explanation.
@@ -765,7 +847,7 @@ sys_errno_t sys_ipc_hangup(cap_phone_handle_t handle)
  *
  * @return An error code on error.
  */
-sys_errno_t sys_ipc_wait_for_call(uspace_ptr_ipc_data_t calldata, uint32_t usec,
+static errno_t ipc_wait_common(uspace_ptr_ipc_data_t calldata, uint32_t usec,
     unsigned int flags)
 {
 	call_t *call = NULL;
@@ -865,6 +947,61 @@ error:
 	return rc;
 }
 
+/** Wait for an incoming IPC call or an answer.
+ *
+ * @param calldata Pointer to buffer where the call/answer data is stored.
+ * @param usec     Timeout. See waitq_sleep_timeout() for explanation.
+ * @param flags    Select mode of sleep operation. See waitq_sleep_timeout()
+ *                 for explanation.
+ *
+ * @return An error code on error.
+ */
+sys_errno_t sys_ipc_wait_for_call(uspace_ptr_ipc_data_t calldata, uint32_t usec,
+    unsigned int flags)
+{
+	return (sys_errno_t) ipc_wait_common(calldata, usec, flags);
+}
+
+/** Wait for incoming IPC calls or answers and receive a batch of them.
+ *
+ * The first call or answer is waited for as in sys_ipc_wait_for_call().
+ * Those already pending afterwards are received without blocking, until
+ * the buffer is full or the answerbox is empty.
+ *
+ * @param calldata Pointer to the array where the call/answer data is stored.
+ * @param count    Number of entries in the array, at most IPC_BATCH_MAX.
+ * @param usec     Timeout. See waitq_sleep_timeout() for explanation.
+ * @param flags    Select mode of sleep operation. See waitq_sleep_timeout()
+ *                 for explanation.
+ * @param received Userspace address where to store the number of calls
+ *                 and answers received.
+ *
+ * @return EOK if at least one call or answer was received, otherwise the
+ *         error code of the first wait.
+ */
+sys_errno_t sys_ipc_wait_batch(uspace_ptr_ipc_data_t calldata, size_t count,
+    uint32_t usec, unsigned int flags, uspace_ptr_size_t received)
+{
+	if ((count == 0) || (count > IPC_BATCH_MAX))
+		return EINVAL;
+
+	errno_t rc = ipc_wait_common(calldata, usec, flags);
+	if (rc != EOK)
+		return (sys_errno_t) rc;
+
+	size_t done = 1;
+	while (done < count) {
+		rc = ipc_wait_common(calldata + done * sizeof(ipc_data_t),
+		    SYNCH_NO_TIMEOUT, SYNCH_FLAGS_NON_BLOCKING);
+		if (rc != EOK)
+			break;
+
+		done++;
+	}
+
+	return (sys_errno_t) copy_to_uspace(received, &done, sizeof(done));
+}
+
 /** Interrupt one thread from sys_ipc_wait_for_call().
  *
  */
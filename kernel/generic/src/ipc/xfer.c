@@ -0,0 +1,233 @@
+/*
+ * Copyright (c) 2026 The HelenOS Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+/** @addtogroup kernel_generic_ipc
+ * @{
+ */
+/** @file
+ * @brief Large IPC data transfers through pinned pages.
+ *
+ * IPC_M_DATA_WRITE and IPC_M_DATA_READ normally copy the data into a kernel
+ * buffer in the context of one task and out of it in the context of the other
+ * one. For a large, page-aligned buffer of the calling task, the kernel
+ * instead takes a reference to each frame backing the buffer when the call
+ * is sent. When the call is answered, the data is copied directly between the
+ * answering task's buffer and the pinned frames, which are temporarily mapped
+ * into the kernel address space if they are not identity-mapped.
+ *
+ * The references keep the frames alive even if the caller unmaps the buffer
+ * in the meantime. They are dropped once the data has been moved or when the
+ * call is destroyed.
+ */
+
+#include <assert.h>
+#include <ipc/xfer.h>
+#include <mm/as.h>
+#include <mm/frame.h>
+#include <mm/km.h>
+#include <mm/page.h>
+#include <genarch/mm/page_pt.h>
+#include <genarch/mm/page_ht.h>
+#include <syscall/copy.h>
+#include <abi/errno.h>
+#include <align.h>
+#include <config.h>
+#include <macros.h>
+#include <stdlib.h>
+
+/** Find and pin the frame backing a user page
+ *
+ * @param page  Address of the page in the current address space.
+ * @param write The frame is going to be written to.
+ * @param frame Place to store the physical address of the frame.
+ *
+ * @return True if the frame has been pinned.
+ */
+static bool ipc_xfer_pin_page(uspace_addr_t page, bool write, uintptr_t *frame)
+{
+	uint8_t byte;
+
+	/* Fault the page in with the required access. */
+	if (copy_from_uspace(&byte, page, 1) != EOK)
+		return false;
+	if (write && copy_to_uspace(page, &byte, 1) != EOK)
+		return false;
+
+	bool pinned = false;
+	pte_t pte;
+
+	page_table_lock(AS, true);
+	bool found = page_mapping_find(AS, page, false, &pte);
+	if (found && PTE_PRESENT(&pte) && PTE_READABLE(&pte) &&
+	    (!write || PTE_WRITABLE(&pte))) {
+		uintptr_t pa = PTE_GET_FRAME(&pte);
+
+		/* Only memory managed by the frame allocator can be pinned. */
+		if (frame_reference_try_add(ADDR2PFN(pa))) {
+			*frame = pa;
+			pinned = true;
+		}
+	}
+	page_table_unlock(AS, true);
+
+	return pinned;
+}
+
+/** Pin a user buffer of the current task
+ *
+ * @param buf   Page-aligned address of the buffer.
+ * @param size  Size of the buffer.
+ * @param write The pinned frames are going to be written to.
+ *
+ * @return Pinned buffer or NULL if the buffer cannot be pinned. The caller is
+ *         expected to fall back to copying the data in that case.
+ */
+ipc_xfer_t *ipc_xfer_pin(uspace_addr_t buf, size_t size, bool write)
+{
+	assert(IS_ALIGNED(buf, PAGE_SIZE));
+
+	size_t pages = ALIGN_UP(size, PAGE_SIZE) >> PAGE_WIDTH;
+	ipc_xfer_t *xfer = malloc(sizeof(ipc_xfer_t) + pages * sizeof(uintptr_t));
+	if (!xfer)
+		return NULL;
+
+	xfer->size = size;
+	xfer->pages = 0;
+
+	while (xfer->pages < pages) {
+		if (!ipc_xfer_pin_page(buf + P2SZ(xfer->pages), write,
+		    &xfer->frames[xfer->pages])) {
+			ipc_xfer_unpin(xfer);
+			return NULL;
+		}
+
+		xfer->pages++;
+	}
+
+	return xfer;
+}
+
+/** Unpin a pinned user buffer
+ *
+ * @param xfer Pinned buffer.
+ */
+void ipc_xfer_unpin(ipc_xfer_t *xfer)
+{
+	/*
+	 * The frames' owners account for the reservation, the same as when
+	 * their address space areas are destroyed.
+	 */
+	for (size_t i = 0; i < xfer->pages; i++)
+		frame_free_noreserve(xfer->frames[i], 1);
+
+	free(xfer);
+}
+
+/** Map a pinned frame into the kernel address space
+ *
+ * @param frame Physical address of the frame.
+ *
+ * @return Kernel address of the frame.
+ */
+static uintptr_t ipc_xfer_map(uintptr_t frame)
+{
+	if (frame >= config.identity_size) {
+		return km_map(frame, PAGE_SIZE, PAGE_SIZE,
+		    PAGE_READ | PAGE_WRITE | PAGE_CACHEABLE);
+	}
+
+	return PA2KA(frame);
+}
+
+/** Unmap a pinned frame mapped by ipc_xfer_map()
+ *
+ * @param page Kernel address of the frame.
+ */
+static void ipc_xfer_unmap(uintptr_t page)
+{
+	if (km_is_non_identity(page))
+		km_unmap(page, PAGE_SIZE);
+}
+
+/** Copy data from a pinned buffer to the current address space
+ *
+ * @param dst  Destination address in the current address space.
+ * @param xfer Pinned buffer.
+ * @param size Number of bytes to copy.
+ *
+ * @return EOK on success or an error code from copy_to_uspace().
+ */
+errno_t ipc_xfer_copy_to_uspace(uspace_addr_t dst, ipc_xfer_t *xfer,
+    size_t size)
+{
+	assert(size <= xfer->size);
+
+	for (size_t i = 0; size > 0; i++) {
+		size_t chunk = min(size, PAGE_SIZE);
+		uintptr_t page = ipc_xfer_map(xfer->frames[i]);
+		errno_t rc = copy_to_uspace(dst, (void *) page, chunk);
+		ipc_xfer_unmap(page);
+		if (rc != EOK)
+			return rc;
+
+		dst += chunk;
+		size -= chunk;
+	}
+
+	return EOK;
+}
+
+/** Copy data from the current address space to a pinned buffer
+ *
+ * @param xfer Pinned buffer, pinned for writing.
+ * @param src  Source address in the current address space.
+ * @param size Number of bytes to copy.
+ *
+ * @return EOK on success or an error code from copy_from_uspace().
+ */
+errno_t ipc_xfer_copy_from_uspace(ipc_xfer_t *xfer, uspace_addr_t src,
+    size_t size)
+{
+	assert(size <= xfer->size);
+
+	for (size_t i = 0; size > 0; i++) {
+		size_t chunk = min(size, PAGE_SIZE);
+		uintptr_t page = ipc_xfer_map(xfer->frames[i]);
+		errno_t rc = copy_from_uspace((void *) page, src, chunk);
+		ipc_xfer_unmap(page);
+		if (rc != EOK)
+			return rc;
+
+		src += chunk;
+		size -= chunk;
+	}
+
+	return EOK;
+}
+
+/** @}
+ */
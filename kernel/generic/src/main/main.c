@@ -77,6 +77,7 @@
 #include <mm/reserve.h>
 #include <synch/waitq.h>
 #include <synch/syswaitq.h>
+#include <synch/futex.h>
 #include <arch/arch.h>
 #include <arch.h>
 #include <ipc/ipc.h>
@@ -232,6 +233,7 @@ void main_bsp_separated_stack(void)
 
 	/* Slab must be initialized after we know the number of processors. */
 	slab_enable_cpucache();
+	frame_enable_cpucache();
 
 	uint64_t size;
 	const char *size_suffix;
@@ -250,6 +252,7 @@ void main_bsp_separated_stack(void)
 	task_init();
 	thread_init();
 	sys_waitq_init();
+	futex_init();
 
 	sysinfo_set_item_data("boot_args", NULL, bargs, str_size(bargs) + 1);
 
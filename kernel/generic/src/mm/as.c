@@ -184,6 +184,9 @@ as_t *as_create(unsigned int flags)
 	refcount_init(&as->refcount);
 	as->cpu_refcount = 0;
 
+	atomic_store(&as->large_pages, 0);
+	atomic_store(&as->large_splits, 0);
+
 #ifdef AS_PAGE_TABLE
 	as->genarch.page_table = page_table_create(flags);
 #else
@@ -880,6 +883,34 @@ _NO_TRACE static as_area_t *find_area_and_lock(as_t *as, uintptr_t va)
 	return NULL;
 }
 
+/** Collect TLB invalidations for the used pages of an address space area.
+ *
+ * Only the pages that are actually mapped need to be invalidated, which
+ * spares invalidating each page of a large and sparsely populated area.
+ *
+ * @param area  Address space area.
+ * @param start Address from which on the used pages are collected.
+ * @param batch Batch of TLB invalidations to initialize.
+ *
+ */
+static void as_area_tlb_batch(as_area_t *area, uintptr_t start,
+    tlb_batch_t *batch)
+{
+	assert(mutex_locked(&area->lock));
+
+	tlb_batch_init(batch, area->as->asid);
+
+	used_space_ival_t *ival = used_space_find_gteq(&area->used_space,
+	    start);
+	while (ival != NULL) {
+		uintptr_t first = max(ival->page, start);
+
+		tlb_batch_add(batch, first,
+		    ival->count - ((first - ival->page) >> PAGE_WIDTH));
+		ival = used_space_next(ival);
+	}
+}
+
 /** Find address space area and change it.
  *
  * @param as      Address space.
@@ -950,13 +981,20 @@ errno_t as_area_resize(as_t *as, uintptr_t address, size_t size, unsigned int fl
 
 		page_table_lock(as, false);
 
+		/*
+		 * A large page straddling the new end of the area is removed
+		 * only partially and needs to be split first.
+		 */
+		page_mapping_split(as, start_free);
+
+		tlb_batch_t batch;
+		as_area_tlb_batch(area, start_free, &batch);
+
 		/*
 		 * Start TLB shootdown sequence.
 		 */
 
-		ipl_t ipl = tlb_shootdown_start(TLB_INVL_PAGES,
-		    as->asid, area->base + P2SZ(pages),
-		    area->pages - pages);
+		ipl_t ipl = tlb_batch_shootdown_start(&batch);
 
 		/*
 		 * Remove frames belonging to used space starting from
@@ -1030,9 +1068,7 @@ errno_t as_area_resize(as_t *as, uintptr_t address, size_t size, unsigned int fl
 		 * Finish TLB shootdown sequence.
 		 */
 
-		tlb_invalidate_pages(as->asid,
-		    area->base + P2SZ(pages),
-		    area->pages - pages);
+		tlb_batch_invalidate(&batch);
 
 		/*
 		 * Invalidate software translation caches
@@ -1104,8 +1140,10 @@ errno_t as_area_destroy(as_t *as, uintptr_t address)
 	/*
 	 * Start TLB shootdown sequence.
 	 */
-	ipl_t ipl = tlb_shootdown_start(TLB_INVL_PAGES, as->asid, area->base,
-	    area->pages);
+	tlb_batch_t batch;
+	as_area_tlb_batch(area, area->base, &batch);
+
+	ipl_t ipl = tlb_batch_shootdown_start(&batch);
 
 	/*
 	 * Visit only the pages mapped by used_space.
@@ -1142,7 +1180,7 @@ errno_t as_area_destroy(as_t *as, uintptr_t address)
 	 * Finish TLB shootdown sequence.
 	 */
 
-	tlb_invalidate_pages(as->asid, area->base, area->pages);
+	tlb_batch_invalidate(&batch);
 
 	/*
 	 * Invalidate potential software translation caches
@@ -1346,6 +1384,40 @@ _NO_TRACE static unsigned int area_flags_to_page_flags(unsigned int aflags)
 	return flags;
 }
 
+#ifdef LARGE_PAGE_SIZE
+
+/** Map a run of pages using a large page if possible.
+ *
+ * The run is mapped by a large page only if it starts at a large page
+ * boundary and its first LARGE_PAGE_PAGES frames are physically contiguous
+ * and equally aligned.
+ *
+ * @param as    Address space.
+ * @param page  First page of the run.
+ * @param frame Array of frames backing the pages of the run.
+ * @param count Number of pages in the run.
+ * @param flags Flags to be used for mapping.
+ *
+ * @return True if the first LARGE_PAGE_PAGES pages of the run were mapped.
+ *
+ */
+static bool as_large_page_insert(as_t *as, uintptr_t page, uintptr_t *frame,
+    size_t count, unsigned int flags)
+{
+	if (count < LARGE_PAGE_PAGES || !IS_ALIGNED(page, LARGE_PAGE_SIZE) ||
+	    !IS_ALIGNED(frame[0], LARGE_PAGE_SIZE))
+		return false;
+
+	for (size_t i = 1; i < LARGE_PAGE_PAGES; i++) {
+		if (frame[i] != frame[0] + FRAMES2SIZE(i))
+			return false;
+	}
+
+	return page_mapping_insert_large(as, page, frame[0], flags);
+}
+
+#endif /* LARGE_PAGE_SIZE */
+
 /** Change address space area flags.
  *
  * The idea is to have the same data, but with a different access mode.
@@ -1401,11 +1473,13 @@ errno_t as_area_change_flags(as_t *as, unsigned int flags, uintptr_t address)
 
 	page_table_lock(as, false);
 
+	tlb_batch_t batch;
+	as_area_tlb_batch(area, area->base, &batch);
+
 	/*
 	 * Start TLB shootdown sequence.
 	 */
-	ipl_t ipl = tlb_shootdown_start(TLB_INVL_PAGES, as->asid, area->base,
-	    area->pages);
+	ipl_t ipl = tlb_batch_shootdown_start(&batch);
 
 	/*
 	 * Remove used pages from page tables and remember their frame
@@ -1441,7 +1515,7 @@ errno_t as_area_change_flags(as_t *as, unsigned int flags, uintptr_t address)
 	 * Finish TLB shootdown sequence.
 	 */
 
-	tlb_invalidate_pages(as->asid, area->base, area->pages);
+	tlb_batch_invalidate(&batch);
 
 	/*
 	 * Invalidate potential software translation caches
@@ -1472,6 +1546,21 @@ errno_t as_area_change_flags(as_t *as, unsigned int flags, uintptr_t address)
 		for (size = 0; size < ival->count; size++) {
 			page_table_lock(as, false);
 
+#ifdef LARGE_PAGE_SIZE
+			/*
+			 * Large pages were split when they were removed above,
+			 * promote them again.
+			 */
+			if (as_large_page_insert(as, ptr + P2SZ(size),
+			    &old_frame[frame_idx], ival->count - size,
+			    page_flags)) {
+				frame_idx += LARGE_PAGE_PAGES;
+				size += LARGE_PAGE_PAGES - 1;
+				page_table_unlock(as, false);
+				continue;
+			}
+#endif
+
 			/* Insert the new mapping */
 			page_mapping_insert(as, ptr + P2SZ(size),
 			    old_frame[frame_idx++], page_flags);
@@ -1675,6 +1764,12 @@ retry:
 			new_as->asid = asid_get();
 	}
 
+	/*
+	 * Catch up with TLB shootdowns that skipped this processor while it
+	 * was not using the new address space.
+	 */
+	tlb_shootdown_as_switch(new_as->asid);
+
 #ifdef AS_PAGE_TABLE
 	SET_PTL0_ADDRESS(new_as->genarch.page_table);
 #endif
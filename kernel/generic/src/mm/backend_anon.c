@@ -52,6 +52,7 @@
 #include <align.h>
 #include <memw.h>
 #include <arch.h>
+#include <config.h>
 
 static bool anon_create(as_area_t *);
 static bool anon_resize(as_area_t *, size_t);
@@ -170,6 +171,70 @@ bool anon_is_shareable(as_area_t *area)
 	return !(area->flags & AS_AREA_LATE_RESERVE);
 }
 
+#ifdef LARGE_PAGE_SIZE
+
+/** Try to service a page fault by mapping a whole large page.
+ *
+ * This is possible only if the naturally aligned large page containing the
+ * faulting page lies entirely within the area, none of its pages has been
+ * mapped yet and physically contiguous memory is readily available. Areas
+ * with late reservation are populated page by page so that they do not
+ * reserve more memory than they actually touch.
+ *
+ * The address space area and page tables must be already locked.
+ *
+ * @param area Pointer to the address space area.
+ * @param upage Faulting virtual page.
+ *
+ * @return True if the large page was mapped.
+ */
+static bool anon_page_fault_large(as_area_t *area, uintptr_t upage)
+{
+	uintptr_t base = ALIGN_DOWN(upage, LARGE_PAGE_SIZE);
+
+	if (area->flags & AS_AREA_LATE_RESERVE)
+		return false;
+
+	if (base < area->base ||
+	    base - area->base + LARGE_PAGE_SIZE > P2SZ(area->pages))
+		return false;
+
+	used_space_ival_t *ival = used_space_find_gteq(&area->used_space, base);
+	if (ival != NULL && ival->page < base + LARGE_PAGE_SIZE)
+		return false;
+
+	/*
+	 * Do not wait for memory, mapping individual pages is always an option.
+	 */
+	uintptr_t frame = frame_alloc(LARGE_PAGE_PAGES,
+	    FRAME_HIGHMEM | FRAME_NO_RESERVE | FRAME_ATOMIC,
+	    LARGE_PAGE_SIZE - 1);
+	if (frame == 0)
+		return false;
+
+	if (frame + LARGE_PAGE_SIZE <= config.identity_size) {
+		memsetb((void *) PA2KA(frame), LARGE_PAGE_SIZE, 0);
+	} else {
+		uintptr_t kpage = km_map(frame, LARGE_PAGE_SIZE, PAGE_SIZE,
+		    PAGE_READ | PAGE_WRITE | PAGE_CACHEABLE);
+		memsetb((void *) kpage, LARGE_PAGE_SIZE, 0);
+		km_unmap(kpage, LARGE_PAGE_SIZE);
+	}
+
+	if (!page_mapping_insert_large(AS, base, frame,
+	    as_area_get_flags(area))) {
+		frame_free_noreserve(frame, LARGE_PAGE_PAGES);
+		return false;
+	}
+
+	if (!used_space_insert(&area->used_space, base, LARGE_PAGE_PAGES))
+		panic("Cannot insert used space.");
+
+	return true;
+}
+
+#endif /* LARGE_PAGE_SIZE */
+
 /** Service a page fault in the anonymous memory address space area.
  *
  * The address space area and page tables must be already locked.
@@ -236,6 +301,13 @@ int anon_page_fault(as_area_t *area, uintptr_t upage, pf_access_t access)
 		 *   the different causes
 		 */
 
+#ifdef LARGE_PAGE_SIZE
+		if (anon_page_fault_large(area, upage)) {
+			mutex_unlock(&area->sh_info->lock);
+			return AS_PF_OK;
+		}
+#endif
+
 		if (area->flags & AS_AREA_LATE_RESERVE) {
 			/*
 			 * Reserve the memory for this page now.
@@ -120,6 +120,49 @@ bool phys_is_shareable(as_area_t *area)
 	return true;
 }
 
+#ifdef LARGE_PAGE_SIZE
+
+/** Try to service a page fault by mapping a whole large page.
+ *
+ * This is possible only if the naturally aligned large page containing the
+ * faulting page lies entirely within the area, the physical memory behind it
+ * is equally aligned and none of its pages has been mapped yet.
+ *
+ * The address space area and page tables must be already locked.
+ *
+ * @param area Pointer to the address space area.
+ * @param upage Faulting virtual page.
+ *
+ * @return True if the large page was mapped.
+ */
+static bool phys_page_fault_large(as_area_t *area, uintptr_t upage)
+{
+	uintptr_t base = ALIGN_DOWN(upage, LARGE_PAGE_SIZE);
+
+	if (base < area->base || base - area->base + LARGE_PAGE_SIZE >
+	    FRAMES2SIZE(min(area->pages, area->backend_data.frames)))
+		return false;
+
+	uintptr_t frame = area->backend_data.base + (base - area->base);
+	if (!IS_ALIGNED(frame, LARGE_PAGE_SIZE))
+		return false;
+
+	used_space_ival_t *ival = used_space_find_gteq(&area->used_space, base);
+	if (ival != NULL && ival->page < base + LARGE_PAGE_SIZE)
+		return false;
+
+	if (!page_mapping_insert_large(AS, base, frame,
+	    as_area_get_flags(area)))
+		return false;
+
+	if (!used_space_insert(&area->used_space, base, LARGE_PAGE_PAGES))
+		panic("Cannot insert used space.");
+
+	return true;
+}
+
+#endif /* LARGE_PAGE_SIZE */
+
 /** Service a page fault in the address space area backed by physical memory.
  *
  * The address space area and page tables must be already locked.
@@ -143,6 +186,12 @@ int phys_page_fault(as_area_t *area, uintptr_t upage, pf_access_t access)
 		return AS_PF_FAULT;
 
 	assert(upage - area->base < area->backend_data.frames * FRAME_SIZE);
+
+#ifdef LARGE_PAGE_SIZE
+	if (phys_page_fault_large(area, upage))
+		return AS_PF_OK;
+#endif
+
 	page_mapping_insert(AS, upage, base + (upage - area->base),
 	    as_area_get_flags(area));
 
@@ -126,7 +126,11 @@ int user_page_fault(as_area_t *area, uintptr_t upage, pf_access_t access)
 	ipc_set_arg4(&data, pager_info->id2);
 	ipc_set_arg5(&data, pager_info->id3);
 
-	errno_t rc = ipc_req_internal(pager_info->pager, &data, (sysarg_t) true);
+	sysarg_t priv = USER_PAGE_IN_KERNEL;
+	if (area->flags & AS_AREA_WRITE)
+		priv |= USER_PAGE_IN_COPY;
+
+	errno_t rc = ipc_req_internal(pager_info->pager, &data, priv);
 
 	if (rc != EOK) {
 		log(LF_USPACE, LVL_FATAL,
@@ -39,6 +39,10 @@
  * This file contains the physical frame allocator and memory zone management.
  * The frame allocator is built on top of the two-level bitmap structure.
  *
+ * Small allocations are served from per-CPU caches of free blocks of
+ * frames, so that they do not need to take the global zones.lock. See
+ * frame_cache_alloc() and frame_cache_free().
+ *
  */
 
 #include <typedefs.h>
@@ -60,6 +64,9 @@
 #include <macros.h>
 #include <config.h>
 #include <str.h>
+#include <stdlib.h>
+#include <memw.h>
+#include <cpu.h>
 #include <proc/thread.h> /* THREAD */
 
 zones_t zones = {
@@ -75,6 +82,68 @@ static IRQ_SPINLOCK_INITIALIZE(mem_avail_lock);
 static CONDVAR_INITIALIZE(mem_avail_cv);
 static size_t mem_avail_req = 0;  /**< Number of frames requested. */
 static size_t mem_avail_gen = 0;  /**< Generation counter. */
+/** Number of threads sleeping until memory becomes available. */
+static atomic_size_t mem_avail_waiters = 0;
+
+/*
+ * Per-CPU frame caches.
+ *
+ * Every CPU keeps stacks of free, naturally aligned blocks of 2^order frames
+ * for the first FRAME_CACHE_ORDERS orders, separately for low and high
+ * memory. From the point of view of their zone, the cached frames are
+ * allocated and have a reference count of one. Blocks are moved between a
+ * cache and the zones in batches, which is the only time the cache takes
+ * zones.lock. An empty stack of one order is refilled by splitting a block
+ * of a higher order first, in the manner of a buddy allocator.
+ *
+ * The caches are enabled by frame_enable_cpucache() after the zones have been
+ * created and merged. The zone layout does not change afterwards, which lets
+ * frame_cache_free() use find_zone() without zones.lock.
+ */
+
+/** Number of block orders kept in the per-CPU frame caches */
+#define FRAME_CACHE_ORDERS  4
+
+/** Capacity of one per-CPU frame cache stack (in blocks) */
+#define FRAME_CACHE_SIZE  32
+
+/** Number of blocks moved between a cache stack and the zones at once */
+#define FRAME_CACHE_BATCH  (FRAME_CACHE_SIZE / 2)
+
+/** Memory classes of the per-CPU frame caches */
+enum {
+	FRAME_CACHE_LOWMEM,
+	FRAME_CACHE_HIGHMEM,
+	FRAME_CACHE_CLASSES
+};
+
+typedef struct {
+	/** Number of blocks in the stack */
+	size_t count;
+	/** First frames of the blocks */
+	pfn_t pfn[FRAME_CACHE_SIZE];
+} frame_cache_stack_t;
+
+typedef struct {
+	IRQ_SPINLOCK_DECLARE(lock);
+	frame_cache_stack_t stack[FRAME_CACHE_CLASSES][FRAME_CACHE_ORDERS];
+
+	/** Allocations served by the cache */
+	uint64_t hits;
+	/** Cacheable allocations that had to search the zones */
+	uint64_t misses;
+	/** Batches moved from the zones to the cache */
+	uint64_t refills;
+	/** Batches moved from the cache to the zones */
+	uint64_t drains;
+	/** Refills and drains that found zones.lock taken */
+	uint64_t contended;
+} frame_cache_t;
+
+/** Per-CPU frame caches, indexed by CPU ID */
+static _Atomic(frame_cache_t *) frame_caches = NULL;
+
+static size_t frame_cache_count(void);
 
 /** Initialize frame structure.
  *
@@ -171,10 +240,10 @@ _NO_TRACE static size_t frame_total_free_get_internal(void)
 
 _NO_TRACE size_t frame_total_free_get(void)
 {
-	size_t total;
+	size_t total = frame_cache_count();
 
 	irq_spinlock_lock(&zones.lock, true);
-	total = frame_total_free_get_internal();
+	total += frame_total_free_get_internal();
 	irq_spinlock_unlock(&zones.lock, true);
 
 	return total;
@@ -567,6 +636,9 @@ _NO_TRACE static void return_config_frames(size_t znum, pfn_t pfn, size_t count)
  */
 bool zone_merge(size_t z1, size_t z2)
 {
+	/* Lock-free users of find_zone() rely on the zones being fixed. */
+	assert(atomic_load(&frame_caches) == NULL);
+
 	irq_spinlock_lock(&zones.lock, true);
 
 	bool ret = true;
@@ -862,6 +934,424 @@ static size_t try_find_zone(size_t count, bool lowmem,
 	    frame_constraint, hint);
 }
 
+/** Wake up threads waiting for memory
+ *
+ * @param freed Number of frames that have been returned to the zones.
+ *
+ */
+static void mem_avail_notify(size_t freed)
+{
+	/* Disabled interrupts needed to prevent deadlock with TLB shootdown. */
+	irq_spinlock_lock(&mem_avail_lock, true);
+
+	if (mem_avail_req > 0)
+		mem_avail_req -= min(mem_avail_req, freed);
+
+	if (mem_avail_req == 0) {
+		mem_avail_gen++;
+		condvar_broadcast(&mem_avail_cv);
+	}
+
+	irq_spinlock_unlock(&mem_avail_lock, true);
+}
+
+/** Get the per-CPU frame cache order of a block
+ *
+ * @param count Number of frames in the block.
+ *
+ * @return Order of the block or -1 if such blocks are not cached.
+ *
+ */
+_NO_TRACE static int frame_cache_order(size_t count)
+{
+	for (int order = 0; order < FRAME_CACHE_ORDERS; order++) {
+		if (count == ((size_t) 1 << order))
+			return order;
+	}
+
+	return -1;
+}
+
+/** Lock zones from within a frame cache
+ *
+ * Interrupts must be disabled and the frame cache locked.
+ *
+ * @param fc Frame cache.
+ *
+ */
+_NO_TRACE static void frame_cache_lock_zones(frame_cache_t *fc)
+{
+	if (!irq_spinlock_trylock(&zones.lock)) {
+		fc->contended++;
+		irq_spinlock_lock(&zones.lock, false);
+	}
+}
+
+/** Move a batch of blocks from the zones to a frame cache stack
+ *
+ * The frame cache must be locked.
+ *
+ * @param fc    Frame cache.
+ * @param cls   Memory class of the stack.
+ * @param order Order of the stack.
+ *
+ * @return True if at least one block has been added to the stack.
+ *
+ */
+_NO_TRACE static bool frame_cache_refill(frame_cache_t *fc, unsigned int cls,
+    int order)
+{
+	frame_cache_stack_t *stack = &fc->stack[cls][order];
+	size_t count = (size_t) 1 << order;
+	zone_flags_t flags = ZONE_AVAILABLE |
+	    ((cls == FRAME_CACHE_HIGHMEM) ? ZONE_HIGHMEM : ZONE_LOWMEM);
+	size_t znum = 0;
+	size_t added = 0;
+
+	frame_cache_lock_zones(fc);
+
+	while (stack->count < FRAME_CACHE_BATCH) {
+		/* Blocks are aligned to their size. */
+		znum = find_free_zone(count, flags, count - 1, znum);
+		if (znum == (size_t) -1)
+			break;
+
+		stack->pfn[stack->count++] = zones.info[znum].base +
+		    zone_frame_alloc(&zones.info[znum], count, count - 1);
+		added++;
+	}
+
+	irq_spinlock_unlock(&zones.lock, false);
+
+	if (added == 0)
+		return false;
+
+	fc->refills++;
+	return true;
+}
+
+/** Move blocks from the bottom of a frame cache stack to the zones
+ *
+ * The frame cache must be locked.
+ *
+ * @param fc      Frame cache.
+ * @param cls     Memory class of the stack.
+ * @param order   Order of the stack.
+ * @param nblocks Number of blocks to move.
+ *
+ * @return Number of frames returned to the zones.
+ *
+ */
+_NO_TRACE static size_t frame_cache_drain(frame_cache_t *fc, unsigned int cls,
+    int order, size_t nblocks)
+{
+	frame_cache_stack_t *stack = &fc->stack[cls][order];
+	size_t count = (size_t) 1 << order;
+	size_t freed = 0;
+
+	assert(nblocks <= stack->count);
+
+	frame_cache_lock_zones(fc);
+
+	for (size_t i = 0; i < nblocks; i++) {
+		pfn_t pfn = stack->pfn[i];
+		size_t znum = find_zone(pfn, count, 0);
+
+		assert(znum != (size_t) -1);
+
+		for (size_t j = 0; j < count; j++) {
+			freed += zone_frame_free(&zones.info[znum],
+			    pfn - zones.info[znum].base + j);
+		}
+	}
+
+	irq_spinlock_unlock(&zones.lock, false);
+
+	stack->count -= nblocks;
+	memmove(&stack->pfn[0], &stack->pfn[nblocks],
+	    stack->count * sizeof(pfn_t));
+
+	fc->drains++;
+	return freed;
+}
+
+/** Take a block from a frame cache
+ *
+ * If the stack of the requested order is empty, a block of the smallest
+ * available higher order is split and the unused halves are kept in the
+ * stacks of the lower orders.
+ *
+ * The frame cache must be locked.
+ *
+ * @param fc    Frame cache.
+ * @param cls   Memory class.
+ * @param order Order of the block.
+ *
+ * @return First frame of the block or zero if there is no suitable block.
+ *
+ */
+_NO_TRACE static pfn_t frame_cache_pop(frame_cache_t *fc, unsigned int cls,
+    int order)
+{
+	for (int o = order; o < FRAME_CACHE_ORDERS; o++) {
+		frame_cache_stack_t *stack = &fc->stack[cls][o];
+		if (stack->count == 0)
+			continue;
+
+		pfn_t pfn = stack->pfn[--stack->count];
+
+		/* The stacks of orders order .. o - 1 are all empty. */
+		while (o > order) {
+			o--;
+			fc->stack[cls][o].pfn[fc->stack[cls][o].count++] =
+			    pfn + ((pfn_t) 1 << o);
+		}
+
+		return pfn;
+	}
+
+	return 0;
+}
+
+/** Allocate frames from the per-CPU frame cache
+ *
+ * @param count      Number of frames to allocate.
+ * @param lowmem     Allocate from low memory only.
+ * @param constraint Indication of bits that cannot be set in the
+ *                   physical frame number of the first allocated frame.
+ *
+ * @return Physical address of the allocated frames or zero if the cache
+ *         could not satisfy the request.
+ *
+ */
+_NO_TRACE static uintptr_t frame_cache_alloc(size_t count, bool lowmem,
+    pfn_t constraint)
+{
+	frame_cache_t *caches = atomic_load_explicit(&frame_caches,
+	    memory_order_acquire);
+	if (!caches)
+		return 0;
+
+	int order = frame_cache_order(count);
+	if ((order < 0) || ((constraint >> order) != 0))
+		return 0;
+
+	ipl_t ipl = interrupts_disable();
+	if (!CPU) {
+		interrupts_restore(ipl);
+		return 0;
+	}
+
+	frame_cache_t *fc = &caches[CPU->id];
+	irq_spinlock_lock(&fc->lock, false);
+
+	/* Prefer high memory, like try_find_zone() does. */
+	unsigned int first = lowmem ? FRAME_CACHE_LOWMEM : FRAME_CACHE_HIGHMEM;
+	pfn_t pfn = 0;
+
+	for (int cls = first; (cls >= 0) && (pfn == 0); cls--)
+		pfn = frame_cache_pop(fc, cls, order);
+
+	for (int cls = first; (cls >= 0) && (pfn == 0); cls--) {
+		if (frame_cache_refill(fc, cls, order))
+			pfn = frame_cache_pop(fc, cls, order);
+	}
+
+	if (pfn != 0)
+		fc->hits++;
+	else
+		fc->misses++;
+
+	irq_spinlock_unlock(&fc->lock, false);
+	interrupts_restore(ipl);
+
+	return PFN2ADDR(pfn);
+}
+
+/** Free frames to the per-CPU frame cache
+ *
+ * Only blocks which are not shared and which the cache can hold are
+ * accepted. The caller falls back to freeing the frames to their zone
+ * otherwise.
+ *
+ * @param pfn   First frame of the block.
+ * @param count Number of frames in the block.
+ *
+ * @return True if the frames have been freed.
+ *
+ */
+_NO_TRACE static bool frame_cache_free(pfn_t pfn, size_t count)
+{
+	frame_cache_t *caches = atomic_load_explicit(&frame_caches,
+	    memory_order_acquire);
+	if (!caches)
+		return false;
+
+	int order = frame_cache_order(count);
+	if ((order < 0) || ((pfn & (count - 1)) != 0) ||
+	    (is_high_priority(pfn, count)))
+		return false;
+
+	/* Let the slow path wake up the threads waiting for memory. */
+	if (atomic_load_explicit(&mem_avail_waiters, memory_order_relaxed) > 0)
+		return false;
+
+	size_t znum = find_zone(pfn, count, 0);
+	if (znum == (size_t) -1)
+		return false;
+
+	zone_t *zone = &zones.info[znum];
+	if (!(zone->flags & ZONE_AVAILABLE))
+		return false;
+
+	for (size_t i = 0; i < count; i++) {
+		if (zone->frames[pfn - zone->base + i].refcount != 1)
+			return false;
+	}
+
+	unsigned int cls = (zone->flags & ZONE_HIGHMEM) ?
+	    FRAME_CACHE_HIGHMEM : FRAME_CACHE_LOWMEM;
+
+	ipl_t ipl = interrupts_disable();
+	if (!CPU) {
+		interrupts_restore(ipl);
+		return false;
+	}
+
+	frame_cache_t *fc = &caches[CPU->id];
+	irq_spinlock_lock(&fc->lock, false);
+
+	frame_cache_stack_t *stack = &fc->stack[cls][order];
+	if (stack->count == FRAME_CACHE_SIZE)
+		(void) frame_cache_drain(fc, cls, order, FRAME_CACHE_BATCH);
+
+	stack->pfn[stack->count++] = pfn;
+
+	irq_spinlock_unlock(&fc->lock, false);
+	interrupts_restore(ipl);
+
+	return true;
+}
+
+/** Return all frames held in the per-CPU frame caches to the zones
+ *
+ * @return Number of frames returned to the zones.
+ *
+ */
+static size_t frame_cache_reclaim(void)
+{
+	frame_cache_t *caches = atomic_load_explicit(&frame_caches,
+	    memory_order_acquire);
+	if (!caches)
+		return 0;
+
+	size_t freed = 0;
+
+	for (size_t i = 0; i < config.cpu_count; i++) {
+		frame_cache_t *fc = &caches[i];
+
+		irq_spinlock_lock(&fc->lock, true);
+
+		for (unsigned int cls = 0; cls < FRAME_CACHE_CLASSES; cls++) {
+			for (int order = 0; order < FRAME_CACHE_ORDERS; order++) {
+				size_t nblocks = fc->stack[cls][order].count;
+				if (nblocks > 0) {
+					freed += frame_cache_drain(fc, cls,
+					    order, nblocks);
+				}
+			}
+		}
+
+		irq_spinlock_unlock(&fc->lock, true);
+	}
+
+	if (freed > 0)
+		mem_avail_notify(freed);
+
+	return freed;
+}
+
+/** Get the number of frames held in the per-CPU frame caches
+ *
+ * Must not be called with zones.lock held.
+ *
+ * @return Number of cached frames.
+ *
+ */
+static size_t frame_cache_count(void)
+{
+	frame_cache_t *caches = atomic_load_explicit(&frame_caches,
+	    memory_order_acquire);
+	if (!caches)
+		return 0;
+
+	size_t total = 0;
+
+	for (size_t i = 0; i < config.cpu_count; i++) {
+		irq_spinlock_lock(&caches[i].lock, true);
+
+		for (unsigned int cls = 0; cls < FRAME_CACHE_CLASSES; cls++) {
+			for (int order = 0; order < FRAME_CACHE_ORDERS; order++)
+				total += caches[i].stack[cls][order].count << order;
+		}
+
+		irq_spinlock_unlock(&caches[i].lock, true);
+	}
+
+	return total;
+}
+
+/** Enable the per-CPU frame caches
+ *
+ * Must be called after the number of processors is known and after all
+ * zones have been created and merged.
+ *
+ */
+void frame_enable_cpucache(void)
+{
+	frame_cache_t *caches = malloc(sizeof(frame_cache_t) * config.cpu_count);
+	if (!caches) {
+		log(LF_OTHER, LVL_WARN, "Cannot allocate per-CPU frame caches.");
+		return;
+	}
+
+	memset(caches, 0, sizeof(frame_cache_t) * config.cpu_count);
+
+	for (size_t i = 0; i < config.cpu_count; i++)
+		irq_spinlock_initialize(&caches[i].lock, "frame.cache.lock");
+
+	atomic_store_explicit(&frame_caches, caches, memory_order_release);
+}
+
+/** Get statistics of the per-CPU frame caches
+ *
+ * @param stats Structure to fill in.
+ *
+ */
+void frame_cache_stats(stats_frames_t *stats)
+{
+	memset(stats, 0, sizeof(stats_frames_t));
+
+	frame_cache_t *caches = atomic_load_explicit(&frame_caches,
+	    memory_order_acquire);
+	if (!caches)
+		return;
+
+	for (size_t i = 0; i < config.cpu_count; i++) {
+		irq_spinlock_lock(&caches[i].lock, true);
+
+		stats->cache_hits += caches[i].hits;
+		stats->cache_misses += caches[i].misses;
+		stats->cache_refills += caches[i].refills;
+		stats->cache_drains += caches[i].drains;
+		stats->zones_contended += caches[i].contended;
+
+		irq_spinlock_unlock(&caches[i].lock, true);
+	}
+
+	stats->cached = (uint64_t) FRAMES2SIZE(frame_cache_count());
+}
+
 /** Allocate frames of physical memory.
  *
  * @param count      Number of continuous frames to allocate.
@@ -887,24 +1377,46 @@ uintptr_t frame_alloc_generic(size_t count, frame_flags_t flags,
 	if (!(flags & FRAME_NO_RESERVE))
 		reserve_force_alloc(count);
 
-loop:
-	irq_spinlock_lock(&zones.lock, true);
-
 	// TODO: Print diagnostic if neither is explicitly specified.
 	bool lowmem = (flags & FRAME_LOWMEM) || !(flags & FRAME_HIGHMEM);
 
+	/*
+	 * Try the cache of the current CPU first.
+	 */
+	uintptr_t cached = frame_cache_alloc(count, lowmem, frame_constraint);
+	if (cached != 0)
+		return cached;
+
+loop:
+	irq_spinlock_lock(&zones.lock, true);
+
 	/*
 	 * First, find suitable frame zone.
 	 */
 	size_t znum = try_find_zone(count, lowmem, frame_constraint, hint);
 
 	/*
-	 * If no memory, reclaim some slab memory,
-	 * if it does not help, reclaim all.
+	 * If no memory, take back the frames held in the per-CPU caches.
+	 */
+	if (znum == (size_t) -1) {
+		irq_spinlock_unlock(&zones.lock, true);
+		size_t freed = frame_cache_reclaim();
+		irq_spinlock_lock(&zones.lock, true);
+
+		if (freed > 0)
+			znum = try_find_zone(count, lowmem,
+			    frame_constraint, hint);
+	}
+
+	/*
+	 * If still no memory, reclaim some slab memory,
+	 * if it does not help, reclaim all. The slab allocator
+	 * may free the frames to the per-CPU caches.
 	 */
 	if ((znum == (size_t) -1) && (!(flags & FRAME_NO_RECLAIM))) {
 		irq_spinlock_unlock(&zones.lock, true);
 		size_t freed = slab_reclaim(0);
+		freed += frame_cache_reclaim();
 		irq_spinlock_lock(&zones.lock, true);
 
 		if (freed > 0)
@@ -914,6 +1426,7 @@ loop:
 		if (znum == (size_t) -1) {
 			irq_spinlock_unlock(&zones.lock, true);
 			freed = slab_reclaim(SLAB_RECLAIM_ALL);
+			freed += frame_cache_reclaim();
 			irq_spinlock_lock(&zones.lock, true);
 
 			if (freed > 0)
@@ -959,10 +1472,12 @@ loop:
 			mem_avail_req = count;
 
 		size_t gen = mem_avail_gen;
+		atomic_inc(&mem_avail_waiters);
 
 		while (gen == mem_avail_gen)
 			condvar_wait(&mem_avail_cv, &mem_avail_lock);
 
+		atomic_dec(&mem_avail_waiters);
 		irq_spinlock_unlock(&mem_avail_lock, true);
 
 #ifdef CONFIG_DEBUG
@@ -1004,6 +1519,12 @@ void frame_free_generic(uintptr_t start, size_t count, frame_flags_t flags)
 {
 	size_t freed = 0;
 
+	if (frame_cache_free(ADDR2PFN(start), count)) {
+		if (!(flags & FRAME_NO_RESERVE))
+			reserve_free(count);
+		return;
+	}
+
 	irq_spinlock_lock(&zones.lock, true);
 
 	for (size_t i = 0; i < count; i++) {
@@ -1022,19 +1543,7 @@ void frame_free_generic(uintptr_t start, size_t count, frame_flags_t flags)
 	irq_spinlock_unlock(&zones.lock, true);
 
 	/* Signal that some memory has been freed. */
-
-	/* Disabled interrupts needed to prevent deadlock with TLB shootdown. */
-	irq_spinlock_lock(&mem_avail_lock, true);
-
-	if (mem_avail_req > 0)
-		mem_avail_req -= min(mem_avail_req, freed);
-
-	if (mem_avail_req == 0) {
-		mem_avail_gen++;
-		condvar_broadcast(&mem_avail_cv);
-	}
-
-	irq_spinlock_unlock(&mem_avail_lock, true);
+	mem_avail_notify(freed);
 
 	if (!(flags & FRAME_NO_RESERVE))
 		reserve_free(freed);
@@ -1074,6 +1583,40 @@ _NO_TRACE void frame_reference_add(pfn_t pfn)
 	irq_spinlock_unlock(&zones.lock, true);
 }
 
+/** Try to add reference to frame.
+ *
+ * Unlike frame_reference_add(), the frame does not need to be managed by
+ * the frame allocator. Only allocated frames in available zones are
+ * referenced, frames in reserved or firmware zones and free frames are not.
+ *
+ * @param pfn Frame number of the frame.
+ *
+ * @return True if the reference has been added.
+ *
+ */
+_NO_TRACE bool frame_reference_try_add(pfn_t pfn)
+{
+	bool added = false;
+
+	irq_spinlock_lock(&zones.lock, true);
+
+	size_t znum = find_zone(pfn, 1, 0);
+	if ((znum != (size_t) -1) &&
+	    (zones.info[znum].flags & ZONE_AVAILABLE)) {
+		frame_t *frame = &zones.info[znum].frames[pfn -
+		    zones.info[znum].base];
+
+		if (frame->refcount > 0) {
+			frame->refcount++;
+			added = true;
+		}
+	}
+
+	irq_spinlock_unlock(&zones.lock, true);
+
+	return added;
+}
+
 /** Mark given range unavailable in frame zones.
  *
  */
@@ -1186,6 +1729,9 @@ void zones_stats(uint64_t *total, uint64_t *unavail, uint64_t *busy,
 	assert(busy != NULL);
 	assert(free != NULL);
 
+	/* Frames held in the per-CPU caches are busy in their zones. */
+	uint64_t cached = (uint64_t) FRAMES2SIZE(frame_cache_count());
+
 	irq_spinlock_lock(&zones.lock, true);
 
 	*total = 0;
@@ -1204,6 +1750,10 @@ void zones_stats(uint64_t *total, uint64_t *unavail, uint64_t *busy,
 	}
 
 	irq_spinlock_unlock(&zones.lock, true);
+
+	cached = min(cached, *busy);
+	*busy -= cached;
+	*free += cached;
 }
 
 /** Prints list of zones.
@@ -109,6 +109,46 @@ _NO_TRACE void page_mapping_insert(as_t *as, uintptr_t page, uintptr_t frame,
 	memory_barrier();
 }
 
+/** Insert mapping of a large page.
+ *
+ * Map the naturally aligned large page starting at page to the physically
+ * contiguous and equally aligned frames starting at frame. The mapping is
+ * only created if there is no mapping in the whole large page yet and the
+ * page table implementation supports large pages.
+ *
+ * @param as    Address space to which page belongs.
+ * @param page  Virtual address of the large page to be mapped.
+ * @param frame Physical address of the first frame of the large page.
+ * @param flags Flags to be used for mapping.
+ *
+ * @return True if the large page was mapped, false if the caller should fall
+ *         back to mapping individual pages.
+ *
+ */
+_NO_TRACE bool page_mapping_insert_large(as_t *as, uintptr_t page,
+    uintptr_t frame, unsigned int flags)
+{
+	assert(page_table_locked(as));
+
+	assert(page_mapping_operations);
+
+	if (!page_mapping_operations->mapping_insert_large)
+		return false;
+
+#ifdef LARGE_PAGE_SIZE
+	assert(IS_ALIGNED(page, LARGE_PAGE_SIZE));
+	assert(IS_ALIGNED(frame, LARGE_PAGE_SIZE));
+#endif
+
+	if (!page_mapping_operations->mapping_insert_large(as, page, frame,
+	    flags))
+		return false;
+
+	/* Repel prefetched accesses to the old mapping. */
+	memory_barrier();
+	return true;
+}
+
 /** Remove mapping of page.
  *
  * Remove any mapping of page within address space as.
@@ -133,6 +173,32 @@ _NO_TRACE void page_mapping_remove(as_t *as, uintptr_t page)
 	memory_barrier();
 }
 
+/** Split a large page so that page becomes a boundary between mappings.
+ *
+ * A large page may only be removed as a whole. Before removing the pages of
+ * an address range that does not start at a large page boundary, the large
+ * page mapping the start of the range, if any, must be split by this
+ * function. Unlike the removal itself, this must be done before the TLB
+ * shootdown is started, because the page table for the split large page is
+ * allocated in a blocking manner.
+ *
+ * @param as   Address space to which page belongs.
+ * @param page Virtual address of the first page of the range.
+ *
+ */
+_NO_TRACE void page_mapping_split(as_t *as, uintptr_t page)
+{
+	assert(page_table_locked(as));
+
+	assert(page_mapping_operations);
+
+	if (!page_mapping_operations->mapping_split)
+		return;
+
+	page_mapping_operations->mapping_split(as,
+	    ALIGN_DOWN(page, PAGE_SIZE));
+}
+
 /** Find mapping for virtual page.
  *
  * @param as       Address space to which page belongs.
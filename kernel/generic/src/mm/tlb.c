@@ -37,10 +37,15 @@
  * The algorithm implemented here is based on the CMU TLB shootdown
  * algorithm and is further simplified (e.g. all CPUs receive all TLB
  * shootdown messages).
+ *
+ * Only processors using the address space concerned by a message are
+ * interrupted and waited for. The others merely queue the message and
+ * process it before they switch to another address space.
  */
 
 #include <mm/tlb.h>
 #include <mm/asid.h>
+#include <mm/page.h>
 #include <arch/mm/tlb.h>
 #include <assert.h>
 #include <smp/ipi.h>
@@ -57,6 +62,82 @@ void tlb_init(void)
 	tlb_arch_init();
 }
 
+/** Initialize a batch of TLB invalidations.
+ *
+ * @param batch Batch to initialize.
+ * @param asid  Address space the batch belongs to.
+ *
+ */
+void tlb_batch_init(tlb_batch_t *batch, asid_t asid)
+{
+	batch->asid = asid;
+	batch->pages = 0;
+	batch->count = 0;
+}
+
+/** Add a page range to a batch of TLB invalidations.
+ *
+ * Adjacent ranges are merged. When the batch grows too large, it is turned
+ * into an invalidation of the whole address space.
+ *
+ * @param batch Batch of TLB invalidations.
+ * @param page  Address of the first page to invalidate.
+ * @param count Number of pages to invalidate.
+ *
+ */
+void tlb_batch_add(tlb_batch_t *batch, uintptr_t page, size_t count)
+{
+	if (count == 0)
+		return;
+
+	if ((batch->count == 1) && (batch->msgs[0].type == TLB_INVL_ASID))
+		return;
+
+	batch->pages += count;
+
+	tlb_shootdown_msg_t *last = (batch->count > 0) ?
+	    &batch->msgs[batch->count - 1] : NULL;
+
+	if ((batch->pages > TLB_BATCH_MAX_PAGES) ||
+	    ((batch->count == TLB_BATCH_RANGES) &&
+	    (last->page + P2SZ(last->count) != page))) {
+		batch->count = 1;
+		batch->msgs[0].type = TLB_INVL_ASID;
+		batch->msgs[0].asid = batch->asid;
+		batch->msgs[0].page = 0;
+		batch->msgs[0].count = 0;
+		return;
+	}
+
+	if ((last != NULL) && (last->page + P2SZ(last->count) == page)) {
+		last->count += count;
+		return;
+	}
+
+	tlb_shootdown_msg_t *msg = &batch->msgs[batch->count++];
+	msg->type = TLB_INVL_PAGES;
+	msg->asid = batch->asid;
+	msg->page = page;
+	msg->count = count;
+}
+
+/** Perform a batch of TLB invalidations on the current processor.
+ *
+ * @param batch Batch of TLB invalidations.
+ *
+ */
+void tlb_batch_invalidate(tlb_batch_t *batch)
+{
+	for (size_t i = 0; i < batch->count; i++) {
+		tlb_shootdown_msg_t *msg = &batch->msgs[i];
+
+		if (msg->type == TLB_INVL_ASID)
+			tlb_invalidate_asid(msg->asid);
+		else
+			tlb_invalidate_pages(msg->asid, msg->page, msg->count);
+	}
+}
+
 #ifdef CONFIG_SMP
 
 /**
@@ -67,26 +148,70 @@ void tlb_init(void)
  */
 IRQ_SPINLOCK_STATIC_INITIALIZE(tlblock);
 
-/** Send TLB shootdown message.
+/** Enqueue TLB shootdown message for a processor.
  *
- * This function attempts to deliver TLB shootdown message
- * to all other processors.
+ * @param cpu Processor whose tlb_lock is held.
+ * @param msg Message to enqueue.
  *
- * @param type  Type describing scope of shootdown.
- * @param asid  Address space, if required by type.
- * @param page  Virtual page address, if required by type.
- * @param count Number of pages, if required by type.
+ */
+static void tlb_shootdown_enqueue(cpu_t *cpu, const tlb_shootdown_msg_t *msg)
+{
+	assert(irq_spinlock_locked(&cpu->tlb_lock));
+
+	if (cpu->tlb_messages_count == TLB_MESSAGE_QUEUE_LEN) {
+		/*
+		 * The message queue is full.
+		 * Erase the queue and store one TLB_INVL_ALL message.
+		 */
+		cpu->tlb_messages_count = 1;
+		cpu->tlb_messages[0].type = TLB_INVL_ALL;
+		cpu->tlb_messages[0].asid = ASID_INVALID;
+		cpu->tlb_messages[0].page = 0;
+		cpu->tlb_messages[0].count = 0;
+	} else if ((cpu->tlb_messages_count == 0) ||
+	    (cpu->tlb_messages[0].type != TLB_INVL_ALL)) {
+		/*
+		 * Enqueue the message.
+		 */
+		cpu->tlb_messages[cpu->tlb_messages_count++] = *msg;
+	}
+}
+
+/** Check whether a processor must process a message synchronously.
+ *
+ * Processors that are not using the address space concerned by the message
+ * process it before switching to another address space.
+ *
+ * @param cpu Processor whose tlb_lock is held.
+ * @param msg TLB shootdown message.
+ *
+ * @return True if the sender must wait for the processor.
+ *
+ */
+static bool tlb_shootdown_sync(cpu_t *cpu, const tlb_shootdown_msg_t *msg)
+{
+	assert(irq_spinlock_locked(&cpu->tlb_lock));
+
+	return (msg->type == TLB_INVL_ALL) || (msg->asid == ASID_KERNEL) ||
+	    (msg->asid == cpu->tlb_asid);
+}
+
+/** Send TLB shootdown messages.
+ *
+ * @param msgs  Messages to send.
+ * @param count Number of messages.
  *
  * @return The interrupt priority level as it existed prior to this call.
  *
  */
-ipl_t tlb_shootdown_start(tlb_invalidate_type_t type, asid_t asid,
-    uintptr_t page, size_t count)
+static ipl_t tlb_shootdown_send(const tlb_shootdown_msg_t *msgs, size_t count)
 {
 	ipl_t ipl = interrupts_disable();
 	CPU->tlb_active = false;
 	irq_spinlock_lock(&tlblock, false);
 
+	bool ipi = false;
+
 	size_t i;
 	for (i = 0; i < config.cpu_count; i++) {
 		if (i == CPU->id)
@@ -95,40 +220,73 @@ ipl_t tlb_shootdown_start(tlb_invalidate_type_t type, asid_t asid,
 		cpu_t *cpu = &cpus[i];
 
 		irq_spinlock_lock(&cpu->tlb_lock, false);
-		if (cpu->tlb_messages_count == TLB_MESSAGE_QUEUE_LEN) {
-			/*
-			 * The message queue is full.
-			 * Erase the queue and store one TLB_INVL_ALL message.
-			 */
-			cpu->tlb_messages_count = 1;
-			cpu->tlb_messages[0].type = TLB_INVL_ALL;
-			cpu->tlb_messages[0].asid = ASID_INVALID;
-			cpu->tlb_messages[0].page = 0;
-			cpu->tlb_messages[0].count = 0;
-		} else {
-			/*
-			 * Enqueue the message.
-			 */
-			size_t idx = cpu->tlb_messages_count++;
-			cpu->tlb_messages[idx].type = type;
-			cpu->tlb_messages[idx].asid = asid;
-			cpu->tlb_messages[idx].page = page;
-			cpu->tlb_messages[idx].count = count;
+		for (size_t j = 0; j < count; j++) {
+			tlb_shootdown_enqueue(cpu, &msgs[j]);
+			if (tlb_shootdown_sync(cpu, &msgs[j]))
+				cpu->tlb_sync = true;
 		}
+
+		if (cpu->tlb_sync)
+			ipi = true;
 		irq_spinlock_unlock(&cpu->tlb_lock, false);
 	}
 
+	if (!ipi)
+		return ipl;
+
 	tlb_shootdown_ipi_send();
 
 busy_wait:
 	for (i = 0; i < config.cpu_count; i++) {
-		if (cpus[i].tlb_active)
+		if ((i != CPU->id) && (cpus[i].tlb_sync) &&
+		    (cpus[i].tlb_active))
 			goto busy_wait;
 	}
 
 	return ipl;
 }
 
+/** Send TLB shootdown message.
+ *
+ * This function attempts to deliver TLB shootdown message
+ * to all other processors.
+ *
+ * @param type  Type describing scope of shootdown.
+ * @param asid  Address space, if required by type.
+ * @param page  Virtual page address, if required by type.
+ * @param count Number of pages, if required by type.
+ *
+ * @return The interrupt priority level as it existed prior to this call.
+ *
+ */
+ipl_t tlb_shootdown_start(tlb_invalidate_type_t type, asid_t asid,
+    uintptr_t page, size_t count)
+{
+	tlb_shootdown_msg_t msg = {
+		.type = type,
+		.asid = asid,
+		.page = page,
+		.count = count
+	};
+
+	return tlb_shootdown_send(&msg, 1);
+}
+
+/** Send TLB shootdown messages for a batch of TLB invalidations.
+ *
+ * The sequence is to be finished by tlb_shootdown_finalize() after the
+ * batch is invalidated locally using tlb_batch_invalidate().
+ *
+ * @param batch Batch of TLB invalidations.
+ *
+ * @return The interrupt priority level as it existed prior to this call.
+ *
+ */
+ipl_t tlb_batch_shootdown_start(tlb_batch_t *batch)
+{
+	return tlb_shootdown_send(batch->msgs, batch->count);
+}
+
 /** Finish TLB shootdown sequence.
  *
  * @param ipl Previous interrupt priority level.
@@ -146,13 +304,13 @@ void tlb_shootdown_ipi_send(void)
 	ipi_broadcast(VECTOR_TLB_SHOOTDOWN_IPI);
 }
 
-/** Receive TLB shootdown message.
+/** Process TLB shootdown messages queued for the current processor.
+ *
+ * Wait for the sender to finish its TLB shootdown sequence first.
  *
  */
-void tlb_shootdown_ipi_recv(void)
+static void tlb_shootdown_process(void)
 {
-	assert(CPU);
-
 	CPU->tlb_active = false;
 	irq_spinlock_lock(&tlblock, false);
 	irq_spinlock_unlock(&tlblock, false);
@@ -188,10 +346,56 @@ void tlb_shootdown_ipi_recv(void)
 	}
 
 	CPU->tlb_messages_count = 0;
+	CPU->tlb_sync = false;
 	irq_spinlock_unlock(&CPU->tlb_lock, false);
 	CPU->tlb_active = true;
 }
 
+/** Receive TLB shootdown message.
+ *
+ */
+void tlb_shootdown_ipi_recv(void)
+{
+	assert(CPU);
+
+	irq_spinlock_lock(&CPU->tlb_lock, false);
+	bool sync = CPU->tlb_sync;
+	irq_spinlock_unlock(&CPU->tlb_lock, false);
+
+	/*
+	 * The IPI is broadcast, but the messages may concern only address
+	 * spaces this processor is not using. These can wait until the next
+	 * address space switch.
+	 */
+	if (sync)
+		tlb_shootdown_process();
+}
+
+/** Prepare the current processor for switching to an address space.
+ *
+ * Messages that were queued lazily while the processor was not using their
+ * address space are processed now, before the new address space is installed.
+ * From now on, messages concerning the new address space are processed
+ * synchronously.
+ *
+ * Interrupts must be disabled.
+ *
+ * @param asid ASID of the address space being switched to.
+ *
+ */
+void tlb_shootdown_as_switch(asid_t asid)
+{
+	assert(interrupts_disabled());
+
+	irq_spinlock_lock(&CPU->tlb_lock, false);
+	CPU->tlb_asid = asid;
+	bool pending = (CPU->tlb_messages_count > 0);
+	irq_spinlock_unlock(&CPU->tlb_lock, false);
+
+	if (pending)
+		tlb_shootdown_process();
+}
+
 #endif /* CONFIG_SMP */
 
 /** @}
@@ -64,6 +64,7 @@
 #include <stdio.h>
 #include <log.h>
 #include <stacktrace.h>
+#include <macros.h>
 
 atomic_size_t nrdy;  /**< Number of ready threads in the system. */
 
@@ -151,6 +152,191 @@ static thread_t *try_find_thread(int *rq_index)
 	return NULL;
 }
 
+#ifdef CONFIG_SMP
+
+/** Check whether a ready thread is likely to have its working set cached
+ *
+ * Threads which ran on their CPU very recently are left there if there
+ * is any other choice, as migrating them would throw the cache away.
+ *
+ * The cycle stamp of the thread comes from the CPU it last ran on, which
+ * is the CPU whose run queue it is in unless it has been stolen. It is
+ * compared with the time that CPU last started a thread, so that cycle
+ * counters of different CPUs need not agree. If that CPU has not started
+ * another thread since, the thread is considered hot.
+ *
+ * @param thread Ready thread, not stolen since it last ran.
+ * @param cpu    CPU whose run queue the thread is in.
+ *
+ * @return True if the thread last ran less than SCHED_CACHE_HOT_USEC before
+ *         @a cpu switched to another thread.
+ *
+ */
+static bool thread_cache_hot(thread_t *thread, cpu_t *cpu)
+{
+	uint32_t window = (uint32_t) cpu->frequency_mhz * SCHED_CACHE_HOT_USEC;
+	uint32_t now = atomic_load_explicit(&cpu->run_cycle,
+	    memory_order_relaxed);
+	int32_t age = (int32_t) (now - (uint32_t) thread->last_cycle);
+
+	return age < (int32_t) window;
+}
+
+/** Move ready threads from another CPU's run queue to the local one
+ *
+ * The victim queue is searched from the back, so that threads which
+ * have waited the shortest time, and are least likely to run on the
+ * victim CPU soon, are taken first. All the threads are moved while the
+ * victim queue lock is held only once.
+ *
+ * @param old_cpu  CPU to steal from.
+ * @param i        Index of the run queue to steal from.
+ * @param count    Maximum number of threads to steal.
+ * @param take_hot If false, cache-hot threads are left alone.
+ *
+ * @return Number of threads stolen.
+ *
+ */
+static size_t steal_threads_from(cpu_t *old_cpu, int i, size_t count,
+    bool take_hot)
+{
+	runq_t *old_rq = &old_cpu->rq[i];
+	runq_t *new_rq = &CPU->rq[i];
+	size_t stolen = 0;
+
+	list_t list;
+	list_initialize(&list);
+
+	ipl_t ipl = interrupts_disable();
+
+	irq_spinlock_lock(&old_rq->lock, false);
+
+	/*
+	 * If fpu_owner is any thread in the list, its store is seen here thanks to
+	 * the runqueue lock.
+	 */
+	thread_t *fpu_owner = atomic_load_explicit(&old_cpu->fpu_owner,
+	    memory_order_relaxed);
+
+	/* Search rq from the back */
+	link_t *link = list_last(&old_rq->rq);
+	while ((link != NULL) && (stolen < count)) {
+		thread_t *thread = list_get_instance(link, thread_t, rq_link);
+		link = list_prev(link, &old_rq->rq);
+
+		/*
+		 * Do not steal CPU-wired threads, threads
+		 * already stolen, threads for which migration
+		 * was temporarily disabled or threads whose
+		 * FPU context is still in the CPU.
+		 */
+		if (thread->stolen || thread->nomigrate || thread == fpu_owner)
+			continue;
+
+		if (!take_hot && thread_cache_hot(thread, old_cpu))
+			continue;
+
+		thread->stolen = true;
+		atomic_set_unordered(&thread->cpu, CPU);
+
+#ifdef KCPULB_VERBOSE
+		log(LF_OTHER, LVL_DEBUG,
+		    "kcpulb%u: TID %" PRIu64 " -> cpu%u, "
+		    "nrdy=%ld, avg=%ld", CPU->id, thread->tid,
+		    CPU->id, atomic_load(&CPU->nrdy),
+		    atomic_load(&nrdy) / config.cpu_active);
+#endif
+
+		/* Remove thread from ready queue. */
+		old_rq->n--;
+		list_remove(&thread->rq_link);
+		list_append(&thread->rq_link, &list);
+		stolen++;
+	}
+
+	irq_spinlock_unlock(&old_rq->lock, false);
+
+	if (stolen > 0) {
+		/* Append threads to local queue. */
+		irq_spinlock_lock(&new_rq->lock, false);
+		list_concat(&new_rq->rq, &list);
+		new_rq->n += stolen;
+		irq_spinlock_unlock(&new_rq->lock, false);
+
+		atomic_fetch_sub(&old_cpu->nrdy, stolen);
+		atomic_fetch_add(&CPU->nrdy, stolen);
+	}
+
+	interrupts_restore(ipl);
+	return stolen;
+}
+
+/** Steal a batch of threads from a CPU
+ *
+ * Low-priority queues are searched first, the same way kcpulb does it.
+ * Cache-cold threads are preferred over cache-hot ones.
+ *
+ * @param cpu   CPU to steal from.
+ * @param count Maximum number of threads to steal.
+ *
+ * @return Number of threads stolen.
+ *
+ */
+static size_t steal_threads(cpu_t *cpu, size_t count)
+{
+	size_t stolen = 0;
+
+	for (int pass = 0; pass < 2; pass++) {
+		for (int rq = RQ_COUNT - 1; rq >= 0; rq--) {
+			stolen += steal_threads_from(cpu, rq, count - stolen,
+			    pass > 0);
+			if (stolen == count)
+				return stolen;
+		}
+	}
+
+	return stolen;
+}
+
+/** Steal work for a CPU which is about to go idle
+ *
+ * The busiest CPU is chosen as the victim. The other CPUs are scanned
+ * starting with the next CPU ID, so that on ties the nearest one wins
+ * and concurrently idle CPUs do not all pick the same victim. At most
+ * half of the victim's ready threads are taken, up to SCHED_STEAL_BATCH.
+ *
+ * @return True if any thread was stolen.
+ *
+ */
+static bool steal_on_idle(void)
+{
+	assert(interrupts_disabled());
+
+	if (atomic_load(&nrdy) == 0)
+		return false;
+
+	cpu_t *victim = NULL;
+	size_t victim_nrdy = 1;
+
+	for (size_t i = 1; i < config.cpu_active; i++) {
+		cpu_t *cpu = &cpus[(CPU->id + i) % config.cpu_active];
+		size_t rdy = atomic_load(&cpu->nrdy);
+
+		if (rdy > victim_nrdy) {
+			victim = cpu;
+			victim_nrdy = rdy;
+		}
+	}
+
+	if (victim == NULL)
+		return false;
+
+	size_t count = min(victim_nrdy / 2, (size_t) SCHED_STEAL_BATCH);
+	return steal_threads(victim, count) > 0;
+}
+
+#endif /* CONFIG_SMP */
+
 /** Get thread to be scheduled
  *
  * Get the optimal thread to be scheduled
@@ -171,6 +357,15 @@ static thread_t *find_best_thread(int *rq_index)
 		if (thread != NULL)
 			return thread;
 
+#ifdef CONFIG_SMP
+		/*
+		 * Rather than waiting for kcpulb, try to take over some work
+		 * from a busy CPU right away.
+		 */
+		if (steal_on_idle())
+			continue;
+#endif
+
 		/*
 		 * For there was nothing to run, the CPU goes to sleep
 		 * until a hardware interrupt or an IPI comes.
@@ -362,6 +557,9 @@ static void prepare_to_run_thread(int rq_index)
 
 	/* Save current CPU cycle */
 	THREAD->last_cycle = get_cycle();
+	atomic_store_explicit(&CPU->run_cycle, (uint32_t) THREAD->last_cycle,
+	    memory_order_relaxed);
+	THREAD->run_tick = CPU_LOCAL->current_clock_tick;
 }
 
 static void add_to_rq(thread_t *thread, cpu_t *cpu, int i)
@@ -398,13 +596,53 @@ static void thread_requeue_preempted(thread_t *thread)
 	add_to_rq(thread, CPU, prio);
 }
 
+/** Account the time THREAD has just run
+ *
+ * Runs accumulate until the thread goes to sleep, at which point the
+ * whole burst is folded into the thread's burst average.
+ *
+ * @param new_state State the thread is leaving the CPU in.
+ *
+ */
+static void thread_account_burst(state_t new_state)
+{
+	THREAD->burst_ticks += CPU_LOCAL->current_clock_tick - THREAD->run_tick;
+
+	if (new_state != Sleeping)
+		return;
+
+	THREAD->burst_avg = (THREAD->burst_avg * (SCHED_BURST_DECAY - 1) +
+	    (THREAD->burst_ticks << SCHED_BURST_SHIFT)) / SCHED_BURST_DECAY;
+	THREAD->burst_ticks = 0;
+}
+
+/** Choose the run queue for a thread which is waking up
+ *
+ * A thread which has been running for k clock ticks between sleeps on
+ * average is queued into run queue k, whose time quantum is just long
+ * enough for such a burst.
+ *
+ * @param thread Thread which is waking up.
+ *
+ * @return Index of the run queue.
+ *
+ */
+static int wakeup_priority(thread_t *thread)
+{
+	uint64_t ticks = thread->burst_avg >> SCHED_BURST_SHIFT;
+
+	return (ticks < RQ_COUNT) ? (int) ticks : RQ_COUNT - 1;
+}
+
 void thread_requeue_sleeping(thread_t *thread)
 {
 	ipl_t ipl = interrupts_disable();
 
 	assert(atomic_get_unordered(&thread->state) == Sleeping || atomic_get_unordered(&thread->state) == Entering);
 
-	atomic_set_unordered(&thread->priority, 0);
+	int prio = wakeup_priority(thread);
+
+	atomic_set_unordered(&thread->priority, prio);
 	atomic_set_unordered(&thread->state, Ready);
 
 	/* Prefer the CPU on which the thread ran last */
@@ -415,7 +653,7 @@ void thread_requeue_sleeping(thread_t *thread)
 		atomic_set_unordered(&thread->cpu, CPU);
 	}
 
-	add_to_rq(thread, cpu, 0);
+	add_to_rq(thread, cpu, prio);
 
 	interrupts_restore(ipl);
 }
@@ -493,6 +731,7 @@ void scheduler_enter(state_t new_state)
 
 	/* Update thread kernel accounting */
 	atomic_time_increment(&THREAD->kcycles, get_cycle() - THREAD->last_cycle);
+	thread_account_burst(new_state);
 
 	fpu_cleanup();
 
@@ -614,72 +853,6 @@ void thread_main_func(void)
 
 #ifdef CONFIG_SMP
 
-static thread_t *steal_thread_from(cpu_t *old_cpu, int i)
-{
-	runq_t *old_rq = &old_cpu->rq[i];
-	runq_t *new_rq = &CPU->rq[i];
-
-	ipl_t ipl = interrupts_disable();
-
-	irq_spinlock_lock(&old_rq->lock, false);
-
-	/*
-	 * If fpu_owner is any thread in the list, its store is seen here thanks to
-	 * the runqueue lock.
-	 */
-	thread_t *fpu_owner = atomic_load_explicit(&old_cpu->fpu_owner,
-	    memory_order_relaxed);
-
-	/* Search rq from the back */
-	list_foreach_rev(old_rq->rq, rq_link, thread_t, thread) {
-
-		/*
-		 * Do not steal CPU-wired threads, threads
-		 * already stolen, threads for which migration
-		 * was temporarily disabled or threads whose
-		 * FPU context is still in the CPU.
-		 */
-		if (thread->stolen || thread->nomigrate || thread == fpu_owner) {
-			continue;
-		}
-
-		thread->stolen = true;
-		atomic_set_unordered(&thread->cpu, CPU);
-
-		/*
-		 * Ready thread on local CPU
-		 */
-
-#ifdef KCPULB_VERBOSE
-		log(LF_OTHER, LVL_DEBUG,
-		    "kcpulb%u: TID %" PRIu64 " -> cpu%u, "
-		    "nrdy=%ld, avg=%ld", CPU->id, thread->tid,
-		    CPU->id, atomic_load(&CPU->nrdy),
-		    atomic_load(&nrdy) / config.cpu_active);
-#endif
-
-		/* Remove thread from ready queue. */
-		old_rq->n--;
-		list_remove(&thread->rq_link);
-		irq_spinlock_unlock(&old_rq->lock, false);
-
-		/* Append thread to local queue. */
-		irq_spinlock_lock(&new_rq->lock, false);
-		list_append(&thread->rq_link, &new_rq->rq);
-		new_rq->n++;
-		irq_spinlock_unlock(&new_rq->lock, false);
-
-		atomic_dec(&old_cpu->nrdy);
-		atomic_inc(&CPU->nrdy);
-		interrupts_restore(ipl);
-		return thread;
-	}
-
-	irq_spinlock_unlock(&old_rq->lock, false);
-	interrupts_restore(ipl);
-	return NULL;
-}
-
 /** Load balancing thread
  *
  * SMP load balancing thread, supervising thread supplies
@@ -695,9 +868,10 @@ void kcpulb(void *arg)
 
 loop:
 	/*
-	 * Work in 1s intervals.
+	 * Idle CPUs steal work on their own in find_best_thread(), so this
+	 * only evens out the queues of CPUs which are all busy.
 	 */
-	thread_sleep(1);
+	thread_usleep(KCPULB_INTERVAL_USEC);
 
 not_satisfied:
 	/*
@@ -721,24 +895,29 @@ not_satisfied:
 	size_t acpu;
 	int rq;
 
-	for (rq = RQ_COUNT - 1; rq >= 0; rq--) {
-		for (acpu = 0; acpu < config.cpu_active; acpu++) {
-			cpu_t *cpu = &cpus[acpu];
-
-			/*
-			 * Not interested in ourselves.
-			 * Doesn't require interrupt disabling for kcpulb has
-			 * THREAD_FLAG_WIRED.
-			 *
-			 */
-			if (CPU == cpu)
-				continue;
-
-			if (atomic_load(&cpu->nrdy) <= average)
-				continue;
-
-			if (steal_thread_from(cpu, rq) && --count == 0)
-				goto satisfied;
+	for (int pass = 0; pass < 2; pass++) {
+		for (rq = RQ_COUNT - 1; rq >= 0; rq--) {
+			for (acpu = 0; acpu < config.cpu_active; acpu++) {
+				cpu_t *cpu = &cpus[acpu];
+
+				/*
+				 * Not interested in ourselves.
+				 * Doesn't require interrupt disabling for kcpulb has
+				 * THREAD_FLAG_WIRED.
+				 *
+				 */
+				if (CPU == cpu)
+					continue;
+
+				rdy = atomic_load(&cpu->nrdy);
+				if (rdy <= average)
+					continue;
+
+				count -= steal_threads_from(cpu, rq,
+				    min(count, rdy - average), pass > 0);
+				if (count == 0)
+					goto satisfied;
+			}
 		}
 	}
 
@@ -48,6 +48,7 @@
 #include <synch/spinlock.h>
 #include <synch/waitq.h>
 #include <synch/syswaitq.h>
+#include <synch/futex.h>
 #include <cpu.h>
 #include <str.h>
 #include <context.h>
@@ -261,6 +262,9 @@ thread_t *thread_create(void (*func)(void *), void *arg, task_t *task,
 	thread->uncounted =
 	    ((flags & THREAD_FLAG_UNCOUNTED) == THREAD_FLAG_UNCOUNTED);
 	atomic_init(&thread->priority, 0);
+	thread->run_tick = 0;
+	thread->burst_ticks = 0;
+	thread->burst_avg = 0;
 	atomic_init(&thread->cpu, NULL);
 	thread->stolen = false;
 	thread->uspace =
@@ -446,6 +450,7 @@ void thread_exit(void)
 			 */
 			ipc_cleanup();
 			sys_waitq_task_cleanup();
+			futex_task_cleanup();
 			LOG("Cleanup of task %" PRIu64 " completed.", TASK->taskid);
 		}
 	}
@@ -0,0 +1,291 @@
+/*
+ * Copyright (c) 2026 The HelenOS Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup kernel_sync
+ * @{
+ */
+
+/**
+ * @file
+ * @brief Address-keyed futex wait queues.
+ *
+ * A user space futex is identified by its address in the caller's address
+ * space. The kernel keeps a wait queue only for futexes which somebody is
+ * sleeping on, waking up or owes a wakeup to. These live in a fixed table
+ * of buckets hashed by the address space and the address, so creating a
+ * futex in user space needs no system call and no kernel memory.
+ *
+ * The wait queues have the same semantics as the ones behind waitq
+ * capabilities, including the wakeup balance needed by the user space
+ * futex protocol. A wait queue is freed as soon as nobody is using it and
+ * its wakeup balance is back at zero. Wait queues left with an unconsumed
+ * wakeup are freed when their task exits.
+ *
+ * The user space futex protocol cannot cope with a failed sleep or wakeup,
+ * so the wait queues are allocated with a blocking allocation and neither
+ * operation fails for lack of memory.
+ */
+
+#include <synch/futex.h>
+#include <synch/spinlock.h>
+#include <synch/waitq.h>
+#include <adt/hash.h>
+#include <adt/list.h>
+#include <abi/synch.h>
+#include <arch.h>
+#include <assert.h>
+#include <errno.h>
+#include <mm/as.h>
+#include <mm/slab.h>
+#include <proc/task.h>
+
+#include <stdint.h>
+
+/** Number of buckets in the futex table (a power of two). */
+#define FUTEX_BUCKETS  256
+
+typedef struct {
+	link_t link;
+
+	/** Address space of the futex. */
+	as_t *as;
+	/** User space address of the futex. */
+	uspace_addr_t uaddr;
+
+	/** Number of threads using the wait queue. Protected by bucket lock. */
+	size_t refcount;
+
+	waitq_t wq;
+} futex_t;
+
+typedef struct {
+	IRQ_SPINLOCK_DECLARE(lock);
+	list_t futexes;
+} futex_bucket_t;
+
+static futex_bucket_t futex_table[FUTEX_BUCKETS];
+static slab_cache_t *futex_cache;
+
+/** Initialize the futex table. */
+void futex_init(void)
+{
+	for (size_t i = 0; i < FUTEX_BUCKETS; i++) {
+		irq_spinlock_initialize(&futex_table[i].lock, "futex.bucket.lock");
+		list_initialize(&futex_table[i].futexes);
+	}
+
+	futex_cache = slab_cache_create("futex_t", sizeof(futex_t), 0, NULL,
+	    NULL, 0);
+}
+
+static futex_bucket_t *futex_bucket(as_t *as, uspace_addr_t uaddr)
+{
+	size_t hash = hash_combine(hash_mix((size_t) as), (size_t) uaddr);
+	return &futex_table[hash_mix(hash) & (FUTEX_BUCKETS - 1)];
+}
+
+static futex_t *futex_find(futex_bucket_t *bucket, as_t *as,
+    uspace_addr_t uaddr)
+{
+	list_foreach(bucket->futexes, link, futex_t, futex) {
+		if ((futex->as == as) && (futex->uaddr == uaddr))
+			return futex;
+	}
+
+	return NULL;
+}
+
+/** Get a reference to the wait queue of a futex, creating it if necessary
+ *
+ * @param uaddr User space address of the futex in the current address space.
+ *
+ * @return Futex with an extra reference.
+ *
+ */
+static futex_t *futex_get(uspace_addr_t uaddr)
+{
+	futex_bucket_t *bucket = futex_bucket(AS, uaddr);
+	futex_t *new = NULL;
+
+	while (true) {
+		irq_spinlock_lock(&bucket->lock, true);
+
+		futex_t *found = futex_find(bucket, AS, uaddr);
+		if (found == NULL && new != NULL) {
+			list_append(&new->link, &bucket->futexes);
+			found = new;
+			new = NULL;
+		}
+
+		if (found != NULL) {
+			found->refcount++;
+			irq_spinlock_unlock(&bucket->lock, true);
+
+			if (new != NULL)
+				slab_free(futex_cache, new);
+
+			return found;
+		}
+
+		irq_spinlock_unlock(&bucket->lock, true);
+
+		/* Allocate outside of the bucket lock and look again. */
+		new = slab_alloc(futex_cache, 0);
+
+		link_initialize(&new->link);
+		new->as = AS;
+		new->uaddr = uaddr;
+		new->refcount = 0;
+		waitq_initialize(&new->wq);
+	}
+}
+
+/** Drop a reference to the wait queue of a futex
+ *
+ * The wait queue is freed if it is not used anymore and it neither keeps
+ * a missed wakeup nor owes one.
+ *
+ * @param futex Futex obtained from futex_get().
+ *
+ */
+static void futex_put(futex_t *futex)
+{
+	futex_bucket_t *bucket = futex_bucket(futex->as, futex->uaddr);
+	bool idle = false;
+
+	irq_spinlock_lock(&bucket->lock, true);
+
+	assert(futex->refcount > 0);
+	if (--futex->refcount == 0) {
+		irq_spinlock_lock(&futex->wq.lock, false);
+		assert(list_empty(&futex->wq.sleepers));
+		idle = (futex->wq.wakeup_balance == 0);
+		irq_spinlock_unlock(&futex->wq.lock, false);
+
+		if (idle)
+			list_remove(&futex->link);
+	}
+
+	irq_spinlock_unlock(&bucket->lock, true);
+
+	if (idle)
+		slab_free(futex_cache, futex);
+}
+
+/** Free all futex wait queues of the exiting task
+ *
+ * Only wait queues which were left with an unbalanced wakeup can remain
+ * at this point.
+ */
+void futex_task_cleanup(void)
+{
+	as_t *as = TASK->as;
+
+	for (size_t i = 0; i < FUTEX_BUCKETS; i++) {
+		futex_bucket_t *bucket = &futex_table[i];
+		list_t garbage;
+		list_initialize(&garbage);
+
+		irq_spinlock_lock(&bucket->lock, true);
+		list_foreach_safe(bucket->futexes, cur, next) {
+			futex_t *futex = list_get_instance(cur, futex_t, link);
+			if (futex->as != as)
+				continue;
+
+			assert(futex->refcount == 0);
+			list_remove(&futex->link);
+			list_append(&futex->link, &garbage);
+		}
+		irq_spinlock_unlock(&bucket->lock, true);
+
+		while (!list_empty(&garbage)) {
+			futex_t *futex = list_get_instance(list_first(&garbage),
+			    futex_t, link);
+			list_remove(&futex->link);
+			slab_free(futex_cache, futex);
+		}
+	}
+}
+
+/** Sleep on a futex
+ *
+ * @param uaddr    User space address of the futex.
+ * @param timeout  Timeout in microseconds.
+ * @param flags    Flags from SYNCH_FLAGS_* family. SYNCH_FLAGS_INTERRUPTIBLE is
+ *                 always implied.
+ *
+ * @return         Error code.
+ */
+sys_errno_t sys_futex_sleep(uspace_addr_t uaddr, uint32_t timeout,
+    unsigned int flags)
+{
+	if ((uaddr == 0) || (uaddr % sizeof(int) != 0))
+		return (sys_errno_t) EINVAL;
+
+	futex_t *futex = futex_get(uaddr);
+
+#ifdef CONFIG_UDEBUG
+	udebug_stoppable_begin();
+#endif
+
+	errno_t rc = _waitq_sleep_timeout(&futex->wq, timeout,
+	    SYNCH_FLAGS_INTERRUPTIBLE | flags);
+
+#ifdef CONFIG_UDEBUG
+	udebug_stoppable_end();
+#endif
+
+	futex_put(futex);
+
+	return (sys_errno_t) rc;
+}
+
+/** Wake up a thread sleeping on a futex
+ *
+ * If nobody is sleeping, the wakeup is kept for the next sleeper.
+ *
+ * @param uaddr  User space address of the futex.
+ *
+ * @return       Error code.
+ */
+sys_errno_t sys_futex_wakeup(uspace_addr_t uaddr)
+{
+	if ((uaddr == 0) || (uaddr % sizeof(int) != 0))
+		return (sys_errno_t) EINVAL;
+
+	futex_t *futex = futex_get(uaddr);
+
+	waitq_wake_one(&futex->wq);
+
+	futex_put(futex);
+
+	return (sys_errno_t) EOK;
+}
+
+/** @}
+ */
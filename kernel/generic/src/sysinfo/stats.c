@@ -43,6 +43,7 @@
 #include <synch/mutex.h>
 #include <time/clock.h>
 #include <mm/frame.h>
+#include <mm/page.h>
 #include <proc/task.h>
 #include <proc/thread.h>
 #include <interrupt.h>
@@ -203,6 +204,22 @@ static size_t get_task_resmem(as_t *as)
 	return (pages << PAGE_WIDTH);
 }
 
+/** Get the size of memory mapped by large pages
+ *
+ * @param as Address space.
+ *
+ * @return Size of memory mapped by large pages (bytes).
+ *
+ */
+static size_t get_task_largemem(as_t *as)
+{
+#ifdef LARGE_PAGE_SIZE
+	return atomic_load(&as->large_pages) * LARGE_PAGE_SIZE;
+#else
+	return 0;
+#endif
+}
+
 /** Produce task statistics
  *
  * Summarize task information into task statistics.
@@ -220,10 +237,19 @@ static void produce_stats_task(task_t *task, stats_task_t *stats_task)
 	str_cpy(stats_task->name, TASK_NAME_BUFLEN, task->name);
 	stats_task->virtmem = get_task_virtmem(task->as);
 	stats_task->resmem = get_task_resmem(task->as);
+	stats_task->largemem = get_task_largemem(task->as);
+	stats_task->large_splits = atomic_load(&task->as->large_splits);
 	stats_task->threads = atomic_load(&task->lifecount);
 	task_get_accounting(task, &(stats_task->ucycles),
 	    &(stats_task->kcycles));
 	stats_task->ipc_info = task->ipc_info;
+
+	irq_spinlock_lock(&task->answerbox.lock, false);
+	stats_task->ipc_info.queued = task->answerbox.queued;
+	stats_task->ipc_info.queued_max = task->answerbox.queued_max;
+	stats_task->ipc_info.queued_cycles = task->answerbox.queued_cycles;
+	stats_task->ipc_info.dispatched = task->answerbox.dispatched;
+	irq_spinlock_unlock(&task->answerbox.lock, false);
 }
 
 /** Get task statistics
@@ -768,6 +794,36 @@ static void *get_stats_physmem(struct sysinfo_item *item, size_t *size,
 	return ((void *) stats_physmem);
 }
 
+/** Get physical frame allocator statistics
+ *
+ * @param item    Sysinfo item (unused).
+ * @param size    Size of the returned data.
+ * @param dry_run Do not get the data, just calculate the size.
+ * @param data    Unused.
+ *
+ * @return Data containing stats_frames_t.
+ *         If the return value is not NULL, it should be freed
+ *         in the context of the sysinfo request.
+ */
+static void *get_stats_frames(struct sysinfo_item *item, size_t *size,
+    bool dry_run, void *data)
+{
+	*size = sizeof(stats_frames_t);
+	if (dry_run)
+		return NULL;
+
+	stats_frames_t *stats_frames =
+	    (stats_frames_t *) malloc(*size);
+	if (stats_frames == NULL) {
+		*size = 0;
+		return NULL;
+	}
+
+	frame_cache_stats(stats_frames);
+
+	return ((void *) stats_frames);
+}
+
 /** Get system load
  *
  * @param item    Sysinfo item (unused).
@@ -847,6 +903,7 @@ void stats_init(void)
 {
 	sysinfo_set_item_gen_data("system.cpus", NULL, get_stats_cpus, NULL);
 	sysinfo_set_item_gen_data("system.physmem", NULL, get_stats_physmem, NULL);
+	sysinfo_set_item_gen_data("system.frames", NULL, get_stats_frames, NULL);
 	sysinfo_set_item_gen_data("system.load", NULL, get_stats_load, NULL);
 	sysinfo_set_item_gen_data("system.tasks", NULL, get_stats_tasks, NULL);
 	sysinfo_set_item_gen_data("system.threads", NULL, get_stats_threads, NULL);
@@ -155,15 +155,15 @@ void clock(void)
 
 	irq_spinlock_lock(&CPU->timeoutlock, false);
 
-	link_t *cur;
-	while ((cur = list_first(&CPU->timeout_active_list)) != NULL) {
-		timeout_t *timeout = list_get_instance(cur, timeout_t, link);
+	phlink_t *cur;
+	while ((cur = pheap_first(&CPU->timeout_heap)) != NULL) {
+		timeout_t *timeout = pheap_get_instance(cur, timeout_t, link);
 
 		if (current_clock_tick <= timeout->deadline) {
 			break;
 		}
 
-		list_remove(cur);
+		pheap_remove(&CPU->timeout_heap, cur);
 		timeout_handler_t handler = timeout->handler;
 		void *arg = timeout->arg;
 		atomic_bool *finished = &timeout->finished;
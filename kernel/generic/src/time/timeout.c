@@ -46,6 +46,17 @@
 #include <arch/asm.h>
 #include <arch.h>
 
+/** Compare deadlines of two timeouts. */
+static int timeout_cmp(phlink_t *a, phlink_t *b)
+{
+	deadline_t da = pheap_get_instance(a, timeout_t, link)->deadline;
+	deadline_t db = pheap_get_instance(b, timeout_t, link)->deadline;
+
+	if (da < db)
+		return -1;
+	return (da > db) ? 1 : 0;
+}
+
 /** Initialize timeouts
  *
  * Initialize kernel timeouts.
@@ -54,7 +65,7 @@
 void timeout_init(void)
 {
 	irq_spinlock_initialize(&CPU->timeoutlock, "cpu.timeoutlock");
-	list_initialize(&CPU->timeout_active_list);
+	pheap_initialize(&CPU->timeout_heap, timeout_cmp);
 }
 
 /** Initialize timeout
@@ -66,7 +77,7 @@ void timeout_init(void)
  */
 void timeout_initialize(timeout_t *timeout)
 {
-	link_initialize(&timeout->link);
+	phlink_initialize(&timeout->link);
 	timeout->cpu = NULL;
 }
 
@@ -82,7 +93,7 @@ deadline_t timeout_deadline_in_usec(uint32_t usec)
 static void timeout_register_deadline_locked(timeout_t *timeout, deadline_t deadline,
     timeout_handler_t handler, void *arg)
 {
-	assert(!link_in_use(&timeout->link));
+	assert(!phlink_used(&timeout->link));
 
 	*timeout = (timeout_t) {
 		.cpu = CPU,
@@ -92,21 +103,8 @@ static void timeout_register_deadline_locked(timeout_t *timeout, deadline_t dead
 		.finished = ATOMIC_VAR_INIT(false),
 	};
 
-	/* Insert timeout into the active timeouts list according to timeout->deadline. */
-
-	link_t *last = list_last(&CPU->timeout_active_list);
-	if (last == NULL || timeout->deadline >= list_get_instance(last, timeout_t, link)->deadline) {
-		list_append(&timeout->link, &CPU->timeout_active_list);
-	} else {
-		for (link_t *cur = list_first(&CPU->timeout_active_list); cur != NULL;
-		    cur = list_next(cur, &CPU->timeout_active_list)) {
-
-			if (timeout->deadline < list_get_instance(cur, timeout_t, link)->deadline) {
-				list_insert_before(&timeout->link, cur);
-				break;
-			}
-		}
-	}
+	/* Insert timeout into the heap of active timeouts. */
+	pheap_insert(&CPU->timeout_heap, &timeout->link);
 }
 
 /** Register timeout
@@ -139,7 +137,7 @@ void timeout_register_deadline(timeout_t *timeout, deadline_t deadline,
 
 /** Unregister timeout
  *
- * Remove timeout from timeout list.
+ * Remove timeout from the heap of active timeouts.
  *
  * @param timeout Timeout to unregister.
  *
@@ -156,9 +154,9 @@ bool timeout_unregister(timeout_t *timeout)
 
 	irq_spinlock_lock(&timeout->cpu->timeoutlock, true);
 
-	bool success = link_in_use(&timeout->link);
+	bool success = phlink_used(&timeout->link);
 	if (success) {
-		list_remove(&timeout->link);
+		pheap_remove(&timeout->cpu->timeout_heap, &timeout->link);
 	}
 
 	irq_spinlock_unlock(&timeout->cpu->timeoutlock, true);
@@ -0,0 +1,152 @@
+/*
+ * Copyright (c) 2026 The HelenOS Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <test.h>
+#include <mm/as.h>
+#include <mm/page.h>
+#include <mm/frame.h>
+#include <arch/mm/page.h>
+#include <genarch/mm/page_pt.h>
+#include <genarch/mm/page_ht.h>
+#include <typedefs.h>
+#include <stdatomic.h>
+
+/** Large page aligned address in the user part of the address space. */
+#define TEST_BASE  ((uintptr_t) 0x40000000)
+
+/** Index of the page removed from the large page to split it. */
+#define TEST_SPLIT_PAGE  7
+
+#ifdef LARGE_PAGE_SIZE
+
+static const char *check_mapping(as_t *as, uintptr_t frame, size_t hole)
+{
+	for (size_t i = 0; i < LARGE_PAGE_PAGES; i++) {
+		pte_t pte;
+		bool found = page_mapping_find(as, TEST_BASE + P2SZ(i), false,
+		    &pte);
+
+		if (i == hole) {
+			if (found && PTE_VALID(&pte))
+				return "Removed page is still mapped.";
+			continue;
+		}
+
+		if (!found || !PTE_VALID(&pte) || !PTE_PRESENT(&pte))
+			return "Page of a large page is not mapped.";
+
+		if (PTE_GET_FRAME(&pte) != frame + FRAMES2SIZE(i))
+			return "Page of a large page is mapped to a wrong frame.";
+	}
+
+	return NULL;
+}
+
+static const char *test_large(as_t *as, uintptr_t frame)
+{
+	if (!page_mapping_insert_large(as, TEST_BASE, frame,
+	    PAGE_USER | PAGE_READ | PAGE_WRITE | PAGE_CACHEABLE))
+		return "Unable to map large page.";
+
+	if (atomic_load(&as->large_pages) != 1)
+		return "Large page not accounted.";
+
+	TPRINTF("Checking large page mapping.\n");
+	const char *rc = check_mapping(as, frame, LARGE_PAGE_PAGES);
+	if (rc != NULL)
+		return rc;
+
+	if (page_mapping_insert_large(as, TEST_BASE, frame,
+	    PAGE_USER | PAGE_READ | PAGE_WRITE | PAGE_CACHEABLE))
+		return "Large page mapped twice.";
+
+	TPRINTF("Removing large page.\n");
+	for (size_t i = 0; i < LARGE_PAGE_PAGES; i++)
+		page_mapping_remove(as, TEST_BASE + P2SZ(i));
+
+	if (atomic_load(&as->large_pages) != 0 ||
+	    atomic_load(&as->large_splits) != 0)
+		return "Large page removal not accounted.";
+
+	for (size_t i = 0; i < LARGE_PAGE_PAGES; i++) {
+		pte_t pte;
+		if (page_mapping_find(as, TEST_BASE + P2SZ(i), false, &pte) &&
+		    PTE_VALID(&pte))
+			return "Removed large page is still mapped.";
+	}
+
+	if (!page_mapping_insert_large(as, TEST_BASE, frame,
+	    PAGE_USER | PAGE_READ | PAGE_WRITE | PAGE_CACHEABLE))
+		return "Unable to map large page again.";
+
+	TPRINTF("Splitting large page.\n");
+	page_mapping_split(as, TEST_BASE + P2SZ(TEST_SPLIT_PAGE));
+	page_mapping_remove(as, TEST_BASE + P2SZ(TEST_SPLIT_PAGE));
+
+	if (atomic_load(&as->large_pages) != 0 ||
+	    atomic_load(&as->large_splits) != 1)
+		return "Large page split not accounted.";
+
+	TPRINTF("Checking split mapping.\n");
+	return check_mapping(as, frame, TEST_SPLIT_PAGE);
+}
+
+#endif /* LARGE_PAGE_SIZE */
+
+const char *test_mapping2(void)
+{
+#ifdef LARGE_PAGE_SIZE
+	as_t *as = as_create(0);
+	if (as == NULL)
+		return "Unable to create address space.";
+
+	uintptr_t frame = frame_alloc(LARGE_PAGE_PAGES,
+	    FRAME_HIGHMEM | FRAME_ATOMIC, LARGE_PAGE_SIZE - 1);
+	if (frame == 0) {
+		as_release(as);
+		return "Unable to allocate large page.";
+	}
+
+	page_table_lock(as, true);
+
+	const char *rc = test_large(as, frame);
+
+	for (size_t i = 0; i < LARGE_PAGE_PAGES; i++)
+		page_mapping_remove(as, TEST_BASE + P2SZ(i));
+
+	page_table_unlock(as, true);
+
+	as_release(as);
+	frame_free(frame, LARGE_PAGE_PAGES);
+
+	return rc;
+#else
+	TPRINTF("Large pages are not supported.\n");
+	return NULL;
+#endif
+}
@@ -0,0 +1,130 @@
+/*
+ * Copyright (c) 2026 The HelenOS Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <test.h>
+#include <mm/as.h>
+#include <mm/page.h>
+#include <mm/frame.h>
+#include <mm/km.h>
+#include <mm/tlb.h>
+#include <arch/mm/page.h>
+#include <arch/cycle.h>
+#include <config.h>
+#include <typedefs.h>
+
+#define ITERATIONS  1000
+
+/** Page aligned address in the user part of the address space. */
+#define TEST_BASE  ((uintptr_t) 0x40000000)
+
+/** Measure unmapping of kernel pages.
+ *
+ * Kernel mappings are shared by all address spaces, so each unmap waits
+ * for all processors.
+ *
+ * @return Average number of cycles per unmap.
+ */
+static uint64_t unmap_kernel(uintptr_t frame)
+{
+	uint64_t cycles = 0;
+
+	for (unsigned int i = 0; i < ITERATIONS; i++) {
+		uintptr_t page = km_map(frame, PAGE_SIZE, PAGE_SIZE,
+		    PAGE_READ | PAGE_WRITE | PAGE_CACHEABLE);
+
+		uint64_t start = get_cycle();
+		km_unmap(page, PAGE_SIZE);
+		cycles += get_cycle() - start;
+	}
+
+	return cycles / ITERATIONS;
+}
+
+/** Measure unmapping of pages in an address space not used by any processor.
+ *
+ * The other processors queue the invalidation lazily instead of being
+ * interrupted.
+ *
+ * @return Average number of cycles per unmap.
+ */
+static uint64_t unmap_unused(as_t *as, uintptr_t frame)
+{
+	uint64_t cycles = 0;
+
+	page_table_lock(as, true);
+
+	for (unsigned int i = 0; i < ITERATIONS; i++) {
+		page_mapping_insert(as, TEST_BASE, frame,
+		    PAGE_USER | PAGE_READ | PAGE_WRITE | PAGE_CACHEABLE);
+
+		uint64_t start = get_cycle();
+
+		tlb_batch_t batch;
+		tlb_batch_init(&batch, as->asid);
+		tlb_batch_add(&batch, TEST_BASE, 1);
+
+		ipl_t ipl = tlb_batch_shootdown_start(&batch);
+		page_mapping_remove(as, TEST_BASE);
+		tlb_batch_invalidate(&batch);
+		tlb_shootdown_finalize(ipl);
+
+		cycles += get_cycle() - start;
+	}
+
+	page_table_unlock(as, true);
+
+	return cycles / ITERATIONS;
+}
+
+const char *test_tlb1(void)
+{
+	as_t *as = as_create(0);
+	if (as == NULL)
+		return "Unable to create address space.";
+
+	uintptr_t frame = frame_alloc(1, FRAME_HIGHMEM | FRAME_ATOMIC, 0);
+	if (frame == 0) {
+		as_release(as);
+		return "Unable to allocate frame.";
+	}
+
+	TPRINTF("Unmapping with %zu active CPUs.\n", config.cpu_active);
+
+	uint64_t kernel = unmap_kernel(frame);
+	TPRINTF("Kernel address space: %" PRIu64 " cycles per unmap.\n",
+	    kernel);
+
+	uint64_t unused = unmap_unused(as, frame);
+	TPRINTF("Unused address space: %" PRIu64 " cycles per unmap.\n",
+	    unused);
+
+	frame_free(frame, 1);
+	as_release(as);
+
+	return NULL;
+}
@@ -45,8 +45,10 @@ test_t tests[] = {
 #include <mm/falloc1.def>
 #include <mm/falloc2.def>
 #include <mm/mapping1.def>
+#include <mm/mapping2.def>
 #include <mm/slab1.def>
 #include <mm/slab2.def>
+#include <mm/tlb1.def>
 #include <synch/semaphore1.def>
 #include <synch/semaphore2.def>
 #include <print/print1.def>
@@ -55,6 +57,8 @@ test_t tests[] = {
 #include <print/print4.def>
 #include <print/print5.def>
 #include <thread/thread1.def>
+#include <thread/sched1.def>
+#include <time/timeout1.def>
 	{
 		.name = NULL,
 		.desc = NULL,
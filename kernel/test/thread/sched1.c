@@ -0,0 +1,181 @@
+/*
+ * Copyright (c) 2026 The HelenOS Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <test.h>
+#include <atomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <config.h>
+#include <cpu.h>
+#include <proc/scheduler.h>
+#include <proc/thread.h>
+#include <time/delay.h>
+
+#include <arch.h>
+
+/*
+ * Load balancing: busy threads started on one CPU are expected to spread
+ * over the other CPUs well within the time the old, once a second load
+ * balancer took.
+ */
+#define SPREAD_THREADS_PER_CPU  2
+#define SPREAD_USEC             500000
+
+/*
+ * Runtime accounting: a thread that computes for several clock ticks
+ * between sleeps must be classified differently from one that sleeps
+ * right away.
+ */
+#define BURST_ROUNDS      8
+#define BURST_HOG_USEC    50000
+#define BURST_SLEEP_USEC  10000
+
+static atomic_bool finish;
+static atomic_uint_fast64_t cpus_seen;
+
+static void spinner(void *data)
+{
+	while (!atomic_load(&finish)) {
+		ipl_t ipl = interrupts_disable();
+		unsigned int id = CPU->id;
+		interrupts_restore(ipl);
+
+		if (id < 64)
+			atomic_fetch_or(&cpus_seen, UINT64_C(1) << id);
+	}
+}
+
+static void burster(void *data)
+{
+	uint64_t *avg = data;
+	bool hog = (*avg != 0);
+
+	for (int i = 0; i < BURST_ROUNDS; i++) {
+		if (hog)
+			delay(BURST_HOG_USEC);
+		thread_usleep(BURST_SLEEP_USEC);
+	}
+
+	*avg = THREAD->burst_avg;
+}
+
+static const char *test_spread(void)
+{
+	size_t count = config.cpu_active * SPREAD_THREADS_PER_CPU;
+	const char *err = NULL;
+
+	thread_t **threads = malloc(count * sizeof(thread_t *));
+	if (threads == NULL)
+		return "Not enough memory";
+
+	atomic_store(&finish, false);
+	atomic_store(&cpus_seen, 0);
+
+	size_t started;
+	for (started = 0; started < count; started++) {
+		threads[started] = thread_create(spinner, NULL, TASK,
+		    THREAD_FLAG_NONE, "sched1-spin");
+		if (threads[started] == NULL)
+			break;
+
+		thread_start(threads[started]);
+	}
+
+	if (started < count) {
+		err = "Could not create thread";
+	} else {
+		thread_usleep(SPREAD_USEC);
+
+		uint64_t seen = atomic_load(&cpus_seen);
+		unsigned int ncpus = 0;
+		for (unsigned int i = 0; i < 64; i++) {
+			if (seen & (UINT64_C(1) << i))
+				ncpus++;
+		}
+
+		TPRINTF("%zu busy threads ran on %u CPUs\n", count, ncpus);
+		if (ncpus < 2)
+			err = "Busy threads did not spread to other CPUs";
+	}
+
+	atomic_store(&finish, true);
+	for (size_t i = 0; i < started; i++)
+		thread_join(threads[i]);
+
+	free(threads);
+	return err;
+}
+
+static const char *test_burst(void)
+{
+	uint64_t hog_avg = 1;
+	uint64_t sleeper_avg = 0;
+
+	thread_t *hog = thread_create(burster, &hog_avg, TASK,
+	    THREAD_FLAG_NONE, "sched1-hog");
+	if (hog == NULL)
+		return "Could not create thread";
+
+	thread_t *sleeper = thread_create(burster, &sleeper_avg, TASK,
+	    THREAD_FLAG_NONE, "sched1-sleep");
+	if (sleeper == NULL) {
+		thread_detach(hog);
+		return "Could not create thread";
+	}
+
+	thread_start(hog);
+	thread_start(sleeper);
+	thread_join(hog);
+	thread_join(sleeper);
+
+	TPRINTF("burst average: hog %" PRIu64 ", sleeper %" PRIu64
+	    " (1/%d ticks)\n", hog_avg, sleeper_avg, 1 << SCHED_BURST_SHIFT);
+
+	if ((hog_avg >> SCHED_BURST_SHIFT) == 0)
+		return "Computing thread was not accounted any run time";
+
+	if (sleeper_avg >= hog_avg)
+		return "Sleeping thread was not told apart from computing one";
+
+	return NULL;
+}
+
+const char *test_sched1(void)
+{
+	const char *err = test_burst();
+	if (err != NULL)
+		return err;
+
+	if (config.cpu_active < 2) {
+		TPRINTF("Only one CPU is active, skipping load balancing\n");
+		return NULL;
+	}
+
+	return test_spread();
+}
@@ -0,0 +1,130 @@
+/*
+ * Copyright (c) 2026 The HelenOS Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <test.h>
+#include <arch.h>
+#include <atomic.h>
+#include <cpu.h>
+#include <preemption.h>
+#include <stdlib.h>
+#include <time/timeout.h>
+#include <typedefs.h>
+#include <arch/cycle.h>
+
+/*
+ * Register and cancel a large number of timeouts on one CPU and report
+ * the cost of each operation. None of the timeouts is supposed to fire.
+ */
+
+#define TIMEOUT_COUNT  100000
+#define BATCH_SIZE     1000
+#define BATCH_COUNT    (TIMEOUT_COUNT / BATCH_SIZE)
+
+/** Step through the timeouts when cancelling them, coprime to the count. */
+#define CANCEL_STRIDE  7919
+
+/** All deadlines are at least an hour away. */
+#define TIMEOUT_BASE_USEC    3600000000U
+#define TIMEOUT_SPREAD_USEC  600000000U
+
+static atomic_size_t fired;
+
+static void timeout_handler(void *arg)
+{
+	atomic_inc(&fired);
+}
+
+static timeout_t *timeout_get(timeout_t **batches, size_t i)
+{
+	return &batches[i / BATCH_SIZE][i % BATCH_SIZE];
+}
+
+const char *test_timeout1(void)
+{
+	timeout_t **batches = calloc(BATCH_COUNT, sizeof(timeout_t *));
+	if (batches == NULL)
+		return "Failed to allocate memory";
+
+	for (size_t b = 0; b < BATCH_COUNT; b++) {
+		batches[b] = malloc(BATCH_SIZE * sizeof(timeout_t));
+		if (batches[b] == NULL) {
+			for (size_t j = 0; j < b; j++)
+				free(batches[j]);
+			free(batches);
+			return "Failed to allocate memory";
+		}
+	}
+
+	atomic_store(&fired, 0);
+
+	const char *err = NULL;
+	uint32_t seed = 0xdeadbeef;
+
+	/* Stay on one CPU so that the cost is not distorted by migration. */
+	preemption_disable();
+
+	uint64_t start = get_cycle();
+	for (size_t i = 0; i < TIMEOUT_COUNT; i++) {
+		seed = seed * 1103515245 + 12345;
+
+		timeout_t *timeout = timeout_get(batches, i);
+		timeout_initialize(timeout);
+		timeout_register(timeout,
+		    TIMEOUT_BASE_USEC + seed % TIMEOUT_SPREAD_USEC,
+		    timeout_handler, NULL);
+	}
+	uint64_t registered = get_cycle();
+
+	size_t failed = 0;
+	for (size_t i = 0; i < TIMEOUT_COUNT; i++) {
+		timeout_t *timeout = timeout_get(batches,
+		    (i * CANCEL_STRIDE) % TIMEOUT_COUNT);
+		if (!timeout_unregister(timeout))
+			failed++;
+	}
+	uint64_t cancelled = get_cycle();
+
+	preemption_enable();
+
+	TPRINTF("Registered %u timeouts in %" PRIu64 " cycles "
+	    "(%" PRIu64 " per timeout)\n", TIMEOUT_COUNT, registered - start,
+	    (registered - start) / TIMEOUT_COUNT);
+	TPRINTF("Cancelled %u timeouts in %" PRIu64 " cycles "
+	    "(%" PRIu64 " per timeout)\n", TIMEOUT_COUNT, cancelled - registered,
+	    (cancelled - registered) / TIMEOUT_COUNT);
+
+	if (failed > 0)
+		err = "Some timeouts could not be cancelled";
+	else if (atomic_load(&fired) > 0)
+		err = "Some timeouts fired prematurely";
+
+	for (size_t b = 0; b < BATCH_COUNT; b++)
+		free(batches[b]);
+	free(batches);
+
+	return err;
+}
@@ -39,17 +39,27 @@
 
 benchmark_t *benchmarks[] = {
 	&benchmark_dir_read,
+	&benchmark_fibril_fanout,
 	&benchmark_fibril_mutex,
+	&benchmark_fibril_pingpong,
 	&benchmark_file_read,
+	&benchmark_futex_create,
+	&benchmark_futex_handoff,
 	&benchmark_rand_read,
 	&benchmark_seq_read,
 	&benchmark_malloc1,
 	&benchmark_malloc2,
+	&benchmark_malloc1_mt,
+	&benchmark_malloc2_mt,
 	&benchmark_ns_ping,
 	&benchmark_ping_pong,
 	&benchmark_read1k,
+	&benchmark_read64k,
+	&benchmark_ring_ping,
+	&benchmark_sched_wakeup,
 	&benchmark_taskgetid,
 	&benchmark_write1k,
+	&benchmark_write64k,
 };
 
 size_t benchmark_count = sizeof(benchmarks) / sizeof(benchmarks[0]);
@@ -35,6 +35,7 @@
 #include <str_error.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <str.h>
 #include "../hbench.h"
 
 /** Execute disk sequential read benchmark. */
@@ -42,11 +43,15 @@ static bool runner(bench_env_t *env, bench_run_t *run, uint64_t size)
 {
 	const char *disk;
 	const char *nbstr;
+	const char *cachedstr;
 	service_id_t svcid;
 	size_t block_size;
 	aoff64_t dev_nblocks;
 	aoff64_t baddr;
+	aoff64_t span;
 	bool block_inited = false;
+	bool cached;
+	block_t *block;
 	char *buf = NULL;
 	uint64_t i;
 	errno_t rc;
@@ -66,6 +71,13 @@ static bool runner(bench_env_t *env, bench_run_t *run, uint64_t size)
 		goto error;
 	}
 
+	/*
+	 * With 'cached' set, the blocks are read through the libblock cache
+	 * (and thus with read-ahead) instead of directly.
+	 */
+	cachedstr = bench_env_param_get(env, "cached", "0");
+	cached = str_cmp(cachedstr, "0") != 0;
+
 	rc = loc_service_get_id(disk, &svcid, 0);
 	if (rc != EOK) {
 		bench_run_fail(run, "failed resolving device '%s'", disk);
@@ -98,6 +110,22 @@ static bool runner(bench_env_t *env, bench_run_t *run, uint64_t size)
 		goto error;
 	}
 
+	/* The cache does not give access to the very last block. */
+	span = dev_nblocks - nb + 1;
+	if (cached) {
+		if (span < 2) {
+			bench_run_fail(run, "device is too small.\n");
+			goto error;
+		}
+		span--;
+
+		rc = block_cache_init(svcid, block_size, 0, CACHE_MODE_WT);
+		if (rc != EOK) {
+			bench_run_fail(run, "failed to initialize block cache");
+			goto error;
+		}
+	}
+
 	buf = malloc(block_size);
 	if (buf == NULL) {
 		bench_run_fail(run, "failed to allocate buffer (%zu bytes)",
@@ -107,9 +135,15 @@ static bool runner(bench_env_t *env, bench_run_t *run, uint64_t size)
 
 	bench_run_start(run);
 	for (i = 0; i < size; i++) {
-		baddr = i % (dev_nblocks - nb + 1);
-
-		rc = block_read_direct(svcid, baddr, 1, buf);
+		baddr = i % span;
+
+		if (cached) {
+			rc = block_get(&block, svcid, baddr, BLOCK_FLAGS_NONE);
+			if (rc == EOK)
+				rc = block_put(block);
+		} else {
+			rc = block_read_direct(svcid, baddr, 1, buf);
+		}
 		if (rc != EOK) {
 			bench_run_fail(run, "failed to read blocks %llu-%llu: "
 			    "%s", (unsigned long long)baddr,
@@ -99,6 +99,7 @@ typedef struct {
 
 extern void bench_run_init(bench_run_t *, char *, size_t);
 extern bool bench_run_fail(bench_run_t *, const char *, ...);
+extern void bench_runners_ensure(int);
 
 /*
  * We keep the following two functions inline to ensure that we start
@@ -132,17 +133,27 @@ extern size_t benchmark_count;
 
 /* Put your benchmark descriptors here (and also to benchlist.c). */
 extern benchmark_t benchmark_dir_read;
+extern benchmark_t benchmark_fibril_fanout;
 extern benchmark_t benchmark_fibril_mutex;
+extern benchmark_t benchmark_fibril_pingpong;
 extern benchmark_t benchmark_file_read;
+extern benchmark_t benchmark_futex_create;
+extern benchmark_t benchmark_futex_handoff;
 extern benchmark_t benchmark_rand_read;
 extern benchmark_t benchmark_seq_read;
 extern benchmark_t benchmark_malloc1;
 extern benchmark_t benchmark_malloc2;
+extern benchmark_t benchmark_malloc1_mt;
+extern benchmark_t benchmark_malloc2_mt;
 extern benchmark_t benchmark_ns_ping;
 extern benchmark_t benchmark_ping_pong;
 extern benchmark_t benchmark_read1k;
+extern benchmark_t benchmark_read64k;
+extern benchmark_t benchmark_ring_ping;
+extern benchmark_t benchmark_sched_wakeup;
 extern benchmark_t benchmark_taskgetid;
 extern benchmark_t benchmark_write1k;
+extern benchmark_t benchmark_write64k;
 
 #endif
 
@@ -34,13 +34,64 @@
 #include <ipc_test.h>
 #include <async.h>
 #include <errno.h>
+#include <fibril.h>
+#include <fibril_synch.h>
+#include <stdlib.h>
+#include <macros.h>
 #include <str_error.h>
 #include "../hbench.h"
 
+/*
+ * With the 'threads' parameter greater than one, the pings are sent
+ * concurrently by that many fibrils, each of which can run on its own runner
+ * thread. This exercises the kernel IPC paths of a multi-threaded task.
+ *
+ * With the 'batch' parameter greater than one, that many pings are sent at
+ * once through the batched IPC call system call before their answers are
+ * waited for.
+ */
+
+#define DEFAULT_THREADS "1"
+#define DEFAULT_BATCH "1"
+
+typedef struct {
+	uint64_t count;
+	errno_t rc;
+	fibril_semaphore_t *finished;
+} pinger_t;
+
 static ipc_test_t *test = NULL;
 
+static bool get_threads(bench_env_t *env, bench_run_t *run, int *threads)
+{
+	const char *str = bench_env_param_get(env, "threads", DEFAULT_THREADS);
+	int nitem = sscanf(str, "%d", threads);
+	if ((nitem < 1) || (*threads < 1))
+		return bench_run_fail(run, "'threads' must be a positive integer.");
+
+	return true;
+}
+
+static bool get_batch(bench_env_t *env, bench_run_t *run, int *batch)
+{
+	const char *str = bench_env_param_get(env, "batch", DEFAULT_BATCH);
+	int nitem = sscanf(str, "%d", batch);
+	if ((nitem < 1) || (*batch < 1) || (*batch > IPC_MAX_ASYNC_CALLS)) {
+		return bench_run_fail(run, "'batch' must be between 1 and %d.",
+		    IPC_MAX_ASYNC_CALLS);
+	}
+
+	return true;
+}
+
 static bool setup(bench_env_t *env, bench_run_t *run)
 {
+	int threads;
+	if (!get_threads(env, run, &threads))
+		return false;
+
+	bench_runners_ensure(threads);
+
 	errno_t rc = ipc_test_create(&test);
 	if (rc != EOK) {
 		return bench_run_fail(run,
@@ -57,8 +108,106 @@ static bool teardown(bench_env_t *env, bench_run_t *run)
 	return true;
 }
 
+static errno_t pinger_fibril(void *arg)
+{
+	pinger_t *pinger = arg;
+	fibril_detach(fibril_get_id());
+
+	for (uint64_t count = 0; count < pinger->count; count++) {
+		pinger->rc = ipc_test_ping(test);
+		if (pinger->rc != EOK)
+			break;
+	}
+
+	fibril_semaphore_up(pinger->finished);
+	return EOK;
+}
+
+static bool runner_parallel(bench_run_t *run, uint64_t niter, int threads)
+{
+	pinger_t *pingers = calloc(threads, sizeof(pinger_t));
+	if (pingers == NULL)
+		return bench_run_fail(run, "failed to allocate %d pingers", threads);
+
+	fibril_semaphore_t finished;
+	fibril_semaphore_initialize(&finished, 0);
+
+	for (int i = 0; i < threads; i++) {
+		pingers[i].count = niter / threads;
+		pingers[i].rc = EOK;
+		pingers[i].finished = &finished;
+	}
+
+	int started = 0;
+
+	bench_run_start(run);
+	for (int i = 0; i < threads; i++) {
+		fid_t fid = fibril_create(pinger_fibril, &pingers[i]);
+		if (!fid)
+			break;
+
+		fibril_add_ready(fid);
+		started++;
+	}
+
+	for (int i = 0; i < started; i++)
+		fibril_semaphore_down(&finished);
+	bench_run_stop(run);
+
+	errno_t rc = EOK;
+	for (int i = 0; i < started; i++) {
+		if (pingers[i].rc != EOK)
+			rc = pingers[i].rc;
+	}
+
+	free(pingers);
+
+	if (started < threads)
+		return bench_run_fail(run, "failed to create pinger fibril %d", started);
+
+	if (rc != EOK) {
+		return bench_run_fail(run, "failed sending ping message: %s (%d)",
+		    str_error(rc), rc);
+	}
+
+	return true;
+}
+
+static bool runner_batch(bench_run_t *run, uint64_t niter, int batch)
+{
+	bench_run_start(run);
+
+	for (uint64_t count = 0; count < niter; count += batch) {
+		size_t n = min(niter - count, (uint64_t) batch);
+		errno_t rc = ipc_test_ping_batch(test, n);
+
+		if (rc != EOK) {
+			return bench_run_fail(run, "failed sending ping messages: %s (%d)",
+			    str_error(rc), rc);
+		}
+	}
+
+	bench_run_stop(run);
+
+	return true;
+}
+
 static bool runner(bench_env_t *env, bench_run_t *run, uint64_t niter)
 {
+	int threads;
+	if (!get_threads(env, run, &threads))
+		return false;
+
+	int batch;
+	if (!get_batch(env, run, &batch))
+		return false;
+
+	if (threads > 1)
+		return runner_parallel(run, niter, threads);
+
+	if (batch > 1)
+		return runner_batch(run, niter, batch);
+
 	bench_run_start(run);
 
 	for (uint64_t count = 0; count < niter; count++) {
@@ -0,0 +1,193 @@
+/*
+ * Copyright (c) 2026 The HelenOS Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup hbench
+ * @{
+ */
+
+#include <fibril.h>
+#include <fibril_synch.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "../hbench.h"
+
+/*
+ * Multi-threaded variants of malloc1 and malloc2. The workload is split
+ * among several fibrils that run on separate runner threads and thus
+ * compete for the allocator. The number of fibrils (and threads) is
+ * given by the 'threads' parameter.
+ */
+
+#define DEFAULT_THREADS "4"
+
+typedef struct {
+	/** Iterations to be done by each worker */
+	uint64_t niter;
+	/** Keep all blocks allocated before freeing them (malloc2 style) */
+	bool many;
+	/** Signalled by each finished worker */
+	fibril_semaphore_t finished;
+	/** Set by a worker that failed to allocate memory */
+	atomic_bool failed;
+} shared_t;
+
+static errno_t worker_one(shared_t *shared)
+{
+	for (uint64_t i = 0; i < shared->niter; i++) {
+		void *p = malloc(1);
+		if (p == NULL)
+			return ENOMEM;
+		free(p);
+	}
+
+	return EOK;
+}
+
+static errno_t worker_many(shared_t *shared)
+{
+	void **p = malloc(shared->niter * sizeof(void *));
+	if (p == NULL)
+		return ENOMEM;
+
+	for (uint64_t count = 0; count < shared->niter; count++) {
+		p[count] = malloc(1);
+		if (p[count] == NULL) {
+			for (uint64_t j = 0; j < count; j++)
+				free(p[j]);
+			free(p);
+			return ENOMEM;
+		}
+	}
+
+	for (uint64_t count = 0; count < shared->niter; count++)
+		free(p[count]);
+
+	free(p);
+	return EOK;
+}
+
+static errno_t worker(void *arg)
+{
+	shared_t *shared = arg;
+	fibril_detach(fibril_get_id());
+
+	errno_t rc = shared->many ? worker_many(shared) : worker_one(shared);
+	if (rc != EOK)
+		atomic_store(&shared->failed, true);
+
+	fibril_semaphore_up(&shared->finished);
+	return EOK;
+}
+
+static bool get_threads(bench_env_t *env, bench_run_t *run, int *threads)
+{
+	const char *str = bench_env_param_get(env, "threads", DEFAULT_THREADS);
+	int nitem = sscanf(str, "%d", threads);
+	if ((nitem < 1) || (*threads < 1))
+		return bench_run_fail(run, "'threads' must be a positive integer.");
+
+	return true;
+}
+
+static bool setup(bench_env_t *env, bench_run_t *run)
+{
+	int threads;
+	if (!get_threads(env, run, &threads))
+		return false;
+
+	bench_runners_ensure(threads);
+	return true;
+}
+
+static bool run_workers(bench_env_t *env, bench_run_t *run, uint64_t size,
+    bool many)
+{
+	int threads;
+	if (!get_threads(env, run, &threads))
+		return false;
+
+	shared_t shared;
+	shared.niter = size / threads;
+	shared.many = many;
+	fibril_semaphore_initialize(&shared.finished, 0);
+	atomic_store(&shared.failed, false);
+
+	int started = 0;
+
+	bench_run_start(run);
+	for (int i = 0; i < threads; i++) {
+		fid_t fid = fibril_create(worker, &shared);
+		if (!fid)
+			break;
+
+		fibril_add_ready(fid);
+		started++;
+	}
+
+	for (int i = 0; i < started; i++)
+		fibril_semaphore_down(&shared.finished);
+	bench_run_stop(run);
+
+	if (started < threads)
+		return bench_run_fail(run, "failed to create worker fibril %d", started);
+
+	if (atomic_load(&shared.failed))
+		return bench_run_fail(run, "failed to allocate memory in a worker");
+
+	return true;
+}
+
+static bool runner_one(bench_env_t *env, bench_run_t *run, uint64_t size)
+{
+	return run_workers(env, run, size, false);
+}
+
+static bool runner_many(bench_env_t *env, bench_run_t *run, uint64_t size)
+{
+	return run_workers(env, run, size, true);
+}
+
+benchmark_t benchmark_malloc1_mt = {
+	.name = "malloc1_mt",
+	.desc = "User-space memory allocator benchmark, repeatedly allocate one block in several threads",
+	.entry = &runner_one,
+	.setup = &setup,
+	.teardown = NULL
+};
+
+benchmark_t benchmark_malloc2_mt = {
+	.name = "malloc2_mt",
+	.desc = "User-space memory allocator benchmark, allocate many small blocks in several threads",
+	.entry = &runner_many,
+	.setup = &setup,
+	.teardown = NULL
+};
+
+/** @}
+ */
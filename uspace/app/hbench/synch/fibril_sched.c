@@ -0,0 +1,274 @@
+/*
+ * Copyright (c) 2026 The HelenOS Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+/** @addtogroup hbench
+ * @{
+ */
+
+#include <fibril.h>
+#include <fibril_synch.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "../hbench.h"
+
+/*
+ * Benchmarks of the fibril scheduler on several runner threads.
+ *
+ * In fibril_pingpong, pairs of fibrils pass a token back and forth. Every
+ * pair is independent of the others, so the throughput should grow with the
+ * number of runner threads as long as there are enough pairs.
+ *
+ * In fibril_fanout, one fibril repeatedly wakes up a group of workers and
+ * waits for all of them to finish a short piece of work. The workers all
+ * become ready on the same runner, so the other runners have to steal them.
+ *
+ * Both take the 'threads' parameter (number of runner threads, including
+ * the main one), and 'fibrils' (number of pairs or workers, respectively).
+ */
+
+#define DEFAULT_THREADS "4"
+#define DEFAULT_FIBRILS "16"
+
+/** Number of loop iterations a fan-out worker spends per round */
+#define FANOUT_WORK 1000
+
+typedef struct {
+	fibril_semaphore_t ping;
+	fibril_semaphore_t pong;
+	uint64_t rounds;
+	fibril_semaphore_t *finished;
+} pair_t;
+
+typedef struct {
+	fibril_semaphore_t start;
+	fibril_semaphore_t *finished;
+	atomic_bool *stop;
+} worker_t;
+
+static bool get_params(bench_env_t *env, bench_run_t *run, int *threads,
+    int *fibrils)
+{
+	const char *str = bench_env_param_get(env, "threads", DEFAULT_THREADS);
+	int nitem = sscanf(str, "%d", threads);
+	if ((nitem < 1) || (*threads < 1))
+		return bench_run_fail(run, "'threads' must be a positive integer.");
+
+	str = bench_env_param_get(env, "fibrils", DEFAULT_FIBRILS);
+	nitem = sscanf(str, "%d", fibrils);
+	if ((nitem < 1) || (*fibrils < 1))
+		return bench_run_fail(run, "'fibrils' must be a positive integer.");
+
+	return true;
+}
+
+static bool setup(bench_env_t *env, bench_run_t *run)
+{
+	int threads;
+	int fibrils;
+	if (!get_params(env, run, &threads, &fibrils))
+		return false;
+
+	bench_runners_ensure(threads);
+	return true;
+}
+
+static errno_t pinger(void *arg)
+{
+	pair_t *pair = arg;
+	fibril_detach(fibril_get_id());
+
+	for (uint64_t i = 0; i < pair->rounds; i++) {
+		fibril_semaphore_up(&pair->ping);
+		fibril_semaphore_down(&pair->pong);
+	}
+
+	fibril_semaphore_up(pair->finished);
+	return EOK;
+}
+
+static errno_t ponger(void *arg)
+{
+	pair_t *pair = arg;
+	fibril_detach(fibril_get_id());
+
+	for (uint64_t i = 0; i < pair->rounds; i++) {
+		fibril_semaphore_down(&pair->ping);
+		fibril_semaphore_up(&pair->pong);
+	}
+
+	fibril_semaphore_up(pair->finished);
+	return EOK;
+}
+
+static bool runner_pingpong(bench_env_t *env, bench_run_t *run, uint64_t size)
+{
+	int threads;
+	int npairs;
+	if (!get_params(env, run, &threads, &npairs))
+		return false;
+
+	pair_t *pairs = calloc(npairs, sizeof(pair_t));
+	if (pairs == NULL)
+		return bench_run_fail(run, "failed to allocate %d pairs", npairs);
+
+	fibril_semaphore_t finished;
+	fibril_semaphore_initialize(&finished, 0);
+
+	for (int i = 0; i < npairs; i++) {
+		fibril_semaphore_initialize(&pairs[i].ping, 0);
+		fibril_semaphore_initialize(&pairs[i].pong, 0);
+		pairs[i].rounds = size / npairs;
+		pairs[i].finished = &finished;
+	}
+
+	int started = 0;
+
+	bench_run_start(run);
+	for (int i = 0; i < npairs; i++) {
+		fid_t ping = fibril_create(pinger, &pairs[i]);
+		if (!ping)
+			break;
+		fid_t pong = fibril_create(ponger, &pairs[i]);
+		if (!pong) {
+			fibril_destroy(ping);
+			break;
+		}
+
+		fibril_add_ready(pong);
+		fibril_add_ready(ping);
+		started++;
+	}
+
+	for (int i = 0; i < 2 * started; i++)
+		fibril_semaphore_down(&finished);
+	bench_run_stop(run);
+
+	free(pairs);
+
+	if (started < npairs)
+		return bench_run_fail(run, "failed to create pair %d", started);
+
+	return true;
+}
+
+static errno_t fanout_worker(void *arg)
+{
+	worker_t *worker = arg;
+	fibril_detach(fibril_get_id());
+
+	while (true) {
+		fibril_semaphore_down(&worker->start);
+		if (atomic_load(worker->stop))
+			break;
+
+		volatile int sink = 0;
+		for (int i = 0; i < FANOUT_WORK; i++)
+			sink += i;
+
+		fibril_semaphore_up(worker->finished);
+	}
+
+	fibril_semaphore_up(worker->finished);
+	return EOK;
+}
+
+static bool runner_fanout(bench_env_t *env, bench_run_t *run, uint64_t size)
+{
+	int threads;
+	int nworkers;
+	if (!get_params(env, run, &threads, &nworkers))
+		return false;
+
+	worker_t *workers = calloc(nworkers, sizeof(worker_t));
+	if (workers == NULL)
+		return bench_run_fail(run, "failed to allocate %d workers", nworkers);
+
+	fibril_semaphore_t finished;
+	fibril_semaphore_initialize(&finished, 0);
+	atomic_bool stop;
+	atomic_store(&stop, false);
+
+	int started = 0;
+	for (int i = 0; i < nworkers; i++) {
+		fibril_semaphore_initialize(&workers[i].start, 0);
+		workers[i].finished = &finished;
+		workers[i].stop = &stop;
+
+		fid_t fid = fibril_create(fanout_worker, &workers[i]);
+		if (!fid)
+			break;
+
+		fibril_add_ready(fid);
+		started++;
+	}
+
+	uint64_t rounds = size / nworkers;
+
+	if (started == nworkers) {
+		bench_run_start(run);
+		for (uint64_t r = 0; r < rounds; r++) {
+			for (int i = 0; i < started; i++)
+				fibril_semaphore_up(&workers[i].start);
+			for (int i = 0; i < started; i++)
+				fibril_semaphore_down(&finished);
+		}
+		bench_run_stop(run);
+	}
+
+	atomic_store(&stop, true);
+	for (int i = 0; i < started; i++)
+		fibril_semaphore_up(&workers[i].start);
+	for (int i = 0; i < started; i++)
+		fibril_semaphore_down(&finished);
+
+	free(workers);
+
+	if (started < nworkers)
+		return bench_run_fail(run, "failed to create worker fibril %d", started);
+
+	return true;
+}
+
+benchmark_t benchmark_fibril_pingpong = {
+	.name = "fibril_pingpong",
+	.desc = "Fibril context switches between independent pairs of fibrils",
+	.entry = &runner_pingpong,
+	.setup = &setup,
+	.teardown = NULL
+};
+
+benchmark_t benchmark_fibril_fanout = {
+	.name = "fibril_fanout",
+	.desc = "One fibril repeatedly waking up a group of workers",
+	.entry = &runner_fanout,
+	.setup = &setup,
+	.teardown = NULL
+};
+
+/** @}
+ */
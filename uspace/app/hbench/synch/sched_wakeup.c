@@ -0,0 +1,235 @@
+/*
+ * Copyright (c) 2026 The HelenOS Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup hbench
+ * @{
+ */
+
+#include <fibril.h>
+#include <fibril_synch.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "../hbench.h"
+
+/*
+ * Kernel scheduler wakeup benchmark.
+ *
+ * The main fibril repeatedly wakes up a group of workers and busy-waits
+ * until all of them have run. As the main fibril keeps its runner thread
+ * busy, the workers are picked up by other runner threads, which first
+ * have to be woken up in the kernel and scheduled on some CPU. On SMP,
+ * the woken threads compete for the CPU they last ran on unless the
+ * kernel moves them to an idle one.
+ *
+ * The throughput is the number of worker wakeups per second. The average
+ * and maximum time between waking up a worker and the worker running are
+ * printed when the benchmark finishes.
+ *
+ * Parameters are 'threads' (number of runner threads, including the main
+ * one, at least two) and 'workers' (number of workers woken up at once).
+ */
+
+#define DEFAULT_THREADS "4"
+#define DEFAULT_WORKERS "3"
+
+/** Number of loop iterations a worker spends per round */
+#define WAKEUP_WORK 1000
+
+typedef struct {
+	/** Time when the current round started */
+	struct timespec start_time;
+	/** Workers which have not run yet in the current round */
+	atomic_int pending;
+	atomic_bool stop;
+	fibril_semaphore_t finished;
+} shared_t;
+
+typedef struct {
+	fibril_semaphore_t start;
+	shared_t *shared;
+} worker_t;
+
+/** Latency statistics over all runs since setup */
+static atomic_uint_fast64_t latency_total;
+static atomic_uint_fast64_t latency_max;
+static atomic_uint_fast64_t latency_count;
+
+static bool get_params(bench_env_t *env, bench_run_t *run, int *threads,
+    int *workers)
+{
+	const char *str = bench_env_param_get(env, "threads", DEFAULT_THREADS);
+	int nitem = sscanf(str, "%d", threads);
+	if ((nitem < 1) || (*threads < 2))
+		return bench_run_fail(run, "'threads' must be an integer greater than one.");
+
+	str = bench_env_param_get(env, "workers", DEFAULT_WORKERS);
+	nitem = sscanf(str, "%d", workers);
+	if ((nitem < 1) || (*workers < 1))
+		return bench_run_fail(run, "'workers' must be a positive integer.");
+
+	return true;
+}
+
+static bool setup(bench_env_t *env, bench_run_t *run)
+{
+	int threads;
+	int workers;
+	if (!get_params(env, run, &threads, &workers))
+		return false;
+
+	atomic_store(&latency_total, 0);
+	atomic_store(&latency_max, 0);
+	atomic_store(&latency_count, 0);
+
+	bench_runners_ensure(threads);
+	return true;
+}
+
+static bool teardown(bench_env_t *env, bench_run_t *run)
+{
+	uint64_t count = atomic_load(&latency_count);
+	if (count == 0)
+		return true;
+
+	printf("Wakeup latency: average %" PRIu64 " ns, maximum %" PRIu64
+	    " ns.\n", atomic_load(&latency_total) / count,
+	    atomic_load(&latency_max));
+	return true;
+}
+
+static void record_latency(uint64_t nsec)
+{
+	atomic_fetch_add(&latency_total, nsec);
+	atomic_fetch_add(&latency_count, 1);
+
+	uint64_t max = atomic_load(&latency_max);
+	while (nsec > max) {
+		if (atomic_compare_exchange_weak(&latency_max, &max, nsec))
+			break;
+	}
+}
+
+static errno_t worker_fibril(void *arg)
+{
+	worker_t *worker = arg;
+	shared_t *shared = worker->shared;
+	fibril_detach(fibril_get_id());
+
+	while (true) {
+		fibril_semaphore_down(&worker->start);
+		if (atomic_load(&shared->stop))
+			break;
+
+		struct timespec now;
+		getuptime(&now);
+		record_latency(ts_sub_diff(&now, &shared->start_time));
+
+		volatile int sink = 0;
+		for (int i = 0; i < WAKEUP_WORK; i++)
+			sink += i;
+
+		atomic_fetch_sub(&shared->pending, 1);
+	}
+
+	fibril_semaphore_up(&shared->finished);
+	return EOK;
+}
+
+static bool runner(bench_env_t *env, bench_run_t *run, uint64_t size)
+{
+	int threads;
+	int nworkers;
+	if (!get_params(env, run, &threads, &nworkers))
+		return false;
+
+	worker_t *workers = calloc(nworkers, sizeof(worker_t));
+	if (workers == NULL)
+		return bench_run_fail(run, "failed to allocate %d workers", nworkers);
+
+	shared_t shared;
+	atomic_store(&shared.pending, 0);
+	atomic_store(&shared.stop, false);
+	fibril_semaphore_initialize(&shared.finished, 0);
+
+	int started = 0;
+	for (int i = 0; i < nworkers; i++) {
+		fibril_semaphore_initialize(&workers[i].start, 0);
+		workers[i].shared = &shared;
+
+		fid_t fid = fibril_create(worker_fibril, &workers[i]);
+		if (!fid)
+			break;
+
+		fibril_add_ready(fid);
+		started++;
+	}
+
+	uint64_t rounds = size / nworkers;
+
+	if (started == nworkers) {
+		bench_run_start(run);
+		for (uint64_t r = 0; r < rounds; r++) {
+			atomic_store(&shared.pending, started);
+			getuptime(&shared.start_time);
+
+			for (int i = 0; i < started; i++)
+				fibril_semaphore_up(&workers[i].start);
+
+			/* Keep this runner busy so that others have to wake up. */
+			while (atomic_load(&shared.pending) > 0)
+				;
+		}
+		bench_run_stop(run);
+	}
+
+	atomic_store(&shared.stop, true);
+	for (int i = 0; i < started; i++)
+		fibril_semaphore_up(&workers[i].start);
+	for (int i = 0; i < started; i++)
+		fibril_semaphore_down(&shared.finished);
+
+	free(workers);
+
+	if (started < nworkers)
+		return bench_run_fail(run, "failed to create worker fibril %d", started);
+
+	return true;
+}
+
+benchmark_t benchmark_sched_wakeup = {
+	.name = "sched_wakeup",
+	.desc = "Kernel thread wakeup-to-run latency and throughput",
+	.entry = &runner,
+	.setup = &setup,
+	.teardown = &teardown
+};
+
+/** @}
+ */
@@ -0,0 +1,262 @@
+/*
+ * Copyright (c) 2026 The HelenOS Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup hbench
+ * @{
+ */
+
+#include <abi/cap.h>
+#include <abi/synch.h>
+#include <abi/syscall.h>
+#include <errno.h>
+#include <fibril.h>
+#include <fibril_synch.h>
+#include <libc.h>
+#include <stdatomic.h>
+#include <str.h>
+#include <str_error.h>
+#include "../hbench.h"
+
+/*
+ * Benchmarks of the kernel futex support.
+ *
+ * The benchmarks use the same semaphore protocol as libc futexes, on top
+ * of either the address-keyed futex system calls or wait queue
+ * capabilities, as selected by the 'backend' parameter ("address", which
+ * is the default, or "waitq").
+ *
+ * In futex_create, each iteration sets up a futex, passes one wakeup
+ * through the kernel and tears the futex down again. With wait queue
+ * capabilities, this includes creating and destroying the capability.
+ *
+ * In futex_handoff, two threads alternately wake each other up, so every
+ * handoff is a contended wakeup of a sleeping thread.
+ */
+
+#define DEFAULT_BACKEND "address"
+
+typedef struct {
+	atomic_int val;
+	cap_waitq_handle_t whandle;
+} bench_futex_t;
+
+typedef struct {
+	bench_futex_t ping;
+	bench_futex_t pong;
+	uint64_t rounds;
+	fibril_semaphore_t finished;
+} handoff_t;
+
+static bool get_backend(bench_env_t *env, bench_run_t *run, bool *waitq)
+{
+	const char *str = bench_env_param_get(env, "backend", DEFAULT_BACKEND);
+	if (str_cmp(str, "address") == 0) {
+		*waitq = false;
+	} else if (str_cmp(str, "waitq") == 0) {
+		*waitq = true;
+	} else {
+		return bench_run_fail(run, "'backend' must be \"address\" or \"waitq\".");
+	}
+
+	return true;
+}
+
+static errno_t bench_futex_init(bench_futex_t *futex, bool waitq)
+{
+	atomic_store(&futex->val, 0);
+	futex->whandle = CAP_NIL;
+
+	if (!waitq)
+		return EOK;
+
+	return __SYSCALL1(SYS_WAITQ_CREATE, (sysarg_t) &futex->whandle);
+}
+
+static void bench_futex_fini(bench_futex_t *futex)
+{
+	if (futex->whandle != CAP_NIL)
+		(void) __SYSCALL1(SYS_WAITQ_DESTROY, (sysarg_t) futex->whandle);
+}
+
+static errno_t bench_futex_sleep(bench_futex_t *futex)
+{
+	if (futex->whandle != CAP_NIL) {
+		return __SYSCALL3(SYS_WAITQ_SLEEP, (sysarg_t) futex->whandle,
+		    0, SYNCH_FLAGS_FUTEX);
+	}
+
+	return __SYSCALL3(SYS_FUTEX_SLEEP, (sysarg_t) &futex->val, 0,
+	    SYNCH_FLAGS_FUTEX);
+}
+
+static errno_t bench_futex_wakeup(bench_futex_t *futex)
+{
+	if (futex->whandle != CAP_NIL)
+		return __SYSCALL1(SYS_WAITQ_WAKEUP, (sysarg_t) futex->whandle);
+
+	return __SYSCALL1(SYS_FUTEX_WAKEUP, (sysarg_t) &futex->val);
+}
+
+static void bench_futex_down(bench_futex_t *futex)
+{
+	if (atomic_fetch_sub_explicit(&futex->val, 1, memory_order_acquire) <= 0)
+		(void) bench_futex_sleep(futex);
+}
+
+static void bench_futex_up(bench_futex_t *futex)
+{
+	if (atomic_fetch_add_explicit(&futex->val, 1, memory_order_release) < 0)
+		(void) bench_futex_wakeup(futex);
+}
+
+static bool setup(bench_env_t *env, bench_run_t *run)
+{
+	bool waitq;
+	return get_backend(env, run, &waitq);
+}
+
+static bool setup_handoff(bench_env_t *env, bench_run_t *run)
+{
+	bool waitq;
+	if (!get_backend(env, run, &waitq))
+		return false;
+
+	/* The two sides must run on separate threads. */
+	bench_runners_ensure(2);
+	return true;
+}
+
+static bool runner_create(bench_env_t *env, bench_run_t *run, uint64_t niter)
+{
+	bool waitq;
+	if (!get_backend(env, run, &waitq))
+		return false;
+
+	bench_run_start(run);
+	for (uint64_t i = 0; i < niter; i++) {
+		bench_futex_t futex;
+
+		errno_t rc = bench_futex_init(&futex, waitq);
+		if (rc != EOK) {
+			bench_run_stop(run);
+			return bench_run_fail(run, "failed to create waitq: %s",
+			    str_error(rc));
+		}
+
+		rc = bench_futex_wakeup(&futex);
+		if (rc == EOK)
+			rc = bench_futex_sleep(&futex);
+
+		bench_futex_fini(&futex);
+
+		if (rc != EOK) {
+			bench_run_stop(run);
+			return bench_run_fail(run, "futex operation failed: %s",
+			    str_error(rc));
+		}
+	}
+	bench_run_stop(run);
+
+	return true;
+}
+
+static errno_t handoff_partner(void *arg)
+{
+	handoff_t *handoff = arg;
+	fibril_detach(fibril_get_id());
+
+	for (uint64_t i = 0; i < handoff->rounds; i++) {
+		bench_futex_down(&handoff->ping);
+		bench_futex_up(&handoff->pong);
+	}
+
+	fibril_semaphore_up(&handoff->finished);
+	return EOK;
+}
+
+static bool runner_handoff(bench_env_t *env, bench_run_t *run, uint64_t niter)
+{
+	bool waitq;
+	if (!get_backend(env, run, &waitq))
+		return false;
+
+	handoff_t handoff;
+	handoff.rounds = niter;
+	fibril_semaphore_initialize(&handoff.finished, 0);
+
+	errno_t rc = bench_futex_init(&handoff.ping, waitq);
+	if (rc != EOK)
+		return bench_run_fail(run, "failed to create waitq: %s", str_error(rc));
+
+	rc = bench_futex_init(&handoff.pong, waitq);
+	if (rc != EOK) {
+		bench_futex_fini(&handoff.ping);
+		return bench_run_fail(run, "failed to create waitq: %s", str_error(rc));
+	}
+
+	fid_t fid = fibril_create(handoff_partner, &handoff);
+	if (!fid) {
+		bench_futex_fini(&handoff.ping);
+		bench_futex_fini(&handoff.pong);
+		return bench_run_fail(run, "failed to create partner fibril");
+	}
+
+	fibril_add_ready(fid);
+
+	bench_run_start(run);
+	for (uint64_t i = 0; i < niter; i++) {
+		bench_futex_up(&handoff.ping);
+		bench_futex_down(&handoff.pong);
+	}
+	bench_run_stop(run);
+
+	fibril_semaphore_down(&handoff.finished);
+
+	bench_futex_fini(&handoff.ping);
+	bench_futex_fini(&handoff.pong);
+	return true;
+}
+
+benchmark_t benchmark_futex_create = {
+	.name = "futex_create",
+	.desc = "Set up a futex and pass one wakeup through the kernel",
+	.entry = &runner_create,
+	.setup = &setup,
+	.teardown = NULL
+};
+
+benchmark_t benchmark_futex_handoff = {
+	.name = "futex_handoff",
+	.desc = "Two threads alternately waking each other up through futexes",
+	.entry = &runner_handoff,
+	.setup = &setup_handoff,
+	.teardown = NULL
+};
+
+/** @}
+ */
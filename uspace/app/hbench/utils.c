@@ -33,10 +33,14 @@
  * @file
  */
 
+#include <fibril.h>
 #include <stdarg.h>
 #include <stdio.h>
 #include "hbench.h"
 
+/** Number of runner threads spawned so far (besides the main one). */
+static int spawned_runners = 0;
+
 /** Initialize bench run structure.
  *
  * @param run Structure to intialize.
@@ -75,5 +79,20 @@ bool bench_run_fail(bench_run_t *run, const char *fmt, ...)
 	return false;
 }
 
+/** Make sure fibrils run on at least the given number of threads.
+ *
+ * Runner threads cannot be stopped, so benchmarks share the ones spawned
+ * by earlier runs and only ever add more.
+ *
+ * @param threads Number of runner threads, including the main one.
+ */
+void bench_runners_ensure(int threads)
+{
+	if (spawned_runners < threads - 1) {
+		spawned_runners +=
+		    fibril_test_spawn_runners(threads - 1 - spawned_runners);
+	}
+}
+
 /** @}
  */
@@ -74,28 +74,32 @@ static void list_tasks(void)
 		return;
 	}
 
-	printf("[taskid] [thrds] [resident] [virtual] [ucycles]"
+	printf("[taskid] [thrds] [resident] [virtual] [large] [ucycles]"
 	    " [kcycles] [name\n");
 
 	for (size_t i = 0; i < count; i++) {
 		uint64_t resmem;
 		uint64_t virtmem;
+		uint64_t largemem;
 		uint64_t ucycles;
 		uint64_t kcycles;
 		const char *resmem_suffix;
 		const char *virtmem_suffix;
+		const char *largemem_suffix;
 		char usuffix;
 		char ksuffix;
 
 		bin_order_suffix(stats_tasks[i].resmem, &resmem, &resmem_suffix, true);
 		bin_order_suffix(stats_tasks[i].virtmem, &virtmem, &virtmem_suffix, true);
+		bin_order_suffix(stats_tasks[i].largemem, &largemem, &largemem_suffix, true);
 		order_suffix(stats_tasks[i].ucycles, &ucycles, &usuffix);
 		order_suffix(stats_tasks[i].kcycles, &kcycles, &ksuffix);
 
 		printf("%-8" PRIu64 " %7zu %7" PRIu64 "%s %6" PRIu64 "%s"
-		    " %8" PRIu64 "%c %8" PRIu64 "%c %s\n",
+		    " %4" PRIu64 "%s %8" PRIu64 "%c %8" PRIu64 "%c %s\n",
 		    stats_tasks[i].task_id, stats_tasks[i].threads,
 		    resmem, resmem_suffix, virtmem, virtmem_suffix,
+		    largemem, largemem_suffix,
 		    ucycles, usuffix, kcycles, ksuffix, stats_tasks[i].name);
 	}
 
@@ -91,6 +91,10 @@ static const column_t ipc_columns[] = {
 	{ "ans snt", 'a', 9 },
 	{ "ans rcv", 'A', 9 },
 	{ "forward", 'f', 9 },
+	{ "queued",  'q', 8 },
+	{ "max q",   'Q', 8 },
+	{ "q wait",  'w', 9 },
+	{ "dispat",  'p', 8 },
 	{ "name",    'd', 0 },
 };
 
@@ -101,6 +105,10 @@ enum {
 	IPC_COL_ANS_SNT,
 	IPC_COL_ANS_RCV,
 	IPC_COL_FORWARD,
+	IPC_COL_QUEUED,
+	IPC_COL_QUEUED_MAX,
+	IPC_COL_QUEUED_CYCLES,
+	IPC_COL_DISPATCHED,
 	IPC_COL_NAME,
 	IPC_NUM_COLUMNS,
 };
@@ -470,6 +478,14 @@ static const char *fill_ipc_table(data_t *data)
 		field[IPC_COL_ANS_RCV].uint = data->tasks[i].ipc_info.answer_received;
 		field[IPC_COL_FORWARD].type = FIELD_UINT_SUFFIX_DEC;
 		field[IPC_COL_FORWARD].uint = data->tasks[i].ipc_info.forwarded;
+		field[IPC_COL_QUEUED].type = FIELD_UINT;
+		field[IPC_COL_QUEUED].uint = data->tasks[i].ipc_info.queued;
+		field[IPC_COL_QUEUED_MAX].type = FIELD_UINT;
+		field[IPC_COL_QUEUED_MAX].uint = data->tasks[i].ipc_info.queued_max;
+		field[IPC_COL_QUEUED_CYCLES].type = FIELD_UINT_SUFFIX_DEC;
+		field[IPC_COL_QUEUED_CYCLES].uint = data->tasks[i].ipc_info.queued_cycles;
+		field[IPC_COL_DISPATCHED].type = FIELD_UINT;
+		field[IPC_COL_DISPATCHED].uint = data->tasks[i].ipc_info.dispatched;
 		field[IPC_COL_NAME].type = FIELD_STRING;
 		field[IPC_COL_NAME].string = data->tasks[i].name;
 		field += IPC_NUM_COLUMNS;
@@ -59,6 +59,8 @@ const sc_desc_t syscall_desc[] = {
 	[SYS_WAITQ_SLEEP] = { "waitq_sleep", 3, V_ERRNO },
 	[SYS_WAITQ_WAKEUP] = { "waitq_wakeup", 1, V_ERRNO },
 	[SYS_WAITQ_DESTROY] = { "waitq_destroy", 1, V_ERRNO },
+	[SYS_FUTEX_SLEEP] = { "futex_sleep", 3, V_ERRNO },
+	[SYS_FUTEX_WAKEUP] = { "futex_wakeup", 1, V_ERRNO },
 	[SYS_SMC_COHERENCE] = { "smc_coherence", 2, V_ERRNO },
 
 	/* Address space related syscalls. */
@@ -74,11 +76,13 @@ const sc_desc_t syscall_desc[] = {
 	/* IPC related syscalls. */
 	[SYS_IPC_CALL_ASYNC_FAST] = { "ipc_call_async_fast", 6, V_HASH },
 	[SYS_IPC_CALL_ASYNC_SLOW] = { "ipc_call_async_slow", 3, V_HASH },
+	[SYS_IPC_CALL_ASYNC_BATCH] = { "ipc_call_async_batch", 3, V_ERRNO },
 	[SYS_IPC_ANSWER_FAST] = { "ipc_answer_fast", 6, V_ERRNO },
 	[SYS_IPC_ANSWER_SLOW] = { "ipc_answer_slow", 2, V_ERRNO },
 	[SYS_IPC_FORWARD_FAST] = { "ipc_forward_fast", 6, V_ERRNO },
 	[SYS_IPC_FORWARD_SLOW] = { "ipc_forward_slow", 3, V_ERRNO },
 	[SYS_IPC_WAIT] = { "ipc_wait_for_call", 3, V_HASH },
+	[SYS_IPC_WAIT_BATCH] = { "ipc_wait_batch", 5, V_ERRNO },
 	[SYS_IPC_POKE] = { "ipc_poke", 0, V_ERRNO },
 	[SYS_IPC_HANGUP] = { "ipc_hangup", 1, V_ERRNO },
 	[SYS_IPC_CONNECT_KBOX] = { "ipc_connect_kbox", 2, V_ERRNO },
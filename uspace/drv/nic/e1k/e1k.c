@@ -1177,6 +1177,7 @@ static uint32_t e1000_inc_tail(uint32_t tail, uint32_t descriptors_count)
 static void e1000_receive_frames(nic_t *nic)
 {
 	e1000_t *e1000 = DRIVER_DATA_NIC(nic);
+	nic_frame_list_t *frames = nic_alloc_frame_list();
 
 	fibril_mutex_lock(&e1000->rx_lock);
 
@@ -1189,11 +1190,13 @@ static void e1000_receive_frames(nic_t *nic)
 	while (rx_descriptor->status & 0x01) {
 		uint32_t frame_size = rx_descriptor->length - E1000_CRC_SIZE;
 
-		nic_frame_t *frame = nic_alloc_frame(nic, frame_size);
+		nic_frame_t *frame = NULL;
+		if (frames != NULL)
+			frame = nic_alloc_frame(nic, frame_size);
 		if (frame != NULL) {
 			memcpy(frame->data, e1000->rx_frame_virt[next_tail], frame_size);
 
-			nic_received_frame(nic, frame);
+			nic_frame_list_append(frames, frame);
 		} else {
 			ddf_msg(LVL_ERROR, "Memory allocation failed. Frame dropped.");
 		}
@@ -1208,6 +1211,9 @@ static void e1000_receive_frames(nic_t *nic)
 	}
 
 	fibril_mutex_unlock(&e1000->rx_lock);
+
+	/* Pass all received frames up at once, without holding the RX lock */
+	nic_received_frame_list(nic, frames);
 }
 
 /** Enable E1000 interupts
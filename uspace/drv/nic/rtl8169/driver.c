@@ -1037,9 +1037,16 @@ static void rtl8169_receive_done(ddf_dev_t *dev)
 
 			frame_size = descr->control & 0x1fff;
 			buffer = rtl8169->rx_buff + (BUFFER_SIZE * tail);
-			frame = nic_alloc_frame(nic_data, frame_size);
-			memcpy(frame->data, buffer, frame_size);
-			nic_frame_list_append(frames, frame);
+			frame = NULL;
+			if (frames != NULL)
+				frame = nic_alloc_frame(nic_data, frame_size);
+			if (frame != NULL) {
+				memcpy(frame->data, buffer, frame_size);
+				nic_frame_list_append(frames, frame);
+			} else {
+				ddf_msg(LVL_WARN, "cannot allocate RX frame, "
+				    "frame dropped");
+			}
 		}
 
 		tail = (tail + 1) % RX_BUFFERS_COUNT;
@@ -1052,7 +1059,6 @@ static void rtl8169_receive_done(ddf_dev_t *dev)
 	fibril_mutex_unlock(&rtl8169->rx_lock);
 
 	nic_received_frame_list(nic_data, frames);
-
 }
 
 /** RTL8169 IRQ handler.
@@ -32,12 +32,15 @@
 #include <stdint.h>
 
 #include <as.h>
+#include <byteorder.h>
 #include <ddf/driver.h>
 #include <ddf/interrupt.h>
 #include <ddf/log.h>
+#include <macros.h>
 #include <ops/nic.h>
 #include <pci_dev_iface.h>
 #include <nic/nic.h>
+#include <str_error.h>
 
 #include <nic.h>
 
@@ -45,17 +48,24 @@
 
 #define NAME	"virtio-net"
 
-#define VIRTIO_NET_NUM_QUEUES	3
-
-#define RX_QUEUE_1	0
-#define TX_QUEUE_1	1
-#define CT_QUEUE_1	2
-
 #define BUFFER_SIZE	2048
 #define RX_BUF_SIZE	BUFFER_SIZE
 #define TX_BUF_SIZE	BUFFER_SIZE
 #define CT_BUF_SIZE	BUFFER_SIZE
 
+/** How long to wait for the device to complete a control command */
+#define CT_TIMEOUT	(1000 * 1000)
+
+/** Features the driver cannot work without */
+#define VIRTIO_NET_FEATURES \
+	(VIRTIO_NET_F_MAC | VIRTIO_NET_F_CTRL_VQ)
+/** Features the driver uses if the device offers them */
+#define VIRTIO_NET_FEATURES_OPTIONAL \
+	(VIRTIO_NET_F_GUEST_CSUM | VIRTIO_NET_F_GUEST_TSO4 | \
+	VIRTIO_NET_F_GUEST_TSO6 | VIRTIO_NET_F_MRG_RXBUF | VIRTIO_NET_F_MQ)
+#define VIRTIO_NET_FEATURES_GUEST_TSO \
+	(VIRTIO_NET_F_GUEST_TSO4 | VIRTIO_NET_F_GUEST_TSO6)
+
 static ddf_dev_ops_t virtio_net_dev_ops;
 
 static errno_t virtio_net_dev_add(ddf_dev_t *dev);
@@ -69,50 +79,253 @@ static driver_t virtio_net_driver = {
 	.driver_ops = &virtio_net_driver_ops
 };
 
-/** VirtIO net IRQ handler.
+/** Complete a partial checksum of a received frame.
  *
- * @param icall IRQ event notification
- * @param arg Argument (nic_t *)
+ * The device leaves the checksum field at csum_start + csum_offset holding
+ * the pseudo-header checksum. The Internet checksum computed from csum_start
+ * to the end of the frame is stored there.
+ *
+ * @param data Frame data
+ * @param size Frame size
+ * @param hdr Packet header received with the frame
+ *
+ * @return @c true on success, @c false if the header does not fit the frame
  */
-static void virtio_net_irq_handler(ipc_call_t *icall, void *arg)
+static bool virtio_net_csum_complete(uint8_t *data, size_t size,
+    const virtio_net_hdr_t *hdr)
+{
+	size_t start = uint16_t_le2host(hdr->csum_start);
+	size_t off = start + uint16_t_le2host(hdr->csum_offset);
+	if (start >= size || off + sizeof(uint16_t) > size)
+		return false;
+
+	uint32_t sum = 0;
+	size_t i;
+	for (i = start; i + 1 < size; i += 2)
+		sum += ((uint32_t) data[i] << 8) | data[i + 1];
+	if (i < size)
+		sum += (uint32_t) data[i] << 8;
+
+	while ((sum >> 16) != 0)
+		sum = (sum & 0xffff) + (sum >> 16);
+
+	uint16_t csum = ~sum;
+	data[off] = csum >> 8;
+	data[off + 1] = csum & 0xff;
+	return true;
+}
+
+/** Pass frames received on a queue pair to the NIC framework.
+ *
+ * Frames that arrive in a single buffer are passed up directly from the DMA
+ * buffer, which is given back to the device only after the frame has been
+ * delivered. Frames spread over several merged buffers are gathered into
+ * a newly allocated frame.
+ *
+ * @param nic NIC
+ * @param qp Queue pair
+ */
+static void virtio_net_receive(nic_t *nic, virtio_net_queue_pair_t *qp)
 {
-	nic_t *nic = (nic_t *)arg;
 	virtio_net_t *virtio_net = nic_get_specific(nic);
 	virtio_dev_t *vdev = &virtio_net->virtio_dev;
+	bool mrg_rxbuf = (vdev->features & VIRTIO_NET_F_MRG_RXBUF) != 0;
+
+	nic_frame_list_t *frames = nic_alloc_frame_list();
+
+	/* Buffers referenced by frames on the list */
+	uint16_t lent[RX_BUFFERS];
+	unsigned lent_count = 0;
+	bool recycled = false;
 
 	uint16_t descno;
 	uint32_t len;
-	while (virtio_virtq_consume_used(vdev, RX_QUEUE_1, &descno, &len)) {
-		virtio_net_hdr_t *hdr =
-		    (virtio_net_hdr_t *) virtio_net->rx_buf[descno];
-		if (len <= sizeof(*hdr)) {
+	while (virtio_virtq_consume_used(vdev, qp->rx_queue, &descno, &len)) {
+		/* The buffer may be recycled before we are done with the frame */
+		virtio_net_hdr_t hdr = *(virtio_net_hdr_t *) qp->rx_buf[descno];
+		uint8_t *data = (uint8_t *) qp->rx_buf[descno] + sizeof(hdr);
+		uint16_t nbufs = mrg_rxbuf ? uint16_t_le2host(hdr.num_buffers) : 1;
+		nic_frame_t *frame = NULL;
+
+		len = min(len, RX_BUF_SIZE);
+		if (len <= sizeof(hdr) || nbufs == 0 || nbufs > RX_BUFFERS) {
 			ddf_msg(LVL_WARN,
 			    "RX data length too short, packet dropped");
-			virtio_virtq_produce_available(vdev, RX_QUEUE_1,
-			    descno);
+			virtio_virtq_add_available(vdev, qp->rx_queue, descno);
+			recycled = true;
 			continue;
 		}
 
-		nic_frame_t *frame = nic_alloc_frame(nic, len - sizeof(*hdr));
-		if (frame) {
-			memcpy(frame->data, &hdr[1], len - sizeof(*hdr));
-			nic_received_frame(nic, frame);
+		size_t size = len - sizeof(hdr);
+		if (nbufs == 1) {
+			if (frames != NULL)
+				frame = nic_wrap_frame(nic, data, size);
+			if (frame != NULL) {
+				lent[lent_count++] = descno;
+			} else {
+				virtio_virtq_add_available(vdev, qp->rx_queue,
+				    descno);
+				recycled = true;
+			}
 		} else {
+			if (frames != NULL)
+				frame = nic_alloc_frame(nic, nbufs * RX_BUF_SIZE);
+			if (frame != NULL)
+				memcpy(frame->data, data, size);
+			virtio_virtq_add_available(vdev, qp->rx_queue, descno);
+
+			for (uint16_t i = 1; i < nbufs; i++) {
+				if (!virtio_virtq_consume_used(vdev,
+				    qp->rx_queue, &descno, &len)) {
+					nic_release_frame(nic, frame);
+					frame = NULL;
+					break;
+				}
+
+				len = min(len, RX_BUF_SIZE);
+				if (frame != NULL) {
+					memcpy(frame->data + size,
+					    qp->rx_buf[descno], len);
+				}
+				size += len;
+				virtio_virtq_add_available(vdev, qp->rx_queue,
+				    descno);
+			}
+			recycled = true;
+
+			if (frame != NULL)
+				frame->size = size;
+		}
+
+		if (frame == NULL) {
 			ddf_msg(LVL_WARN,
 			    "Cannot allocate RX frame, packet dropped");
+			continue;
+		}
+
+		if ((hdr.flags & VIRTIO_NET_HDR_F_NEEDS_CSUM) &&
+		    !virtio_net_csum_complete(frame->data, frame->size, &hdr)) {
+			ddf_msg(LVL_WARN,
+			    "Invalid RX checksum offset, packet dropped");
+			nic_release_frame(nic, frame);
+			continue;
+		}
+
+		nic_frame_list_append(frames, frame);
+	}
+
+	/* Pass all received frames up at once */
+	nic_received_frame_list(nic, frames);
+
+	/* The frames have been copied out, give their buffers back */
+	for (unsigned i = 0; i < lent_count; i++) {
+		virtio_virtq_add_available(vdev, qp->rx_queue, lent[i]);
+		recycled = true;
+	}
+
+	if (recycled)
+		virtio_virtq_notify(vdev, qp->rx_queue);
+}
+
+/** VirtIO net IRQ handler.
+ *
+ * There is a single INTx interrupt for the whole device, so all queues are
+ * serviced here.
+ *
+ * @param icall IRQ event notification
+ * @param arg Argument (nic_t *)
+ */
+static void virtio_net_irq_handler(ipc_call_t *icall, void *arg)
+{
+	nic_t *nic = (nic_t *)arg;
+	virtio_net_t *virtio_net = nic_get_specific(nic);
+	virtio_dev_t *vdev = &virtio_net->virtio_dev;
+
+	for (unsigned i = 0; i < virtio_net->pair_count; i++)
+		virtio_net_receive(nic, &virtio_net->pairs[i]);
+
+	uint16_t descno;
+	uint32_t len;
+	for (unsigned i = 0; i < virtio_net->pair_count; i++) {
+		virtio_net_queue_pair_t *qp = &virtio_net->pairs[i];
+
+		while (virtio_virtq_consume_used(vdev, qp->tx_queue, &descno,
+		    &len)) {
+			virtio_free_desc(vdev, qp->tx_queue, &qp->tx_free_head,
+			    descno);
+		}
+	}
+
+	while (virtio_virtq_consume_used(vdev, virtio_net->ct_queue, &descno,
+	    &len)) {
+		uint16_t next = virtio_virtq_desc_get_next(vdev,
+		    virtio_net->ct_queue, descno);
+		virtio_free_desc(vdev, virtio_net->ct_queue,
+		    &virtio_net->ct_free_head, descno);
+		if (next != (uint16_t) -1U) {
+			virtio_free_desc(vdev, virtio_net->ct_queue,
+			    &virtio_net->ct_free_head, next);
 		}
 
-		virtio_virtq_produce_available(vdev, RX_QUEUE_1, descno);
+		fibril_mutex_lock(&virtio_net->ct_lock);
+		virtio_net->ct_done = true;
+		fibril_condvar_broadcast(&virtio_net->ct_cv);
+		fibril_mutex_unlock(&virtio_net->ct_lock);
 	}
+}
 
-	while (virtio_virtq_consume_used(vdev, TX_QUEUE_1, &descno, &len)) {
-		virtio_free_desc(vdev, TX_QUEUE_1, &virtio_net->tx_free_head,
-		    descno);
+/** Tell the device how many queue pairs to use.
+ *
+ * The device must be live for the control queue to be processed.
+ *
+ * @param virtio_net VirtIO net device
+ * @param pairs Number of queue pairs
+ *
+ * @return EOK on success or an error code
+ */
+static errno_t virtio_net_ctrl_mq_set(virtio_net_t *virtio_net, uint16_t pairs)
+{
+	virtio_dev_t *vdev = &virtio_net->virtio_dev;
+	uint16_t ct = virtio_net->ct_queue;
+
+	uint16_t cmd = virtio_alloc_desc(vdev, ct, &virtio_net->ct_free_head);
+	if (cmd == (uint16_t) -1U)
+		return ENOMEM;
+	uint16_t ack = virtio_alloc_desc(vdev, ct, &virtio_net->ct_free_head);
+	if (ack == (uint16_t) -1U) {
+		virtio_free_desc(vdev, ct, &virtio_net->ct_free_head, cmd);
+		return ENOMEM;
 	}
-	while (virtio_virtq_consume_used(vdev, CT_QUEUE_1, &descno, &len)) {
-		virtio_free_desc(vdev, CT_QUEUE_1, &virtio_net->ct_free_head,
-		    descno);
+
+	virtio_net_ctrl_hdr_t *hdr = virtio_net->ct_buf[cmd];
+	hdr->class = VIRTIO_NET_CTRL_MQ;
+	hdr->command = VIRTIO_NET_CTRL_MQ_VQ_PAIRS_SET;
+	uint16_t *arg = (uint16_t *) &hdr[1];
+	*arg = host2uint16_t_le(pairs);
+
+	volatile uint8_t *status = virtio_net->ct_buf[ack];
+	*status = VIRTIO_NET_ERR;
+
+	virtio_virtq_desc_set(vdev, ct, cmd, virtio_net->ct_buf_p[cmd],
+	    sizeof(*hdr) + sizeof(*arg), VIRTQ_DESC_F_NEXT, ack);
+	virtio_virtq_desc_set(vdev, ct, ack, virtio_net->ct_buf_p[ack],
+	    sizeof(*status), VIRTQ_DESC_F_WRITE, 0);
+
+	fibril_mutex_lock(&virtio_net->ct_lock);
+	virtio_net->ct_done = false;
+	virtio_virtq_produce_available(vdev, ct, cmd);
+
+	errno_t rc = EOK;
+	while (!virtio_net->ct_done && rc == EOK) {
+		rc = fibril_condvar_wait_timeout(&virtio_net->ct_cv,
+		    &virtio_net->ct_lock, CT_TIMEOUT);
 	}
+	fibril_mutex_unlock(&virtio_net->ct_lock);
+
+	if (rc != EOK)
+		return rc;
+
+	return (*status == VIRTIO_NET_OK) ? EOK : EIO;
 }
 
 static errno_t virtio_net_register_interrupt(ddf_dev_t *dev)
@@ -172,6 +385,83 @@ static errno_t virtio_net_register_interrupt(ddf_dev_t *dev)
 	    &virtio_net->irq_handle);
 }
 
+
+/** Release the DMA buffers of all queues.
+ *
+ * @param virtio_net VirtIO net device
+ */
+static void virtio_net_teardown_bufs(virtio_net_t *virtio_net)
+{
+	for (unsigned i = 0; i < VIRTIO_NET_MAX_QUEUE_PAIRS; i++) {
+		virtio_teardown_dma_bufs(virtio_net->pairs[i].rx_buf);
+		virtio_teardown_dma_bufs(virtio_net->pairs[i].tx_buf);
+	}
+	virtio_teardown_dma_bufs(virtio_net->ct_buf);
+}
+
+/** Set up the virtqueues and DMA buffers of a queue pair.
+ *
+ * @param virtio_net VirtIO net device
+ * @param qp Queue pair
+ * @param index Index of the queue pair
+ *
+ * @return EOK on success or an error code
+ */
+static errno_t virtio_net_pair_setup(virtio_net_t *virtio_net,
+    virtio_net_queue_pair_t *qp, unsigned index)
+{
+	virtio_dev_t *vdev = &virtio_net->virtio_dev;
+
+	qp->rx_queue = 2 * index;
+	qp->tx_queue = 2 * index + 1;
+
+	errno_t rc = virtio_virtq_setup(vdev, qp->rx_queue, RX_BUFFERS);
+	if (rc != EOK)
+		return rc;
+	rc = virtio_virtq_setup(vdev, qp->tx_queue, TX_BUFFERS);
+	if (rc != EOK)
+		return rc;
+
+	/*
+	 * Setup DMA buffers. RX buffers are writable so that partial
+	 * checksums can be completed in place.
+	 */
+	rc = virtio_setup_dma_bufs(RX_BUFFERS, RX_BUF_SIZE, true,
+	    qp->rx_buf, qp->rx_buf_p);
+	if (rc != EOK)
+		return rc;
+	rc = virtio_setup_dma_bufs(TX_BUFFERS, TX_BUF_SIZE, true,
+	    qp->tx_buf, qp->tx_buf_p);
+	if (rc != EOK)
+		return rc;
+
+	/*
+	 * Give all RX buffers to the NIC
+	 */
+	for (unsigned i = 0; i < RX_BUFFERS; i++) {
+		/*
+		 * Associtate the buffer with the descriptor, set length and
+		 * flags.
+		 */
+		virtio_virtq_desc_set(vdev, qp->rx_queue, i, qp->rx_buf_p[i],
+		    RX_BUF_SIZE, VIRTQ_DESC_F_WRITE, 0);
+		/*
+		 * Put the set descriptor into the available ring of the RX
+		 * queue.
+		 */
+		virtio_virtq_add_available(vdev, qp->rx_queue, i);
+	}
+	virtio_virtq_notify(vdev, qp->rx_queue);
+
+	/*
+	 * Put all TX buffers on a free list
+	 */
+	virtio_create_desc_free_list(vdev, qp->tx_queue, TX_BUFFERS,
+	    &qp->tx_free_head);
+
+	return EOK;
+}
+
 static errno_t virtio_net_initialize(ddf_dev_t *dev)
 {
 	nic_t *nic = nic_create_and_bind(dev);
@@ -186,6 +476,9 @@ static errno_t virtio_net_initialize(ddf_dev_t *dev)
 
 	nic_set_specific(nic, virtio_net);
 
+	fibril_mutex_initialize(&virtio_net->ct_lock);
+	fibril_condvar_initialize(&virtio_net->ct_cv);
+
 	errno_t rc = virtio_pci_dev_initialize(dev, &virtio_net->virtio_dev);
 	if (rc != EOK)
 		return rc;
@@ -202,18 +495,34 @@ static errno_t virtio_net_initialize(ddf_dev_t *dev)
 		goto fail;
 
 	/* Reset the device and negotiate the feature bits */
-	rc = virtio_device_setup_start(vdev,
-	    VIRTIO_NET_F_MAC | VIRTIO_NET_F_CTRL_VQ);
+	rc = virtio_device_setup_start(vdev, VIRTIO_NET_FEATURES,
+	    VIRTIO_NET_FEATURES_OPTIONAL);
+	if (rc == EOK && (vdev->features & VIRTIO_NET_FEATURES_GUEST_TSO) &&
+	    (!(vdev->features & VIRTIO_NET_F_GUEST_CSUM) ||
+	    !(vdev->features & VIRTIO_NET_F_MRG_RXBUF))) {
+		/*
+		 * Large received segments need merged buffers and come with
+		 * partial checksums. Renegotiate without them.
+		 */
+		rc = virtio_device_setup_start(vdev, VIRTIO_NET_FEATURES,
+		    VIRTIO_NET_FEATURES_OPTIONAL &
+		    ~VIRTIO_NET_FEATURES_GUEST_TSO);
+	}
 	if (rc != EOK)
 		goto fail;
 
 	/* Perform device-specific setup */
 
 	/*
-	 * Discover and configure the virtqueues
+	 * Discover and configure the virtqueues. The control queue follows
+	 * the maximum number of queue pairs the device supports.
 	 */
+	uint16_t max_pairs = 1;
+	if (vdev->features & VIRTIO_NET_F_MQ)
+		max_pairs = pio_read_le16(&netcfg->max_virtqueue_pairs);
+
 	uint16_t num_queues = pio_read_le16(&cfg->num_queues);
-	if (num_queues != VIRTIO_NET_NUM_QUEUES) {
+	if (max_pairs == 0 || num_queues < 2 * max_pairs + 1) {
 		ddf_msg(LVL_NOTE, "Unsupported number of virtqueues: %u",
 		    num_queues);
 		rc = ELIMIT;
@@ -226,25 +535,19 @@ static errno_t virtio_net_initialize(ddf_dev_t *dev)
 		goto fail;
 	}
 
-	rc = virtio_virtq_setup(vdev, RX_QUEUE_1, RX_BUFFERS);
-	if (rc != EOK)
-		goto fail;
-	rc = virtio_virtq_setup(vdev, TX_QUEUE_1, TX_BUFFERS);
-	if (rc != EOK)
-		goto fail;
-	rc = virtio_virtq_setup(vdev, CT_QUEUE_1, CT_BUFFERS);
-	if (rc != EOK)
-		goto fail;
+	unsigned pairs = min(max_pairs, VIRTIO_NET_MAX_QUEUE_PAIRS);
+	for (unsigned i = 0; i < pairs; i++) {
+		rc = virtio_net_pair_setup(virtio_net, &virtio_net->pairs[i],
+		    i);
+		if (rc != EOK)
+			goto fail;
+	}
 
-	/*
-	 * Setup DMA buffers
-	 */
-	rc = virtio_setup_dma_bufs(RX_BUFFERS, RX_BUF_SIZE, false,
-	    virtio_net->rx_buf, virtio_net->rx_buf_p);
-	if (rc != EOK)
-		goto fail;
-	rc = virtio_setup_dma_bufs(TX_BUFFERS, TX_BUF_SIZE, true,
-	    virtio_net->tx_buf, virtio_net->tx_buf_p);
+	/* Until told otherwise, the device uses just the first queue pair */
+	virtio_net->pair_count = 1;
+
+	virtio_net->ct_queue = 2 * max_pairs;
+	rc = virtio_virtq_setup(vdev, virtio_net->ct_queue, CT_BUFFERS);
 	if (rc != EOK)
 		goto fail;
 	rc = virtio_setup_dma_bufs(CT_BUFFERS, CT_BUF_SIZE, true,
@@ -253,29 +556,9 @@ static errno_t virtio_net_initialize(ddf_dev_t *dev)
 		goto fail;
 
 	/*
-	 * Give all RX buffers to the NIC
+	 * Put all CT buffers on a free list
 	 */
-	for (unsigned i = 0; i < RX_BUFFERS; i++) {
-		/*
-		 * Associtate the buffer with the descriptor, set length and
-		 * flags.
-		 */
-		virtio_virtq_desc_set(vdev, RX_QUEUE_1, i,
-		    virtio_net->rx_buf_p[i], RX_BUF_SIZE, VIRTQ_DESC_F_WRITE,
-		    0);
-		/*
-		 * Put the set descriptor into the available ring of the RX
-		 * queue.
-		 */
-		virtio_virtq_produce_available(vdev, RX_QUEUE_1, i);
-	}
-
-	/*
-	 * Put all TX and CT buffers on a free list
-	 */
-	virtio_create_desc_free_list(vdev, TX_QUEUE_1, TX_BUFFERS,
-	    &virtio_net->tx_free_head);
-	virtio_create_desc_free_list(vdev, CT_QUEUE_1, CT_BUFFERS,
+	virtio_create_desc_free_list(vdev, virtio_net->ct_queue, CT_BUFFERS,
 	    &virtio_net->ct_free_head);
 
 	/*
@@ -305,12 +588,24 @@ static errno_t virtio_net_initialize(ddf_dev_t *dev)
 	/* Go live */
 	virtio_device_setup_finalize(vdev);
 
+	/* Spread the traffic over all queue pairs */
+	if (pairs > 1) {
+		rc = virtio_net_ctrl_mq_set(virtio_net, pairs);
+		if (rc == EOK) {
+			virtio_net->pair_count = pairs;
+		} else {
+			ddf_msg(LVL_WARN, "Failed to enable %u queue pairs: %s",
+			    pairs, str_error(rc));
+		}
+	}
+
+	ddf_msg(LVL_NOTE, "Using %u queue pair(s), features %x",
+	    virtio_net->pair_count, vdev->features);
+
 	return EOK;
 
 fail:
-	virtio_teardown_dma_bufs(virtio_net->rx_buf);
-	virtio_teardown_dma_bufs(virtio_net->tx_buf);
-	virtio_teardown_dma_bufs(virtio_net->ct_buf);
+	virtio_net_teardown_bufs(virtio_net);
 
 	virtio_device_setup_fail(vdev);
 	virtio_pci_dev_cleanup(vdev);
@@ -322,34 +617,94 @@ static void virtio_net_uninitialize(ddf_dev_t *dev)
 	nic_t *nic = ddf_dev_data_get(dev);
 	virtio_net_t *virtio_net = (virtio_net_t *) nic_get_specific(nic);
 
-	virtio_teardown_dma_bufs(virtio_net->rx_buf);
-	virtio_teardown_dma_bufs(virtio_net->tx_buf);
-	virtio_teardown_dma_bufs(virtio_net->ct_buf);
+	virtio_net_teardown_bufs(virtio_net);
 
 	virtio_device_setup_fail(&virtio_net->virtio_dev);
 	virtio_pci_dev_cleanup(&virtio_net->virtio_dev);
 }
 
-static void virtio_net_send(nic_t *nic, void *data, size_t size)
+/** Select the transmit queue pair for a frame.
+ *
+ * Frames are spread by their IP source and destination addresses, so that
+ * frames of a single connection stay in order.
+ *
+ * @param virtio_net VirtIO net device
+ * @param data Frame data
+ * @param size Frame size
+ *
+ * @return Queue pair index
+ */
+static unsigned virtio_net_tx_select(virtio_net_t *virtio_net,
+    const uint8_t *data, size_t size)
+{
+	if (virtio_net->pair_count == 1 || size < ETH_ADDR * 2 + 2)
+		return 0;
+
+	size_t off;
+	size_t len;
+	uint16_t ethertype = ((uint16_t) data[12] << 8) | data[13];
+	switch (ethertype) {
+	case 0x0800:
+		/* IPv4 source and destination address */
+		off = 14 + 12;
+		len = 8;
+		break;
+	case 0x86dd:
+		/* IPv6 source and destination address */
+		off = 14 + 8;
+		len = 32;
+		break;
+	default:
+		return 0;
+	}
+
+	if (off + len > size)
+		return 0;
+
+	uint32_t hash = 0;
+	for (size_t i = off; i < off + len; i++)
+		hash = hash * 31 + data[i];
+
+	return hash % virtio_net->pair_count;
+}
+
+/** Send a frame on one of the transmit queues.
+ *
+ * Each transmit queue is busy on its own while its ring is full, so a full
+ * queue does not hold up frames for the other queues. The frame that finds
+ * its queue full is refused and the client gets the error.
+ *
+ * @param nic NIC
+ * @param data Frame data
+ * @param size Frame size in bytes
+ *
+ * @return EOK on success, EBUSY if the transmit queue is full, ELIMIT if
+ *         the frame is too big
+ */
+static errno_t virtio_net_send(nic_t *nic, void *data, size_t size)
 {
 	virtio_net_t *virtio_net = nic_get_specific(nic);
 	virtio_dev_t *vdev = &virtio_net->virtio_dev;
 
-	if (size > sizeof(virtio_net) + TX_BUF_SIZE) {
+	if (size > TX_BUF_SIZE - sizeof(virtio_net_hdr_t)) {
 		ddf_msg(LVL_WARN, "TX data too big, frame dropped");
-		return;
+		return ELIMIT;
 	}
 
-	uint16_t descno = virtio_alloc_desc(vdev, TX_QUEUE_1,
-	    &virtio_net->tx_free_head);
+	virtio_net_queue_pair_t *qp =
+	    &virtio_net->pairs[virtio_net_tx_select(virtio_net, data, size)];
+
+	uint16_t descno = virtio_alloc_desc(vdev, qp->tx_queue,
+	    &qp->tx_free_head);
 	if (descno == (uint16_t) -1U) {
-		ddf_msg(LVL_WARN, "No TX buffers available, frame dropped");
-		return;
+		ddf_msg(LVL_DEBUG, "No TX buffers available, frame refused");
+		nic_report_send_error(nic, NIC_SEC_BUFFER_FULL, 1);
+		return EBUSY;
 	}
 	assert(descno < TX_BUFFERS);
 
 	/* Setup the packet header */
-	virtio_net_hdr_t *hdr = (virtio_net_hdr_t *) virtio_net->tx_buf[descno];
+	virtio_net_hdr_t *hdr = (virtio_net_hdr_t *) qp->tx_buf[descno];
 	memset(hdr, 0, sizeof(virtio_net_hdr_t));
 	hdr->gso_type = VIRTIO_NET_HDR_GSO_NONE;
 	hdr->num_buffers = 0;
@@ -360,9 +715,10 @@ static void virtio_net_send(nic_t *nic, void *data, size_t size)
 	/*
 	 * Set the descriptor, put it into the virtqueue and notify the device
 	 */
-	virtio_virtq_desc_set(vdev, TX_QUEUE_1, descno,
-	    virtio_net->tx_buf_p[descno], sizeof(virtio_net_hdr_t) + size, 0, 0);
-	virtio_virtq_produce_available(vdev, TX_QUEUE_1, descno);
+	virtio_virtq_desc_set(vdev, qp->tx_queue, descno,
+	    qp->tx_buf_p[descno], sizeof(virtio_net_hdr_t) + size, 0, 0);
+	virtio_virtq_produce_available(vdev, qp->tx_queue, descno);
+	return EOK;
 }
 
 static errno_t virtio_net_on_multicast_mode_change(nic_t *nic,
@@ -416,7 +772,7 @@ static errno_t virtio_net_dev_add(ddf_dev_t *dev)
 	nic_set_ddf_fun(nic, fun);
 	ddf_fun_set_ops(fun, &virtio_net_dev_ops);
 
-	nic_set_send_frame_handler(nic, virtio_net_send);
+	nic_set_try_send_frame_handler(nic, virtio_net_send);
 	nic_set_filtering_change_handlers(nic, NULL,
 	    virtio_net_on_multicast_mode_change,
 	    virtio_net_on_broadcast_mode_change, NULL, NULL);
@@ -31,22 +31,44 @@
 
 #include <virtio-pci.h>
 #include <abi/cap.h>
+#include <fibril_synch.h>
 #include <nic/nic.h>
 
-#define RX_BUFFERS	8
-#define TX_BUFFERS	8
+/** Number of RX descriptors and buffers in each receive queue */
+#define RX_BUFFERS	64
+/** Number of TX descriptors and buffers in each transmit queue */
+#define TX_BUFFERS	64
 #define CT_BUFFERS	4
 
+/** Maximum number of queue pairs used by the driver */
+#define VIRTIO_NET_MAX_QUEUE_PAIRS	4
+
 /** Device handles packets with partial checksum. */
 #define VIRTIO_NET_F_CSUM		(1U << 0)
 /** Driver handles packets with partial checksum. */
-#define VIRTIO_NET_F_GUEST_CSUM		(1U << 2)
+#define VIRTIO_NET_F_GUEST_CSUM		(1U << 1)
 /** Device has given MAC address. */
 #define VIRTIO_NET_F_MAC		(1U << 5)
+/** Driver can receive TSOv4. */
+#define VIRTIO_NET_F_GUEST_TSO4		(1U << 7)
+/** Driver can receive TSOv6. */
+#define VIRTIO_NET_F_GUEST_TSO6		(1U << 8)
+/** Driver can merge receive buffers. */
+#define VIRTIO_NET_F_MRG_RXBUF		(1U << 15)
 /** Control channel is available */
 #define VIRTIO_NET_F_CTRL_VQ		(1U << 17)
+/** Device supports multiqueue with automatic receive steering. */
+#define VIRTIO_NET_F_MQ			(1U << 22)
+
+/** Checksum starting at csum_start must be completed by the driver. */
+#define VIRTIO_NET_HDR_F_NEEDS_CSUM	1
+/** Checksum of the packet has been validated by the device. */
+#define VIRTIO_NET_HDR_F_DATA_VALID	2
 
 #define VIRTIO_NET_HDR_GSO_NONE 0
+#define VIRTIO_NET_HDR_GSO_TCPV4 1
+#define VIRTIO_NET_HDR_GSO_UDP 3
+#define VIRTIO_NET_HDR_GSO_TCPV6 4
 typedef struct {
 	uint8_t flags;
 	uint8_t gso_type;
@@ -57,22 +79,57 @@ typedef struct {
 	uint16_t num_buffers;
 } virtio_net_hdr_t;
 
+/** Control virtqueue command header */
+typedef struct {
+	uint8_t class;
+	uint8_t command;
+} __attribute__((packed)) virtio_net_ctrl_hdr_t;
+
+#define VIRTIO_NET_OK	0
+#define VIRTIO_NET_ERR	1
+
+#define VIRTIO_NET_CTRL_MQ			4
+#define VIRTIO_NET_CTRL_MQ_VQ_PAIRS_SET		0
+
 typedef struct {
 	uint8_t mac[ETH_ADDR];
+	ioport16_t status;
+	ioport16_t max_virtqueue_pairs;
 } virtio_net_cfg_t;
 
+/** Receive and transmit virtqueue pair */
 typedef struct {
-	virtio_dev_t virtio_dev;
+	/** Index of the receive virtqueue */
+	uint16_t rx_queue;
+	/** Index of the transmit virtqueue */
+	uint16_t tx_queue;
+
 	void *rx_buf[RX_BUFFERS];
 	uintptr_t rx_buf_p[RX_BUFFERS];
 	void *tx_buf[TX_BUFFERS];
 	uintptr_t tx_buf_p[TX_BUFFERS];
-	void *ct_buf[CT_BUFFERS];
-	uintptr_t ct_buf_p[CT_BUFFERS];
 
 	uint16_t tx_free_head;
+} virtio_net_queue_pair_t;
+
+typedef struct {
+	virtio_dev_t virtio_dev;
+
+	/** Queue pairs in use */
+	virtio_net_queue_pair_t pairs[VIRTIO_NET_MAX_QUEUE_PAIRS];
+	unsigned pair_count;
+
+	/** Index of the control virtqueue */
+	uint16_t ct_queue;
+	void *ct_buf[CT_BUFFERS];
+	uintptr_t ct_buf_p[CT_BUFFERS];
 	uint16_t ct_free_head;
 
+	/** Synchronizes control commands with their completion */
+	fibril_mutex_t ct_lock;
+	fibril_condvar_t ct_cv;
+	bool ct_done;
+
 	int irq;
 	cap_irq_handle_t irq_handle;
 } virtio_net_t;
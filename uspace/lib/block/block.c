@@ -55,10 +55,29 @@
 #include <str_error.h>
 #include <offset.h>
 #include <inttypes.h>
+#include <stdatomic.h>
 #include "block.h"
 
 #define MAX_WRITE_RETRIES 10
 
+/** Number of independently locked parts of a block cache */
+#define CACHE_SHARDS	8
+
+/**
+ * Maximal share (numerator / denominator) of the unreferenced blocks in a
+ * shard that may sit on the hot list before the hot list is used as the
+ * source of victims.
+ */
+#define CACHE_HOT_SHARE_NUM	3
+#define CACHE_HOT_SHARE_DEN	4
+
+/** Maximal number of adjacent dirty blocks written back in one request */
+#define CACHE_WB_BATCH	16
+
+/** Initial and maximal number of blocks read ahead of a sequential reader */
+#define RA_MIN_WINDOW	4
+#define RA_MAX_WINDOW	32
+
 /** Lock protecting the device connection list */
 static FIBRIL_MUTEX_INITIALIZE(dcl_lock);
 /** Device connection list head. */
@@ -66,15 +85,48 @@ static LIST_INITIALIZE(dcl);
 
 typedef struct {
 	fibril_mutex_t lock;
+	hash_table_t block_hash;
+	list_t cold_list;         /**< Unreferenced blocks used once. */
+	list_t hot_list;          /**< Unreferenced blocks used repeatedly. */
+	size_t cold_count;        /**< Number of blocks on cold_list. */
+	size_t hot_count;         /**< Number of blocks on hot_list. */
+	uint64_t hits;            /**< Lookups satisfied from the shard. */
+	uint64_t misses;          /**< Blocks instantiated in the shard. */
+	uint64_t evictions;       /**< Blocks recycled or freed. */
+} cache_shard_t;
+
+typedef struct {
 	size_t lblock_size;       /**< Logical block size. */
 	unsigned blocks_cluster;  /**< Physical blocks per block_t */
 	unsigned block_count;     /**< Total number of blocks. */
-	unsigned blocks_cached;   /**< Number of cached blocks. */
-	hash_table_t block_hash;
-	list_t free_list;
+	atomic_uint blocks_cached;   /**< Number of cached blocks. */
 	enum cache_mode mode;
+	atomic_uint_fast64_t wb_batches;  /**< Write-back requests issued. */
+	atomic_uint_fast64_t wb_blocks;   /**< Blocks written back. */
+	atomic_uint_fast64_t ra_blocks;   /**< Blocks read ahead. */
+	/** Blocks are distributed among the shards by their logical address. */
+	cache_shard_t shards[CACHE_SHARDS];
+
+	/*
+	 * Read-ahead state, protected by ra_lock.
+	 */
+	fibril_mutex_t ra_lock;
+	fibril_condvar_t ra_cv;
+	list_t ra_queue;          /**< Pending ra_req_t requests. */
+	bool ra_running;          /**< Read-ahead fibril is running. */
+	bool ra_stop;             /**< Read-ahead fibril should terminate. */
+	aoff64_t ra_last;         /**< Last block requested by block_get(). */
+	aoff64_t ra_next;         /**< First block not requested ahead yet. */
+	size_t ra_window;         /**< Read-ahead window, 0 if not sequential. */
 } cache_t;
 
+/** Request for the read-ahead fibril */
+typedef struct {
+	link_t link;
+	aoff64_t ba;              /**< First logical block. */
+	size_t cnt;               /**< Number of blocks. */
+} ra_req_t;
+
 typedef struct {
 	link_t link;
 	service_id_t service_id;
@@ -89,6 +141,9 @@ typedef struct {
 
 static errno_t read_blocks(devcon_t *, aoff64_t, size_t, void *, size_t);
 static errno_t write_blocks(devcon_t *, aoff64_t, size_t, void *, size_t);
+static errno_t cache_writeback(devcon_t *, block_t *);
+static errno_t readahead_fibril(void *);
+static void readahead_access(devcon_t *, aoff64_t);
 static aoff64_t ba_ltop(devcon_t *, aoff64_t);
 
 static devcon_t *devcon_search(service_id_t service_id)
@@ -268,11 +323,79 @@ static const hash_table_ops_t cache_ops = {
 	.remove_callback = NULL
 };
 
+/** Get the cache shard responsible for a logical block address. */
+static cache_shard_t *cache_shard(cache_t *cache, aoff64_t lba)
+{
+	return &cache->shards[lba % CACHE_SHARDS];
+}
+
+/** Put an unreferenced block on the tail of its replacement list.
+ *
+ * Should be called with the shard lock held.
+ */
+static void cache_link(cache_shard_t *shard, block_t *b)
+{
+	if (b->hot) {
+		list_append(&b->free_link, &shard->hot_list);
+		shard->hot_count++;
+	} else {
+		list_append(&b->free_link, &shard->cold_list);
+		shard->cold_count++;
+	}
+}
+
+/** Take a block off its replacement list.
+ *
+ * Should be called with the shard lock held.
+ */
+static void cache_unlink(cache_shard_t *shard, block_t *b)
+{
+	list_remove(&b->free_link);
+	if (b->hot)
+		shard->hot_count--;
+	else
+		shard->cold_count--;
+}
+
+/** Choose an unreferenced block to be recycled.
+ *
+ * Blocks which were referenced only once since they entered the cache are
+ * preferred, so that a long sequential scan does not push out the blocks
+ * which are used repeatedly (e.g. metadata). The hot list is only allowed
+ * to hold a limited share of the unreferenced blocks, though, so that the
+ * cache still adapts when the working set changes.
+ *
+ * Should be called with the shard lock held.
+ *
+ * @return Least recently used block of the chosen list or NULL if
+ *         there are no unreferenced blocks in the shard.
+ */
+static block_t *cache_victim(cache_shard_t *shard)
+{
+	list_t *list;
+
+	if (list_empty(&shard->cold_list))
+		list = &shard->hot_list;
+	else if (shard->hot_count * CACHE_HOT_SHARE_DEN >
+	    (shard->hot_count + shard->cold_count) * CACHE_HOT_SHARE_NUM)
+		list = &shard->hot_list;
+	else
+		list = &shard->cold_list;
+
+	link_t *link = list_first(list);
+	if (link == NULL)
+		return NULL;
+
+	return list_get_instance(link, block_t, free_link);
+}
+
 errno_t block_cache_init(service_id_t service_id, size_t size, unsigned blocks,
     enum cache_mode mode)
 {
 	devcon_t *devcon = devcon_search(service_id);
 	cache_t *cache;
+	unsigned i;
+
 	if (!devcon)
 		return ENOENT;
 	if (devcon->cache)
@@ -281,11 +404,12 @@ errno_t block_cache_init(service_id_t service_id, size_t size, unsigned blocks,
 	if (!cache)
 		return ENOMEM;
 
-	fibril_mutex_initialize(&cache->lock);
-	list_initialize(&cache->free_list);
 	cache->lblock_size = size;
 	cache->block_count = blocks;
-	cache->blocks_cached = 0;
+	atomic_init(&cache->blocks_cached, 0);
+	atomic_init(&cache->wb_batches, 0);
+	atomic_init(&cache->wb_blocks, 0);
+	atomic_init(&cache->ra_blocks, 0);
 	cache->mode = mode;
 
 	/* Allow 1:1 or small-to-large block size translation */
@@ -296,12 +420,42 @@ errno_t block_cache_init(service_id_t service_id, size_t size, unsigned blocks,
 
 	cache->blocks_cluster = cache->lblock_size / devcon->pblock_size;
 
-	if (!hash_table_create(&cache->block_hash, 0, 0, &cache_ops)) {
-		free(cache);
-		return ENOMEM;
+	for (i = 0; i < CACHE_SHARDS; i++) {
+		cache_shard_t *shard = &cache->shards[i];
+
+		fibril_mutex_initialize(&shard->lock);
+		list_initialize(&shard->cold_list);
+		list_initialize(&shard->hot_list);
+		shard->cold_count = 0;
+		shard->hot_count = 0;
+		shard->hits = 0;
+		shard->misses = 0;
+		shard->evictions = 0;
+
+		if (!hash_table_create(&shard->block_hash, 0, 0, &cache_ops)) {
+			while (i-- > 0)
+				hash_table_destroy(&cache->shards[i].block_hash);
+			free(cache);
+			return ENOMEM;
+		}
 	}
 
+	fibril_mutex_initialize(&cache->ra_lock);
+	fibril_condvar_initialize(&cache->ra_cv);
+	list_initialize(&cache->ra_queue);
+	cache->ra_stop = false;
+	cache->ra_last = 0;
+	cache->ra_next = 0;
+	cache->ra_window = 0;
+
 	devcon->cache = cache;
+
+	/* The cache works without read-ahead should this fail. */
+	fid_t fid = fibril_create(readahead_fibril, devcon);
+	cache->ra_running = (fid != 0);
+	if (fid != 0)
+		fibril_add_ready(fid);
+
 	return EOK;
 }
 
@@ -317,43 +471,103 @@ errno_t block_cache_fini(service_id_t service_id)
 		return EOK;
 	cache = devcon->cache;
 
+	/* Stop the read-ahead fibril, dropping any pending requests. */
+	fibril_mutex_lock(&cache->ra_lock);
+	cache->ra_stop = true;
+	fibril_condvar_broadcast(&cache->ra_cv);
+	while (cache->ra_running)
+		fibril_condvar_wait(&cache->ra_cv, &cache->ra_lock);
+	fibril_mutex_unlock(&cache->ra_lock);
+
 	/*
 	 * We are expecting to find all blocks for this device handle on the
-	 * free list, i.e. the block reference count should be zero. Do not
-	 * bother with the cache and block locks because we are single-threaded.
+	 * replacement lists, i.e. the block reference count should be zero.
+	 * Do not bother with the shard and block locks because we are
+	 * single-threaded.
 	 */
-	while (!list_empty(&cache->free_list)) {
-		block_t *b = list_get_instance(list_first(&cache->free_list),
-		    block_t, free_link);
+	for (unsigned i = 0; i < CACHE_SHARDS; i++) {
+		cache_shard_t *shard = &cache->shards[i];
 
-		list_remove(&b->free_link);
-		if (b->dirty) {
-			rc = write_blocks(devcon, b->pba, cache->blocks_cluster,
-			    b->data, b->size);
-			if (rc != EOK)
-				return rc;
-		}
+		while (!list_empty(&shard->cold_list) ||
+		    !list_empty(&shard->hot_list)) {
+			list_t *list = list_empty(&shard->cold_list) ?
+			    &shard->hot_list : &shard->cold_list;
+			block_t *b = list_get_instance(list_first(list),
+			    block_t, free_link);
 
-		hash_table_remove_item(&cache->block_hash, &b->hash_link);
+			cache_unlink(shard, b);
+			if (b->dirty) {
+				rc = cache_writeback(devcon, b);
+				if (rc != EOK)
+					return rc;
+			}
 
-		free(b->data);
-		free(b);
+			hash_table_remove_item(&shard->block_hash, &b->hash_link);
+
+			free(b->data);
+			free(b);
+		}
 	}
 
-	hash_table_destroy(&cache->block_hash);
+	for (unsigned i = 0; i < CACHE_SHARDS; i++)
+		hash_table_destroy(&cache->shards[i].block_hash);
 	devcon->cache = NULL;
 	free(cache);
 
 	return EOK;
 }
 
+/** Get block cache statistics.
+ *
+ * The counters of individual shards are sampled one after another,
+ * so the result is only approximate while the cache is in use.
+ *
+ * @param service_id	Service ID of the block device.
+ * @param stats		Place to store the statistics.
+ *
+ * @return		EOK on success or an error code.
+ */
+errno_t block_cache_get_stats(service_id_t service_id,
+    block_cache_stats_t *stats)
+{
+	devcon_t *devcon = devcon_search(service_id);
+	cache_t *cache;
+
+	if (!devcon)
+		return ENOENT;
+	if (!devcon->cache)
+		return ENOENT;
+	cache = devcon->cache;
+
+	stats->hits = 0;
+	stats->misses = 0;
+	stats->evictions = 0;
+
+	for (unsigned i = 0; i < CACHE_SHARDS; i++) {
+		cache_shard_t *shard = &cache->shards[i];
+
+		fibril_mutex_lock(&shard->lock);
+		stats->hits += shard->hits;
+		stats->misses += shard->misses;
+		stats->evictions += shard->evictions;
+		fibril_mutex_unlock(&shard->lock);
+	}
+
+	stats->wb_batches = atomic_load(&cache->wb_batches);
+	stats->wb_blocks = atomic_load(&cache->wb_blocks);
+	stats->ra_blocks = atomic_load(&cache->ra_blocks);
+	stats->blocks_cached = atomic_load(&cache->blocks_cached);
+
+	return EOK;
+}
+
 #define CACHE_LO_WATERMARK	10
 #define CACHE_HI_WATERMARK	20
-static bool cache_can_grow(cache_t *cache)
+static bool cache_can_grow(cache_t *cache, cache_shard_t *shard)
 {
-	if (cache->blocks_cached < CACHE_LO_WATERMARK)
+	if (atomic_load(&cache->blocks_cached) < CACHE_LO_WATERMARK)
 		return true;
-	if (!list_empty(&cache->free_list))
+	if (!list_empty(&shard->cold_list) || !list_empty(&shard->hot_list))
 		return false;
 	return true;
 }
@@ -365,10 +579,130 @@ static void block_initialize(block_t *b)
 	b->write_failures = 0;
 	b->dirty = false;
 	b->toxic = false;
+	b->hot = false;
+	b->prefetched = false;
 	fibril_rwlock_initialize(&b->contents_lock);
 	link_initialize(&b->free_link);
 }
 
+/** Lock a cached block which can be written back along with another one.
+ *
+ * Only blocks which are dirty and not referenced qualify. Locks are only
+ * tried, because the caller already holds the lock of another block.
+ *
+ * @param cache		Block cache.
+ * @param lba		Logical address of the block.
+ *
+ * @return		Locked block or NULL.
+ */
+static block_t *cache_writeback_grab(cache_t *cache, aoff64_t lba)
+{
+	cache_shard_t *shard = cache_shard(cache, lba);
+	block_t *b = NULL;
+
+	if (!fibril_mutex_trylock(&shard->lock))
+		return NULL;
+
+	ht_link_t *hlink = hash_table_find(&shard->block_hash, &lba);
+	if (hlink) {
+		b = hash_table_get_inst(hlink, block_t, hash_link);
+		if (!fibril_mutex_trylock(&b->lock)) {
+			b = NULL;
+		} else if ((b->refcnt != 0) || !b->dirty || b->toxic) {
+			fibril_mutex_unlock(&b->lock);
+			b = NULL;
+		}
+	}
+
+	fibril_mutex_unlock(&shard->lock);
+	return b;
+}
+
+/** Write a dirty block back to the device.
+ *
+ * In write-back mode, dirty unreferenced blocks adjacent to @a b are
+ * written together with it using a single request to the device. The
+ * neighbours are marked clean on success. Updating the state of @a b
+ * itself is left up to the caller.
+ *
+ * @param devcon	Device connection.
+ * @param b		Block to write back. The caller must hold its lock
+ *			or otherwise guarantee exclusive access.
+ *
+ * @return		EOK on success or an error code.
+ */
+static errno_t cache_writeback(devcon_t *devcon, block_t *b)
+{
+	cache_t *cache = devcon->cache;
+	block_t *batch[CACHE_WB_BATCH];
+	size_t first = CACHE_WB_BATCH / 2;
+	size_t last = first;
+	errno_t rc;
+
+	batch[first] = b;
+
+	if (cache->mode == CACHE_MODE_WB) {
+		for (aoff64_t lba = b->lba; (first > 0) && (lba > 0); first--) {
+			block_t *nb = cache_writeback_grab(cache, --lba);
+			if (nb == NULL)
+				break;
+			batch[first - 1] = nb;
+		}
+
+		for (aoff64_t lba = b->lba; last < CACHE_WB_BATCH - 1; last++) {
+			block_t *nb = cache_writeback_grab(cache, ++lba);
+			if (nb == NULL)
+				break;
+			batch[last + 1] = nb;
+		}
+	}
+
+	size_t cnt = last - first + 1;
+	void *buf = NULL;
+
+	if (cnt > 1) {
+		buf = malloc(cnt * cache->lblock_size);
+		if (buf == NULL) {
+			/* Fall back to writing just the requested block. */
+			for (size_t i = first; i <= last; i++) {
+				if (batch[i] != b)
+					fibril_mutex_unlock(&batch[i]->lock);
+			}
+			first = last = CACHE_WB_BATCH / 2;
+			cnt = 1;
+		}
+	}
+
+	if (cnt == 1) {
+		rc = write_blocks(devcon, b->pba, cache->blocks_cluster,
+		    b->data, b->size);
+	} else {
+		for (size_t i = first; i <= last; i++) {
+			memcpy(buf + (i - first) * cache->lblock_size,
+			    batch[i]->data, cache->lblock_size);
+		}
+
+		rc = write_blocks(devcon, batch[first]->pba,
+		    cnt * cache->blocks_cluster, buf, cnt * cache->lblock_size);
+		free(buf);
+
+		for (size_t i = first; i <= last; i++) {
+			if (batch[i] == b)
+				continue;
+			if (rc == EOK) {
+				batch[i]->dirty = false;
+				batch[i]->write_failures = 0;
+			}
+			fibril_mutex_unlock(&batch[i]->lock);
+		}
+	}
+
+	atomic_fetch_add(&cache->wb_batches, 1);
+	atomic_fetch_add(&cache->wb_blocks, cnt);
+
+	return rc;
+}
+
 /** Instantiate a block in memory and get a reference to it.
  *
  * @param block			Pointer to where the function will store the
@@ -385,8 +719,8 @@ errno_t block_get(block_t **block, service_id_t service_id, aoff64_t ba, int fla
 {
 	devcon_t *devcon;
 	cache_t *cache;
+	cache_shard_t *shard;
 	block_t *b;
-	link_t *link;
 	aoff64_t p_ba;
 	errno_t rc;
 
@@ -396,6 +730,7 @@ errno_t block_get(block_t **block, service_id_t service_id, aoff64_t ba, int fla
 	assert(devcon->cache);
 
 	cache = devcon->cache;
+	shard = cache_shard(cache, ba);
 
 	/*
 	 * Check whether the logical block (or part of it) is beyond
@@ -408,12 +743,15 @@ errno_t block_get(block_t **block, service_id_t service_id, aoff64_t ba, int fla
 		return EIO;
 	}
 
+	if (!(flags & BLOCK_FLAGS_NOREAD))
+		readahead_access(devcon, ba);
+
 retry:
 	rc = EOK;
 	b = NULL;
 
-	fibril_mutex_lock(&cache->lock);
-	ht_link_t *hlink = hash_table_find(&cache->block_hash, &ba);
+	fibril_mutex_lock(&shard->lock);
+	ht_link_t *hlink = hash_table_find(&shard->block_hash, &ba);
 	if (hlink) {
 	found:
 		/*
@@ -422,16 +760,27 @@ retry:
 		b = hash_table_get_inst(hlink, block_t, hash_link);
 		fibril_mutex_lock(&b->lock);
 		if (b->refcnt++ == 0)
-			list_remove(&b->free_link);
+			cache_unlink(shard, b);
+		/*
+		 * The block has been referenced again since it entered the
+		 * cache. From now on, prefer to keep it over blocks that
+		 * were used just once. The first reference to a block read
+		 * ahead does not count.
+		 */
+		if (b->prefetched)
+			b->prefetched = false;
+		else
+			b->hot = true;
 		if (b->toxic)
 			rc = EIO;
+		shard->hits++;
 		fibril_mutex_unlock(&b->lock);
-		fibril_mutex_unlock(&cache->lock);
+		fibril_mutex_unlock(&shard->lock);
 	} else {
 		/*
 		 * The block was not found in the cache.
 		 */
-		if (cache_can_grow(cache)) {
+		if (cache_can_grow(cache, shard)) {
 			/*
 			 * We can grow the cache by allocating new blocks.
 			 * Should the allocation fail, we fail over and try to
@@ -446,36 +795,34 @@ retry:
 				b = NULL;
 				goto recycle;
 			}
-			cache->blocks_cached++;
+			atomic_fetch_add(&cache->blocks_cached, 1);
 		} else {
 			/*
-			 * Try to recycle a block from the free list.
+			 * Try to recycle a block from the replacement lists.
 			 */
 		recycle:
-			if (list_empty(&cache->free_list)) {
-				fibril_mutex_unlock(&cache->lock);
+			b = cache_victim(shard);
+			if (b == NULL) {
+				fibril_mutex_unlock(&shard->lock);
 				rc = ENOMEM;
 				goto out;
 			}
-			link = list_first(&cache->free_list);
-			b = list_get_instance(link, block_t, free_link);
 
 			fibril_mutex_lock(&b->lock);
 			if (b->dirty) {
 				/*
 				 * The block needs to be written back to the
 				 * device before it changes identity. Do this
-				 * while not holding the cache lock so that
+				 * while not holding the shard lock so that
 				 * concurrency is not impeded. Also move the
-				 * block to the end of the free list so that we
+				 * block to the end of its list so that we
 				 * do not slow down other instances of
-				 * block_get() draining the free list.
+				 * block_get() draining the list.
 				 */
-				list_remove(&b->free_link);
-				list_append(&b->free_link, &cache->free_list);
-				fibril_mutex_unlock(&cache->lock);
-				rc = write_blocks(devcon, b->pba,
-				    cache->blocks_cluster, b->data, b->size);
+				cache_unlink(shard, b);
+				cache_link(shard, b);
+				fibril_mutex_unlock(&shard->lock);
+				rc = cache_writeback(devcon, b);
 				if (rc != EOK) {
 					/*
 					 * We did not manage to write the block
@@ -497,7 +844,7 @@ retry:
 					b->write_failures = 0;
 
 				b->dirty = false;
-				if (!fibril_mutex_trylock(&cache->lock)) {
+				if (!fibril_mutex_trylock(&shard->lock)) {
 					/*
 					 * Somebody is probably racing with us.
 					 * Unlock the block and retry.
@@ -505,14 +852,14 @@ retry:
 					fibril_mutex_unlock(&b->lock);
 					goto retry;
 				}
-				hlink = hash_table_find(&cache->block_hash, &ba);
+				hlink = hash_table_find(&shard->block_hash, &ba);
 				if (hlink) {
 					/*
 					 * Someone else must have already
 					 * instantiated the block while we were
-					 * not holding the cache lock.
+					 * not holding the shard lock.
 					 * Leave the recycled block on the
-					 * freelist and continue as if we
+					 * list and continue as if we
 					 * found the block of interest during
 					 * the first try.
 					 */
@@ -524,11 +871,12 @@ retry:
 			fibril_mutex_unlock(&b->lock);
 
 			/*
-			 * Unlink the block from the free list and the hash
-			 * table.
+			 * Unlink the block from the replacement list and the
+			 * hash table.
 			 */
-			list_remove(&b->free_link);
-			hash_table_remove_item(&cache->block_hash, &b->hash_link);
+			cache_unlink(shard, b);
+			hash_table_remove_item(&shard->block_hash, &b->hash_link);
+			shard->evictions++;
 		}
 
 		block_initialize(b);
@@ -536,15 +884,16 @@ retry:
 		b->size = cache->lblock_size;
 		b->lba = ba;
 		b->pba = ba_ltop(devcon, b->lba);
-		hash_table_insert(&cache->block_hash, &b->hash_link);
+		hash_table_insert(&shard->block_hash, &b->hash_link);
+		shard->misses++;
 
 		/*
-		 * Lock the block before releasing the cache lock. Thus we don't
+		 * Lock the block before releasing the shard lock. Thus we don't
 		 * kill concurrent operations on the cache while doing I/O on
 		 * the block.
 		 */
 		fibril_mutex_lock(&b->lock);
-		fibril_mutex_unlock(&cache->lock);
+		fibril_mutex_unlock(&shard->lock);
 
 		if (!(flags & BLOCK_FLAGS_NOREAD)) {
 			/*
@@ -572,7 +921,7 @@ out:
 
 /** Release a reference to a block.
  *
- * If the last reference is dropped, the block is put on the free list.
+ * If the last reference is dropped, the block is put on a replacement list.
  *
  * @param block		Block of which a reference is to be released.
  *
@@ -582,6 +931,7 @@ errno_t block_put(block_t *block)
 {
 	devcon_t *devcon = devcon_search(block->service_id);
 	cache_t *cache;
+	cache_shard_t *shard;
 	unsigned blocks_cached;
 	enum cache_mode mode;
 	errno_t rc = EOK;
@@ -591,42 +941,40 @@ errno_t block_put(block_t *block)
 	assert(block->refcnt >= 1);
 
 	cache = devcon->cache;
+	shard = cache_shard(cache, block->lba);
 
 retry:
-	fibril_mutex_lock(&cache->lock);
-	blocks_cached = cache->blocks_cached;
+	blocks_cached = atomic_load(&cache->blocks_cached);
 	mode = cache->mode;
-	fibril_mutex_unlock(&cache->lock);
 
 	/*
 	 * Determine whether to sync the block. Syncing the block is best done
-	 * when not holding the cache lock as it does not impede concurrency.
-	 * Since the situation may have changed when we unlocked the cache, the
-	 * blocks_cached and mode variables are mere hints. We will recheck the
-	 * conditions later when the cache lock is held again.
+	 * when not holding the shard lock as it does not impede concurrency.
+	 * Since the situation may have changed by the time we lock the shard,
+	 * the blocks_cached variable is a mere hint. We will recheck the
+	 * conditions later when the shard lock is held.
 	 */
 	fibril_mutex_lock(&block->lock);
 	if (block->toxic)
 		block->dirty = false;	/* will not write back toxic block */
 	if (block->dirty && (block->refcnt == 1) &&
 	    (blocks_cached > CACHE_HI_WATERMARK || mode != CACHE_MODE_WB)) {
-		rc = write_blocks(devcon, block->pba, cache->blocks_cluster,
-		    block->data, block->size);
+		rc = cache_writeback(devcon, block);
 		if (rc == EOK)
 			block->write_failures = 0;
 		block->dirty = false;
 	}
 	fibril_mutex_unlock(&block->lock);
 
-	fibril_mutex_lock(&cache->lock);
+	fibril_mutex_lock(&shard->lock);
 	fibril_mutex_lock(&block->lock);
 	if (!--block->refcnt) {
 		/*
 		 * Last reference to the block was dropped. Either free the
-		 * block or put it on the free list. In case of an I/O error,
-		 * free the block.
+		 * block or put it on a replacement list. In case of an I/O
+		 * error, free the block.
 		 */
-		if ((cache->blocks_cached > CACHE_HI_WATERMARK) ||
+		if ((atomic_load(&cache->blocks_cached) > CACHE_HI_WATERMARK) ||
 		    (rc != EOK)) {
 			/*
 			 * Currently there are too many cached blocks or there
@@ -636,14 +984,14 @@ retry:
 			if (block->dirty) {
 				/*
 				 * We cannot sync the block while holding the
-				 * cache lock. Release everything and retry.
+				 * shard lock. Release everything and retry.
 				 */
 				block->refcnt++;
 
 				if (block->write_failures < MAX_WRITE_RETRIES) {
 					block->write_failures++;
 					fibril_mutex_unlock(&block->lock);
-					fibril_mutex_unlock(&cache->lock);
+					fibril_mutex_unlock(&shard->lock);
 					goto retry;
 				} else {
 					printf("Too many errors writing block %"
@@ -655,35 +1003,436 @@ retry:
 			/*
 			 * Take the block out of the cache and free it.
 			 */
-			hash_table_remove_item(&cache->block_hash, &block->hash_link);
+			hash_table_remove_item(&shard->block_hash, &block->hash_link);
 			fibril_mutex_unlock(&block->lock);
 			free(block->data);
 			free(block);
-			cache->blocks_cached--;
-			fibril_mutex_unlock(&cache->lock);
+			atomic_fetch_sub(&cache->blocks_cached, 1);
+			shard->evictions++;
+			fibril_mutex_unlock(&shard->lock);
 			return rc;
 		}
 		/*
-		 * Put the block on the free list.
+		 * Put the block on a replacement list.
 		 */
 		if (cache->mode != CACHE_MODE_WB && block->dirty) {
 			/*
-			 * We cannot sync the block while holding the cache
+			 * We cannot sync the block while holding the shard
 			 * lock. Release everything and retry.
 			 */
 			block->refcnt++;
 			fibril_mutex_unlock(&block->lock);
-			fibril_mutex_unlock(&cache->lock);
+			fibril_mutex_unlock(&shard->lock);
 			goto retry;
 		}
-		list_append(&block->free_link, &cache->free_list);
+		cache_link(shard, block);
 	}
 	fibril_mutex_unlock(&block->lock);
-	fibril_mutex_unlock(&cache->lock);
+	fibril_mutex_unlock(&shard->lock);
 
 	return rc;
 }
 
+/** Release the reference held by the read-ahead fibril.
+ *
+ * Unlike block_put(), the block is always kept in the cache unless
+ * reading it failed.
+ *
+ * @param cache		Block cache.
+ * @param b		Block to release.
+ */
+static void prefetch_release(cache_t *cache, block_t *b)
+{
+	cache_shard_t *shard = cache_shard(cache, b->lba);
+
+	fibril_mutex_lock(&shard->lock);
+	fibril_mutex_lock(&b->lock);
+	if (!--b->refcnt) {
+		if (b->toxic) {
+			hash_table_remove_item(&shard->block_hash, &b->hash_link);
+			fibril_mutex_unlock(&b->lock);
+			free(b->data);
+			free(b);
+			atomic_fetch_sub(&cache->blocks_cached, 1);
+			fibril_mutex_unlock(&shard->lock);
+			return;
+		}
+
+		cache_link(shard, b);
+	}
+	fibril_mutex_unlock(&b->lock);
+	fibril_mutex_unlock(&shard->lock);
+}
+
+/** Instantiate a block to be filled by read-ahead.
+ *
+ * Read-ahead lets the cache exceed its high watermark by at most
+ * RA_MAX_WINDOW blocks. Beyond that, only clean blocks from the cold
+ * list are recycled so that neither write-back nor the eviction of
+ * blocks in active use is ever caused by read-ahead.
+ *
+ * @param devcon	Device connection.
+ * @param ba		Logical block address.
+ * @param wait		If false, do not block on the shard lock.
+ * @param rb		Place to store the block, referenced and locked.
+ *
+ * @return		EOK on success, EEXIST if the block is already
+ *			cached, EBUSY if the shard lock is contended and
+ *			@a wait is false, ENOMEM if there is no room for
+ *			the block.
+ */
+static errno_t prefetch_instantiate(devcon_t *devcon, aoff64_t ba, bool wait,
+    block_t **rb)
+{
+	cache_t *cache = devcon->cache;
+	cache_shard_t *shard = cache_shard(cache, ba);
+	block_t *b = NULL;
+
+	if (wait)
+		fibril_mutex_lock(&shard->lock);
+	else if (!fibril_mutex_trylock(&shard->lock))
+		return EBUSY;
+
+	if (hash_table_find(&shard->block_hash, &ba) != NULL) {
+		fibril_mutex_unlock(&shard->lock);
+		return EEXIST;
+	}
+
+	if (atomic_load(&cache->blocks_cached) <
+	    CACHE_HI_WATERMARK + RA_MAX_WINDOW) {
+		b = malloc(sizeof(block_t));
+		if (b) {
+			b->data = malloc(cache->lblock_size);
+			if (!b->data) {
+				free(b);
+				b = NULL;
+			}
+		}
+		if (b)
+			atomic_fetch_add(&cache->blocks_cached, 1);
+	}
+
+	if (!b) {
+		link_t *link = list_first(&shard->cold_list);
+		if (link)
+			b = list_get_instance(link, block_t, free_link);
+
+		if (!b || !fibril_mutex_trylock(&b->lock)) {
+			fibril_mutex_unlock(&shard->lock);
+			return ENOMEM;
+		}
+
+		if (b->dirty) {
+			fibril_mutex_unlock(&b->lock);
+			fibril_mutex_unlock(&shard->lock);
+			return ENOMEM;
+		}
+		fibril_mutex_unlock(&b->lock);
+
+		cache_unlink(shard, b);
+		hash_table_remove_item(&shard->block_hash, &b->hash_link);
+		shard->evictions++;
+	}
+
+	block_initialize(b);
+	b->prefetched = true;
+	b->service_id = devcon->service_id;
+	b->size = cache->lblock_size;
+	b->lba = ba;
+	b->pba = ba_ltop(devcon, b->lba);
+	hash_table_insert(&shard->block_hash, &b->hash_link);
+
+	/*
+	 * Keep the block locked until its contents are read so that
+	 * block_get() waits for the data instead of reading it again.
+	 */
+	fibril_mutex_lock(&b->lock);
+	fibril_mutex_unlock(&shard->lock);
+
+	*rb = b;
+	return EOK;
+}
+
+/** Read a run of adjacent blocks instantiated by read-ahead.
+ *
+ * The blocks are read using a single request, unlocked and released.
+ *
+ * @param devcon	Device connection.
+ * @param run		Blocks with consecutive logical addresses.
+ * @param cnt		Number of blocks.
+ */
+static void prefetch_read(devcon_t *devcon, block_t **run, size_t cnt)
+{
+	cache_t *cache = devcon->cache;
+	void *buf = NULL;
+	errno_t rc;
+
+	if (cnt > 1)
+		buf = malloc(cnt * cache->lblock_size);
+
+	if (buf) {
+		rc = read_blocks(devcon, run[0]->pba,
+		    cnt * cache->blocks_cluster, buf, cnt * cache->lblock_size);
+		for (size_t i = 0; i < cnt; i++) {
+			if (rc == EOK) {
+				memcpy(run[i]->data,
+				    buf + i * cache->lblock_size,
+				    cache->lblock_size);
+			} else {
+				run[i]->toxic = true;
+			}
+		}
+		free(buf);
+	} else {
+		for (size_t i = 0; i < cnt; i++) {
+			rc = read_blocks(devcon, run[i]->pba,
+			    cache->blocks_cluster, run[i]->data,
+			    cache->lblock_size);
+			if (rc != EOK)
+				run[i]->toxic = true;
+		}
+	}
+
+	/* Unlock all blocks first, prefetch_release() locks the shards. */
+	for (size_t i = 0; i < cnt; i++)
+		fibril_mutex_unlock(&run[i]->lock);
+	for (size_t i = 0; i < cnt; i++)
+		prefetch_release(cache, run[i]);
+
+	atomic_fetch_add(&cache->ra_blocks, cnt);
+}
+
+/** Read a range of blocks into the cache.
+ *
+ * Blocks which are already cached are skipped, the missing ones are read
+ * in runs of at most RA_MAX_WINDOW blocks. Blocks beyond the end of the
+ * device are ignored.
+ *
+ * @param devcon	Device connection.
+ * @param ba		Logical address of the first block.
+ * @param cnt		Number of blocks.
+ */
+static void prefetch_range(devcon_t *devcon, aoff64_t ba, size_t cnt)
+{
+	cache_t *cache = devcon->cache;
+	block_t *run[RA_MAX_WINDOW];
+	size_t n = 0;
+	errno_t rc;
+
+	for (; cnt > 0; ba++, cnt--) {
+		if (ba_ltop(devcon, ba) + cache->blocks_cluster >=
+		    devcon->pblocks)
+			break;
+
+		/*
+		 * Do not block on a shard lock while holding locked blocks,
+		 * somebody may be waiting for them with that lock held.
+		 */
+		rc = prefetch_instantiate(devcon, ba, n == 0, &run[n]);
+		if (rc == EBUSY) {
+			prefetch_read(devcon, run, n);
+			n = 0;
+			rc = prefetch_instantiate(devcon, ba, true, &run[n]);
+		}
+
+		if (rc == EOK) {
+			if (++n == RA_MAX_WINDOW) {
+				prefetch_read(devcon, run, n);
+				n = 0;
+			}
+			continue;
+		}
+
+		if (n > 0) {
+			prefetch_read(devcon, run, n);
+			n = 0;
+		}
+
+		if (rc == ENOMEM)
+			return;
+	}
+
+	if (n > 0)
+		prefetch_read(devcon, run, n);
+}
+
+/** Read-ahead helper fibril.
+ *
+ * Serves the queue of prefetch requests of one device until
+ * block_cache_fini() asks it to terminate.
+ *
+ * @param arg		Device connection.
+ *
+ * @return		EOK.
+ */
+static errno_t readahead_fibril(void *arg)
+{
+	devcon_t *devcon = arg;
+	cache_t *cache = devcon->cache;
+
+	fibril_mutex_lock(&cache->ra_lock);
+	while (true) {
+		while (list_empty(&cache->ra_queue) && !cache->ra_stop)
+			fibril_condvar_wait(&cache->ra_cv, &cache->ra_lock);
+		if (cache->ra_stop)
+			break;
+
+		ra_req_t *req = list_get_instance(list_first(&cache->ra_queue),
+		    ra_req_t, link);
+		list_remove(&req->link);
+		fibril_mutex_unlock(&cache->ra_lock);
+
+		prefetch_range(devcon, req->ba, req->cnt);
+		free(req);
+
+		fibril_mutex_lock(&cache->ra_lock);
+	}
+
+	while (!list_empty(&cache->ra_queue)) {
+		ra_req_t *req = list_get_instance(list_first(&cache->ra_queue),
+		    ra_req_t, link);
+		list_remove(&req->link);
+		free(req);
+	}
+
+	cache->ra_running = false;
+	fibril_condvar_broadcast(&cache->ra_cv);
+	fibril_mutex_unlock(&cache->ra_lock);
+
+	return EOK;
+}
+
+/** Pass a range of blocks to the read-ahead fibril.
+ *
+ * @param cache		Block cache.
+ * @param ba		Logical address of the first block.
+ * @param cnt		Number of blocks.
+ *
+ * @return		EOK on success, ENOMEM if the request could not be
+ *			allocated, ENOTSUP if the cache has no read-ahead
+ *			fibril.
+ */
+static errno_t readahead_queue(cache_t *cache, aoff64_t ba, size_t cnt)
+{
+	ra_req_t *req = malloc(sizeof(ra_req_t));
+	if (!req)
+		return ENOMEM;
+
+	link_initialize(&req->link);
+	req->ba = ba;
+	req->cnt = cnt;
+
+	fibril_mutex_lock(&cache->ra_lock);
+	if (!cache->ra_running || cache->ra_stop) {
+		fibril_mutex_unlock(&cache->ra_lock);
+		free(req);
+		return ENOTSUP;
+	}
+	list_append(&req->link, &cache->ra_queue);
+	fibril_condvar_signal(&cache->ra_cv);
+	fibril_mutex_unlock(&cache->ra_lock);
+
+	return EOK;
+}
+
+/** Update sequential access detection and read ahead if appropriate.
+ *
+ * Two successive requests for adjacent blocks start read-ahead of
+ * RA_MIN_WINDOW blocks. Whenever the reader gets within half a window
+ * of the end of the data read ahead so far, the window is doubled (up
+ * to RA_MAX_WINDOW) and the next window is requested, so that the
+ * reader does not have to wait for the device. A non-sequential request
+ * stops the read-ahead.
+ *
+ * @param devcon	Device connection.
+ * @param ba		Logical address of the requested block.
+ */
+static void readahead_access(devcon_t *devcon, aoff64_t ba)
+{
+	cache_t *cache = devcon->cache;
+	aoff64_t start = 0;
+	size_t cnt = 0;
+
+	fibril_mutex_lock(&cache->ra_lock);
+
+	if (ba == cache->ra_last) {
+		fibril_mutex_unlock(&cache->ra_lock);
+		return;
+	}
+
+	if (ba != cache->ra_last + 1) {
+		cache->ra_window = 0;
+	} else if (cache->ra_window == 0) {
+		cache->ra_window = RA_MIN_WINDOW;
+		start = ba + 1;
+		cnt = cache->ra_window;
+	} else if (ba + cache->ra_window / 2 >= cache->ra_next) {
+		cache->ra_window = min(cache->ra_window * 2, RA_MAX_WINDOW);
+		start = max(cache->ra_next, ba + 1);
+		cnt = cache->ra_window;
+	}
+
+	if (cnt > 0)
+		cache->ra_next = start + cnt;
+	cache->ra_last = ba;
+
+	fibril_mutex_unlock(&cache->ra_lock);
+
+	if (cnt > 0)
+		(void) readahead_queue(cache, start, cnt);
+}
+
+/** Prefetch blocks into the cache.
+ *
+ * This is a hint for file systems which know which blocks they are going
+ * to need soon (e.g. the rest of an extent or a cluster). The blocks are
+ * read asynchronously by a helper fibril, blocks which are already cached
+ * are skipped.
+ *
+ * @param service_id	Service ID of the block device.
+ * @param ba		Logical address of the first block.
+ * @param cnt		Number of blocks.
+ *
+ * @return		EOK on success or an error code.
+ */
+errno_t block_prefetch(service_id_t service_id, aoff64_t ba, size_t cnt)
+{
+	devcon_t *devcon = devcon_search(service_id);
+
+	assert(devcon);
+	assert(devcon->cache);
+
+	if (cnt == 0)
+		return EOK;
+
+	return readahead_queue(devcon->cache, ba, cnt);
+}
+
+/** Read a physical block through the block cache.
+ *
+ * @param devcon	Device connection.
+ * @param ba		Physical block address.
+ * @param buf		Buffer for one physical block.
+ *
+ * @return		EOK on success or an error code.
+ */
+static errno_t read_block_cached(devcon_t *devcon, aoff64_t ba, void *buf)
+{
+	cache_t *cache = devcon->cache;
+	block_t *b;
+	errno_t rc;
+
+	rc = block_get(&b, devcon->service_id, ba / cache->blocks_cluster,
+	    BLOCK_FLAGS_NONE);
+	if (rc != EOK)
+		return rc;
+
+	memcpy(buf, b->data + (ba % cache->blocks_cluster) *
+	    devcon->pblock_size, devcon->pblock_size);
+
+	return block_put(b);
+}
+
 /** Read sequential data from a block device.
  *
  * @param service_id	Service ID of the block device.
@@ -735,8 +1484,20 @@ errno_t block_seqread(service_id_t service_id, void *buf, size_t *bufpos,
 			/* Refill the communication buffer with a new block. */
 			errno_t rc;
 
-			rc = read_blocks(devcon, *pos / block_size, 1, buf,
-			    devcon->pblock_size);
+			aoff64_t ba = *pos / block_size;
+
+			/*
+			 * Go through the cache if there is one, so that the
+			 * reader benefits from read-ahead.
+			 */
+			if (devcon->cache != NULL &&
+			    ba - ba % devcon->cache->blocks_cluster +
+			    devcon->cache->blocks_cluster < devcon->pblocks) {
+				rc = read_block_cached(devcon, ba, buf);
+			} else {
+				rc = read_blocks(devcon, ba, 1, buf,
+				    devcon->pblock_size);
+			}
 			if (rc != EOK) {
 				return rc;
 			}
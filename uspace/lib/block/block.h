@@ -71,6 +71,10 @@ typedef struct block {
 	bool dirty;
 	/** If true, the blcok does not contain valid data. */
 	bool toxic;
+	/** If true, the block was referenced repeatedly while cached. */
+	bool hot;
+	/** If true, the block was read ahead and not referenced yet. */
+	bool prefetched;
 	/** Readers / Writer lock protecting the contents of the block. */
 	fibril_rwlock_t contents_lock;
 	/** Service ID of service providing the block device. */
@@ -83,7 +87,7 @@ typedef struct block {
 	size_t size;
 	/** Number of write failures. */
 	int write_failures;
-	/** Link for placing the block into the free block list. */
+	/** Link for placing the block into a cache replacement list. */
 	link_t free_link;
 	/** Link for placing the block into the block hash table. */
 	ht_link_t hash_link;
@@ -99,6 +103,24 @@ enum cache_mode {
 	CACHE_MODE_WB
 };
 
+/** Block cache statistics */
+typedef struct {
+	/** Number of block_get() calls satisfied from the cache */
+	uint64_t hits;
+	/** Number of blocks instantiated in the cache */
+	uint64_t misses;
+	/** Number of blocks recycled or freed to make room */
+	uint64_t evictions;
+	/** Number of write requests issued to write back dirty blocks */
+	uint64_t wb_batches;
+	/** Number of blocks written back by these requests */
+	uint64_t wb_blocks;
+	/** Number of blocks read ahead */
+	uint64_t ra_blocks;
+	/** Number of blocks currently in the cache */
+	unsigned blocks_cached;
+} block_cache_stats_t;
+
 extern errno_t block_init(service_id_t);
 extern void block_fini(service_id_t);
 
@@ -107,9 +129,11 @@ extern void *block_bb_get(service_id_t);
 
 extern errno_t block_cache_init(service_id_t, size_t, unsigned, enum cache_mode);
 extern errno_t block_cache_fini(service_id_t);
+extern errno_t block_cache_get_stats(service_id_t, block_cache_stats_t *);
 
 extern errno_t block_get(block_t **, service_id_t, aoff64_t, int);
 extern errno_t block_put(block_t *);
+extern errno_t block_prefetch(service_id_t, aoff64_t, size_t);
 
 extern errno_t block_seqread(service_id_t, void *, size_t *, size_t *, aoff64_t *,
     void *, size_t);
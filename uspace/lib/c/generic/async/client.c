@@ -121,6 +121,9 @@
 #include "../private/libc.h"
 #include "../private/fibril.h"
 
+/** Maximum number of messages made by one system call */
+#define ASYNC_SEND_BATCH  16
+
 static fibril_rmutex_t message_mutex;
 
 /** Naming service session */
@@ -348,6 +351,66 @@ aid_t async_send_5(async_exch_t *exch, sysarg_t imethod, sysarg_t arg1,
 	    dataptr);
 }
 
+/** Send a batch of messages.
+ *
+ * The messages are made with as few system calls as possible. Each message
+ * can be waited for or forgotten like one sent by async_send_5().
+ *
+ * @param exch    Exchange for sending the messages.
+ * @param count   Number of messages.
+ * @param reqs    Service-defined interface, method and payload arguments of
+ *                each message.
+ * @param answers If non-NULL, storage where the replies will be stored, one
+ *                for each message.
+ * @param aids    Storage for the IDs of the sent messages. An ID is 0 if the
+ *                message could not be sent.
+ *
+ */
+void async_send_batch(async_exch_t *exch, size_t count, const ipc_call_t *reqs,
+    ipc_call_t *answers, aid_t *aids)
+{
+	ipc_batch_call_t batch[ASYNC_SEND_BATCH];
+	amsg_t *msgs[ASYNC_SEND_BATCH];
+	size_t i = 0;
+
+	while (i < count) {
+		size_t n = 0;
+
+		while ((n < ASYNC_SEND_BATCH) && (i < count)) {
+			amsg_t *msg = (exch != NULL) ? amsg_create() : NULL;
+			aids[i] = (aid_t) msg;
+			if (msg == NULL) {
+				i++;
+				continue;
+			}
+
+			msg->dataptr = (answers != NULL) ? &answers[i] : NULL;
+
+			batch[n].phone = exch->phone;
+			batch[n].label = (sysarg_t) msg;
+			memcpy(batch[n].args, reqs[i].args, sizeof(batch[n].args));
+			msgs[n] = msg;
+			n++;
+			i++;
+		}
+
+		size_t first = 0;
+		while (first < n) {
+			size_t submitted = 0;
+			errno_t rc = ipc_call_async_batch(&batch[first], n - first,
+			    &submitted);
+			if (rc == EOK)
+				break;
+
+			/* The call which failed will never be answered. */
+			first += submitted;
+			msgs[first]->retval = rc;
+			msgs[first]->done = true;
+			first++;
+		}
+	}
+}
+
 /** Wait for a message sent by the async framework.
  *
  * @param amsgid Hash of the message to wait for.
@@ -0,0 +1,634 @@
+/*
+ * Copyright (c) 2026 The HelenOS Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup libc
+ * @{
+ */
+/** @file Shared-memory ring channels
+ *
+ * A ring channel lets a client stream requests to a server through memory
+ * shared by the two tasks instead of issuing an IPC call per request. The
+ * client creates the channel on an existing session, which shares a single
+ * address space area with the server. The area holds a header and two
+ * single-producer single-consumer queues: the submission queue, filled by
+ * the client and drained by the server, and the completion queue, which
+ * carries the answers back.
+ *
+ * As long as both sides keep finding work in the queues, no system call is
+ * made at all. A side that runs out of work publishes an idle flag before
+ * going to sleep in its connection or reply wait. The peer that later
+ * produces an entry and finds the flag set wakes the sleeper up:
+ *
+ *  - The client wakes an idle server by sending a one-way doorbell message
+ *    on the session. The server sleeps in async_get_call(), so it also keeps
+ *    receiving the ordinary calls of the session.
+ *
+ *  - A client that waits for an answer parks a wait call at the server.
+ *    The server answers that call after it publishes the next completion.
+ *
+ * Waitq capabilities are local to the task which created them, so the
+ * cross-task wakeup is an IPC message. Within each task, the waiting
+ * fibril blocks in the fibril framework like any other fibril waiting for IPC.
+ *
+ * Both wakeup paths follow the same pattern. The sleeper stores its idle
+ * flag, then re-checks the queue. The producer stores the queue index, then
+ * swaps the flag. These are sequentially consistent operations, so either
+ * the sleeper sees the new entry or the producer sees the flag.
+ *
+ * The client keeps at most as many requests outstanding as the queues have
+ * entries. A request is outstanding until its answer has been released.
+ * Neither queue can therefore overflow, and neither side ever has to wait
+ * for free space. All calls of the protocol go through the session of the
+ * ring, so it must not use EXCHANGE_PARALLEL. With parallel exchanges, the
+ * calls could reach a different connection fibril in the server.
+ */
+
+#include <align.h>
+#include <as.h>
+#include <assert.h>
+#include <async.h>
+#include <async_ring.h>
+#include <errno.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include "../private/async.h"
+
+#define ASYNC_RING_MAGIC  0x52494e47
+
+/** Maximum number of entries in each queue */
+#define ASYNC_RING_MAX_ENTRIES  4096
+
+/** Maximum inline payload size of a message */
+#define ASYNC_RING_MAX_DATA  (64 * 1024)
+
+/** Alignment separating the parts written by different sides */
+#define ASYNC_RING_ALIGN  64
+
+/** Ring channel protocol operations (ARG1 of the ring method) */
+enum {
+	/** Share the ring area with the server (followed by IPC_M_SHARE_OUT) */
+	ASYNC_RING_SETUP,
+	/** Wake up an idle server */
+	ASYNC_RING_DOORBELL,
+	/** Wait until the server publishes an answer */
+	ASYNC_RING_WAIT,
+	/** Tear down the ring */
+	ASYNC_RING_CLOSE
+};
+
+/** Header at the beginning of the shared ring area */
+typedef struct {
+	/** Written by the client when creating the ring */
+	uint32_t magic;
+	uint32_t entries;
+	uint32_t data_size;
+	uint32_t msg_size;
+
+	/** Written by the client */
+	atomic_uint sq_tail __attribute__((aligned(ASYNC_RING_ALIGN)));
+	atomic_uint cq_head;
+	atomic_uint client_idle;
+
+	/** Written by the server */
+	atomic_uint sq_head __attribute__((aligned(ASYNC_RING_ALIGN)));
+	atomic_uint cq_tail;
+	atomic_uint server_idle;
+} async_ring_shared_t;
+
+/** Ring channel endpoint */
+struct async_ring {
+	/** Shared ring area */
+	async_ring_shared_t *shared;
+	/** Size of the shared ring area */
+	size_t size;
+	/** Submission queue slots */
+	uint8_t *sq;
+	/** Completion queue slots */
+	uint8_t *cq;
+
+	/** Number of entries in each queue (a power of two) */
+	uint32_t entries;
+	/** Inline payload size of each message */
+	size_t data_size;
+	/** Size of a message slot */
+	size_t msg_size;
+
+	/** True for the server endpoint */
+	bool server;
+	/** Interface method used for the ring protocol */
+	sysarg_t imethod;
+
+	/** Session of the ring (client) */
+	async_sess_t *sess;
+	/** Next submission queue slot to fill (client) */
+	uint32_t sq_tail;
+	/** Next completion queue slot to consume (client) */
+	uint32_t cq_head;
+
+	/** Next submission queue slot to serve (server) */
+	uint32_t sq_head;
+	/** Next completion queue slot to fill (server) */
+	uint32_t cq_tail;
+	/** Parked ASYNC_RING_WAIT call (server) */
+	ipc_call_t wait_call;
+	/** True if @c wait_call holds a call (server) */
+	bool waiting;
+};
+
+static size_t async_ring_msg_size(size_t data_size)
+{
+	return ALIGN_UP(sizeof(async_ring_msg_t) + data_size,
+	    sizeof(sysarg_t));
+}
+
+static size_t async_ring_queues_offset(void)
+{
+	return ALIGN_UP(sizeof(async_ring_shared_t), ASYNC_RING_ALIGN);
+}
+
+static async_ring_msg_t *async_ring_slot(async_ring_t *ring, uint8_t *queue,
+    uint32_t idx)
+{
+	return (async_ring_msg_t *)
+	    (queue + (idx & (ring->entries - 1)) * ring->msg_size);
+}
+
+/** Set up the queue pointers of a ring endpoint */
+static void async_ring_layout(async_ring_t *ring, void *area, size_t size,
+    uint32_t entries, size_t data_size)
+{
+	ring->shared = (async_ring_shared_t *) area;
+	ring->size = size;
+	ring->entries = entries;
+	ring->data_size = data_size;
+	ring->msg_size = async_ring_msg_size(data_size);
+	ring->sq = (uint8_t *) area + async_ring_queues_offset();
+	ring->cq = ring->sq + entries * ring->msg_size;
+}
+
+/** Create a ring channel on a session.
+ *
+ * The server receives the setup as an ordinary call with method @a imethod
+ * and passes it to async_ring_accept(). The same method carries the ring
+ * protocol messages later on.
+ *
+ * @param sess      Session to the server. It must not use parallel
+ *                  exchanges.
+ * @param imethod   Interface method the server accepts rings with.
+ * @param entries   Number of entries in each queue. A power of two.
+ * @param data_size Inline payload size of each message in bytes.
+ * @param rring     Place to store the new ring.
+ *
+ * @return EOK on success, EINVAL on invalid arguments, ENOTSUP if the
+ *         session uses parallel exchanges, ENOMEM if out of memory, or
+ *         an error code returned by the server.
+ */
+errno_t async_ring_create(async_sess_t *sess, sysarg_t imethod,
+    size_t entries, size_t data_size, async_ring_t **rring)
+{
+	if ((entries == 0) || (entries > ASYNC_RING_MAX_ENTRIES) ||
+	    ((entries & (entries - 1)) != 0) || (data_size > ASYNC_RING_MAX_DATA))
+		return EINVAL;
+
+	exch_mgmt_t mgmt = sess->mgmt;
+	if (sess->iface != 0)
+		mgmt = sess->iface & IFACE_EXCHANGE_MASK;
+
+	if (mgmt == EXCHANGE_PARALLEL)
+		return ENOTSUP;
+
+	async_ring_t *ring = calloc(1, sizeof(async_ring_t));
+	if (ring == NULL)
+		return ENOMEM;
+
+	size_t size = ALIGN_UP(async_ring_queues_offset() +
+	    2 * entries * async_ring_msg_size(data_size), PAGE_SIZE);
+	void *area = as_area_create(AS_AREA_ANY, size,
+	    AS_AREA_READ | AS_AREA_WRITE | AS_AREA_CACHEABLE, AS_AREA_UNPAGED);
+	if (area == AS_MAP_FAILED) {
+		free(ring);
+		return ENOMEM;
+	}
+
+	async_ring_layout(ring, area, size, entries, data_size);
+	ring->sess = sess;
+	ring->imethod = imethod;
+
+	async_ring_shared_t *shared = ring->shared;
+	shared->magic = ASYNC_RING_MAGIC;
+	shared->entries = entries;
+	shared->data_size = data_size;
+	shared->msg_size = ring->msg_size;
+	atomic_init(&shared->sq_tail, 0);
+	atomic_init(&shared->cq_head, 0);
+	atomic_init(&shared->client_idle, 0);
+	atomic_init(&shared->sq_head, 0);
+	atomic_init(&shared->cq_tail, 0);
+	atomic_init(&shared->server_idle, 0);
+
+	async_exch_t *exch = async_exchange_begin(sess);
+	aid_t req = async_send_1(exch, imethod, ASYNC_RING_SETUP, NULL);
+	errno_t rc = async_share_out_start(exch, area,
+	    AS_AREA_READ | AS_AREA_WRITE | AS_AREA_CACHEABLE);
+	async_exchange_end(exch);
+
+	if (rc != EOK) {
+		async_forget(req);
+		as_area_destroy(area);
+		free(ring);
+		return rc;
+	}
+
+	errno_t retval;
+	async_wait_for(req, &retval);
+	if (retval != EOK) {
+		as_area_destroy(area);
+		free(ring);
+		return retval;
+	}
+
+	*rring = ring;
+	return EOK;
+}
+
+/** Get the next free request slot.
+ *
+ * The caller fills in the slot and submits it with async_ring_send().
+ *
+ * @param ring Client ring endpoint.
+ *
+ * @return Request slot or NULL if the maximum number of requests is
+ *         outstanding. Answers need to be released first in that case.
+ */
+async_ring_msg_t *async_ring_send_msg(async_ring_t *ring)
+{
+	assert(!ring->server);
+
+	if (ring->sq_tail - ring->cq_head >= ring->entries)
+		return NULL;
+
+	return async_ring_slot(ring, ring->sq, ring->sq_tail);
+}
+
+/** Submit the request filled in the slot from async_ring_send_msg().
+ *
+ * @param ring Client ring endpoint.
+ */
+void async_ring_send(async_ring_t *ring)
+{
+	assert(!ring->server);
+	assert(ring->sq_tail - ring->cq_head < ring->entries);
+
+	async_ring_shared_t *shared = ring->shared;
+
+	ring->sq_tail++;
+	atomic_store(&shared->sq_tail, ring->sq_tail);
+
+	if (atomic_load_explicit(&shared->server_idle, memory_order_relaxed) &&
+	    atomic_exchange(&shared->server_idle, 0)) {
+		async_exch_t *exch = async_exchange_begin(ring->sess);
+		async_msg_1(exch, ring->imethod, ASYNC_RING_DOORBELL);
+		async_exchange_end(exch);
+	}
+}
+
+/** Wait for the next answer.
+ *
+ * Answers arrive in the order in which the server has served the requests.
+ * Use the tag of the message to match them with requests. The answer
+ * remains valid until it is released with async_ring_release().
+ *
+ * @param ring Client ring endpoint.
+ * @param rmsg Place to store a pointer to the answer.
+ *
+ * @return EOK on success, EIO if the server corrupted the ring, or an
+ *         error code if the server could not be reached.
+ */
+errno_t async_ring_wait(async_ring_t *ring, async_ring_msg_t **rmsg)
+{
+	assert(!ring->server);
+
+	async_ring_shared_t *shared = ring->shared;
+
+	while (true) {
+		uint32_t tail = atomic_load_explicit(&shared->cq_tail,
+		    memory_order_acquire);
+
+		if (tail == ring->cq_head) {
+			atomic_store(&shared->client_idle, 1);
+			tail = atomic_load(&shared->cq_tail);
+			if (tail == ring->cq_head) {
+				async_exch_t *exch = async_exchange_begin(ring->sess);
+				aid_t req = async_send_1(exch, ring->imethod,
+				    ASYNC_RING_WAIT, NULL);
+				async_exchange_end(exch);
+
+				errno_t rc;
+				async_wait_for(req, &rc);
+				if (rc != EOK)
+					return rc;
+
+				continue;
+			}
+
+			atomic_store(&shared->client_idle, 0);
+		}
+
+		if (tail - ring->cq_head > ring->sq_tail - ring->cq_head)
+			return EIO;
+
+		*rmsg = async_ring_slot(ring, ring->cq, ring->cq_head);
+		return EOK;
+	}
+}
+
+/** Release the answer returned by async_ring_wait().
+ *
+ * @param ring Client ring endpoint.
+ */
+void async_ring_release(async_ring_t *ring)
+{
+	assert(!ring->server);
+
+	ring->cq_head++;
+	atomic_store_explicit(&ring->shared->cq_head, ring->cq_head,
+	    memory_order_release);
+}
+
+/** Accept a ring channel.
+ *
+ * The server calls this for a call with the ring method of its interface.
+ * The call is answered.
+ *
+ * @param icall Ring setup call.
+ * @param rring Place to store the new ring.
+ *
+ * @return EOK on success or an error code.
+ */
+errno_t async_ring_accept(ipc_call_t *icall, async_ring_t **rring)
+{
+	if (ipc_get_arg1(icall) != ASYNC_RING_SETUP) {
+		async_answer_0(icall, EINVAL);
+		return EINVAL;
+	}
+
+	async_ring_t *ring = calloc(1, sizeof(async_ring_t));
+	if (ring == NULL) {
+		async_answer_0(icall, ENOMEM);
+		return ENOMEM;
+	}
+
+	ipc_call_t call;
+	size_t size;
+	unsigned int flags;
+	if (!async_share_out_receive(&call, &size, &flags)) {
+		free(ring);
+		async_answer_0(&call, EINVAL);
+		async_answer_0(icall, EINVAL);
+		return EINVAL;
+	}
+
+	if ((size < sizeof(async_ring_shared_t)) ||
+	    ((flags & (AS_AREA_READ | AS_AREA_WRITE)) !=
+	    (AS_AREA_READ | AS_AREA_WRITE))) {
+		free(ring);
+		async_answer_0(&call, EINVAL);
+		async_answer_0(icall, EINVAL);
+		return EINVAL;
+	}
+
+	void *area;
+	errno_t rc = async_share_out_finalize(&call, &area);
+	if ((rc != EOK) || (area == AS_MAP_FAILED)) {
+		free(ring);
+		async_answer_0(icall, ENOMEM);
+		return ENOMEM;
+	}
+
+	/*
+	 * Take a snapshot of the geometry of the ring. The client can rewrite
+	 * the header at any time, so it is not consulted again.
+	 */
+	async_ring_shared_t *shared = (async_ring_shared_t *) area;
+	uint32_t magic = shared->magic;
+	uint32_t entries = shared->entries;
+	uint32_t data_size = shared->data_size;
+	uint32_t msg_size = shared->msg_size;
+
+	if ((magic != ASYNC_RING_MAGIC) || (entries == 0) ||
+	    (entries > ASYNC_RING_MAX_ENTRIES) ||
+	    ((entries & (entries - 1)) != 0) ||
+	    (data_size > ASYNC_RING_MAX_DATA) ||
+	    (msg_size != async_ring_msg_size(data_size)) ||
+	    (async_ring_queues_offset() + 2 * entries * msg_size > size)) {
+		as_area_destroy(area);
+		free(ring);
+		async_answer_0(icall, EINVAL);
+		return EINVAL;
+	}
+
+	async_ring_layout(ring, area, size, entries, data_size);
+	ring->server = true;
+	ring->imethod = ipc_get_imethod(icall);
+
+	async_answer_0(icall, EOK);
+	*rring = ring;
+	return EOK;
+}
+
+/** Answer the parked wait call of the client, if any. */
+static void async_ring_wakeup(async_ring_t *ring, errno_t rc)
+{
+	if (ring->waiting) {
+		ring->waiting = false;
+		async_answer_0(&ring->wait_call, rc);
+	}
+}
+
+/** Receive the next request from a ring.
+ *
+ * If the submission queue is empty, the calling connection fibril sleeps
+ * until the client submits a request or another call arrives on the
+ * connection. Calls that do not belong to the ring protocol are returned
+ * to the caller. This includes the hangup of the connection.
+ *
+ * @param ring Server ring endpoint.
+ * @param rmsg Place to store a pointer to the request. The request stays
+ *             valid until answered with async_ring_answer().
+ * @param call Place to store an ordinary call.
+ *
+ * @return EOK if a request was received, ENOENT if an ordinary call was
+ *         received, EHANGUP if the client closed the ring, or EIO if the
+ *         client corrupted the ring.
+ */
+errno_t async_ring_receive(async_ring_t *ring, async_ring_msg_t **rmsg,
+    ipc_call_t *call)
+{
+	assert(ring->server);
+
+	async_ring_shared_t *shared = ring->shared;
+
+	while (true) {
+		uint32_t tail = atomic_load_explicit(&shared->sq_tail,
+		    memory_order_acquire);
+
+		if (tail != ring->sq_head) {
+			if (tail - ring->sq_head > ring->entries)
+				return EIO;
+
+			*rmsg = async_ring_slot(ring, ring->sq, ring->sq_head);
+			return EOK;
+		}
+
+		atomic_store(&shared->server_idle, 1);
+		if (atomic_load(&shared->sq_tail) != ring->sq_head) {
+			atomic_store(&shared->server_idle, 0);
+			continue;
+		}
+
+		async_get_call(call);
+		atomic_store(&shared->server_idle, 0);
+
+		if ((ipc_get_imethod(call) != ring->imethod) ||
+		    (ipc_get_arg1(call) == ASYNC_RING_SETUP))
+			return ENOENT;
+
+		switch (ipc_get_arg1(call)) {
+		case ASYNC_RING_DOORBELL:
+			async_answer_0(call, EOK);
+			break;
+		case ASYNC_RING_WAIT:
+			async_ring_wakeup(ring, EOK);
+
+			if (atomic_load(&shared->cq_head) != ring->cq_tail) {
+				/* An answer is ready already */
+				async_answer_0(call, EOK);
+			} else {
+				ring->wait_call = *call;
+				ring->waiting = true;
+			}
+			break;
+		case ASYNC_RING_CLOSE:
+			async_ring_wakeup(ring, EHANGUP);
+			async_answer_0(call, EOK);
+			return EHANGUP;
+		default:
+			async_answer_0(call, EINVAL);
+			break;
+		}
+	}
+}
+
+/** Get the answer slot for the request being served.
+ *
+ * @param ring Server ring endpoint.
+ *
+ * @return Answer slot with the tag of the request filled in.
+ */
+async_ring_msg_t *async_ring_answer_msg(async_ring_t *ring)
+{
+	assert(ring->server);
+
+	async_ring_msg_t *req = async_ring_slot(ring, ring->sq, ring->sq_head);
+	async_ring_msg_t *answer = async_ring_slot(ring, ring->cq,
+	    ring->cq_tail);
+
+	answer->tag = req->tag;
+	return answer;
+}
+
+/** Answer the request being served.
+ *
+ * Answer arguments and payload need to be filled in the slot returned by
+ * async_ring_answer_msg() beforehand. After this call, the request slot
+ * must not be used anymore.
+ *
+ * @param ring   Server ring endpoint.
+ * @param retval Return value of the request.
+ */
+void async_ring_answer(async_ring_t *ring, errno_t retval)
+{
+	assert(ring->server);
+
+	async_ring_shared_t *shared = ring->shared;
+	async_ring_msg_t *answer = async_ring_slot(ring, ring->cq,
+	    ring->cq_tail);
+
+	answer->method = (sysarg_t) retval;
+
+	ring->sq_head++;
+	ring->cq_tail++;
+	atomic_store_explicit(&shared->sq_head, ring->sq_head,
+	    memory_order_release);
+	atomic_store(&shared->cq_tail, ring->cq_tail);
+
+	if (atomic_load_explicit(&shared->client_idle, memory_order_relaxed) &&
+	    atomic_exchange(&shared->client_idle, 0))
+		async_ring_wakeup(ring, EOK);
+}
+
+/** Get the inline payload size of the ring messages.
+ *
+ * @param ring Ring endpoint.
+ *
+ * @return Maximum value of the @c size field of a message.
+ */
+size_t async_ring_data_size(async_ring_t *ring)
+{
+	return ring->data_size;
+}
+
+/** Destroy a ring endpoint.
+ *
+ * The client closes the ring on the server. It must not have any requests
+ * outstanding when doing so. The server destroys its endpoint after
+ * async_ring_receive() reports that the ring was closed, or after the
+ * connection has been hung up.
+ *
+ * @param ring Ring endpoint.
+ */
+void async_ring_destroy(async_ring_t *ring)
+{
+	if (ring == NULL)
+		return;
+
+	if (ring->server) {
+		async_ring_wakeup(ring, EHANGUP);
+	} else {
+		async_exch_t *exch = async_exchange_begin(ring->sess);
+		(void) async_req_1_0(exch, ring->imethod, ASYNC_RING_CLOSE);
+		async_exchange_end(exch);
+	}
+
+	as_area_destroy(ring->shared);
+	free(ring);
+}
+
+/** @}
+ */
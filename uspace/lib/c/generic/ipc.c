@@ -109,6 +109,25 @@ errno_t ipc_call_async_slow(cap_phone_handle_t phandle, sysarg_t imethod,
 	    (sysarg_t) label);
 }
 
+/** Make a batch of asynchronous calls in one system call.
+ *
+ * The calls are made in the order of the array. The batch stops at the
+ * first call which cannot be made. The remaining calls are not made.
+ *
+ * @param calls     Calls to make.
+ * @param count     Number of calls, at most IPC_BATCH_MAX.
+ * @param submitted Place to store the number of calls made.
+ *
+ * @return EOK if all calls were made, otherwise the error code of the
+ *         first call which was not made.
+ */
+errno_t ipc_call_async_batch(ipc_batch_call_t *calls, size_t count,
+    size_t *submitted)
+{
+	return (errno_t) __SYSCALL3(SYS_IPC_CALL_ASYNC_BATCH,
+	    (sysarg_t) calls, count, (sysarg_t) submitted);
+}
+
 /** Answer received call (fast version).
  *
  * The fast answer makes use of passing retval and first four arguments in
@@ -176,6 +195,27 @@ errno_t ipc_wait(ipc_call_t *call, sysarg_t usec, unsigned int flags)
 	return __SYSCALL3(SYS_IPC_WAIT, (sysarg_t) call, usec, flags);
 }
 
+/** Wait for calls and answers and receive a batch of them.
+ *
+ * The first call is waited for as in ipc_wait(). The calls and answers
+ * that are pending afterwards are received without blocking.
+ *
+ * @param calls    Array for the received calls and answers.
+ * @param count    Size of the array, at most IPC_BATCH_MAX.
+ * @param usec     Timeout of the first wait.
+ * @param flags    Flags of the first wait.
+ * @param received Place to store the number of received calls and answers.
+ *
+ * @return EOK if at least one call or answer was received, otherwise the
+ *         error code of the first wait.
+ */
+errno_t ipc_wait_batch(ipc_call_t *calls, size_t count, sysarg_t usec,
+    unsigned int flags, size_t *received)
+{
+	return (errno_t) __SYSCALL5(SYS_IPC_WAIT_BATCH, (sysarg_t) calls,
+	    count, usec, flags, (sysarg_t) received);
+}
+
 /** Hang up a phone.
  *
  * @param phandle  Handle of the phone to be hung up.
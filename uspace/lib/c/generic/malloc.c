@@ -79,6 +79,32 @@
  */
 #define SHRINK_GRANULARITY  (64 * PAGE_SIZE)
 
+/** Largest request served by the per-fibril block caches */
+#define CACHE_MAX_SIZE  1024
+
+/** Number of per-fibril cache size classes */
+#define CACHE_CLASSES  12
+
+/** Approximate number of bytes a single cache class may hold
+ *
+ * The number of blocks kept in a class is derived from this and
+ * clamped to [CACHE_MIN_COUNT, CACHE_MAX_COUNT]. Half of the limit
+ * is moved between the cache and the heap at once.
+ *
+ */
+#define CACHE_CLASS_BYTES  4096
+#define CACHE_MIN_COUNT    4
+#define CACHE_MAX_COUNT    32
+
+/** Maximal number of bytes held by all caches of a single fibril
+ *
+ * The caches stay attached to the fibril until it terminates, so
+ * their total is kept well below the sum of the per-class limits.
+ * Once it is exceeded, every class is flushed to half its size.
+ *
+ */
+#define CACHE_FIBRIL_BYTES  (16 * 1024)
+
 /** Overhead of each heap block. */
 #define STRUCT_OVERHEAD \
 	(sizeof(heap_block_head_t) + sizeof(heap_block_foot_t))
@@ -199,6 +225,37 @@ static heap_block_head_t *next_fit = NULL;
 /** Futex for thread-safe heap manipulation */
 static fibril_rmutex_t malloc_mutex;
 
+/** Per-fibril cache of used blocks of a single size class
+ *
+ * Blocks sitting in the cache remain marked as used in the heap.
+ * The list is threaded through the first word of the block payload.
+ *
+ */
+typedef struct {
+	/** First cached block */
+	void *head;
+
+	/** Number of cached blocks */
+	size_t count;
+} malloc_cache_t;
+
+/** Net block sizes of the cache classes */
+static const size_t cache_class_size[CACHE_CLASSES] = {
+	16, 32, 48, 64, 96, 128, 192, 256, 384, 512, 768, 1024
+};
+
+/** Smallest class that fits a request of (index * BASE_ALIGN) bytes */
+static uint8_t cache_class_index[CACHE_MAX_SIZE / BASE_ALIGN + 1];
+
+/** Block caches of the current fibril */
+static fibril_local malloc_cache_t malloc_cache[CACHE_CLASSES];
+
+/** Number of bytes held by the block caches of the current fibril */
+static fibril_local size_t malloc_cache_bytes = 0;
+
+/** Bypass the caches (set once the fibril has drained them for good) */
+static fibril_local bool malloc_cache_disabled = false;
+
 #define malloc_assert(expr) safe_assert(expr)
 
 /*
@@ -499,10 +556,19 @@ void __malloc_init(void)
 
 	if (!area_create(PAGE_SIZE))
 		abort();
+
+	unsigned int cls = 0;
+	for (size_t i = 0; i < sizeof(cache_class_index); i++) {
+		while (cache_class_size[cls] < i * BASE_ALIGN)
+			cls++;
+
+		cache_class_index[i] = cls;
+	}
 }
 
 void __malloc_fini(void)
 {
+	__malloc_fibril_fini();
 	fibril_rmutex_destroy(&malloc_mutex);
 }
 
@@ -777,6 +843,219 @@ static void *malloc_internal(size_t size, size_t align)
 	return heap_grow_and_alloc(gross_size, falign);
 }
 
+/** Return a block to the heap
+ *
+ * Should be called only inside the critical section.
+ *
+ * @param addr The address of the block.
+ *
+ */
+static void free_internal(void *const addr)
+{
+	/* Calculate the position of the header. */
+	heap_block_head_t *head =
+	    (heap_block_head_t *) (addr - sizeof(heap_block_head_t));
+
+	block_check(head);
+	malloc_assert(!head->free);
+
+	heap_area_t *area = head->area;
+
+	area_check(area);
+	malloc_assert((void *) head >= (void *) AREA_FIRST_BLOCK_HEAD(area));
+	malloc_assert((void *) head < area->end);
+
+	/* Mark the block itself as free. */
+	head->free = true;
+
+	/* Look at the next block. If it is free, merge the two. */
+	heap_block_head_t *next_head =
+	    (heap_block_head_t *) (((void *) head) + head->size);
+
+	if ((void *) next_head < area->end) {
+		block_check(next_head);
+		if (next_head->free)
+			block_init(head, head->size + next_head->size, true, area);
+	}
+
+	/* Look at the previous block. If it is free, merge the two. */
+	if ((void *) head > (void *) AREA_FIRST_BLOCK_HEAD(area)) {
+		heap_block_foot_t *prev_foot =
+		    (heap_block_foot_t *) (((void *) head) - sizeof(heap_block_foot_t));
+
+		heap_block_head_t *prev_head =
+		    (heap_block_head_t *) (((void *) head) - prev_foot->size);
+
+		block_check(prev_head);
+
+		if (prev_head->free)
+			block_init(prev_head, prev_head->size + head->size, true,
+			    area);
+	}
+
+	heap_shrink(area);
+}
+
+/** Get the cache class a block can be recycled into
+ *
+ * The class is the largest one whose size does not exceed the net size
+ * of the block, so that a block handed out of the class is always
+ * large enough. Blocks considerably larger than the largest class are
+ * left to the heap.
+ *
+ * @param net Net size of the block.
+ *
+ * @return Cache class or -1 if the block should not be cached.
+ *
+ */
+static inline int cache_class_of_block(size_t net)
+{
+	if (net > CACHE_MAX_SIZE + STRUCT_OVERHEAD)
+		return -1;
+
+	if (net >= CACHE_MAX_SIZE)
+		return CACHE_CLASSES - 1;
+
+	unsigned int cls = cache_class_index[net / BASE_ALIGN];
+	if (cache_class_size[cls] > net)
+		cls--;
+
+	return cls;
+}
+
+/** Get the maximal number of blocks held by a cache class */
+static inline size_t cache_limit(unsigned int cls)
+{
+	return min(max(CACHE_CLASS_BYTES / cache_class_size[cls],
+	    CACHE_MIN_COUNT), CACHE_MAX_COUNT);
+}
+
+/** Return cached blocks to the heap
+ *
+ * Should be called only inside the critical section.
+ *
+ * @param cls  Cache class to trim.
+ * @param keep Number of blocks to leave in the cache.
+ *
+ */
+static void cache_flush(unsigned int cls, size_t keep)
+{
+	malloc_cache_t *cache = &malloc_cache[cls];
+
+	while (cache->count > keep) {
+		void *block = cache->head;
+
+		cache->head = *((void **) block);
+		cache->count--;
+		malloc_cache_bytes -= cache_class_size[cls];
+		free_internal(block);
+	}
+}
+
+/** Allocate a block of a cache class and refill the cache
+ *
+ * Allocate half of the cache limit worth of blocks in a single
+ * critical section, return one of them and keep the rest in
+ * the cache of the current fibril.
+ *
+ * @param cls Cache class.
+ *
+ * @return Allocated memory or NULL.
+ *
+ */
+static void *cache_refill(unsigned int cls)
+{
+	malloc_cache_t *cache = &malloc_cache[cls];
+	size_t size = cache_class_size[cls];
+	size_t batch = cache_limit(cls) / 2;
+
+	heap_lock();
+
+	void *block = malloc_internal(size, BASE_ALIGN);
+
+	for (size_t i = 1; (block != NULL) && (i < batch); i++) {
+		void *extra = malloc_internal(size, BASE_ALIGN);
+		if (extra == NULL)
+			break;
+
+		*((void **) extra) = cache->head;
+		cache->head = extra;
+		cache->count++;
+		malloc_cache_bytes += size;
+	}
+
+	heap_unlock();
+
+	return block;
+}
+
+/** Try to keep a freed block in the cache of the current fibril
+ *
+ * The header of a used block is not touched by anybody but its owner,
+ * therefore it can be checked without holding the heap lock.
+ *
+ * @param addr The address of the block.
+ *
+ * @return True if the block was cached, false if it should be
+ *         returned to the heap.
+ *
+ */
+static bool cache_put(void *const addr)
+{
+	heap_block_head_t *head =
+	    (heap_block_head_t *) (addr - sizeof(heap_block_head_t));
+
+	block_check(head);
+	malloc_assert(!head->free);
+
+	int cls = cache_class_of_block(NET_SIZE(head->size));
+	if (cls < 0)
+		return false;
+
+	malloc_cache_t *cache = &malloc_cache[cls];
+
+	*((void **) addr) = cache->head;
+	cache->head = addr;
+	cache->count++;
+	malloc_cache_bytes += cache_class_size[cls];
+
+	size_t limit = cache_limit(cls);
+	if (cache->count > limit) {
+		heap_lock();
+		cache_flush(cls, limit / 2);
+		heap_unlock();
+	}
+
+	if (malloc_cache_bytes > CACHE_FIBRIL_BYTES) {
+		heap_lock();
+
+		for (unsigned int i = 0; i < CACHE_CLASSES; i++)
+			cache_flush(i, malloc_cache[i].count / 2);
+
+		heap_unlock();
+	}
+
+	return true;
+}
+
+/** Drain the block caches of the current fibril
+ *
+ * Called when the fibril is about to terminate. Any later
+ * allocation requests of the fibril bypass the caches.
+ *
+ */
+void __malloc_fibril_fini(void)
+{
+	malloc_cache_disabled = true;
+
+	heap_lock();
+
+	for (unsigned int cls = 0; cls < CACHE_CLASSES; cls++)
+		cache_flush(cls, 0);
+
+	heap_unlock();
+}
+
 /** Allocate memory
  *
  * @param size Number of bytes to allocate.
@@ -786,6 +1065,22 @@ static void *malloc_internal(size_t size, size_t align)
  */
 void *malloc(const size_t size)
 {
+	if ((size <= CACHE_MAX_SIZE) && (!malloc_cache_disabled)) {
+		unsigned int cls =
+		    cache_class_index[ALIGN_UP(size, BASE_ALIGN) / BASE_ALIGN];
+		malloc_cache_t *cache = &malloc_cache[cls];
+
+		if (cache->head == NULL)
+			return cache_refill(cls);
+
+		void *block = cache->head;
+		cache->head = *((void **) block);
+		cache->count--;
+		malloc_cache_bytes -= cache_class_size[cls];
+
+		return block;
+	}
+
 	heap_lock();
 	void *block = malloc_internal(size, BASE_ALIGN);
 	heap_unlock();
@@ -962,51 +1257,11 @@ void free(void *const addr)
 	if (addr == NULL)
 		return;
 
-	heap_lock();
-
-	/* Calculate the position of the header. */
-	heap_block_head_t *head =
-	    (heap_block_head_t *) (addr - sizeof(heap_block_head_t));
-
-	block_check(head);
-	malloc_assert(!head->free);
-
-	heap_area_t *area = head->area;
-
-	area_check(area);
-	malloc_assert((void *) head >= (void *) AREA_FIRST_BLOCK_HEAD(area));
-	malloc_assert((void *) head < area->end);
-
-	/* Mark the block itself as free. */
-	head->free = true;
-
-	/* Look at the next block. If it is free, merge the two. */
-	heap_block_head_t *next_head =
-	    (heap_block_head_t *) (((void *) head) + head->size);
-
-	if ((void *) next_head < area->end) {
-		block_check(next_head);
-		if (next_head->free)
-			block_init(head, head->size + next_head->size, true, area);
-	}
-
-	/* Look at the previous block. If it is free, merge the two. */
-	if ((void *) head > (void *) AREA_FIRST_BLOCK_HEAD(area)) {
-		heap_block_foot_t *prev_foot =
-		    (heap_block_foot_t *) (((void *) head) - sizeof(heap_block_foot_t));
-
-		heap_block_head_t *prev_head =
-		    (heap_block_head_t *) (((void *) head) - prev_foot->size);
-
-		block_check(prev_head);
-
-		if (prev_head->free)
-			block_init(prev_head, prev_head->size + head->size, true,
-			    area);
-	}
-
-	heap_shrink(area);
+	if (!malloc_cache_disabled && cache_put(addr))
+		return;
 
+	heap_lock();
+	free_internal(addr);
 	heap_unlock();
 }
 
@@ -43,6 +43,8 @@ typedef struct {
 
 #define FIBRIL_EVENT_INIT ((fibril_event_t) {0})
 
+typedef struct fibril_runner fibril_runner_t;
+
 struct fibril {
 	// XXX: The first two fields must not move (for taskdump).
 	link_t all_link;
@@ -59,6 +61,12 @@ struct fibril {
 	errno_t retval;
 
 	fibril_t *thread_ctx;
+	/* Runner that ran the fibril last. */
+	fibril_runner_t *runner;
+	/* Fibril whose switch to this one is to be finished. */
+	fibril_t *switched_from;
+	/* Whether the fibril's context is being saved (_switch_state_t). */
+	atomic_int switching;
 
 	bool is_running : 1;
 	bool is_writer : 1;
@@ -78,6 +86,7 @@ extern fibril_t *fibril_self(void);
 
 extern void __fibrils_init(void);
 extern void __fibrils_fini(void);
+extern void __fibril_thread_fini(void);
 
 extern void fibril_wait_for(fibril_event_t *);
 extern errno_t fibril_wait_timeout(fibril_event_t *, const struct timespec *);
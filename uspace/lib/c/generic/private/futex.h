@@ -36,6 +36,7 @@
 #define _LIBC_FUTEX_H_
 
 #include <assert.h>
+#include <stdlib.h>
 #include <stdatomic.h>
 #include <errno.h>
 #include <libc.h>
@@ -44,6 +45,12 @@
 #include <abi/cap.h>
 #include <abi/synch.h>
 
+/*
+ * Futexes are identified in the kernel by the address of their counter,
+ * so they need no kernel resources until somebody has to sleep on them.
+ * A futex can still be backed by a waitq capability allocated with
+ * futex_allocate_waitq(), in which case whandle is not CAP_NIL.
+ */
 typedef struct futex {
 	volatile atomic_int val;
 	volatile cap_waitq_handle_t whandle;
@@ -85,9 +92,9 @@ void __futex_give_to(futex_t *, void *, const char *);
 
 #else
 
-#define futex_lock(fut)     (void) futex_down((fut))
+#define futex_lock(fut)     futex_down_nofail((fut))
 #define futex_trylock(fut)  futex_trydown((fut))
-#define futex_unlock(fut)   (void) futex_up((fut))
+#define futex_unlock(fut)   futex_up_nofail((fut))
 
 #define futex_give_to(fut, owner) ((void)0)
 #define futex_assert_is_locked(fut) assert(atomic_load_explicit(&(fut)->val, memory_order_relaxed) <= 0)
@@ -121,8 +128,6 @@ static inline errno_t futex_down_composable(futex_t *futex,
 {
 	// TODO: Add tests for this.
 
-	assert(futex->whandle != CAP_NIL);
-
 	if (atomic_fetch_sub_explicit(&futex->val, 1, memory_order_acquire) > 0)
 		return EOK;
 
@@ -147,7 +152,12 @@ static inline errno_t futex_down_composable(futex_t *futex,
 		assert(timeout > 0);
 	}
 
-	return __SYSCALL3(SYS_WAITQ_SLEEP, (sysarg_t) futex->whandle,
+	if (futex->whandle != CAP_NIL) {
+		return __SYSCALL3(SYS_WAITQ_SLEEP, (sysarg_t) futex->whandle,
+		    (sysarg_t) timeout, (sysarg_t) SYNCH_FLAGS_FUTEX);
+	}
+
+	return __SYSCALL3(SYS_FUTEX_SLEEP, (sysarg_t) &futex->val,
 	    (sysarg_t) timeout, (sysarg_t) SYNCH_FLAGS_FUTEX);
 }
 
@@ -162,10 +172,27 @@ static inline errno_t futex_down_composable(futex_t *futex,
  */
 static inline errno_t futex_up(futex_t *futex)
 {
-	if (atomic_fetch_add_explicit(&futex->val, 1, memory_order_release) < 0)
+	if (atomic_fetch_add_explicit(&futex->val, 1, memory_order_release) >= 0)
+		return EOK;
+
+	if (futex->whandle != CAP_NIL)
 		return __SYSCALL1(SYS_WAITQ_WAKEUP, (sysarg_t) futex->whandle);
 
-	return EOK;
+	return __SYSCALL1(SYS_FUTEX_WAKEUP, (sysarg_t) &futex->val);
+}
+
+/** Up the futex, aborting if the wakeup cannot be delivered.
+ *
+ * A failed wakeup would leave a sleeper blocked forever, so the caller
+ * cannot just ignore the error.
+ *
+ * @param futex Futex.
+ *
+ */
+static inline void futex_up_nofail(futex_t *futex)
+{
+	if (futex_up(futex) != EOK)
+		abort();
 }
 
 static inline errno_t futex_down_timeout(futex_t *futex,
@@ -178,7 +205,7 @@ static inline errno_t futex_down_timeout(futex_t *futex,
 	 */
 	errno_t rc = futex_down_composable(futex, expires);
 	if (rc != EOK)
-		futex_up(futex);
+		futex_up_nofail(futex);
 	return rc;
 }
 
@@ -223,6 +250,25 @@ static inline errno_t futex_down(futex_t *futex)
 	return futex_down_timeout(futex, NULL);
 }
 
+/** Down the futex, retrying until it is acquired.
+ *
+ * Used where the caller relies on holding the futex afterwards. An
+ * interrupted sleep is retried, any other failure aborts the task.
+ *
+ * @param futex Futex.
+ *
+ */
+static inline void futex_down_nofail(futex_t *futex)
+{
+	while (true) {
+		errno_t rc = futex_down(futex);
+		if (rc == EOK)
+			return;
+		if (rc != EINTR)
+			abort();
+	}
+}
+
 #endif
 
 /** @}
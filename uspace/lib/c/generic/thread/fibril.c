@@ -35,6 +35,7 @@
  */
 
 #include <adt/list.h>
+#include <adt/pheap.h>
 #include <fibril.h>
 #include <stack.h>
 #include <tls.h>
@@ -52,13 +53,16 @@
 #include "../private/futex.h"
 #include "../private/fibril.h"
 #include "../private/libc.h"
+#include "../private/malloc.h"
 
 #define DPRINTF(...) ((void)0)
-#undef READY_DEBUG
 
-/** Member of timeout_list. */
+/** Maximum number of IPC calls received by one system call. */
+#define IPC_RECEIVE_BATCH 16
+
+/** Member of timeout_heap. */
 typedef struct {
-	link_t link;
+	phlink_t link;
 	struct timespec expires;
 	fibril_event_t *event;
 } _timeout_t;
@@ -83,22 +87,83 @@ typedef enum {
 	SWITCH_FROM_BLOCKED,
 } _switch_type_t;
 
+/**
+ * State of a fibril switching away from its runner.
+ *
+ * A fibril that is woken up before its context is saved must not be queued
+ * yet, since another runner could resume it with a stale context. The wakeup
+ * is only recorded and the fibril is queued by whoever finishes the switch.
+ */
+typedef enum {
+	/** The context is not being saved. */
+	SWITCH_STATE_NONE,
+	/** The context is being saved. */
+	SWITCH_STATE_SAVING,
+	/** The context is being saved and the fibril is to be queued then. */
+	SWITCH_STATE_WOKEN,
+} _switch_state_t;
+
+typedef enum {
+	/** Running fibrils or looking for some to run. */
+	RUNNER_BUSY,
+	/** Sleeping on its park semaphore. */
+	RUNNER_PARKED,
+	/** Sleeping in the kernel, waiting for an IPC call. */
+	RUNNER_IPC_WAIT,
+	/** The thread of the runner has exited. */
+	RUNNER_DEAD,
+} _runner_state_t;
+
+/**
+ * Scheduling state of one thread running fibrils.
+ *
+ * Each runner has its own queue of ready fibrils. A fibril that becomes ready
+ * is queued on the runner that ran it last, and runners that run out of work
+ * steal from the others. Runners are never freed, so the list of all runners
+ * can be walked without holding any lock.
+ */
+struct fibril_runner {
+	/** Protects ready. */
+	futex_t lock;
+	list_t ready;
+	atomic_size_t ready_count;
+
+	/** Semaphore the runner sleeps on when it is parked. */
+	futex_t park;
+	atomic_int state;
+	/** Set when the runner was woken up to steal work from others. */
+	atomic_bool stealing;
+
+	_Atomic(fibril_runner_t *) next;
+};
+
 static bool multithreaded = false;
 
-/* This futex serializes access to global data. */
+/* This futex serializes access to events, timeouts and fibril_list. */
 static futex_t fibril_futex;
-static futex_t ready_semaphore;
-static long ready_st_count;
 
-static LIST_INITIALIZE(ready_list);
 static LIST_INITIALIZE(fibril_list);
-static LIST_INITIALIZE(timeout_list);
+static pheap_t timeout_heap;
 
 static futex_t ipc_lists_futex;
 static LIST_INITIALIZE(ipc_waiter_list);
 static LIST_INITIALIZE(ipc_buffer_list);
 static LIST_INITIALIZE(ipc_buffer_free_list);
 
+/*
+ * The first runner is allocated statically so that fibrils can be started
+ * before any thread has a helper fibril. It is the head of the runner list.
+ */
+static fibril_runner_t main_runner;
+static atomic_bool main_runner_claimed;
+
+/* This futex serializes appending to the runner list. */
+static futex_t runners_futex;
+static fibril_runner_t *runners_tail = &main_runner;
+
+/** Number of runners woken up to steal work that have not looked yet. */
+static atomic_int runners_searching;
+
 /* Only used as unique markers for triggered events. */
 static fibril_t _fibril_event_triggered;
 static fibril_t _fibril_event_timed_out;
@@ -106,37 +171,7 @@ static fibril_t _fibril_event_timed_out;
 #define _EVENT_TRIGGERED (&_fibril_event_triggered)
 #define _EVENT_TIMED_OUT (&_fibril_event_timed_out)
 
-static inline void _ready_debug_check(void)
-{
-#ifdef READY_DEBUG
-	assert(!multithreaded);
-	long count = (long) list_count(&ready_list) +
-	    (long) list_count(&ipc_buffer_free_list);
-	assert(ready_st_count == count);
-#endif
-}
-
-static inline void _ready_up(void)
-{
-	if (multithreaded) {
-		futex_up(&ready_semaphore);
-	} else {
-		ready_st_count++;
-		_ready_debug_check();
-	}
-}
-
-static inline errno_t _ready_down(const struct timespec *expires)
-{
-	if (multithreaded)
-		return futex_down_timeout(&ready_semaphore, expires);
-
-	_ready_debug_check();
-	ready_st_count--;
-	return EOK;
-}
-
-static atomic_int threads_in_ipc_wait;
+static void _fibril_switch_finish(void);
 
 /** Function that spans the whole life-cycle of a fibril.
  *
@@ -147,8 +182,8 @@ static atomic_int threads_in_ipc_wait;
  */
 static void _fibril_main(void)
 {
-	/* fibril_futex is locked when a fibril is started. */
-	futex_unlock(&fibril_futex);
+	/* Finish the switch that brought us here. */
+	_fibril_switch_finish();
 
 	fibril_t *fibril = fibril_self();
 
@@ -237,144 +272,485 @@ static fibril_t *_fibril_trigger_internal(fibril_event_t *event, fibril_t *reaso
 	return f;
 }
 
-static errno_t _ipc_wait(ipc_call_t *call, const struct timespec *expires)
+static errno_t _ipc_wait(ipc_call_t *calls, size_t count, size_t *received,
+    const struct timespec *expires)
 {
-	if (!expires)
-		return ipc_wait(call, SYNCH_NO_TIMEOUT, SYNCH_FLAGS_NONE);
+	if (!expires) {
+		return ipc_wait_batch(calls, count, SYNCH_NO_TIMEOUT,
+		    SYNCH_FLAGS_NONE, received);
+	}
 
-	if (expires->tv_sec == 0)
-		return ipc_wait(call, SYNCH_NO_TIMEOUT, SYNCH_FLAGS_NON_BLOCKING);
+	if (expires->tv_sec == 0) {
+		return ipc_wait_batch(calls, count, SYNCH_NO_TIMEOUT,
+		    SYNCH_FLAGS_NON_BLOCKING, received);
+	}
 
 	struct timespec now;
 	getuptime(&now);
 
-	if (ts_gteq(&now, expires))
-		return ipc_wait(call, SYNCH_NO_TIMEOUT, SYNCH_FLAGS_NON_BLOCKING);
+	if (ts_gteq(&now, expires)) {
+		return ipc_wait_batch(calls, count, SYNCH_NO_TIMEOUT,
+		    SYNCH_FLAGS_NON_BLOCKING, received);
+	}
+
+	return ipc_wait_batch(calls, count, NSEC2USEC(ts_sub_diff(expires, &now)),
+	    SYNCH_FLAGS_NONE, received);
+}
+
+static errno_t _runner_initialize(fibril_runner_t *r)
+{
+	errno_t rc = futex_initialize(&r->lock, 1);
+	if (rc != EOK)
+		return rc;
+
+	rc = futex_initialize(&r->park, 0);
+	if (rc != EOK) {
+		futex_destroy(&r->lock);
+		return rc;
+	}
 
-	return ipc_wait(call, NSEC2USEC(ts_sub_diff(expires, &now)),
-	    SYNCH_FLAGS_NONE);
+	list_initialize(&r->ready);
+	atomic_init(&r->ready_count, 0);
+	atomic_init(&r->state, RUNNER_BUSY);
+	atomic_init(&r->stealing, false);
+	atomic_init(&r->next, NULL);
+	return EOK;
 }
 
-/*
- * Waits until a ready fibril is added to the list, or an IPC message arrives.
- * Returns NULL on timeout and may also return NULL if returning from IPC
- * wait after new ready fibrils are added.
+/** Get a runner for a thread that is about to get its helper fibril. */
+static fibril_runner_t *_runner_create(void)
+{
+	if (!atomic_exchange(&main_runner_claimed, true))
+		return &main_runner;
+
+	fibril_runner_t *r = malloc(sizeof(fibril_runner_t));
+	if (!r)
+		return NULL;
+
+	if (_runner_initialize(r) != EOK) {
+		free(r);
+		return NULL;
+	}
+
+	futex_lock(&runners_futex);
+	atomic_store_explicit(&runners_tail->next, r, memory_order_release);
+	runners_tail = r;
+	futex_unlock(&runners_futex);
+
+	return r;
+}
+
+/** Get the next runner in the circular order of all runners. */
+static fibril_runner_t *_runner_next(fibril_runner_t *r)
+{
+	fibril_runner_t *next = atomic_load_explicit(&r->next,
+	    memory_order_acquire);
+	return next ? next : &main_runner;
+}
+
+/**
+ * @return Runner of the calling thread, or the main runner if the thread
+ *         has not got one yet.
  */
-static fibril_t *_ready_list_pop(const struct timespec *expires, bool locked)
+static fibril_runner_t *_runner_self(void)
 {
-	if (locked) {
-		futex_assert_is_locked(&fibril_futex);
-		assert(expires);
-		/* Must be nonblocking. */
-		assert(expires->tv_sec == 0);
-	} else {
-		futex_assert_is_not_locked(&fibril_futex);
+	fibril_t *helper = fibril_self()->thread_ctx;
+	if (helper && helper->runner)
+		return helper->runner;
+
+	return &main_runner;
+}
+
+/**
+ * Queue a fibril on @a r, or on the next runner whose thread has not exited.
+ *
+ * The state of a runner is checked under its lock, which
+ * __fibril_thread_fini() holds while retiring the runner, so no fibril is left
+ * behind on the queue of an exited thread.
+ *
+ * @return Runner the fibril was queued on.
+ */
+static fibril_runner_t *_runner_enqueue(fibril_runner_t *r, fibril_t *f)
+{
+	fibril_runner_t *first = r;
+
+	futex_lock(&r->lock);
+	while (atomic_load(&r->state) == RUNNER_DEAD) {
+		fibril_runner_t *next = _runner_next(r);
+		if (next == first) {
+			/* There is no other runner, keep the fibril here. */
+			break;
+		}
+
+		futex_unlock(&r->lock);
+		r = next;
+		futex_lock(&r->lock);
 	}
 
-	errno_t rc = _ready_down(expires);
-	if (rc != EOK)
+	list_append(&f->link, &r->ready);
+	atomic_fetch_add_explicit(&r->ready_count, 1, memory_order_relaxed);
+	futex_unlock(&r->lock);
+	return r;
+}
+
+static fibril_t *_runner_dequeue(fibril_runner_t *r)
+{
+	if (atomic_load_explicit(&r->ready_count, memory_order_relaxed) == 0)
 		return NULL;
 
-	/*
-	 * Once we acquire a token from ready_semaphore, there are two options.
-	 * Either there is a ready fibril in the list, or it's our turn to
-	 * call `ipc_wait_cycle()`. There is one extra token on the semaphore
-	 * for each entry of the call buffer.
-	 */
+	futex_lock(&r->lock);
+	fibril_t *f = list_pop(&r->ready, fibril_t, link);
+	if (f)
+		atomic_fetch_sub_explicit(&r->ready_count, 1, memory_order_relaxed);
+	futex_unlock(&r->lock);
+	return f;
+}
 
-	if (!locked)
-		futex_lock(&fibril_futex);
-	fibril_t *f = list_pop(&ready_list, fibril_t, link);
-	if (!f)
-		atomic_fetch_add_explicit(&threads_in_ipc_wait, 1,
+/**
+ * Steal work from other runners.
+ *
+ * Takes the younger half of the first non-empty queue found, returns one of
+ * the stolen fibrils and queues the rest on @a r.
+ */
+static fibril_t *_runner_steal(fibril_runner_t *r)
+{
+	for (fibril_runner_t *victim = _runner_next(r); victim != r;
+	    victim = _runner_next(victim)) {
+		if (atomic_load_explicit(&victim->ready_count,
+		    memory_order_relaxed) == 0)
+			continue;
+
+		list_t stolen;
+		list_initialize(&stolen);
+
+		futex_lock(&victim->lock);
+		size_t count = (atomic_load_explicit(&victim->ready_count,
+		    memory_order_relaxed) + 1) / 2;
+		for (size_t i = 0; i < count; i++) {
+			link_t *link = list_last(&victim->ready);
+			list_remove(link);
+			list_prepend(link, &stolen);
+		}
+		atomic_fetch_sub_explicit(&victim->ready_count, count,
 		    memory_order_relaxed);
-	if (!locked)
-		futex_unlock(&fibril_futex);
+		futex_unlock(&victim->lock);
+
+		if (count == 0)
+			continue;
+
+		fibril_t *f = list_pop(&stolen, fibril_t, link);
+		if (count > 1) {
+			futex_lock(&r->lock);
+			list_concat(&r->ready, &stolen);
+			atomic_fetch_add_explicit(&r->ready_count, count - 1,
+			    memory_order_relaxed);
+			futex_unlock(&r->lock);
+		}
 
-	if (f)
 		return f;
+	}
 
-	if (!multithreaded)
-		assert(list_empty(&ipc_buffer_list));
+	return NULL;
+}
 
-	/* No fibril is ready, IPC wait it is. */
-	ipc_call_t call = { 0 };
-	rc = _ipc_wait(&call, expires);
+/** @return true if any runner has a ready fibril. */
+static bool _runner_work_available(void)
+{
+	fibril_runner_t *r = &main_runner;
 
-	atomic_fetch_sub_explicit(&threads_in_ipc_wait, 1,
-	    memory_order_relaxed);
+	do {
+		if (atomic_load(&r->ready_count) != 0)
+			return true;
+		r = atomic_load_explicit(&r->next, memory_order_acquire);
+	} while (r);
 
-	if (rc != EOK && rc != ENOENT) {
-		/* Return token. */
-		_ready_up();
-		return NULL;
+	return false;
+}
+
+/** Wake up a parked runner.
+ *
+ * @param steal  The runner is woken up to steal work from other runners.
+ * @return true if the runner was parked and is now waking up.
+ */
+static bool _runner_unpark(fibril_runner_t *r, bool steal)
+{
+	int expected = RUNNER_PARKED;
+	if (!atomic_compare_exchange_strong(&r->state, &expected, RUNNER_BUSY))
+		return false;
+
+	if (steal) {
+		atomic_fetch_add(&runners_searching, 1);
+		atomic_store_explicit(&r->stealing, true, memory_order_relaxed);
+	}
+
+	futex_up_nofail(&r->park);
+	return true;
+}
+
+/** Wake up one idle runner so that it steals the work of busy ones. */
+static void _runner_wake_idle(void)
+{
+	bool ipc_waiting = false;
+	fibril_runner_t *r = &main_runner;
+
+	do {
+		int state = atomic_load(&r->state);
+		if (state == RUNNER_PARKED && _runner_unpark(r, true))
+			return;
+		if (state == RUNNER_IPC_WAIT)
+			ipc_waiting = true;
+		r = atomic_load_explicit(&r->next, memory_order_acquire);
+	} while (r);
+
+	if (ipc_waiting) {
+		DPRINTF("Poking.\n");
+		/* Wakeup one thread sleeping in SYS_IPC_WAIT. */
+		ipc_poke();
+	}
+}
+
+/** Make sure a fibril just queued on @a r gets to run. */
+static void _runner_kick(fibril_runner_t *r)
+{
+	switch (atomic_load(&r->state)) {
+	case RUNNER_PARKED:
+		if (_runner_unpark(r, false))
+			return;
+		break;
+	case RUNNER_IPC_WAIT:
+		DPRINTF("Poking.\n");
+		/* Wakeup one thread sleeping in SYS_IPC_WAIT. */
+		ipc_poke();
+		return;
+	default:
+		break;
 	}
 
 	/*
-	 * We might get ENOENT due to a poke.
-	 * In that case, we propagate the null call out of fibril_ipc_wait(),
-	 * because poke must result in that call returning.
+	 * The runner is busy and the fibril it runs may not block for a long
+	 * time, so one idle runner is woken up to steal the queued work, unless
+	 * another runner is already on its way to do so.
 	 */
+	if (atomic_load(&runners_searching) == 0)
+		_runner_wake_idle();
+}
+
+/**
+ * Claim a fibril that has just been woken up.
+ *
+ * @return @a f if it can be run, or NULL if it is still switching away on
+ *         another runner and will be queued once its context is saved.
+ */
+static fibril_t *_ready_claim(fibril_t *f)
+{
+	int expected = SWITCH_STATE_SAVING;
+	if (f && atomic_compare_exchange_strong(&f->switching, &expected,
+	    SWITCH_STATE_WOKEN))
+		return NULL;
+
+	return f;
+}
+
+/** Queue a ready fibril, preferably on the runner that ran it last. */
+static void _ready_push(fibril_t *f)
+{
+	f = _ready_claim(f);
+	if (!f)
+		return;
+
+	fibril_runner_t *r = f->runner;
+	if (!r)
+		r = _runner_self();
+
+	r = _runner_enqueue(r, f);
+
+	/* Pairs with the fence in _runner_idle(). */
+	atomic_thread_fence(memory_order_seq_cst);
+	_runner_kick(r);
+}
+
+/** Take a fibril from the runner's own queue, or steal one. */
+static fibril_t *_ready_pop(fibril_runner_t *r)
+{
+	fibril_t *f = _runner_dequeue(r);
+	if (!f)
+		f = _runner_steal(r);
+	return f;
+}
+
+static _ipc_buffer_t *_ipc_buffer_reserve(void)
+{
+	futex_lock(&ipc_lists_futex);
+	_ipc_buffer_t *buf = list_pop(&ipc_buffer_free_list, _ipc_buffer_t, link);
+	futex_unlock(&ipc_lists_futex);
+	return buf;
+}
+
+static void _ipc_buffer_release(_ipc_buffer_t *buf)
+{
+	if (!buf)
+		return;
+
+	futex_lock(&ipc_lists_futex);
+	list_append(&buf->link, &ipc_buffer_free_list);
+	futex_unlock(&ipc_lists_futex);
+}
+
+/**
+ * Wait for IPC calls and hand them over to waiting fibrils, or store them
+ * in buffers if there are none.
+ *
+ * Besides the reserved buffer, up to IPC_RECEIVE_BATCH - 1 more free
+ * buffers are taken, so that all calls pending in the kernel can be received
+ * in one system call. Each received call is guaranteed a buffer.
+ *
+ * The calls are received on the stack, as threads without a runner of their
+ * own may get here concurrently through fibril_yield() or fibril_exit().
+ *
+ * @return Fibril woken up by the first call, or NULL.
+ */
+static fibril_t *_ipc_receive(_ipc_buffer_t *buf,
+    const struct timespec *expires)
+{
+	_ipc_buffer_t *bufs[IPC_RECEIVE_BATCH] = { buf };
+	size_t nbufs = 1;
+
+	futex_lock(&ipc_lists_futex);
+	while (nbufs < IPC_RECEIVE_BATCH) {
+		bufs[nbufs] = list_pop(&ipc_buffer_free_list, _ipc_buffer_t, link);
+		if (!bufs[nbufs])
+			break;
+		nbufs++;
+	}
+	futex_unlock(&ipc_lists_futex);
+
+	ipc_call_t calls[IPC_RECEIVE_BATCH];
+	size_t received = 0;
+	errno_t rc = _ipc_wait(calls, nbufs, &received, expires);
+
+	if (rc == ENOENT) {
+		/*
+		 * We might get ENOENT due to a poke.
+		 * In that case, we propagate the null call out of
+		 * fibril_ipc_wait(), because poke must result in that call
+		 * returning.
+		 */
+		calls[0] = (ipc_call_t) { 0 };
+		received = 1;
+	} else if (rc != EOK) {
+		received = 0;
+	}
 
 	/*
 	 * If a fibril is already waiting for IPC, we wake up the fibril,
-	 * and return the token to ready_semaphore.
-	 * If there is no fibril waiting, we pop a buffer bucket and
-	 * put our call there. The token then returns when the bucket is
-	 * returned.
+	 * and return the buffer to the free list. If there is no fibril
+	 * waiting, we put the call in the buffer. The buffer returns to the
+	 * free list once the call is picked up.
 	 */
 
-	if (!locked)
-		futex_lock(&fibril_futex);
+	fibril_t *woken[IPC_RECEIVE_BATCH];
+	size_t nwoken = 0;
 
+	futex_lock(&fibril_futex);
 	futex_lock(&ipc_lists_futex);
 
-	_ipc_waiter_t *w = list_pop(&ipc_waiter_list, _ipc_waiter_t, link);
-	if (w) {
-		*w->call = call;
-		w->rc = rc;
-		/* We switch to the woken up fibril immediately if possible. */
-		f = _fibril_trigger_internal(&w->event, _EVENT_TRIGGERED);
-
-		/* Return token. */
-		_ready_up();
-	} else {
-		_ipc_buffer_t *buf = list_pop(&ipc_buffer_free_list, _ipc_buffer_t, link);
-		assert(buf);
-		*buf = (_ipc_buffer_t) { .call = call, .rc = rc };
-		list_append(&buf->link, &ipc_buffer_list);
+	for (size_t i = 0; i < nbufs; i++) {
+		_ipc_waiter_t *w = NULL;
+		if (i < received)
+			w = list_pop(&ipc_waiter_list, _ipc_waiter_t, link);
+
+		if (w) {
+			*w->call = calls[i];
+			w->rc = rc;
+			woken[nwoken++] =
+			    _fibril_trigger_internal(&w->event, _EVENT_TRIGGERED);
+			list_append(&bufs[i]->link, &ipc_buffer_free_list);
+		} else if (i < received) {
+			*bufs[i] = (_ipc_buffer_t) { .call = calls[i], .rc = rc };
+			list_append(&bufs[i]->link, &ipc_buffer_list);
+		} else {
+			list_append(&bufs[i]->link, &ipc_buffer_free_list);
+		}
 	}
 
 	futex_unlock(&ipc_lists_futex);
+	futex_unlock(&fibril_futex);
 
-	if (!locked)
-		futex_unlock(&fibril_futex);
+	/* We switch to the first woken up fibril immediately if possible. */
+	for (size_t i = 1; i < nwoken; i++)
+		_ready_push(woken[i]);
 
-	return f;
+	return (nwoken > 0) ? _ready_claim(woken[0]) : NULL;
 }
 
-static fibril_t *_ready_list_pop_nonblocking(bool locked)
+/**
+ * Find a fibril to switch to without blocking. Pending IPC is checked if no
+ * fibril is ready.
+ */
+static fibril_t *_ready_pop_nonblocking(fibril_runner_t *r)
 {
+	fibril_t *f = _ready_pop(r);
+	if (f)
+		return f;
+
+	_ipc_buffer_t *buf = _ipc_buffer_reserve();
+	if (!buf)
+		return NULL;
+
 	struct timespec tv = { .tv_sec = 0, .tv_nsec = 0 };
-	return _ready_list_pop(&tv, locked);
+	return _ipc_receive(buf, &tv);
 }
 
-static void _ready_list_push(fibril_t *f)
+/**
+ * Block the runner until a fibril is queued for it, an IPC call arrives or
+ * the timeout expires.
+ *
+ * An idle runner waits for IPC if there is a free buffer for the call.
+ * Otherwise it parks. Either way, it publishes its state first, so that
+ * _ready_push() knows how to wake it up, and only then checks for work one
+ * last time.
+ *
+ * @return Fibril woken up by an IPC call, or NULL.
+ */
+static fibril_t *_runner_idle(fibril_runner_t *r, const struct timespec *expires)
 {
-	if (!f)
-		return;
+	_ipc_buffer_t *buf = _ipc_buffer_reserve();
+	int state = buf ? RUNNER_IPC_WAIT : RUNNER_PARKED;
 
-	futex_assert_is_locked(&fibril_futex);
+	atomic_store(&r->state, state);
 
-	/* Enqueue in ready_list. */
-	list_append(&f->link, &ready_list);
-	_ready_up();
+	/* Pairs with the fence in _ready_push(). */
+	atomic_thread_fence(memory_order_seq_cst);
 
-	if (atomic_load_explicit(&threads_in_ipc_wait, memory_order_relaxed)) {
-		DPRINTF("Poking.\n");
-		/* Wakeup one thread sleeping in SYS_IPC_WAIT. */
-		ipc_poke();
+	if (_runner_work_available()) {
+		int expected = state;
+		if (!atomic_compare_exchange_strong(&r->state, &expected,
+		    RUNNER_BUSY)) {
+			/* Somebody is waking us up already, eat the wakeup. */
+			assert(state == RUNNER_PARKED);
+			futex_down_nofail(&r->park);
+		}
+
+		_ipc_buffer_release(buf);
+		return NULL;
+	}
+
+	if (buf) {
+		fibril_t *f = _ipc_receive(buf, expires);
+		atomic_store(&r->state, RUNNER_BUSY);
+		return f;
 	}
+
+	if (futex_down_timeout(&r->park, expires) != EOK) {
+		int expected = RUNNER_PARKED;
+		if (!atomic_compare_exchange_strong(&r->state, &expected,
+		    RUNNER_BUSY)) {
+			/* Lost the race with a wakeup, eat it. */
+			futex_down_nofail(&r->park);
+		}
+	}
+
+	return NULL;
 }
 
 /* Blocks the current fibril until an IPC call arrives. */
@@ -390,8 +766,6 @@ static errno_t _wait_ipc(ipc_call_t *call, const struct timespec *expires)
 
 		/* Return to freelist. */
 		list_append(&buf->link, &ipc_buffer_free_list);
-		/* Return IPC wait token. */
-		_ready_up();
 
 		futex_unlock(&ipc_lists_futex);
 		return rc;
@@ -422,9 +796,9 @@ static struct timespec *_handle_expired_timeouts(struct timespec *next_timeout)
 
 	futex_lock(&fibril_futex);
 
-	while (!list_empty(&timeout_list)) {
-		link_t *cur = list_first(&timeout_list);
-		_timeout_t *to = list_get_instance(cur, _timeout_t, link);
+	phlink_t *cur;
+	while ((cur = pheap_first(&timeout_heap)) != NULL) {
+		_timeout_t *to = pheap_get_instance(cur, _timeout_t, link);
 
 		if (ts_gt(&to->expires, &ts)) {
 			*next_timeout = to->expires;
@@ -432,9 +806,9 @@ static struct timespec *_handle_expired_timeouts(struct timespec *next_timeout)
 			return next_timeout;
 		}
 
-		list_remove(&to->link);
+		pheap_remove(&timeout_heap, &to->link);
 
-		_ready_list_push(_fibril_trigger_internal(
+		_ready_push(_fibril_trigger_internal(
 		    to->event, _EVENT_TIMED_OUT));
 	}
 
@@ -444,7 +818,7 @@ static struct timespec *_handle_expired_timeouts(struct timespec *next_timeout)
 
 /**
  * Clean up after a dead fibril from which we restored context, if any.
- * Called after a switch is made and fibril_futex is unlocked.
+ * Called after a switch is made.
  */
 static void _fibril_cleanup_dead(void)
 {
@@ -459,23 +833,40 @@ static void _fibril_cleanup_dead(void)
 	srcf->clean_after_me = NULL;
 }
 
+/**
+ * Complete a switch in the context of the fibril switched to.
+ *
+ * The fibril we switched from has its context saved by now, so it is queued
+ * if it was woken up meanwhile, or it may be queued by its waker from now on.
+ */
+static void _fibril_switch_finish(void)
+{
+	fibril_t *self = fibril_self();
+	fibril_t *prev = self->switched_from;
+
+	self->switched_from = NULL;
+	if (prev && atomic_exchange(&prev->switching, SWITCH_STATE_NONE) ==
+	    SWITCH_STATE_WOKEN)
+		_ready_push(prev);
+
+	_fibril_cleanup_dead();
+}
+
 /** Switch to a fibril. */
-static void _fibril_switch_to(_switch_type_t type, fibril_t *dstf, bool locked)
+static void _fibril_switch_to(_switch_type_t type, fibril_t *dstf)
 {
 	assert(fibril_self()->rmutex_locks == 0);
-
-	if (!locked)
-		futex_lock(&fibril_futex);
-	else
-		futex_assert_is_locked(&fibril_futex);
+	futex_assert_is_not_locked(&fibril_futex);
 
 	fibril_t *srcf = fibril_self();
 	assert(srcf);
 	assert(dstf);
+	assert(srcf != dstf);
 
 	switch (type) {
 	case SWITCH_FROM_YIELD:
-		_ready_list_push(srcf);
+		/* We are queued again once our context is saved. */
+		atomic_store(&srcf->switching, SWITCH_STATE_WOKEN);
 		break;
 	case SWITCH_FROM_DEAD:
 		dstf->clean_after_me = srcf;
@@ -485,11 +876,15 @@ static void _fibril_switch_to(_switch_type_t type, fibril_t *dstf, bool locked)
 		break;
 	}
 
+	/* Only fibrils with a saved context get queued. */
+	assert(atomic_load(&dstf->switching) == SWITCH_STATE_NONE);
+
 	dstf->thread_ctx = srcf->thread_ctx;
 	srcf->thread_ctx = NULL;
 
-	/* Just some bookkeeping to allow better debugging of futex locks. */
-	futex_give_to(&fibril_futex, dstf);
+	if (dstf->thread_ctx)
+		dstf->runner = dstf->thread_ctx->runner;
+	dstf->switched_from = srcf;
 
 	/* Swap to the next fibril. */
 	context_swap(&srcf->ctx, &dstf->ctx);
@@ -497,11 +892,7 @@ static void _fibril_switch_to(_switch_type_t type, fibril_t *dstf, bool locked)
 	assert(srcf == fibril_self());
 	assert(srcf->thread_ctx);
 
-	if (!locked) {
-		/* Must be after context_swap()! */
-		futex_unlock(&fibril_futex);
-		_fibril_cleanup_dead();
-	}
+	_fibril_switch_finish();
 }
 
 /**
@@ -520,18 +911,47 @@ static errno_t _helper_fibril_fn(void *arg)
 
 	(void) arg;
 
+	fibril_runner_t *r = fibril_self()->runner;
+	assert(r);
+
 	struct timespec next_timeout;
 	while (true) {
 		struct timespec *to = _handle_expired_timeouts(&next_timeout);
-		fibril_t *f = _ready_list_pop(to, false);
-		if (f) {
-			_fibril_switch_to(SWITCH_FROM_HELPER, f, false);
+		fibril_t *f = _ready_pop(r);
+
+		if (atomic_load_explicit(&r->stealing, memory_order_relaxed)) {
+			atomic_store_explicit(&r->stealing, false,
+			    memory_order_relaxed);
+			atomic_fetch_sub(&runners_searching, 1);
 		}
+
+		if (!f)
+			f = _runner_idle(r, to);
+
+		if (f)
+			_fibril_switch_to(SWITCH_FROM_HELPER, f);
 	}
 
 	return EOK;
 }
 
+/** Create the helper fibril of the calling thread, with a runner. */
+static fibril_t *_helper_create(void)
+{
+	fibril_t *helper = (fibril_t *)
+	    fibril_create_generic(_helper_fibril_fn, NULL, PAGE_SIZE);
+	if (!helper)
+		return NULL;
+
+	helper->runner = _runner_create();
+	if (!helper->runner) {
+		fibril_destroy((fid_t) helper);
+		return NULL;
+	}
+
+	return helper;
+}
+
 /** Create a new fibril.
  *
  * @param func Implementing function of the new fibril.
@@ -595,22 +1015,22 @@ void fibril_destroy(fid_t fid)
 	fibril_teardown(fibril);
 }
 
+static int _timeout_cmp(phlink_t *a, phlink_t *b)
+{
+	_timeout_t *ta = pheap_get_instance(a, _timeout_t, link);
+	_timeout_t *tb = pheap_get_instance(b, _timeout_t, link);
+
+	if (ts_gt(&tb->expires, &ta->expires))
+		return -1;
+	return ts_gt(&ta->expires, &tb->expires) ? 1 : 0;
+}
+
 static void _insert_timeout(_timeout_t *timeout)
 {
 	futex_assert_is_locked(&fibril_futex);
 	assert(timeout);
 
-	link_t *tmp = timeout_list.head.next;
-	while (tmp != &timeout_list.head) {
-		_timeout_t *cur = list_get_instance(tmp, _timeout_t, link);
-
-		if (ts_gteq(&cur->expires, &timeout->expires))
-			break;
-
-		tmp = tmp->next;
-	}
-
-	list_insert_before(&timeout->link, tmp);
+	pheap_insert(&timeout_heap, &timeout->link);
 }
 
 /**
@@ -630,10 +1050,11 @@ errno_t fibril_wait_timeout(fibril_event_t *event,
 
 	DPRINTF("### Fibril %p sleeping on event %p.\n", fibril_self(), event);
 
-	if (!fibril_self()->thread_ctx) {
-		fibril_self()->thread_ctx =
-		    fibril_create_generic(_helper_fibril_fn, NULL, PAGE_SIZE);
-		if (!fibril_self()->thread_ctx)
+	fibril_t *srcf = fibril_self();
+
+	if (!srcf->thread_ctx) {
+		srcf->thread_ctx = _helper_create();
+		if (!srcf->thread_ctx)
 			return ENOMEM;
 	}
 
@@ -648,35 +1069,6 @@ errno_t fibril_wait_timeout(fibril_event_t *event,
 
 	assert(event->fibril == _EVENT_INITIAL);
 
-	fibril_t *srcf = fibril_self();
-	fibril_t *dstf = NULL;
-
-	/*
-	 * We cannot block here waiting for another fibril becoming
-	 * ready, since that would require unlocking the fibril_futex,
-	 * and that in turn would allow another thread to restore
-	 * the source fibril before this thread finished switching.
-	 *
-	 * Instead, we switch to an internal "helper" fibril whose only
-	 * job is to wait for an event, freeing the source fibril for
-	 * wakeups. There is always one for each running thread.
-	 */
-
-	dstf = _ready_list_pop_nonblocking(true);
-	if (!dstf) {
-		// XXX: It is possible for the _ready_list_pop_nonblocking() to
-		//      check for IPC, find a pending message, and trigger the
-		//      event on which we are currently trying to sleep.
-		if (event->fibril == _EVENT_TRIGGERED) {
-			event->fibril = _EVENT_INITIAL;
-			futex_unlock(&fibril_futex);
-			return EOK;
-		}
-
-		dstf = srcf->thread_ctx;
-		assert(dstf);
-	}
-
 	_timeout_t timeout = { 0 };
 	if (expires) {
 		timeout.expires = *expires;
@@ -684,25 +1076,49 @@ errno_t fibril_wait_timeout(fibril_event_t *event,
 		_insert_timeout(&timeout);
 	}
 
-	assert(srcf);
-
+	/*
+	 * As soon as fibril_futex is released, we can be woken up. Until our
+	 * context is saved, the wakeup is only recorded and we are queued
+	 * when the switch is finished.
+	 */
+	atomic_store(&srcf->switching, SWITCH_STATE_SAVING);
 	event->fibril = srcf;
 	srcf->sleep_event = event;
 
-	assert(event->fibril != _EVENT_INITIAL);
+	futex_unlock(&fibril_futex);
 
-	_fibril_switch_to(SWITCH_FROM_BLOCKED, dstf, true);
+	/*
+	 * We cannot block here waiting for another fibril becoming ready,
+	 * since that would leave this fibril half switched out.
+	 *
+	 * Instead, we switch to an internal "helper" fibril whose only
+	 * job is to wait for an event, freeing the source fibril for
+	 * wakeups. There is always one for each running thread.
+	 */
+
+	fibril_t *dstf = _ready_pop_nonblocking(srcf->thread_ctx->runner);
+	int woken = SWITCH_STATE_WOKEN;
+	if (!dstf && atomic_compare_exchange_strong(&srcf->switching, &woken,
+	    SWITCH_STATE_NONE)) {
+		/* We were woken up before we even got to switch away. */
+	} else {
+		if (!dstf)
+			dstf = srcf->thread_ctx;
+		_fibril_switch_to(SWITCH_FROM_BLOCKED, dstf);
+	}
+
+	futex_lock(&fibril_futex);
 
 	assert(event->fibril != srcf);
 	assert(event->fibril != _EVENT_INITIAL);
 	assert(event->fibril == _EVENT_TIMED_OUT || event->fibril == _EVENT_TRIGGERED);
 
-	list_remove(&timeout.link);
+	if (phlink_used(&timeout.link))
+		pheap_remove(&timeout_heap, &timeout.link);
 	errno_t rc = (event->fibril == _EVENT_TIMED_OUT) ? ETIMEOUT : EOK;
 	event->fibril = _EVENT_INITIAL;
 
 	futex_unlock(&fibril_futex);
-	_fibril_cleanup_dead();
 	return rc;
 }
 
@@ -722,8 +1138,10 @@ void fibril_wait_for(fibril_event_t *event)
 void fibril_notify(fibril_event_t *event)
 {
 	futex_lock(&fibril_futex);
-	_ready_list_push(_fibril_trigger_internal(event, _EVENT_TRIGGERED));
+	fibril_t *f = _fibril_trigger_internal(event, _EVENT_TRIGGERED);
 	futex_unlock(&fibril_futex);
+
+	_ready_push(f);
 }
 
 /** Start a fibril that has not been running yet. */
@@ -736,9 +1154,9 @@ void fibril_start(fibril_t *fibril)
 	if (!link_in_use(&fibril->all_link))
 		list_append(&fibril->all_link, &fibril_list);
 
-	_ready_list_push(fibril);
-
 	futex_unlock(&fibril_futex);
+
+	_ready_push(fibril);
 }
 
 /** Start a fibril that has not been running yet. (obsolete) */
@@ -775,13 +1193,17 @@ void fibril_yield(void)
 	if (fibril_self()->rmutex_locks > 0)
 		return;
 
-	fibril_t *f = _ready_list_pop_nonblocking(false);
+	fibril_t *f = _ready_pop_nonblocking(_runner_self());
 	if (f)
-		_fibril_switch_to(SWITCH_FROM_YIELD, f, false);
+		_fibril_switch_to(SWITCH_FROM_YIELD, f);
 }
 
 static errno_t _runner_fn(void *arg)
 {
+	fibril_self()->runner = _runner_create();
+	if (!fibril_self()->runner)
+		return ENOMEM;
+
 	_helper_fibril_fn(arg);
 	return EOK;
 }
@@ -798,12 +1220,7 @@ int fibril_test_spawn_runners(int n)
 {
 	assert(fibril_self()->rmutex_locks == 0);
 
-	if (!multithreaded) {
-		_ready_debug_check();
-		if (futex_initialize(&ready_semaphore, ready_st_count) != EOK)
-			abort();
-		multithreaded = true;
-	}
+	multithreaded = true;
 
 	errno_t rc;
 
@@ -854,20 +1271,63 @@ _Noreturn void fibril_exit(long retval)
 	// TODO: implement fibril_join() and remember retval
 	(void) retval;
 
-	fibril_t *f = _ready_list_pop_nonblocking(false);
+	/* Hand the blocks cached by this fibril back to the heap. */
+	__malloc_fibril_fini();
+
+	fibril_t *f = _ready_pop_nonblocking(_runner_self());
 	if (!f)
 		f = fibril_self()->thread_ctx;
 
-	_fibril_switch_to(SWITCH_FROM_DEAD, f, false);
+	_fibril_switch_to(SWITCH_FROM_DEAD, f);
 	__builtin_unreachable();
 }
 
+/**
+ * Retire the runner of the calling thread, which is about to exit.
+ *
+ * Fibrils queued on the runner are handed over to another one.
+ */
+void __fibril_thread_fini(void)
+{
+	fibril_t *helper = fibril_self()->thread_ctx;
+	if (!helper)
+		return;
+
+	fibril_runner_t *r = helper->runner;
+
+	/*
+	 * Once the runner is marked dead under its lock, _ready_push() no
+	 * longer queues fibrils on it.
+	 */
+	list_t orphans;
+	list_initialize(&orphans);
+
+	futex_lock(&r->lock);
+	atomic_store(&r->state, RUNNER_DEAD);
+	list_concat(&orphans, &r->ready);
+	atomic_store_explicit(&r->ready_count, 0, memory_order_relaxed);
+	futex_unlock(&r->lock);
+
+	fibril_t *f;
+	while ((f = list_pop(&orphans, fibril_t, link)) != NULL) {
+		fibril_runner_t *heir = _runner_enqueue(_runner_next(r), f);
+		atomic_thread_fence(memory_order_seq_cst);
+		_runner_kick(heir);
+	}
+}
+
 void __fibrils_init(void)
 {
 	if (futex_initialize(&fibril_futex, 1) != EOK)
 		abort();
 	if (futex_initialize(&ipc_lists_futex, 1) != EOK)
 		abort();
+	if (futex_initialize(&runners_futex, 1) != EOK)
+		abort();
+	if (_runner_initialize(&main_runner) != EOK)
+		abort();
+
+	pheap_initialize(&timeout_heap, _timeout_cmp);
 
 	/*
 	 * We allow a fixed, small amount of parallelism for IPC reads, but
@@ -878,16 +1338,17 @@ void __fibrils_init(void)
 #define IPC_BUFFER_COUNT 1024
 	static _ipc_buffer_t buffers[IPC_BUFFER_COUNT];
 
-	for (int i = 0; i < IPC_BUFFER_COUNT; i++) {
+	for (int i = 0; i < IPC_BUFFER_COUNT; i++)
 		list_append(&buffers[i].link, &ipc_buffer_free_list);
-		_ready_up();
-	}
 }
 
 void __fibrils_fini(void)
 {
 	futex_destroy(&fibril_futex);
 	futex_destroy(&ipc_lists_futex);
+	futex_destroy(&runners_futex);
+	futex_destroy(&main_runner.lock);
+	futex_destroy(&main_runner.park);
 }
 
 void fibril_usleep(usec_t timeout)
@@ -44,6 +44,9 @@
 #define DPRINTF(...) dummy_printf(__VA_ARGS__)
 
 /** Initialize futex counter.
+ *
+ * The kernel finds the futex by its address when somebody needs to sleep
+ * on it, so no kernel resources are allocated here.
  *
  * @param futex Futex.
  * @param val   Initialization value.
@@ -54,7 +57,7 @@ errno_t futex_initialize(futex_t *futex, int val)
 {
 	atomic_store_explicit(&futex->val, val, memory_order_relaxed);
 	futex->whandle = CAP_NIL;
-	return futex_allocate_waitq(futex);
+	return EOK;
 }
 
 #ifdef CONFIG_DEBUG_FUTEX
@@ -91,7 +94,7 @@ void __futex_lock(futex_t *futex, const char *name)
 	fibril_t *self = (fibril_t *) fibril_get_id();
 	DPRINTF("Locking futex %s (%p) by fibril %p.\n", name, futex, self);
 	__futex_assert_is_not_locked(futex, name);
-	futex_down(futex);
+	futex_down_nofail(futex);
 
 	void *prev_owner = atomic_load_explicit(&futex->owner,
 	    memory_order_relaxed);
@@ -105,7 +108,7 @@ void __futex_unlock(futex_t *futex, const char *name)
 	DPRINTF("Unlocking futex %s (%p) by fibril %p.\n", name, futex, self);
 	__futex_assert_is_locked(futex, name);
 	atomic_store_explicit(&futex->owner, NULL, memory_order_relaxed);
-	futex_up(futex);
+	futex_up_nofail(futex);
 }
 
 bool __futex_trylock(futex_t *futex, const char *name)
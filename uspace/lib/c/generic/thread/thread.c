@@ -45,6 +45,7 @@
 
 #include "../private/thread.h"
 #include "../private/fibril.h"
+#include "../private/malloc.h"
 
 /** Main thread function.
  *
@@ -72,6 +73,8 @@ static void __thread_main(void *arg)
 	 * free(uarg);
 	 */
 
+	__fibril_thread_fini();
+	__malloc_fibril_fini();
 	fibril_teardown(fibril);
 	thread_exit(0);
 }
@@ -126,6 +126,9 @@ extern aid_t async_send_4(async_exch_t *, sysarg_t, sysarg_t, sysarg_t,
 extern aid_t async_send_5(async_exch_t *, sysarg_t, sysarg_t, sysarg_t,
     sysarg_t, sysarg_t, sysarg_t, ipc_call_t *);
 
+extern void async_send_batch(async_exch_t *, size_t, const ipc_call_t *,
+    ipc_call_t *, aid_t *);
+
 extern void async_wait_for(aid_t, errno_t *);
 extern errno_t async_wait_timeout(aid_t, errno_t *, usec_t);
 extern void async_forget(aid_t);
@@ -0,0 +1,91 @@
+/*
+ * Copyright (c) 2026 The HelenOS Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup libc
+ * @{
+ */
+/** @file Shared-memory ring channels
+ */
+
+#ifndef _LIBC_ASYNC_RING_H_
+#define _LIBC_ASYNC_RING_H_
+
+#include <async.h>
+#include <errno.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/** Number of message arguments carried by a ring message */
+#define ASYNC_RING_ARGS  5
+
+/** Ring message slot
+ *
+ * The same layout is used for requests in the submission queue and for
+ * answers in the completion queue. The slot lives in memory shared with
+ * the peer, which can modify it at any time. The receiving side must copy
+ * any field it needs to validate before using it.
+ */
+typedef struct {
+	/** Client-assigned tag, copied into the answer */
+	sysarg_t tag;
+
+	/** Request method or answer return value */
+	sysarg_t method;
+
+	/** Message arguments */
+	sysarg_t args[ASYNC_RING_ARGS];
+
+	/** Number of valid bytes in @c data */
+	size_t size;
+
+	/** Inline payload, as large as requested when creating the ring */
+	uint8_t data[];
+} async_ring_msg_t;
+
+typedef struct async_ring async_ring_t;
+
+extern errno_t async_ring_create(async_sess_t *, sysarg_t, size_t, size_t,
+    async_ring_t **);
+extern async_ring_msg_t *async_ring_send_msg(async_ring_t *);
+extern void async_ring_send(async_ring_t *);
+extern errno_t async_ring_wait(async_ring_t *, async_ring_msg_t **);
+extern void async_ring_release(async_ring_t *);
+
+extern errno_t async_ring_accept(ipc_call_t *, async_ring_t **);
+extern errno_t async_ring_receive(async_ring_t *, async_ring_msg_t **,
+    ipc_call_t *);
+extern async_ring_msg_t *async_ring_answer_msg(async_ring_t *);
+extern void async_ring_answer(async_ring_t *, errno_t);
+
+extern size_t async_ring_data_size(async_ring_t *);
+extern void async_ring_destroy(async_ring_t *);
+
+#endif
+
+/** @}
+ */
@@ -0,0 +1,180 @@
+/*
+ * Copyright (c) 2026 The HelenOS Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+#include <adt/pheap.h>
+#include <pcut/pcut.h>
+#include <stdlib.h>
+
+/** Test entry */
+typedef struct {
+	phlink_t pheap;
+	int key;
+} test_entry_t;
+
+enum {
+	/** Number of entries in the stress test */
+	test_stress_len = 100000
+};
+
+/** Test compare function.
+ *
+ * @param a First entry
+ * @param b Second entry
+ * @return <0, 0, >0 if key of @a a is less than, equal or greater than
+ *         key of @a b
+ */
+static int test_cmp(phlink_t *a, phlink_t *b)
+{
+	int ka = pheap_get_instance(a, test_entry_t, pheap)->key;
+	int kb = pheap_get_instance(b, test_entry_t, pheap)->key;
+
+	return ka - kb;
+}
+
+/** Pop all entries and check they come out in non-decreasing order.
+ *
+ * @param pheap Pairing heap
+ * @return Number of entries popped or -1 if the order was wrong
+ */
+static long test_drain(pheap_t *pheap)
+{
+	long count = 0;
+	int last = 0;
+	phlink_t *cur;
+
+	while ((cur = pheap_pop(pheap)) != NULL) {
+		int key = pheap_get_instance(cur, test_entry_t, pheap)->key;
+		if (count > 0 && key < last)
+			return -1;
+		if (phlink_used(cur))
+			return -1;
+		last = key;
+		count++;
+	}
+
+	return count;
+}
+
+PCUT_INIT;
+
+PCUT_TEST_SUITE(pheap);
+
+/** Empty heap test. */
+PCUT_TEST(empty)
+{
+	pheap_t pheap;
+
+	pheap_initialize(&pheap, test_cmp);
+	PCUT_ASSERT_TRUE(pheap_empty(&pheap));
+	PCUT_ASSERT_INT_EQUALS(0, pheap_count(&pheap));
+	PCUT_ASSERT_NULL(pheap_first(&pheap));
+	PCUT_ASSERT_NULL(pheap_pop(&pheap));
+}
+
+/** Entries inserted in decreasing order come out in increasing order. */
+PCUT_TEST(decr_seq)
+{
+	pheap_t pheap;
+	test_entry_t e[100];
+
+	pheap_initialize(&pheap, test_cmp);
+
+	for (int i = 0; i < 100; i++) {
+		phlink_initialize(&e[i].pheap);
+		PCUT_ASSERT_FALSE(phlink_used(&e[i].pheap));
+		e[i].key = 100 - i;
+		pheap_insert(&pheap, &e[i].pheap);
+		PCUT_ASSERT_TRUE(phlink_used(&e[i].pheap));
+		PCUT_ASSERT_EQUALS(&e[i].pheap, pheap_first(&pheap));
+	}
+
+	PCUT_ASSERT_INT_EQUALS(100, pheap_count(&pheap));
+	PCUT_ASSERT_INT_EQUALS(100, test_drain(&pheap));
+	PCUT_ASSERT_TRUE(pheap_empty(&pheap));
+}
+
+/** Removing arbitrary entries keeps the heap order. */
+PCUT_TEST(remove)
+{
+	pheap_t pheap;
+	test_entry_t e[100];
+
+	pheap_initialize(&pheap, test_cmp);
+
+	for (int i = 0; i < 100; i++) {
+		phlink_initialize(&e[i].pheap);
+		e[i].key = (i * 37) % 100;
+		pheap_insert(&pheap, &e[i].pheap);
+	}
+
+	/* Force some structure into the heap */
+	(void) pheap_pop(&pheap);
+
+	for (int i = 1; i < 100; i += 2) {
+		if (phlink_used(&e[i].pheap)) {
+			pheap_remove(&pheap, &e[i].pheap);
+			PCUT_ASSERT_FALSE(phlink_used(&e[i].pheap));
+		}
+	}
+
+	PCUT_ASSERT_INT_EQUALS(pheap_count(&pheap), test_drain(&pheap));
+}
+
+/** Insert and cancel many entries, as a timer would. */
+PCUT_TEST(stress)
+{
+	pheap_t pheap;
+	test_entry_t *e;
+	unsigned seed = 42;
+
+	e = calloc(test_stress_len, sizeof(test_entry_t));
+	PCUT_ASSERT_NOT_NULL(e);
+
+	pheap_initialize(&pheap, test_cmp);
+
+	for (int i = 0; i < test_stress_len; i++) {
+		seed = seed * 1103515245 + 12345;
+		phlink_initialize(&e[i].pheap);
+		e[i].key = (seed >> 8) % 1000000;
+		pheap_insert(&pheap, &e[i].pheap);
+	}
+
+	/* Cancel two thirds in a scattered order */
+	for (long i = 0; i < test_stress_len; i++) {
+		long j = (i * 7919) % test_stress_len;
+		if (j % 3 != 0)
+			pheap_remove(&pheap, &e[j].pheap);
+	}
+
+	PCUT_ASSERT_INT_EQUALS((test_stress_len + 2) / 3,
+	    pheap_count(&pheap));
+	PCUT_ASSERT_INT_EQUALS((test_stress_len + 2) / 3, test_drain(&pheap));
+
+	free(e);
+}
+
+PCUT_EXPORT(pheap);
@@ -0,0 +1,832 @@
+/*
+ * Copyright (c) 2026 The HelenOS Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef LIBCPP_BITS_ADT_FLAT_HASH_TABLE
+#define LIBCPP_BITS_ADT_FLAT_HASH_TABLE
+
+#include <__bits/adt/flat_hash_table_iterators.hpp>
+#include <__bits/adt/hash_table_policies.hpp>
+#include <__bits/adt/key_extractors.hpp>
+#include <__bits/builtins.hpp>
+#include <cstdint>
+#include <cstdlib>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <new>
+#include <utility>
+
+namespace std::aux
+{
+    /**
+     * A group of control bytes that is probed at once.
+     * The bytes are packed into a single 64bit word and
+     * matched using bit tricks (SWAR), which works on all
+     * of our architectures. The layout of the control bytes
+     * is the same as the one used by SSE2 based tables, so
+     * a vectorized group can be dropped in later.
+     */
+    struct flat_hash_group
+    {
+        using mask_type = uint64_t;
+
+        static constexpr size_t width{8};
+
+        static constexpr mask_type lsbs{0x0101010101010101ULL};
+        static constexpr mask_type msbs{0x8080808080808080ULL};
+
+        explicit flat_hash_group(const flat_ctrl_t* pos) noexcept
+            : ctrl{}
+        {
+            /**
+             * Note: The masks below expect byte i of the group
+             *       in bits [8i, 8i + 7], so we have to swap
+             *       the bytes on big endian machines.
+             */
+            __builtin_memcpy(&ctrl, pos, width);
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+            ctrl = __builtin_bswap64(ctrl);
+#endif
+        }
+
+        /**
+         * Returns a mask with the highest bit of each byte set
+         * if that byte is equal to h2. This can report a false
+         * positive (but never for a non-full slot), so the caller
+         * always has to compare keys afterwards.
+         */
+        mask_type match(flat_ctrl_t h2) const noexcept
+        {
+            auto x = ctrl ^ (lsbs * static_cast<uint8_t>(h2));
+
+            return (x - lsbs) & ~x & msbs;
+        }
+
+        mask_type match_empty() const noexcept
+        {
+            return (ctrl & (~ctrl << 6)) & msbs;
+        }
+
+        mask_type match_empty_or_deleted() const noexcept
+        {
+            return (ctrl & (~ctrl << 7)) & msbs;
+        }
+
+        static size_t lowest(mask_type mask) noexcept
+        {
+            return static_cast<size_t>(count_trailing_zeros(mask)) >> 3;
+        }
+
+        static mask_type next(mask_type mask) noexcept
+        {
+            return mask & (mask - 1);
+        }
+
+        mask_type ctrl;
+    };
+
+    /**
+     * Open addressing alternative to the chained hash_table.
+     * Elements are stored inline in a single array of slots
+     * accompanied by an array of control bytes (see above),
+     * so a lookup touches one cache line of control bytes and
+     * (usually) one slot, and an insert only allocates when
+     * the table has to grow.
+     *
+     * The capacity is always of the form 2^n - 1 so that it can
+     * be used as a mask for the probe sequence. The control array
+     * has capacity + 1 + (group width - 1) bytes: the byte at index
+     * capacity is a sentinel that terminates iteration and the rest
+     * mirrors the first bytes of the table so that a group can
+     * be loaded from any position without wrapping.
+     *
+     * Note: Equivalent keys could not be kept adjacent in an open
+     *       addressing table without shifting elements around, which
+     *       is why this table only backs unique key containers.
+     */
+
+    template<
+        class Value, class Key, class KeyExtractor,
+        class Hasher, class KeyEq,
+        class Alloc, class Size,
+        class Iterator, class ConstIterator,
+        class LocalIterator, class ConstLocalIterator,
+        class Policy
+    >
+    class flat_hash_table
+    {
+        using group_type = flat_hash_group;
+
+        public:
+            using value_type     = Value;
+            using key_type       = Key;
+            using size_type      = Size;
+            using allocator_type = Alloc;
+            using key_equal      = KeyEq;
+            using hasher         = Hasher;
+            using key_extract    = KeyExtractor;
+
+            using iterator             = Iterator;
+            using const_iterator       = ConstIterator;
+            using local_iterator       = LocalIterator;
+            using const_local_iterator = ConstLocalIterator;
+
+            flat_hash_table(size_type buckets, float max_load_factor = 1.f)
+                : ctrl_{}, slots_{}, capacity_{}, size_{}, growth_left_{},
+                  initial_capacity_{normalize_capacity_(buckets)},
+                  hasher_{}, key_eq_{}, key_extractor_{},
+                  max_load_factor_{max_load_factor}
+            { /* DUMMY BODY */ }
+
+            flat_hash_table(size_type buckets, const hasher& hf, const key_equal& eql,
+                            float max_load_factor = 1.f)
+                : ctrl_{}, slots_{}, capacity_{}, size_{}, growth_left_{},
+                  initial_capacity_{normalize_capacity_(buckets)},
+                  hasher_{hf}, key_eq_{eql}, key_extractor_{},
+                  max_load_factor_{max_load_factor}
+            { /* DUMMY BODY */ }
+
+            flat_hash_table(const flat_hash_table& other)
+                : flat_hash_table{other.bucket_count(), other.hasher_, other.key_eq_,
+                                  other.max_load_factor_}
+            {
+                reserve(other.size_);
+
+                for (const auto& x: other)
+                    insert(x);
+            }
+
+            flat_hash_table(flat_hash_table&& other)
+                : ctrl_{other.ctrl_}, slots_{other.slots_},
+                  capacity_{other.capacity_}, size_{other.size_},
+                  growth_left_{other.growth_left_},
+                  initial_capacity_{other.initial_capacity_},
+                  hasher_{move(other.hasher_)}, key_eq_{move(other.key_eq_)},
+                  key_extractor_{move(other.key_extractor_)},
+                  max_load_factor_{other.max_load_factor_}
+            {
+                other.ctrl_ = nullptr;
+                other.slots_ = nullptr;
+                other.capacity_ = size_type{};
+                other.size_ = size_type{};
+                other.growth_left_ = size_type{};
+                other.max_load_factor_ = 1.f;
+            }
+
+            flat_hash_table& operator=(const flat_hash_table& other)
+            {
+                flat_hash_table tmp{other};
+                tmp.swap(*this);
+
+                return *this;
+            }
+
+            flat_hash_table& operator=(flat_hash_table&& other)
+            {
+                flat_hash_table tmp{move(other)};
+                tmp.swap(*this);
+
+                return *this;
+            }
+
+            bool empty() const noexcept
+            {
+                return size_ == 0;
+            }
+
+            size_type size() const noexcept
+            {
+                return size_;
+            }
+
+            size_type max_size(allocator_type& alloc)
+            {
+                return allocator_traits<allocator_type>::max_size(alloc);
+            }
+
+            iterator begin() noexcept
+            {
+                if (size_ == 0)
+                    return end();
+
+                iterator it{ctrl_, slots_};
+                it.skip_empty_slots();
+
+                return it;
+            }
+
+            const_iterator begin() const noexcept
+            {
+                return cbegin();
+            }
+
+            iterator end() noexcept
+            {
+                return iterator{};
+            }
+
+            const_iterator end() const noexcept
+            {
+                return cend();
+            }
+
+            const_iterator cbegin() const noexcept
+            {
+                if (size_ == 0)
+                    return cend();
+
+                const_iterator it{ctrl_, slots_};
+                it.skip_empty_slots();
+
+                return it;
+            }
+
+            const_iterator cend() const noexcept
+            {
+                return const_iterator{};
+            }
+
+            template<class... Args>
+            auto emplace(Args&&... args)
+            {
+                return Policy::emplace(*this, forward<Args>(args)...);
+            }
+
+            auto insert(const value_type& val)
+            {
+                return Policy::insert(*this, val);
+            }
+
+            auto insert(value_type&& val)
+            {
+                return Policy::insert(*this, forward<value_type>(val));
+            }
+
+            template<class K, class... Args>
+            auto try_emplace(K&& key, Args&&... args)
+            {
+                return Policy::try_emplace(
+                    *this, forward<K>(key), forward<Args>(args)...
+                );
+            }
+
+            size_type erase(const key_type& key)
+            {
+                return Policy::erase(*this, key);
+            }
+
+            iterator erase(const_iterator it)
+            {
+                if (it == cend())
+                    return end();
+
+                auto idx = static_cast<size_type>(it.slot() - slots_);
+                erase_at_(idx);
+
+                /**
+                 * Note: The erased slot is no longer full, so
+                 *       skipping from it moves us to the next element.
+                 */
+                iterator res{ctrl_ + idx, slots_ + idx};
+                res.skip_empty_slots();
+
+                return res;
+            }
+
+            iterator erase(const_iterator first, const_iterator last)
+            {
+                while (first != last)
+                    first = erase(first);
+
+                return iterator{
+                    first.ctrl(), const_cast<value_type*>(first.slot())
+                };
+            }
+
+            void clear() noexcept
+            {
+                if (!ctrl_)
+                    return;
+
+                destroy_slots_();
+                reset_ctrl_();
+
+                size_ = size_type{};
+                growth_left_ = growth_limit_(capacity_);
+            }
+
+            void swap(flat_hash_table& other)
+                noexcept(allocator_traits<allocator_type>::is_always_equal::value &&
+                         noexcept(std::swap(declval<Hasher&>(), declval<Hasher&>())) &&
+                         noexcept(std::swap(declval<KeyEq&>(), declval<KeyEq&>())))
+            {
+                std::swap(ctrl_, other.ctrl_);
+                std::swap(slots_, other.slots_);
+                std::swap(capacity_, other.capacity_);
+                std::swap(size_, other.size_);
+                std::swap(growth_left_, other.growth_left_);
+                std::swap(initial_capacity_, other.initial_capacity_);
+                std::swap(hasher_, other.hasher_);
+                std::swap(key_eq_, other.key_eq_);
+                std::swap(max_load_factor_, other.max_load_factor_);
+            }
+
+            hasher hash_function() const
+            {
+                return hasher_;
+            }
+
+            key_equal key_eq() const
+            {
+                return key_eq_;
+            }
+
+            iterator find(const key_type& key)
+            {
+                auto idx = find_idx_(key, hash_(key));
+                if (idx == npos_)
+                    return end();
+
+                return iterator{ctrl_ + idx, slots_ + idx};
+            }
+
+            const_iterator find(const key_type& key) const
+            {
+                auto idx = find_idx_(key, hash_(key));
+                if (idx == npos_)
+                    return cend();
+
+                return const_iterator{ctrl_ + idx, slots_ + idx};
+            }
+
+            size_type count(const key_type& key) const
+            {
+                return Policy::count(*this, key);
+            }
+
+            pair<iterator, iterator> equal_range(const key_type& key)
+            {
+                return Policy::equal_range(*this, key);
+            }
+
+            pair<const_iterator, const_iterator> equal_range(const key_type& key) const
+            {
+                return Policy::equal_range_const(*this, key);
+            }
+
+            size_type bucket_count() const noexcept
+            {
+                return capacity_ ? capacity_ : initial_capacity_;
+            }
+
+            size_type max_bucket_count() const noexcept
+            {
+                return std::numeric_limits<size_type>::max() /
+                       (sizeof(value_type) + sizeof(flat_ctrl_t));
+            }
+
+            size_type bucket_size(size_type n) const
+            {
+                if (n < capacity_ && flat_ctrl_is_full(ctrl_[n]))
+                    return 1;
+                else
+                    return 0;
+            }
+
+            size_type bucket(const key_type& key) const
+            {
+                auto hash = hash_(key);
+                auto idx = find_idx_(key, hash);
+
+                if (idx != npos_)
+                    return idx;
+                else
+                    return h1_(hash) & bucket_count();
+            }
+
+            local_iterator begin(size_type n)
+            {
+                return n < capacity_ ? slots_ + n : nullptr;
+            }
+
+            const_local_iterator begin(size_type n) const
+            {
+                return cbegin(n);
+            }
+
+            local_iterator end(size_type n)
+            {
+                return begin(n) + bucket_size(n);
+            }
+
+            const_local_iterator end(size_type n) const
+            {
+                return cend(n);
+            }
+
+            const_local_iterator cbegin(size_type n) const
+            {
+                return n < capacity_ ? slots_ + n : nullptr;
+            }
+
+            const_local_iterator cend(size_type n) const
+            {
+                return cbegin(n) + bucket_size(n);
+            }
+
+            float load_factor() const noexcept
+            {
+                return size_ / static_cast<float>(bucket_count());
+            }
+
+            float max_load_factor() const noexcept
+            {
+                return max_load_factor_;
+            }
+
+            void max_load_factor(float factor)
+            {
+                if (factor > 0.f)
+                    max_load_factor_ = factor;
+
+                if (capacity_)
+                {
+                    auto limit = growth_limit_(capacity_);
+                    if (size_ > limit)
+                        rehash(size_type{});
+                    else
+                        growth_left_ = limit - size_;
+                }
+            }
+
+            void rehash(size_type count)
+            {
+                auto cap = normalize_capacity_(count);
+                while (growth_limit_(cap) < size_)
+                    cap = cap * 2 + 1;
+
+                if (capacity_ == 0)
+                {
+                    /**
+                     * Note: Nothing is allocated yet, just
+                     *       remember the requested capacity.
+                     */
+                    initial_capacity_ = cap;
+                    return;
+                }
+
+                if (cap != capacity_)
+                    resize_(cap);
+            }
+
+            void reserve(size_type count)
+            {
+                auto cap = normalize_capacity_(count);
+                while (growth_limit_(cap) < count)
+                    cap = cap * 2 + 1;
+
+                if (cap > bucket_count())
+                    rehash(cap);
+            }
+
+            bool is_eq_to(const flat_hash_table& other) const
+            {
+                if (size() != other.size())
+                    return false;
+
+                for (const auto& x: *this)
+                {
+                    auto it = other.find(key_extractor_(x));
+                    if (it == other.end() || !(*it == x))
+                        return false;
+                }
+
+                return true;
+            }
+
+            ~flat_hash_table()
+            {
+                if (ctrl_)
+                {
+                    destroy_slots_();
+                    deallocate_(ctrl_, capacity_);
+                }
+            }
+
+            const key_type& get_key(const value_type& val) const
+            {
+                return key_extractor_(val);
+            }
+
+            bool keys_equal(const key_type& key, const value_type& val) const
+            {
+                return key_eq_(key, key_extractor_(val));
+            }
+
+        private:
+            flat_ctrl_t* ctrl_;
+            value_type* slots_;
+            size_type capacity_;
+            size_type size_;
+            size_type growth_left_;
+            size_type initial_capacity_;
+            hasher hasher_;
+            key_equal key_eq_;
+            key_extract key_extractor_;
+            float max_load_factor_;
+
+            static constexpr size_type npos_{std::numeric_limits<size_type>::max()};
+            static constexpr size_type cloned_bytes_{group_type::width - 1};
+            static constexpr size_type min_capacity_{group_type::width - 1};
+            static constexpr size_t hash_multiplier_{
+                sizeof(size_t) == 8 ? static_cast<size_t>(0x9E3779B97F4A7C15ULL)
+                                    : static_cast<size_t>(0x9E3779B9UL)
+            };
+
+            static size_type normalize_capacity_(size_type n)
+            {
+                size_type cap{min_capacity_};
+                while (cap < n)
+                    cap = cap * 2 + 1;
+
+                return cap;
+            }
+
+            /**
+             * Note: We never let the table get more than 7/8 full
+             *       (with the smallest table being a special case
+             *       that needs at least one empty slot in its only
+             *       group), so probing always terminates.
+             */
+            size_type growth_limit_(size_type cap) const
+            {
+                size_type limit = cap == min_capacity_ ? cap - 1 : cap - cap / 8;
+                auto requested = static_cast<size_type>(cap * max_load_factor_);
+
+                if (requested < limit)
+                    limit = requested;
+
+                return limit > 0 ? limit : 1;
+            }
+
+            /**
+             * Note: Some hashers (including our std::hash for integers)
+             *       are just identity, so we mix the bits before splitting
+             *       them into the probe start (h1) and the control byte (h2).
+             */
+            size_t hash_(const key_type& key) const
+            {
+                size_t hash = hasher_(key) * hash_multiplier_;
+
+                return hash ^ (hash >> (sizeof(size_t) * 4));
+            }
+
+            static size_type h1_(size_t hash)
+            {
+                return static_cast<size_type>(hash >> 7);
+            }
+
+            static flat_ctrl_t h2_(size_t hash)
+            {
+                return static_cast<flat_ctrl_t>(hash & 0x7F);
+            }
+
+            void set_ctrl_(size_type idx, flat_ctrl_t val)
+            {
+                ctrl_[idx] = val;
+                ctrl_[((idx - cloned_bytes_) & capacity_) + (cloned_bytes_ & capacity_)] = val;
+            }
+
+            size_type find_idx_(const key_type& key, size_t hash) const
+            {
+                if (size_ == 0)
+                    return npos_;
+
+                auto h2 = h2_(hash);
+                auto pos = h1_(hash) & capacity_;
+                size_type step{};
+
+                while (true)
+                {
+                    group_type group{ctrl_ + pos};
+
+                    for (auto mask = group.match(h2); mask; mask = group_type::next(mask))
+                    {
+                        auto idx = (pos + group_type::lowest(mask)) & capacity_;
+                        if (key_eq_(key, key_extractor_(slots_[idx])))
+                            return idx;
+                    }
+
+                    if (group.match_empty())
+                        return npos_;
+
+                    step += group_type::width;
+                    pos = (pos + step) & capacity_;
+                }
+            }
+
+            size_type find_first_non_full_(size_t hash) const
+            {
+                auto pos = h1_(hash) & capacity_;
+                size_type step{};
+
+                while (true)
+                {
+                    group_type group{ctrl_ + pos};
+
+                    auto mask = group.match_empty_or_deleted();
+                    if (mask)
+                        return (pos + group_type::lowest(mask)) & capacity_;
+
+                    step += group_type::width;
+                    pos = (pos + step) & capacity_;
+                }
+            }
+
+            /**
+             * Finds a slot for a new element with the given hash,
+             * growing the table if necessary. The slot is not
+             * marked as full until commit_insert_ is called, so
+             * that a throwing constructor leaves the table intact.
+             */
+            size_type prepare_insert_(size_t hash)
+            {
+                if (capacity_ == 0)
+                    resize_(initial_capacity_);
+                else if (growth_left_ == 0)
+                {
+                    /**
+                     * Note: If most of the used-up growth is taken
+                     *       by tombstones, we just clean them up
+                     *       instead of doubling the table. The limit
+                     *       depends on max_load_factor, so we compare
+                     *       against it to make sure the cleanup leaves
+                     *       some growth for this insertion.
+                     */
+                    if (size_ * 32 <= growth_limit_(capacity_) * 25)
+                        resize_(capacity_);
+                    else
+                    {
+                        auto cap = capacity_ * 2 + 1;
+                        while (growth_limit_(cap) <= size_)
+                            cap = cap * 2 + 1;
+
+                        resize_(cap);
+                    }
+                }
+
+                return find_first_non_full_(hash);
+            }
+
+            void commit_insert_(size_type idx, size_t hash)
+            {
+                if (ctrl_[idx] == flat_ctrl_empty)
+                    --growth_left_;
+
+                set_ctrl_(idx, h2_(hash));
+                ++size_;
+            }
+
+            iterator make_iterator_(size_type idx)
+            {
+                return iterator{ctrl_ + idx, slots_ + idx};
+            }
+
+            template<class... Args>
+            void construct_at_(size_type idx, size_t hash, Args&&... args)
+            {
+                ::new(static_cast<void*>(slots_ + idx)) value_type(forward<Args>(args)...);
+                commit_insert_(idx, hash);
+            }
+
+            void erase_at_(size_type idx)
+            {
+                slots_[idx].~value_type();
+                --size_;
+
+                /**
+                 * If there is no window of group width full slots
+                 * around the erased one, no probe sequence could have
+                 * continued past it and we can mark it as empty
+                 * instead of leaving a tombstone behind.
+                 */
+                size_type before{};
+                while (before < group_type::width &&
+                       ctrl_[(idx - before - 1) & capacity_] != flat_ctrl_empty)
+                    ++before;
+
+                size_type after{1};
+                while (after < group_type::width &&
+                       ctrl_[(idx + after) & capacity_] != flat_ctrl_empty)
+                    ++after;
+
+                if (before + after < group_type::width)
+                {
+                    set_ctrl_(idx, flat_ctrl_empty);
+                    ++growth_left_;
+                }
+                else
+                    set_ctrl_(idx, flat_ctrl_deleted);
+            }
+
+            void destroy_slots_()
+            {
+                for (size_type i = 0; i < capacity_; ++i)
+                {
+                    if (flat_ctrl_is_full(ctrl_[i]))
+                        slots_[i].~value_type();
+                }
+            }
+
+            void reset_ctrl_()
+            {
+                for (size_type i = 0; i < capacity_ + group_type::width; ++i)
+                    ctrl_[i] = flat_ctrl_empty;
+                ctrl_[capacity_] = flat_ctrl_sentinel;
+            }
+
+            /**
+             * Note: Control bytes and slots share a single allocation,
+             *       slots start at the first suitably aligned offset.
+             */
+            static size_type slots_offset_(size_type cap)
+            {
+                constexpr size_type align = alignof(value_type);
+
+                return (cap + group_type::width + align - 1) & ~(align - 1);
+            }
+
+            static flat_ctrl_t* allocate_(size_type cap)
+            {
+                auto bytes = slots_offset_(cap) + cap * sizeof(value_type);
+
+                return static_cast<flat_ctrl_t*>(::operator new(bytes));
+            }
+
+            static void deallocate_(flat_ctrl_t* ctrl, size_type)
+            {
+                ::operator delete(static_cast<void*>(ctrl));
+            }
+
+            void resize_(size_type new_cap)
+            {
+                auto old_ctrl = ctrl_;
+                auto old_slots = slots_;
+                auto old_cap = capacity_;
+
+                ctrl_ = allocate_(new_cap);
+                slots_ = reinterpret_cast<value_type*>(
+                    reinterpret_cast<char*>(ctrl_) + slots_offset_(new_cap)
+                );
+                capacity_ = new_cap;
+                reset_ctrl_();
+
+                for (size_type i = 0; i < old_cap; ++i)
+                {
+                    if (!flat_ctrl_is_full(old_ctrl[i]))
+                        continue;
+
+                    auto hash = hash_(key_extractor_(old_slots[i]));
+                    auto idx = find_first_non_full_(hash);
+
+                    ::new(static_cast<void*>(slots_ + idx)) value_type(move(old_slots[i]));
+                    old_slots[i].~value_type();
+                    set_ctrl_(idx, h2_(hash));
+                }
+
+                growth_left_ = growth_limit_(capacity_) - size_;
+
+                if (old_ctrl)
+                    deallocate_(old_ctrl, old_cap);
+            }
+
+            friend Policy;
+    };
+}
+
+#endif
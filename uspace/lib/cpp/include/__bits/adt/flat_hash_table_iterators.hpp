@@ -0,0 +1,304 @@
+/*
+ * Copyright (c) 2026 The HelenOS Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef LIBCPP_BITS_ADT_FLAT_HASH_TABLE_ITERATORS
+#define LIBCPP_BITS_ADT_FLAT_HASH_TABLE_ITERATORS
+
+#include <__bits/iterator_helpers.hpp>
+#include <cstdint>
+#include <iterator>
+
+namespace std::aux
+{
+    /**
+     * Every slot of the flat hash table has one control byte.
+     * Full slots store the lowest 7 bits of the hash of their
+     * element (so the byte is non-negative), while all other
+     * states have the highest bit set, which allows us to
+     * test a whole group of control bytes at once.
+     */
+    using flat_ctrl_t = int8_t;
+
+    inline constexpr flat_ctrl_t flat_ctrl_empty{-128};
+    inline constexpr flat_ctrl_t flat_ctrl_deleted{-2};
+    inline constexpr flat_ctrl_t flat_ctrl_sentinel{-1};
+
+    inline constexpr bool flat_ctrl_is_full(flat_ctrl_t ctrl) noexcept
+    {
+        return ctrl >= 0;
+    }
+
+    /**
+     * Note: Because the sentinel is the largest non-full value,
+     *       this skips both empty and deleted slots and stops
+     *       either on a full slot or on the sentinel that follows
+     *       the last slot of the table.
+     */
+    inline constexpr bool flat_ctrl_is_empty_or_deleted(flat_ctrl_t ctrl) noexcept
+    {
+        return ctrl < flat_ctrl_sentinel;
+    }
+
+    template<class Value, class Reference, class Pointer, class Size>
+    class flat_hash_table_iterator
+    {
+        public:
+            using value_type      = Value;
+            using size_type       = Size;
+            using reference       = Reference;
+            using pointer         = Pointer;
+            using difference_type = ptrdiff_t;
+
+            using iterator_category = forward_iterator_tag;
+
+            flat_hash_table_iterator(const flat_ctrl_t* ctrl = nullptr,
+                                     value_type* slot = nullptr)
+                : ctrl_{ctrl}, slot_{slot}
+            { /* DUMMY BODY */ }
+
+            flat_hash_table_iterator(const flat_hash_table_iterator&) = default;
+            flat_hash_table_iterator& operator=(const flat_hash_table_iterator&) = default;
+
+            reference operator*() const
+            {
+                return *slot_;
+            }
+
+            pointer operator->() const
+            {
+                return slot_;
+            }
+
+            flat_hash_table_iterator& operator++()
+            {
+                ++ctrl_;
+                ++slot_;
+                skip_empty_slots();
+
+                return *this;
+            }
+
+            flat_hash_table_iterator operator++(int)
+            {
+                auto tmp = *this;
+                ++(*this);
+
+                return tmp;
+            }
+
+            void skip_empty_slots()
+            {
+                while (flat_ctrl_is_empty_or_deleted(*ctrl_))
+                {
+                    ++ctrl_;
+                    ++slot_;
+                }
+
+                if (*ctrl_ == flat_ctrl_sentinel)
+                {
+                    ctrl_ = nullptr;
+                    slot_ = nullptr;
+                }
+            }
+
+            value_type* slot() const
+            {
+                return slot_;
+            }
+
+            const flat_ctrl_t* ctrl() const
+            {
+                return ctrl_;
+            }
+
+        private:
+            const flat_ctrl_t* ctrl_;
+            value_type* slot_;
+    };
+
+    template<class Value, class Ref, class Ptr, class Size>
+    bool operator==(const flat_hash_table_iterator<Value, Ref, Ptr, Size>& lhs,
+                    const flat_hash_table_iterator<Value, Ref, Ptr, Size>& rhs)
+    {
+        return lhs.slot() == rhs.slot();
+    }
+
+    template<class Value, class Ref, class Ptr, class Size>
+    bool operator!=(const flat_hash_table_iterator<Value, Ref, Ptr, Size>& lhs,
+                    const flat_hash_table_iterator<Value, Ref, Ptr, Size>& rhs)
+    {
+        return !(lhs == rhs);
+    }
+
+    template<class Value, class ConstReference, class ConstPointer, class Size>
+    class flat_hash_table_const_iterator
+    {
+        using non_const_iterator_type = flat_hash_table_iterator<
+            Value, get_non_const_ref_t<ConstReference>,
+            get_non_const_ptr_t<ConstPointer>, Size
+        >;
+
+        public:
+            using value_type      = Value;
+            using size_type       = Size;
+            using const_reference = ConstReference;
+            using const_pointer   = ConstPointer;
+            using difference_type = ptrdiff_t;
+
+            using iterator_category = forward_iterator_tag;
+
+            flat_hash_table_const_iterator(const flat_ctrl_t* ctrl = nullptr,
+                                           const value_type* slot = nullptr)
+                : ctrl_{ctrl}, slot_{slot}
+            { /* DUMMY BODY */ }
+
+            flat_hash_table_const_iterator(const flat_hash_table_const_iterator&) = default;
+            flat_hash_table_const_iterator& operator=(const flat_hash_table_const_iterator&) = default;
+
+            flat_hash_table_const_iterator(const non_const_iterator_type& other)
+                : ctrl_{other.ctrl()}, slot_{other.slot()}
+            { /* DUMMY BODY */ }
+
+            flat_hash_table_const_iterator& operator=(const non_const_iterator_type& other)
+            {
+                ctrl_ = other.ctrl();
+                slot_ = other.slot();
+
+                return *this;
+            }
+
+            const_reference operator*() const
+            {
+                return *slot_;
+            }
+
+            const_pointer operator->() const
+            {
+                return slot_;
+            }
+
+            flat_hash_table_const_iterator& operator++()
+            {
+                ++ctrl_;
+                ++slot_;
+                skip_empty_slots();
+
+                return *this;
+            }
+
+            flat_hash_table_const_iterator operator++(int)
+            {
+                auto tmp = *this;
+                ++(*this);
+
+                return tmp;
+            }
+
+            void skip_empty_slots()
+            {
+                while (flat_ctrl_is_empty_or_deleted(*ctrl_))
+                {
+                    ++ctrl_;
+                    ++slot_;
+                }
+
+                if (*ctrl_ == flat_ctrl_sentinel)
+                {
+                    ctrl_ = nullptr;
+                    slot_ = nullptr;
+                }
+            }
+
+            const value_type* slot() const
+            {
+                return slot_;
+            }
+
+            const flat_ctrl_t* ctrl() const
+            {
+                return ctrl_;
+            }
+
+        private:
+            const flat_ctrl_t* ctrl_;
+            const value_type* slot_;
+    };
+
+    template<class Value, class CRef, class CPtr, class Size>
+    bool operator==(const flat_hash_table_const_iterator<Value, CRef, CPtr, Size>& lhs,
+                    const flat_hash_table_const_iterator<Value, CRef, CPtr, Size>& rhs)
+    {
+        return lhs.slot() == rhs.slot();
+    }
+
+    template<class Value, class CRef, class CPtr, class Size>
+    bool operator!=(const flat_hash_table_const_iterator<Value, CRef, CPtr, Size>& lhs,
+                    const flat_hash_table_const_iterator<Value, CRef, CPtr, Size>& rhs)
+    {
+        return !(lhs == rhs);
+    }
+
+    template<class Value, class Ref, class Ptr, class CRef, class CPtr, class Size>
+    bool operator==(const flat_hash_table_iterator<Value, Ref, Ptr, Size>& lhs,
+                    const flat_hash_table_const_iterator<Value, CRef, CPtr, Size>& rhs)
+    {
+        return lhs.slot() == rhs.slot();
+    }
+
+    template<class Value, class Ref, class Ptr, class CRef, class CPtr, class Size>
+    bool operator!=(const flat_hash_table_iterator<Value, Ref, Ptr, Size>& lhs,
+                    const flat_hash_table_const_iterator<Value, CRef, CPtr, Size>& rhs)
+    {
+        return !(lhs == rhs);
+    }
+
+    template<class Value, class CRef, class CPtr, class Ref, class Ptr, class Size>
+    bool operator==(const flat_hash_table_const_iterator<Value, CRef, CPtr, Size>& lhs,
+                    const flat_hash_table_iterator<Value, Ref, Ptr, Size>& rhs)
+    {
+        return lhs.slot() == rhs.slot();
+    }
+
+    template<class Value, class CRef, class CPtr, class Ref, class Ptr, class Size>
+    bool operator!=(const flat_hash_table_const_iterator<Value, CRef, CPtr, Size>& lhs,
+                    const flat_hash_table_iterator<Value, Ref, Ptr, Size>& rhs)
+    {
+        return !(lhs == rhs);
+    }
+
+    /**
+     * Note: In the flat table every slot is its own bucket,
+     *       so a local iterator is just a pointer to the element
+     *       and the local range [begin(n), end(n)) is either
+     *       empty or contains exactly the element in slot n.
+     */
+    template<class Pointer>
+    using flat_hash_table_local_iterator = Pointer;
+}
+
+#endif
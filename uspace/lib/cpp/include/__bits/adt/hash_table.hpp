@@ -204,6 +204,14 @@ namespace std::aux
                 return Policy::insert(*this, forward<value_type>(val));
             }
 
+            template<class K, class... Args>
+            auto try_emplace(K&& key, Args&&... args)
+            {
+                return Policy::try_emplace(
+                    *this, forward<K>(key), forward<Args>(args)...
+                );
+            }
+
             size_type erase(const key_type& key)
             {
                 return Policy::erase(*this, key);
@@ -242,6 +250,16 @@ namespace std::aux
                     return res;
             }
 
+            iterator erase(const_iterator first, const_iterator last)
+            {
+                while (first != last)
+                    first = erase(first);
+
+                return iterator{
+                    table_, first.idx(), bucket_count_, first.node()
+                };
+            }
+
             void clear() noexcept
             {
                 for (size_type i = 0; i < bucket_count_; ++i)
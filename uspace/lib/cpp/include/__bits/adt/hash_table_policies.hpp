@@ -34,7 +34,90 @@
 
 namespace std::aux
 {
-    struct hash_single_policy
+    /**
+     * Besides the algorithms that differ between the single and
+     * multi variants of the unordered containers, a policy also
+     * selects the table (and iterator types) the container is
+     * built upon. The engines themselves are only declared here,
+     * they are defined in their respective headers.
+     */
+
+    template<class Value, class Reference, class Pointer, class Size>
+    class hash_table_iterator;
+
+    template<class Value, class ConstReference, class ConstPointer, class Size>
+    class hash_table_const_iterator;
+
+    template<class Value, class Reference, class Pointer>
+    class hash_table_local_iterator;
+
+    template<class Value, class ConstReference, class ConstPointer>
+    class hash_table_const_local_iterator;
+
+    template<class Value, class Reference, class Pointer, class Size>
+    class flat_hash_table_iterator;
+
+    template<class Value, class ConstReference, class ConstPointer, class Size>
+    class flat_hash_table_const_iterator;
+
+    template<
+        class Value, class Key, class KeyExtractor,
+        class Hasher, class KeyEq,
+        class Alloc, class Size,
+        class Iterator, class ConstIterator,
+        class LocalIterator, class ConstLocalIterator,
+        class Policy
+    >
+    class hash_table;
+
+    template<
+        class Value, class Key, class KeyExtractor,
+        class Hasher, class KeyEq,
+        class Alloc, class Size,
+        class Iterator, class ConstIterator,
+        class LocalIterator, class ConstLocalIterator,
+        class Policy
+    >
+    class flat_hash_table;
+
+    /**
+     * Iterator and table selection shared by the policies
+     * of the chained hash table.
+     */
+    template<class Policy>
+    struct hash_chained_storage
+    {
+        template<class Value, class Reference, class Pointer, class Size>
+        using iterator = hash_table_iterator<Value, Reference, Pointer, Size>;
+
+        template<class Value, class ConstReference, class ConstPointer, class Size>
+        using const_iterator = hash_table_const_iterator<
+            Value, ConstReference, ConstPointer, Size
+        >;
+
+        template<class Value, class Reference, class Pointer>
+        using local_iterator = hash_table_local_iterator<Value, Reference, Pointer>;
+
+        template<class Value, class ConstReference, class ConstPointer>
+        using const_local_iterator = hash_table_const_local_iterator<
+            Value, ConstReference, ConstPointer
+        >;
+
+        template<
+            class Value, class Key, class KeyExtractor,
+            class Hasher, class KeyEq,
+            class Alloc, class Size,
+            class Iterator, class ConstIterator,
+            class LocalIterator, class ConstLocalIterator
+        >
+        using table = hash_table<
+            Value, Key, KeyExtractor, Hasher, KeyEq, Alloc, Size,
+            Iterator, ConstIterator, LocalIterator, ConstLocalIterator,
+            Policy
+        >;
+    };
+
+    struct hash_single_policy: hash_chained_storage<hash_single_policy>
     {
         template<class Table, class Key>
         static typename Table::size_type count(const Table& table, const Key& key)
@@ -262,9 +345,52 @@ namespace std::aux
                 }, true);
             }
         }
+
+        template<class Table, class Key, class... Args>
+        static pair<
+            typename Table::iterator, bool
+        > try_emplace(Table& table, Key&& key, Args&&... args)
+        {
+            using mapped_type = typename Table::value_type::second_type;
+            using node_type   = typename Table::node_type;
+            using iterator    = typename Table::iterator;
+
+            table.increment_size();
+
+            auto [bucket, target, idx] = table.find_insertion_spot(key);
+
+            if (!bucket)
+                return make_pair(table.end(), false);
+
+            if (target && table.keys_equal(key, target->value))
+            {
+                table.decrement_size();
+
+                return make_pair(
+                    iterator{
+                        table.table(), idx, table.bucket_count(),
+                        target
+                    },
+                    false
+                );
+            }
+            else
+            {
+                auto node = new node_type{
+                    forward<Key>(key), mapped_type(forward<Args>(args)...)
+                };
+                bucket->append(node);
+
+                return make_pair(iterator{
+                    table.table(), idx,
+                    table.bucket_count(),
+                    node
+                }, true);
+            }
+        }
     };
 
-    struct hash_multi_policy
+    struct hash_multi_policy: hash_chained_storage<hash_multi_policy>
     {
         template<class Table, class Key>
         static typename Table::size_type count(const Table& table, const Key& key)
@@ -459,6 +585,153 @@ namespace std::aux
             };
         }
     };
+    /**
+     * Policy of the open addressing flat_hash_table, which
+     * only supports unique keys.
+     */
+    struct hash_flat_single_policy
+    {
+        template<class Value, class Reference, class Pointer, class Size>
+        using iterator = flat_hash_table_iterator<Value, Reference, Pointer, Size>;
+
+        template<class Value, class ConstReference, class ConstPointer, class Size>
+        using const_iterator = flat_hash_table_const_iterator<
+            Value, ConstReference, ConstPointer, Size
+        >;
+
+        template<class Value, class Reference, class Pointer>
+        using local_iterator = Pointer;
+
+        template<class Value, class ConstReference, class ConstPointer>
+        using const_local_iterator = ConstPointer;
+
+        template<
+            class Value, class Key, class KeyExtractor,
+            class Hasher, class KeyEq,
+            class Alloc, class Size,
+            class Iterator, class ConstIterator,
+            class LocalIterator, class ConstLocalIterator
+        >
+        using table = flat_hash_table<
+            Value, Key, KeyExtractor, Hasher, KeyEq, Alloc, Size,
+            Iterator, ConstIterator, LocalIterator, ConstLocalIterator,
+            hash_flat_single_policy
+        >;
+
+        template<class Table, class Key>
+        static typename Table::size_type count(const Table& table, const Key& key)
+        {
+            return table.find(key) == table.end() ? 0 : 1;
+        }
+
+        template<class Table, class Key>
+        static typename Table::size_type erase(Table& table, const Key& key)
+        {
+            auto idx = table.find_idx_(key, table.hash_(key));
+            if (idx == Table::npos_)
+                return 0;
+
+            table.erase_at_(idx);
+
+            return 1;
+        }
+
+        template<class Table, class Key>
+        static pair<
+            typename Table::iterator,
+            typename Table::iterator
+        > equal_range(Table& table, const Key& key)
+        {
+            auto first = table.find(key);
+            auto last = first;
+
+            if (last != table.end())
+                ++last;
+
+            return make_pair(first, last);
+        }
+
+        template<class Table, class Key>
+        static pair<
+            typename Table::const_iterator,
+            typename Table::const_iterator
+        > equal_range_const(const Table& table, const Key& key)
+        {
+            auto first = table.find(key);
+            auto last = first;
+
+            if (last != table.end())
+                ++last;
+
+            return make_pair(first, last);
+        }
+
+        template<class Table, class... Args>
+        static pair<
+            typename Table::iterator, bool
+        > emplace(Table& table, Args&&... args)
+        {
+            using value_type = typename Table::value_type;
+
+            /**
+             * Note: Like in the chained table, we need to construct
+             *       the value to get to its key. It is moved into the
+             *       table afterwards if the key is not present.
+             */
+            auto val = value_type{forward<Args>(args)...};
+
+            return insert(table, move(val));
+        }
+
+        template<class Table, class Value>
+        static pair<
+            typename Table::iterator, bool
+        > insert(Table& table, Value&& val)
+        {
+            const auto& key = table.get_key(val);
+            auto hash = table.hash_(key);
+
+            auto idx = table.find_idx_(key, hash);
+            if (idx != Table::npos_)
+                return make_pair(table.make_iterator_(idx), false);
+
+            idx = table.prepare_insert_(hash);
+            table.construct_at_(idx, hash, forward<Value>(val));
+
+            return make_pair(table.make_iterator_(idx), true);
+        }
+
+        template<class Table, class Key, class... Args>
+        static pair<
+            typename Table::iterator, bool
+        > try_emplace(Table& table, Key&& key, Args&&... args)
+        {
+            using mapped_type = typename Table::value_type::second_type;
+
+            auto hash = table.hash_(key);
+
+            auto idx = table.find_idx_(key, hash);
+            if (idx != Table::npos_)
+                return make_pair(table.make_iterator_(idx), false);
+
+            idx = table.prepare_insert_(hash);
+            table.construct_at_(
+                idx, hash, forward<Key>(key),
+                mapped_type(forward<Args>(args)...)
+            );
+
+            return make_pair(table.make_iterator_(idx), true);
+        }
+    };
+
+    /**
+     * Policy used by unordered_map and unordered_set by default.
+     * The chained table keeps references to elements valid across
+     * rehashing as required by [unord.req], the flat table does
+     * not, so it has to be selected explicitly (see
+     * aux::flat_unordered_map and aux::flat_unordered_set).
+     */
+    using hash_default_single_policy = hash_single_policy;
 }
 
 #endif
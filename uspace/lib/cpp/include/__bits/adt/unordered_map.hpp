@@ -29,6 +29,7 @@
 #ifndef LIBCPP_BITS_ADT_UNORDERED_MAP
 #define LIBCPP_BITS_ADT_UNORDERED_MAP
 
+#include <__bits/adt/flat_hash_table.hpp>
 #include <__bits/adt/hash_table.hpp>
 #include <initializer_list>
 #include <functional>
@@ -46,10 +47,13 @@ namespace std
         class Key, class Value,
         class Hash = hash<Key>,
         class Pred = equal_to<Key>,
-        class Alloc = allocator<pair<const Key, Value>>
+        class Alloc = allocator<pair<const Key, Value>>,
+        class Policy = aux::hash_default_single_policy
     >
     class unordered_map
     {
+            using policy_type = Policy;
+
         public:
             using key_type        = Key;
             using mapped_type     = Value;
@@ -64,16 +68,16 @@ namespace std
             using size_type       = size_t;
             using difference_type = ptrdiff_t;
 
-            using iterator             = aux::hash_table_iterator<
+            using iterator             = typename policy_type::template iterator<
                 value_type, reference, pointer, size_type
             >;
-            using const_iterator       = aux::hash_table_const_iterator<
+            using const_iterator       = typename policy_type::template const_iterator<
                 value_type, const_reference, const_pointer, size_type
             >;
-            using local_iterator       = aux::hash_table_local_iterator<
+            using local_iterator       = typename policy_type::template local_iterator<
                 value_type, reference, pointer
             >;
-            using const_local_iterator = aux::hash_table_const_local_iterator<
+            using const_local_iterator = typename policy_type::template const_local_iterator<
                 value_type, const_reference, const_pointer
             >;
 
@@ -314,71 +318,13 @@ namespace std
                  *       an insertion takes place.
                  */
 
-                table_.increment_size();
-
-                auto [bucket, target, idx] = table_.find_insertion_spot(key);
-
-                if (!bucket)
-                    return make_pair(end(), false);
-
-                if (target && table_.keys_equal(key, target->value))
-                {
-                    table_.decrement_size();
-
-                    return make_pair(
-                        iterator{
-                            table_.table(), idx, table_.bucket_count(),
-                            target
-                        },
-                        false
-                    );
-                }
-                else
-                {
-                    auto node = new node_type{key, forward<Args>(args)...};
-                    bucket->append(node);
-
-                    return make_pair(iterator{
-                        table_.table(), idx,
-                        table_.bucket_count(),
-                        node
-                    }, true);
-                }
+                return table_.try_emplace(key, forward<Args>(args)...);
             }
 
             template<class... Args>
             pair<iterator, bool> try_emplace(key_type&& key, Args&&... args)
             {
-                table_.increment_size();
-
-                auto [bucket, target, idx] = table_.find_insertion_spot(key);
-
-                if (!bucket)
-                    return make_pair(end(), false);
-
-                if (target && table_.keys_equal(key, target->value))
-                {
-                    table_.decrement_size();
-
-                    return make_pair(
-                        iterator{
-                            table_.table(), idx, table_.bucket_count(),
-                            target
-                        },
-                        false
-                    );
-                }
-                else
-                {
-                    auto node = new node_type{move(key), forward<Args>(args)...};
-                    bucket->append(node);
-
-                    return make_pair(iterator{
-                        table_.table(), idx,
-                        table_.bucket_count(),
-                        node
-                    }, true);
-                }
+                return table_.try_emplace(move(key), forward<Args>(args)...);
             }
 
             template<class... Args>
@@ -396,73 +342,26 @@ namespace std
             template<class T>
             pair<iterator, bool> insert_or_assign(const key_type& key, T&& val)
             {
-                table_.increment_size();
-
-                auto [bucket, target, idx] = table_.find_insertion_spot(key);
-
-                if (!bucket)
-                    return make_pair(end(), false);
-
-                if (target && table_.keys_equal(key, target->value))
-                {
-                    table_.decrement_size();
-                    target->value.second = forward<T>(val);
-
-                    return make_pair(
-                        iterator{
-                            table_.table(), idx, table_.bucket_count(),
-                            target
-                        },
-                        false
-                    );
-                }
-                else
-                {
-                    auto node = new node_type{key, forward<T>(val)};
-                    bucket->append(node);
+                /**
+                 * Note: The value is only moved from by try_emplace
+                 *       if the insertion takes place, so we can still
+                 *       assign it if it does not.
+                 */
+                auto res = table_.try_emplace(key, forward<T>(val));
+                if (!res.second)
+                    res.first->second = forward<T>(val);
 
-                    return make_pair(iterator{
-                        table_.table(), idx,
-                        table_.bucket_count(),
-                        node
-                    }, true);
-                }
+                return res;
             }
 
             template<class T>
             pair<iterator, bool> insert_or_assign(key_type&& key, T&& val)
             {
-                table_.increment_size();
-
-                auto [bucket, target, idx] = table_.find_insertion_spot(key);
-
-                if (!bucket)
-                    return make_pair(end(), false);
+                auto res = table_.try_emplace(move(key), forward<T>(val));
+                if (!res.second)
+                    res.first->second = forward<T>(val);
 
-                if (target && table_.keys_equal(key, target->value))
-                {
-                    table_.decrement_size();
-                    target->value.second = forward<T>(val);
-
-                    return make_pair(
-                        iterator{
-                            table_.table(), idx, table_.bucket_count(),
-                            target
-                        },
-                        false
-                    );
-                }
-                else
-                {
-                    auto node = new node_type{move(key), forward<T>(val)};
-                    bucket->append(node);
-
-                    return make_pair(iterator{
-                        table_.table(), idx,
-                        table_.bucket_count(),
-                        node
-                    }, true);
-                }
+                return res;
             }
 
             template<class T>
@@ -489,13 +388,7 @@ namespace std
 
             iterator erase(const_iterator first, const_iterator last)
             {
-                while (first != last)
-                    first = erase(first);
-
-                return iterator{
-                    table_.table(), first.idx(),
-                    table_.bucket_count(), table_.head(first.idx())
-                };
+                return table_.erase(first, last);
             }
 
             void clear() noexcept
@@ -549,58 +442,12 @@ namespace std
 
             mapped_type& operator[](const key_type& key)
             {
-                auto spot = table_.find_insertion_spot(key);
-                auto bucket = get<0>(spot);
-
-                if (bucket->head)
-                {
-                    auto head = bucket->head;
-                    auto current = bucket->head;
-
-                    do
-                    {
-                        if (table_.keys_equal(key, current->value))
-                            return current->value.second;
-                        else
-                            current = current->next;
-                    }
-                    while (current != head);
-                }
-
-                auto node = new node_type{key, mapped_type{}};
-                bucket->append(node);
-
-                table_.increment_size();
-                table_.rehash_if_needed();
-                return node->value.second;
+                return table_.try_emplace(key).first->second;
             }
 
             mapped_type& operator[](key_type&& key)
             {
-                auto spot = table_.find_insertion_spot(key);
-                auto bucket = get<0>(spot);
-
-                if (bucket->head)
-                {
-                    auto head = bucket->head;
-                    auto current = bucket->head;
-
-                    do
-                    {
-                        if (table_.keys_equal(key, current->value))
-                            return current->value.second;
-                        else
-                            current = current->next;
-                    }
-                    while (current != head);
-                }
-
-                auto node = new node_type{move(key), mapped_type{}};
-                bucket->append(node);
-
-                table_.increment_size();
-                table_.rehash_if_needed();
-                return node->value.second;
+                return table_.try_emplace(move(key)).first->second;
             }
 
             mapped_type& at(const key_type& key)
@@ -695,22 +542,20 @@ namespace std
             }
 
         private:
-            using table_type = aux::hash_table<
+            using table_type = typename policy_type::template table<
                 value_type, key_type, aux::key_value_key_extractor<key_type, mapped_type>,
                 hasher, key_equal, allocator_type, size_type,
-                iterator, const_iterator, local_iterator, const_local_iterator,
-                aux::hash_single_policy
+                iterator, const_iterator, local_iterator, const_local_iterator
             >;
-            using node_type = typename table_type::node_type;
 
             table_type table_;
             allocator_type allocator_;
 
             static constexpr size_type default_bucket_count_{16};
 
-            template<class K, class V, class H, class P, class A>
-            friend bool operator==(unordered_map<K, V, H, P, A>&,
-                                   unordered_map<K, V, H, P, A>&);
+            template<class K, class V, class H, class P, class A, class Po>
+            friend bool operator==(unordered_map<K, V, H, P, A, Po>&,
+                                   unordered_map<K, V, H, P, A, Po>&);
     };
 
     /**
@@ -993,13 +838,7 @@ namespace std
 
             iterator erase(const_iterator first, const_iterator last)
             {
-                while (first != last)
-                    first = erase(first);
-
-                return iterator{
-                    table_.table(), first.idx(),
-                    table_.bucket_count(), table_.head(first.idx())
-                };
+                return table_.erase(first, last);
             }
 
             void clear() noexcept
@@ -1144,9 +983,28 @@ namespace std
                                    unordered_multimap<K, V, H, P, A>&);
     };
 
-    template<class Key, class Value, class Hash, class Pred, class Alloc>
-    void swap(unordered_map<Key, Value, Hash, Pred, Alloc>& lhs,
-              unordered_map<Key, Value, Hash, Pred, Alloc>& rhs)
+    namespace aux
+    {
+        /**
+         * Note: An unordered_map backed by the open addressing
+         *       flat_hash_table. It is faster, but rehashing moves
+         *       the elements, so references, pointers and iterators
+         *       to them are invalidated by every rehash.
+         */
+        template<
+            class Key, class Value,
+            class Hash = std::hash<Key>,
+            class Pred = equal_to<Key>,
+            class Alloc = allocator<pair<const Key, Value>>
+        >
+        using flat_unordered_map = unordered_map<
+            Key, Value, Hash, Pred, Alloc, hash_flat_single_policy
+        >;
+    }
+
+    template<class Key, class Value, class Hash, class Pred, class Alloc, class Policy>
+    void swap(unordered_map<Key, Value, Hash, Pred, Alloc, Policy>& lhs,
+              unordered_map<Key, Value, Hash, Pred, Alloc, Policy>& rhs)
         noexcept(noexcept(lhs.swap(rhs)))
     {
         lhs.swap(rhs);
@@ -1160,17 +1018,17 @@ namespace std
         lhs.swap(rhs);
     }
 
-    template<class Key, class Value, class Hash, class Pred, class Alloc>
-    bool operator==(unordered_map<Key, Value, Hash, Pred, Alloc>& lhs,
-                    unordered_map<Key, Value, Hash, Pred, Alloc>& rhs)
+    template<class Key, class Value, class Hash, class Pred, class Alloc, class Policy>
+    bool operator==(unordered_map<Key, Value, Hash, Pred, Alloc, Policy>& lhs,
+                    unordered_map<Key, Value, Hash, Pred, Alloc, Policy>& rhs)
     {
         // TODO: this does not compare values, use is_permutation when we have it
         return lhs.table_.is_eq_to(rhs.table_);
     }
 
-    template<class Key, class Value, class Hash, class Pred, class Alloc>
-    bool operator!=(unordered_map<Key, Value, Hash, Pred, Alloc>& lhs,
-                    unordered_map<Key, Value, Hash, Pred, Alloc>& rhs)
+    template<class Key, class Value, class Hash, class Pred, class Alloc, class Policy>
+    bool operator!=(unordered_map<Key, Value, Hash, Pred, Alloc, Policy>& lhs,
+                    unordered_map<Key, Value, Hash, Pred, Alloc, Policy>& rhs)
     {
         return !(lhs == rhs);
     }
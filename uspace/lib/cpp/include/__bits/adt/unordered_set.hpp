@@ -29,6 +29,7 @@
 #ifndef LIBCPP_BITS_ADT_UNORDERED_SET
 #define LIBCPP_BITS_ADT_UNORDERED_SET
 
+#include <__bits/adt/flat_hash_table.hpp>
 #include <__bits/adt/hash_table.hpp>
 #include <initializer_list>
 #include <functional>
@@ -45,10 +46,13 @@ namespace std
         class Key,
         class Hash = hash<Key>,
         class Pred = equal_to<Key>,
-        class Alloc = allocator<Key>
+        class Alloc = allocator<Key>,
+        class Policy = aux::hash_default_single_policy
     >
     class unordered_set
     {
+            using policy_type = Policy;
+
         public:
             using key_type        = Key;
             using value_type      = Key;
@@ -67,11 +71,11 @@ namespace std
              *       types are constant iterators, the standard does not require them
              *       to be the same type, but why not? :)
              */
-            using iterator             = aux::hash_table_const_iterator<
+            using iterator             = typename policy_type::template const_iterator<
                 value_type, const_reference, const_pointer, size_type
             >;
             using const_iterator       = iterator;
-            using local_iterator       = aux::hash_table_const_local_iterator<
+            using local_iterator       = typename policy_type::template const_local_iterator<
                 value_type, const_reference, const_pointer
             >;
             using const_local_iterator = local_iterator;
@@ -302,13 +306,7 @@ namespace std
 
             iterator erase(const_iterator first, const_iterator last)
             {
-                while (first != last)
-                    first = erase(first);
-
-                return iterator{
-                    table_.table(), first.idx(),
-                    table_.bucket_count(), first.node()
-                };
+                return table_.erase(first, last);
             }
 
             void clear() noexcept
@@ -436,11 +434,10 @@ namespace std
             }
 
         private:
-            using table_type = aux::hash_table<
+            using table_type = typename policy_type::template table<
                 key_type, key_type, aux::key_no_value_key_extractor<key_type>,
                 hasher, key_equal, allocator_type, size_type,
-                iterator, const_iterator, local_iterator, const_local_iterator,
-                aux::hash_single_policy
+                iterator, const_iterator, local_iterator, const_local_iterator
             >;
 
             table_type table_;
@@ -448,9 +445,9 @@ namespace std
 
             static constexpr size_type default_bucket_count_{16};
 
-            template<class K, class H, class P, class A>
-            friend bool operator==(const unordered_set<K, H, P, A>&,
-                                   const unordered_set<K, H, P, A>&);
+            template<class K, class H, class P, class A, class Po>
+            friend bool operator==(const unordered_set<K, H, P, A, Po>&,
+                                   const unordered_set<K, H, P, A, Po>&);
     };
 
     /**
@@ -718,13 +715,7 @@ namespace std
 
             iterator erase(const_iterator first, const_iterator last)
             {
-                while (first != last)
-                    first = erase(first);
-
-                return iterator{
-                    table_.table(), first.idx(),
-                    table_.bucket_count(), table_.head(first.idx())
-                };
+                return table_.erase(first, last);
             }
 
             void clear() noexcept
@@ -869,9 +860,28 @@ namespace std
                                    const unordered_multiset<K, H, P, A>&);
     };
 
-    template<class Key, class Hash, class Pred, class Alloc>
-    void swap(unordered_set<Key, Hash, Pred, Alloc>& lhs,
-              unordered_set<Key, Hash, Pred, Alloc>& rhs)
+    namespace aux
+    {
+        /**
+         * Note: An unordered_set backed by the open addressing
+         *       flat_hash_table. It is faster, but rehashing moves
+         *       the elements, so references, pointers and iterators
+         *       to them are invalidated by every rehash.
+         */
+        template<
+            class Key,
+            class Hash = std::hash<Key>,
+            class Pred = equal_to<Key>,
+            class Alloc = allocator<Key>
+        >
+        using flat_unordered_set = unordered_set<
+            Key, Hash, Pred, Alloc, hash_flat_single_policy
+        >;
+    }
+
+    template<class Key, class Hash, class Pred, class Alloc, class Policy>
+    void swap(unordered_set<Key, Hash, Pred, Alloc, Policy>& lhs,
+              unordered_set<Key, Hash, Pred, Alloc, Policy>& rhs)
         noexcept(noexcept(lhs.swap(rhs)))
     {
         lhs.swap(rhs);
@@ -885,16 +895,16 @@ namespace std
         lhs.swap(rhs);
     }
 
-    template<class Key, class Hash, class Pred, class Alloc>
-    bool operator==(const unordered_set<Key, Hash, Pred, Alloc>& lhs,
-                    const unordered_set<Key, Hash, Pred, Alloc>& rhs)
+    template<class Key, class Hash, class Pred, class Alloc, class Policy>
+    bool operator==(const unordered_set<Key, Hash, Pred, Alloc, Policy>& lhs,
+                    const unordered_set<Key, Hash, Pred, Alloc, Policy>& rhs)
     {
         return lhs.table_.is_eq_to(rhs.table_);
     }
 
-    template<class Key, class Hash, class Pred, class Alloc>
-    bool operator!=(const unordered_set<Key, Hash, Pred, Alloc>& lhs,
-                    const unordered_set<Key, Hash, Pred, Alloc>& rhs)
+    template<class Key, class Hash, class Pred, class Alloc, class Policy>
+    bool operator!=(const unordered_set<Key, Hash, Pred, Alloc, Policy>& lhs,
+                    const unordered_set<Key, Hash, Pred, Alloc, Policy>& rhs)
     {
         return !(lhs == rhs);
     }
@@ -30,6 +30,7 @@
 #define LIBCPP_BITS_ALGORITHM
 
 #include <iterator>
+#include <new>
 #include <utility>
 
 namespace std
@@ -653,7 +654,46 @@ namespace std
      * 25.3.11, rotate:
      */
 
-    // TODO: implement
+    template<class ForwardIterator>
+    ForwardIterator rotate(ForwardIterator first, ForwardIterator middle,
+                           ForwardIterator last)
+    {
+        if (first == middle)
+            return last;
+        if (middle == last)
+            return first;
+
+        auto res = first;
+        advance(res, distance(middle, last));
+
+        /**
+         * Note: Each pass swaps the front of the sequence
+         *       with the elements following middle until
+         *       one of the two parts is in its final place,
+         *       the rest is then rotated the same way.
+         */
+        auto next = middle;
+        while (first != next)
+        {
+            iter_swap(first++, next++);
+
+            if (next == last)
+                next = middle;
+            else if (first == middle)
+                middle = next;
+        }
+
+        return res;
+    }
+
+    template<class ForwardIterator, class OutputIterator>
+    OutputIterator rotate_copy(ForwardIterator first, ForwardIterator middle,
+                               ForwardIterator last, OutputIterator result)
+    {
+        result = copy(middle, last, result);
+
+        return copy(first, middle, result);
+    }
 
     /**
      * 25.3.12, shuffle:
@@ -687,6 +727,134 @@ namespace std
     void sort_heap(RandomAccessIterator, RandomAccessIterator,
                    Compare);
 
+    template<class ForwardIterator, class T, class Compare>
+    ForwardIterator lower_bound(ForwardIterator, ForwardIterator,
+                                const T&, Compare);
+
+    template<class ForwardIterator, class T, class Compare>
+    ForwardIterator upper_bound(ForwardIterator, ForwardIterator,
+                                const T&, Compare);
+
+    namespace aux
+    {
+        template<class RandomAccessIterator, class Size, class Compare>
+        void correct_children(RandomAccessIterator, Size, Size, Compare);
+
+        /**
+         * Ranges shorter than this are left to insertion sort,
+         * which beats the recursive algorithms on small inputs.
+         */
+        inline constexpr ptrdiff_t sort_threshold{16};
+
+        template<class RandomAccessIterator, class Compare>
+        void insertion_sort(RandomAccessIterator first,
+                            RandomAccessIterator last, Compare comp)
+        {
+            if (first == last)
+                return;
+
+            for (auto it = first + 1; it != last; ++it)
+            {
+                auto value = move(*it);
+                auto hole = it;
+
+                while (hole != first && comp(value, *(hole - 1)))
+                {
+                    *hole = move(*(hole - 1));
+                    --hole;
+                }
+
+                *hole = move(value);
+            }
+        }
+
+        template<class RandomAccessIterator, class Compare>
+        void move_median_to_first(RandomAccessIterator res,
+                                  RandomAccessIterator a,
+                                  RandomAccessIterator b,
+                                  RandomAccessIterator c,
+                                  Compare comp)
+        {
+            if (comp(*a, *b))
+            {
+                if (comp(*b, *c))
+                    iter_swap(res, b);
+                else if (comp(*a, *c))
+                    iter_swap(res, c);
+                else
+                    iter_swap(res, a);
+            }
+            else if (comp(*a, *c))
+                iter_swap(res, a);
+            else if (comp(*b, *c))
+                iter_swap(res, c);
+            else
+                iter_swap(res, b);
+        }
+
+        /**
+         * Partitions [first + 1, last) around the median of three
+         * which gets moved to *first. Since the median is neither
+         * the smallest nor the largest of the three, both scans
+         * are guaranteed to stop without bounds checks.
+         */
+        template<class RandomAccessIterator, class Compare>
+        RandomAccessIterator partition_pivot(RandomAccessIterator first,
+                                             RandomAccessIterator last,
+                                             Compare comp)
+        {
+            auto mid = first + (last - first) / 2;
+            move_median_to_first(first, first + 1, mid, last - 1, comp);
+
+            auto pivot = first;
+            ++first;
+            while (true)
+            {
+                while (comp(*first, *pivot))
+                    ++first;
+                --last;
+                while (comp(*pivot, *last))
+                    --last;
+
+                if (!(first < last))
+                    return first;
+
+                iter_swap(first, last);
+                ++first;
+            }
+        }
+
+        template<class RandomAccessIterator, class Size, class Compare>
+        void introsort_loop(RandomAccessIterator first,
+                            RandomAccessIterator last,
+                            Size depth_limit, Compare comp)
+        {
+            while (last - first > sort_threshold)
+            {
+                if (depth_limit == 0)
+                {
+                    /**
+                     * Too many bad pivots, fall back to heap sort
+                     * to keep the worst case at O(n log n).
+                     */
+                    make_heap(first, last, comp);
+                    sort_heap(first, last, comp);
+
+                    return;
+                }
+                --depth_limit;
+
+                /**
+                 * Note: We recurse into the right part and loop
+                 *       on the left one to save some stack.
+                 */
+                auto cut = partition_pivot(first, last, comp);
+                introsort_loop(cut, last, depth_limit, comp);
+                last = cut;
+            }
+        }
+    }
+
     template<class RandomAccessIterator>
     void sort(RandomAccessIterator first, RandomAccessIterator last)
     {
@@ -700,63 +868,270 @@ namespace std
               Compare comp)
     {
         /**
-         * Note: This isn't the most effective approach,
-         *       but since we already have these two functions
-         *       and they satisfy asymptotic limitations
-         *       imposed by the standard, we're using them at
-         *       the moment. Might be good to change it to qsort
-         *       or merge sort later.
+         * Note: This is introsort, median of three quicksort
+         *       that switches to heap sort once the recursion
+         *       gets deeper than 2 * log2(n) and leaves the
+         *       small ranges to a final insertion sort pass.
          */
+        if (last - first < 2)
+            return;
 
-        make_heap(first, last, comp);
-        sort_heap(first, last, comp);
+        size_t depth_limit{};
+        for (auto n = last - first; n > 1; n /= 2)
+            depth_limit += 2;
+
+        aux::introsort_loop(first, last, depth_limit, comp);
+        aux::insertion_sort(first, last, comp);
     }
 
     /**
      * 25.4.1.2, stable_sort:
      */
 
-    // TODO: implement
+    namespace aux
+    {
+        /**
+         * Moves [first, middle) to the (uninitialized) buffer
+         * and merges it with [middle, last) back into place.
+         * Taking the element from the buffer on ties keeps
+         * the merge stable.
+         */
+        template<class RandomAccessIterator, class Pointer, class Compare>
+        void merge_with_buffer(RandomAccessIterator first,
+                               RandomAccessIterator middle,
+                               RandomAccessIterator last,
+                               Pointer buffer, Compare comp)
+        {
+            using value_type = typename iterator_traits<RandomAccessIterator>::value_type;
+
+            auto buffer_end = buffer;
+            for (auto it = first; it != middle; ++it, ++buffer_end)
+                ::new(static_cast<void*>(buffer_end)) value_type(move(*it));
+
+            auto buf = buffer;
+            while (buf != buffer_end && middle != last)
+            {
+                if (comp(*middle, *buf))
+                    *first++ = move(*middle++);
+                else
+                    *first++ = move(*buf++);
+            }
+
+            while (buf != buffer_end)
+                *first++ = move(*buf++);
+
+            for (auto it = buffer; it != buffer_end; ++it)
+                it->~value_type();
+        }
+
+        /**
+         * Fallback used when we fail to allocate the buffer,
+         * which trades the linear merge for an O(n log n) one.
+         */
+        template<class RandomAccessIterator, class Compare>
+        void merge_without_buffer(RandomAccessIterator first,
+                                  RandomAccessIterator middle,
+                                  RandomAccessIterator last,
+                                  Compare comp)
+        {
+            auto len1 = middle - first;
+            auto len2 = last - middle;
+            if (len1 == 0 || len2 == 0)
+                return;
+
+            if (len1 + len2 == 2)
+            {
+                if (comp(*middle, *first))
+                    iter_swap(first, middle);
+
+                return;
+            }
+
+            RandomAccessIterator cut1{}, cut2{};
+            if (len1 > len2)
+            {
+                cut1 = first + len1 / 2;
+                cut2 = lower_bound(middle, last, *cut1, comp);
+            }
+            else
+            {
+                cut2 = middle + len2 / 2;
+                cut1 = upper_bound(first, middle, *cut2, comp);
+            }
+
+            auto new_middle = rotate(cut1, middle, cut2);
+            merge_without_buffer(first, cut1, new_middle, comp);
+            merge_without_buffer(new_middle, cut2, last, comp);
+        }
+
+        template<class RandomAccessIterator, class Pointer, class Compare>
+        void merge_sort(RandomAccessIterator first, RandomAccessIterator last,
+                        Pointer buffer, Compare comp)
+        {
+            auto count = last - first;
+            if (count <= sort_threshold)
+            {
+                insertion_sort(first, last, comp);
+
+                return;
+            }
+
+            auto middle = first + count / 2;
+            merge_sort(first, middle, buffer, comp);
+            merge_sort(middle, last, buffer, comp);
+
+            // Already in order, happens a lot with partially sorted input.
+            if (!comp(*middle, *(middle - 1)))
+                return;
+
+            if (buffer)
+                merge_with_buffer(first, middle, last, buffer, comp);
+            else
+                merge_without_buffer(first, middle, last, comp);
+        }
+    }
+
+    template<class RandomAccessIterator>
+    void stable_sort(RandomAccessIterator first, RandomAccessIterator last)
+    {
+        using value_type = typename iterator_traits<RandomAccessIterator>::value_type;
+
+        stable_sort(first, last, less<value_type>{});
+    }
+
+    template<class RandomAccessIterator, class Compare>
+    void stable_sort(RandomAccessIterator first, RandomAccessIterator last,
+                     Compare comp)
+    {
+        using value_type = typename iterator_traits<RandomAccessIterator>::value_type;
+
+        auto count = last - first;
+        if (count < 2)
+            return;
+
+        /**
+         * Note: Merges never need more than the left half
+         *       of the range in the buffer. If we cannot get
+         *       it, we still sort, just with in place merges.
+         */
+        auto buffer_size = static_cast<size_t>((count + 1) / 2);
+        auto buffer = static_cast<value_type*>(
+            ::operator new(buffer_size * sizeof(value_type), nothrow)
+        );
+
+        aux::merge_sort(first, last, buffer, comp);
+
+        ::operator delete(buffer);
+    }
 
     /**
      * 25.4.1.3, partial_sort:
      */
 
-    // TODO: implement
+    template<class RandomAccessIterator>
+    void partial_sort(RandomAccessIterator first,
+                      RandomAccessIterator middle,
+                      RandomAccessIterator last)
+    {
+        using value_type = typename iterator_traits<RandomAccessIterator>::value_type;
 
-    /**
-     * 25.4.1.4, partial_sort_copy:
-     */
+        partial_sort(first, middle, last, less<value_type>{});
+    }
 
-    // TODO: implement
+    template<class RandomAccessIterator, class Compare>
+    void partial_sort(RandomAccessIterator first,
+                      RandomAccessIterator middle,
+                      RandomAccessIterator last,
+                      Compare comp)
+    {
+        /**
+         * Note: We keep the smallest middle - first elements
+         *       seen so far in a max heap, so every remaining
+         *       element costs one comparison with its top and
+         *       only the smaller ones need a sift down.
+         */
+        auto count = middle - first;
+        if (count == 0)
+            return;
+
+        make_heap(first, middle, comp);
+        for (auto it = middle; it != last; ++it)
+        {
+            if (comp(*it, *first))
+            {
+                iter_swap(it, first);
+                aux::correct_children(first, decltype(count){}, count, comp);
+            }
+        }
+
+        sort_heap(first, middle, comp);
+    }
 
     /**
-     * 25.4.1.5, is_sorted:
+     * 25.4.1.4, partial_sort_copy:
      */
 
-    template<class ForwardIterator>
-    bool is_sorted(ForwardIterator first, ForwardIterator last)
+    template<class InputIterator, class RandomAccessIterator>
+    RandomAccessIterator partial_sort_copy(InputIterator first,
+                                           InputIterator last,
+                                           RandomAccessIterator result_first,
+                                           RandomAccessIterator result_last)
     {
-        return is_sorted_until(first, last) == last;
+        using value_type = typename iterator_traits<RandomAccessIterator>::value_type;
+
+        return partial_sort_copy(
+            first, last, result_first, result_last,
+            less<value_type>{}
+        );
     }
 
-    template<class ForwardIterator, class Comp>
-    bool is_sorted(ForwardIterator first, ForwardIterator last,
-                   Comp comp)
+    template<class InputIterator, class RandomAccessIterator, class Compare>
+    RandomAccessIterator partial_sort_copy(InputIterator first,
+                                           InputIterator last,
+                                           RandomAccessIterator result_first,
+                                           RandomAccessIterator result_last,
+                                           Compare comp)
     {
-        return is_sorted_until(first, last, comp) == last;
+        auto result_it = result_first;
+        while (first != last && result_it != result_last)
+            *result_it++ = *first++;
+
+        auto count = result_it - result_first;
+        if (count == 0)
+            return result_it;
+
+        make_heap(result_first, result_it, comp);
+        while (first != last)
+        {
+            if (comp(*first, *result_first))
+            {
+                *result_first = *first;
+                aux::correct_children(result_first, decltype(count){}, count, comp);
+            }
+            ++first;
+        }
+
+        sort_heap(result_first, result_it, comp);
+
+        return result_it;
     }
 
+    /**
+     * 25.4.1.5, is_sorted:
+     */
+
     template<class ForwardIterator>
     ForwardIterator is_sorted_until(ForwardIterator first, ForwardIterator last)
     {
-        if (distance(first, last) < 2)
+        if (first == last)
             return last;
 
-        while (first != last)
+        auto next = first;
+        while (++next != last)
         {
-            if (*first > *(++first))
-                return first;
+            if (*next < *first)
+                return next;
+            first = next;
         }
 
         return last;
@@ -766,18 +1141,33 @@ namespace std
     ForwardIterator is_sorted_until(ForwardIterator first, ForwardIterator last,
                                     Comp comp)
     {
-        if (distance(first, last) < 2)
+        if (first == last)
             return last;
 
-        while (first != last)
+        auto next = first;
+        while (++next != last)
         {
-            if (!comp(*first, *(++first)))
-                return first;
+            if (comp(*next, *first))
+                return next;
+            first = next;
         }
 
         return last;
     }
 
+    template<class ForwardIterator>
+    bool is_sorted(ForwardIterator first, ForwardIterator last)
+    {
+        return is_sorted_until(first, last) == last;
+    }
+
+    template<class ForwardIterator, class Comp>
+    bool is_sorted(ForwardIterator first, ForwardIterator last,
+                   Comp comp)
+    {
+        return is_sorted_until(first, last, comp) == last;
+    }
+
     /**
      * 25.4.2, nth_element:
      */
@@ -792,13 +1182,73 @@ namespace std
      * 25.4.3.1, lower_bound
      */
 
-    // TODO: implement
+    template<class ForwardIterator, class T>
+    ForwardIterator lower_bound(ForwardIterator first, ForwardIterator last,
+                                const T& value)
+    {
+        using value_type = typename iterator_traits<ForwardIterator>::value_type;
+
+        return lower_bound(first, last, value, less<value_type>{});
+    }
+
+    template<class ForwardIterator, class T, class Compare>
+    ForwardIterator lower_bound(ForwardIterator first, ForwardIterator last,
+                                const T& value, Compare comp)
+    {
+        auto count = distance(first, last);
+        while (count > 0)
+        {
+            auto step = count / 2;
+            auto it = first;
+            advance(it, step);
+
+            if (comp(*it, value))
+            {
+                first = ++it;
+                count -= step + 1;
+            }
+            else
+                count = step;
+        }
+
+        return first;
+    }
 
     /**
      * 25.4.3.2, upper_bound
      */
 
-    // TODO: implement
+    template<class ForwardIterator, class T>
+    ForwardIterator upper_bound(ForwardIterator first, ForwardIterator last,
+                                const T& value)
+    {
+        using value_type = typename iterator_traits<ForwardIterator>::value_type;
+
+        return upper_bound(first, last, value, less<value_type>{});
+    }
+
+    template<class ForwardIterator, class T, class Compare>
+    ForwardIterator upper_bound(ForwardIterator first, ForwardIterator last,
+                                const T& value, Compare comp)
+    {
+        auto count = distance(first, last);
+        while (count > 0)
+        {
+            auto step = count / 2;
+            auto it = first;
+            advance(it, step);
+
+            if (!comp(value, *it))
+            {
+                first = ++it;
+                count -= step + 1;
+            }
+            else
+                count = step;
+        }
+
+        return first;
+    }
 
     /**
      * 25.4.3.3, equal_range:
@@ -881,35 +1331,31 @@ namespace std
                               Size idx, Size count, Compare comp)
         {
             using aux::heap_left_child;
-            using aux::heap_right_child;
-
-            auto left = heap_left_child(idx);
-            auto right = heap_right_child(idx);
 
-            bool left_incorrect{comp(first[idx], first[left])};
-            bool right_incorrect{comp(first[idx], first[right])};
-            while ((left < count && left_incorrect) ||
-                   (right < count && right_incorrect))
+            /**
+             * Note: Instead of swapping on every level we hold
+             *       the sifted value aside and move the larger
+             *       child up until we find the value's place.
+             */
+            auto child = heap_left_child(idx);
+            if (child >= count)
+                return;
+
+            auto value = move(first[idx]);
+            while (child < count)
             {
-                if (right >= count || (left_incorrect && comp(first[right], first[left])))
-                {
-                    swap(first[idx], first[left]);
+                if (child + 1 < count && comp(first[child], first[child + 1]))
+                    ++child;
 
-                    idx = left;
-                }
-                else if (right < count && right_incorrect)
-                {
-                    swap(first[idx], first[right]);
+                if (!comp(value, first[child]))
+                    break;
 
-                    idx = right;
-                } // Else should not happen because of the while condition.
-
-                left = heap_left_child(idx);
-                right = heap_right_child(idx);
-
-                left_incorrect = comp(first[idx], first[left]);
-                right_incorrect = comp(first[idx], first[right]);
+                first[idx] = move(first[child]);
+                idx = child;
+                child = heap_left_child(idx);
             }
+
+            first[idx] = move(value);
         }
     }
 
@@ -971,7 +1417,7 @@ namespace std
             return;
 
         swap(first[0], first[count - 1]);
-        aux::correct_children(first, decltype(count){}, count - 2, comp);
+        aux::correct_children(first, decltype(count){}, count - 1, comp);
     }
 
     /**
@@ -996,7 +1442,8 @@ namespace std
         if (count <= 1)
             return;
 
-        for (auto i = count; i > 0; --i)
+        // Leaves are trivially heaps, so we start at the last parent.
+        for (auto i = count / 2; i > 0; --i)
         {
             auto idx = i - 1;
 
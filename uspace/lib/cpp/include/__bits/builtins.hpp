@@ -82,6 +82,15 @@ namespace std::aux
     {
         return static_cast<size_t>(__builtin_floor(static_cast<double>(val)));
     }
+
+    /**
+     * Note: The result is undefined for val == 0,
+     *       same as with the builtin itself.
+     */
+    constexpr int count_trailing_zeros(unsigned long long val)
+    {
+        return __builtin_ctzll(val);
+    }
 }
 
 #endif
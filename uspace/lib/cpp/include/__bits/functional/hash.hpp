@@ -75,7 +75,14 @@ namespace std
             static_assert(is_arithmetic<T>::value || is_pointer<T>::value,
                           "invalid type passed to aux::hash");
 
+            /**
+             * Note: The value can be narrower than the converted
+             *       integer, so we need to clear the upper bytes
+             *       first, otherwise the hash would depend on
+             *       whatever was in memory before.
+             */
             converter<T> conv;
+            conv.converted = 0;
             conv.value = x;
 
             return hash_<size_t>(conv.converted);
@@ -236,6 +236,8 @@ namespace std
 
             void init_()
             {
+                str_.ensure_not_local_();
+
                 if ((mode_ & ios_base::in) != 0)
                 {
                     this->input_begin_ = this->input_next_ = str_.begin();
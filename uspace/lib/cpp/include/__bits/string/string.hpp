@@ -470,7 +470,7 @@ namespace std
             { /* DUMMY BODY */ }
 
             explicit basic_string(const allocator_type& alloc)
-                : data_{}, size_{}, capacity_{}, allocator_{alloc}
+                : data_{local_}, size_{}, allocator_{alloc}
             {
                 /**
                  * Postconditions:
@@ -478,29 +478,24 @@ namespace std
                  *  size() = 0
                  *  capacity() = unspecified
                  */
-                data_ = allocator_.allocate(default_capacity_);
-                capacity_ = default_capacity_;
+                ensure_null_terminator_();
             }
 
             basic_string(const basic_string& other)
-                : data_{}, size_{other.size_}, capacity_{other.capacity_},
-                  allocator_{other.allocator_}
+                : data_{}, size_{}, allocator_{other.allocator_}
             {
-                init_(other.data(), size_);
+                init_(other.data(), other.size_);
             }
 
             basic_string(basic_string&& other)
-                : data_{other.data_}, size_{other.size_},
-                  capacity_{other.capacity_}, allocator_{move(other.allocator_)}
+                : data_{}, size_{}, allocator_{move(other.allocator_)}
             {
-                other.data_ = nullptr;
-                other.size_ = 0;
-                other.capacity_ = 0;
+                steal_(other);
             }
 
             basic_string(const basic_string& other, size_type pos, size_type n = npos,
                          const allocator_type& alloc = allocator_type{})
-                : data_{}, size_{}, capacity_{}, allocator_{alloc}
+                : data_{}, size_{}, allocator_{alloc}
             {
                 // TODO: if pos < other.size() throw out_of_range.
                 auto len = min(n, other.size() - pos);
@@ -508,21 +503,21 @@ namespace std
             }
 
             basic_string(const value_type* str, size_type n, const allocator_type& alloc = allocator_type{})
-                : data_{}, size_{n}, capacity_{n}, allocator_{alloc}
+                : data_{}, size_{}, allocator_{alloc}
             {
-                init_(str, size_);
+                init_(str, n);
             }
 
             basic_string(const value_type* str, const allocator_type& alloc = allocator_type{})
-                : data_{}, size_{}, capacity_{}, allocator_{alloc}
+                : data_{}, size_{}, allocator_{alloc}
             {
                 init_(str, traits_type::length(str));
             }
 
             basic_string(size_type n, value_type c, const allocator_type& alloc = allocator_type{})
-                : data_{}, size_{n}, capacity_{n + 1}, allocator_{alloc}
+                : data_{}, size_{}, allocator_{alloc}
             {
-                data_ = allocator_.allocate(capacity_);
+                init_storage_(n);
                 for (size_type i = 0; i < size_; ++i)
                     traits_type::assign(data_[i], c);
                 ensure_null_terminator_();
@@ -531,13 +526,11 @@ namespace std
             template<class InputIterator>
             basic_string(InputIterator first, InputIterator last,
                          const allocator_type& alloc = allocator_type{})
-                : data_{}, size_{}, capacity_{}, allocator_{alloc}
+                : data_{}, size_{}, allocator_{alloc}
             {
                 if constexpr (is_integral<InputIterator>::value)
                 { // Required by the standard.
-                    size_ = static_cast<size_type>(first);
-                    capacity_ = size_;
-                    data_ = allocator_.allocate(capacity_);
+                    init_storage_(static_cast<size_type>(first));
 
                     for (size_type i = 0; i < size_; ++i)
                         traits_type::assign(data_[i], static_cast<value_type>(last));
@@ -555,31 +548,30 @@ namespace std
             { /* DUMMY BODY */ }
 
             basic_string(const basic_string& other, const allocator_type& alloc)
-                : data_{}, size_{other.size_}, capacity_{other.capacity_}, allocator_{alloc}
+                : data_{}, size_{}, allocator_{alloc}
             {
-                init_(other.data(), size_);
+                init_(other.data(), other.size_);
             }
 
             basic_string(basic_string&& other, const allocator_type& alloc)
-                : data_{other.data_}, size_{other.size_}, capacity_{other.capacity_}, allocator_{alloc}
+                : data_{}, size_{}, allocator_{alloc}
             {
-                other.data_ = nullptr;
-                other.size_ = 0;
-                other.capacity_ = 0;
+                steal_(other);
             }
 
             ~basic_string()
             {
-                allocator_.deallocate(data_, capacity_);
+                release_();
             }
 
             basic_string& operator=(const basic_string& other)
             {
+                /**
+                 * Note: Unlike copy and swap, this reuses our
+                 *       buffer if the other string fits into it.
+                 */
                 if (this != &other)
-                {
-                    basic_string tmp{other};
-                    swap(tmp);
-                }
+                    assign(other.data(), other.size_);
 
                 return *this;
             }
@@ -589,7 +581,10 @@ namespace std
                          allocator_traits<allocator_type>::is_always_equal::value)
             {
                 if (this != &other)
-                    swap(other);
+                {
+                    release_();
+                    steal_(other);
+                }
 
                 return *this;
             }
@@ -704,9 +699,9 @@ namespace std
                 // TODO: if new_size > max_size() throw length_error.
                 if (new_size > size_)
                 {
-                    ensure_free_space_(new_size - size_ + 1);
+                    ensure_free_space_(new_size - size_);
                     for (size_type i = size_; i < new_size; ++i)
-                        traits_type::assign(data_[i], i);
+                        traits_type::assign(data_[i], c);
                 }
 
                 size_ = new_size;
@@ -720,7 +715,8 @@ namespace std
 
             size_type capacity() const noexcept
             {
-                return capacity_;
+                // The null terminator does not count.
+                return allocated_() - 1;
             }
 
             void reserve(size_type new_capacity = 0)
@@ -728,21 +724,39 @@ namespace std
                 // TODO: if new_capacity > max_size() throw
                 //       length_error (this function shall have no
                 //       effect in such case)
-                if (new_capacity > capacity_)
-                    resize_with_copy_(size_, new_capacity);
-                else if (new_capacity < capacity_)
+                if (new_capacity > capacity())
+                    resize_with_copy_(size_, new_capacity + 1);
+                else if (new_capacity < capacity())
                     shrink_to_fit(); // Non-binding request, but why not.
             }
 
             void shrink_to_fit()
             {
-                if (size_ != capacity_)
-                    resize_with_copy_(size_, capacity_);
+                if (is_local_())
+                    return;
+
+                auto old_data = data_;
+                auto old_capacity = capacity_;
+                if (size_ <= local_capacity_)
+                {
+                    // Note: This overwrites capacity_, hence the copies above.
+                    data_ = local_;
+                    traits_type::copy(data_, old_data, size_ + 1);
+                    allocator_.deallocate(old_data, old_capacity);
+                }
+                else if (size_ + 1 < capacity_)
+                {
+                    data_ = allocator_.allocate(size_ + 1);
+                    capacity_ = size_ + 1;
+                    traits_type::copy(data_, old_data, size_ + 1);
+                    allocator_.deallocate(old_data, old_capacity);
+                }
             }
 
             void clear() noexcept
             {
                 size_ = 0;
+                ensure_null_terminator_();
             }
 
             bool empty() const noexcept
@@ -884,9 +898,7 @@ namespace std
 
             basic_string& assign(basic_string&& str)
             {
-                swap(str);
-
-                return *this;
+                return *this = move(str);
             }
 
             basic_string& assign(const basic_string& str, size_type pos,
@@ -895,7 +907,6 @@ namespace std
                 if (pos < str.size())
                 {
                     auto len = min(n, str.size() - pos);
-                    ensure_free_space_(len);
 
                     return assign(str.data() + pos, len);
                 }
@@ -907,8 +918,19 @@ namespace std
             basic_string& assign(const value_type* str, size_type n)
             {
                 // TODO: if (n > max_size()) throw length_error.
-                resize_without_copy_(n + 1);
-                traits_type::copy(begin(), str, n);
+                if (n + 1 > allocated_())
+                {
+                    // Copy first, str can point into our old buffer.
+                    auto new_data = allocator_.allocate(n + 1);
+                    traits_type::copy(new_data, str, n);
+
+                    release_();
+                    data_ = new_data;
+                    capacity_ = n + 1;
+                }
+                else
+                    traits_type::move(data_, str, n);
+
                 size_ = n;
                 ensure_null_terminator_();
 
@@ -1083,7 +1105,7 @@ namespace std
                 auto len = min(n1, size_ - pos);
 
                 basic_string tmp{};
-                tmp.resize_without_copy_(size_ - len + n2);
+                tmp.resize_without_copy_(size_ - len + n2 + 1);
 
                 // Prefix.
                 copy_(begin(), begin() + pos, tmp.begin());
@@ -1095,6 +1117,7 @@ namespace std
                 copy_(begin() + pos + len, end(), tmp.begin() + pos + n2);
 
                 tmp.size_ = size_ - len + n2;
+                tmp.ensure_null_terminator_();
                 swap(tmp);
                 return *this;
             }
@@ -1160,9 +1183,26 @@ namespace std
                 noexcept(allocator_traits<allocator_type>::propagate_on_container_swap::value ||
                          allocator_traits<allocator_type>::is_always_equal::value)
             {
-                std::swap(data_, other.data_);
-                std::swap(size_, other.size_);
-                std::swap(capacity_, other.capacity_);
+                if (this == &other)
+                    return;
+
+                if (!is_local_() && !other.is_local_())
+                {
+                    std::swap(data_, other.data_);
+                    std::swap(size_, other.size_);
+                    std::swap(capacity_, other.capacity_);
+
+                    return;
+                }
+
+                /**
+                 * Note: A local buffer cannot change owners,
+                 *       so we move its contents instead. None
+                 *       of the steals below allocates.
+                 */
+                basic_string tmp{move(other)};
+                other.steal_(*this);
+                steal_(tmp);
             }
 
             /**
@@ -1476,41 +1516,108 @@ namespace std
             }
 
         private:
+            /**
+             * Strings of up to this many characters are stored
+             * in the string object itself (where the capacity
+             * would otherwise be) and do not allocate at all.
+             * Note: The local buffer is larger than the capacity
+             *       it shares storage with, so on 64-bit targets
+             *       sizeof(basic_string) grows from 32 to 40 bytes.
+             */
+            static constexpr size_type local_capacity_{15 / sizeof(value_type)};
+
             value_type* data_;
             size_type size_;
-            size_type capacity_;
+            union
+            {
+                // Includes the null terminator, valid only if !is_local_().
+                size_type capacity_;
+                value_type local_[local_capacity_ + 1];
+            };
             allocator_type allocator_;
 
             template<class C, class T, class A>
             friend class basic_stringbuf;
 
+            bool is_local_() const noexcept
+            {
+                return data_ == local_;
+            }
+
+            size_type allocated_() const noexcept
+            {
+                return is_local_() ? local_capacity_ + 1 : capacity_;
+            }
+
+            void release_() noexcept
+            {
+                if (!is_local_())
+                    allocator_.deallocate(data_, capacity_);
+            }
+
             /**
-             * Arbitrary value, standard just requires
-             * data() to have some capacity.
-             * (Well, we could've done data_ = &data_ and
-             * set capacity to 0, but that would be too cryptic.)
+             * Takes over the contents of other, leaving it empty.
+             * Expects that we do not own any memory at this point.
              */
-            static constexpr size_type default_capacity_{4};
+            void steal_(basic_string& other) noexcept
+            {
+                if (other.is_local_())
+                {
+                    data_ = local_;
+                    traits_type::copy(data_, other.data_, other.size_ + 1);
+                }
+                else
+                {
+                    data_ = other.data_;
+                    capacity_ = other.capacity_;
+                }
+                size_ = other.size_;
 
-            void init_(const value_type* str, size_type size)
+                other.data_ = other.local_;
+                other.size_ = 0;
+                other.ensure_null_terminator_();
+            }
+
+            /**
+             * Sets up storage for size characters in a string
+             * under construction, without initializing them.
+             */
+            void init_storage_(size_type size)
             {
-                if (data_)
-                    allocator_.deallocate(data_, capacity_);
+                if (size > local_capacity_)
+                {
+                    data_ = allocator_.allocate(size + 1);
+                    capacity_ = size + 1;
+                }
+                else
+                    data_ = local_;
 
                 size_ = size;
-                capacity_ = size + 1;
+            }
 
-                data_ = allocator_.allocate(capacity_);
+            void init_(const value_type* str, size_type size)
+            {
+                init_storage_(size);
                 traits_type::copy(data_, str, size);
                 ensure_null_terminator_();
             }
 
+            /**
+             * Used by basic_stringbuf, whose get and put areas point
+             * into its string and have to survive moves of the string.
+             */
+            void ensure_not_local_()
+            {
+                if (is_local_())
+                    resize_with_copy_(size_, local_capacity_ + 2);
+            }
+
             size_type next_capacity_(size_type hint = 0) const noexcept
             {
                 if (hint != 0)
-                    return max(capacity_ * 2, hint);
+                    return max(allocated_() * 2, hint);
                 else
-                    return max(capacity_ * 2, size_type{2u});
+                    return max(allocated_() * 2, size_type{2u});
             }
 
             void ensure_free_space_(size_type n)
@@ -1520,36 +1627,39 @@ namespace std
                  *       did in vector, because in string
                  *       reserve can cause shrinking.
                  */
-                if (size_ + 1 + n > capacity_)
+                if (size_ + 1 + n > allocated_())
                     resize_with_copy_(size_, max(size_ + 1 + n, next_capacity_()));
             }
 
             void resize_without_copy_(size_type capacity)
             {
-                if (data_)
-                    allocator_.deallocate(data_, capacity_);
+                if (capacity > allocated_())
+                {
+                    auto new_data = allocator_.allocate(capacity);
+
+                    release_();
+                    data_ = new_data;
+                    capacity_ = capacity;
+                }
 
-                data_ = allocator_.allocate(capacity);
                 size_ = 0;
-                capacity_ = capacity;
                 ensure_null_terminator_();
             }
 
             void resize_with_copy_(size_type size, size_type capacity)
             {
-                if(capacity_ == 0 || capacity_ < capacity)
+                if (capacity > allocated_())
                 {
                     auto new_data = allocator_.allocate(capacity);
 
                     auto to_copy = min(size, size_);
-                    traits_type::move(new_data, data_, to_copy);
-
-                    std::swap(data_, new_data);
+                    traits_type::copy(new_data, data_, to_copy);
 
-                    allocator_.deallocate(new_data, capacity_);
+                    release_();
+                    data_ = new_data;
+                    capacity_ = capacity;
                 }
 
-                capacity_ = capacity;
                 size_ = size;
                 ensure_null_terminator_();
             }
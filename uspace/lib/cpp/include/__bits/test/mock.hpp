@@ -30,6 +30,7 @@
 #define LIBCPP_BITS_TEST_MOCK
 
 #include <cstdlib>
+#include <new>
 #include <tuple>
 
 namespace std::test
@@ -75,6 +76,50 @@ namespace std::test
             move_constructor_calls = size_t{};
         }
     };
+
+    /**
+     * Allocator that counts the calls to allocate and
+     * deallocate, so that we can check when a container
+     * (e.g. a short string) does not touch the heap at all.
+     * The counters are shared by all value types.
+     */
+    struct mock_allocator_calls
+    {
+        static size_t allocations;
+        static size_t deallocations;
+
+        static void clear()
+        {
+            allocations = size_t{};
+            deallocations = size_t{};
+        }
+    };
+
+    template<class T>
+    struct mock_allocator
+    {
+        using value_type = T;
+
+        mock_allocator() = default;
+
+        template<class U>
+        mock_allocator(const mock_allocator<U>&)
+        { /* DUMMY BODY */ }
+
+        T* allocate(size_t n)
+        {
+            ++mock_allocator_calls::allocations;
+
+            return static_cast<T*>(::operator new(n * sizeof(T)));
+        }
+
+        void deallocate(T* ptr, size_t)
+        {
+            ++mock_allocator_calls::deallocations;
+
+            ::operator delete(ptr);
+        }
+    };
 }
 
 #endif
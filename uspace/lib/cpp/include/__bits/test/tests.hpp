@@ -123,6 +123,8 @@ namespace std::test
             void test_find();
             void test_substr();
             void test_compare();
+            void test_capacity();
+            void test_allocations();
     };
 
     class bitset_test: public test_suite
@@ -205,6 +207,9 @@ namespace std::test
             void test_histogram();
             void test_emplace_insert();
             void test_multi();
+            void test_rehash_and_reserve();
+            void test_buckets();
+            void test_benchmark();
     };
 
     class unordered_set_test: public test_suite
@@ -293,6 +298,10 @@ namespace std::test
         private:
             void test_non_modifying();
             void test_mutating();
+            void test_sorting();
+            void test_heap();
+            void test_binary_search();
+            void test_benchmark();
     };
 
     class future_test: public test_suite
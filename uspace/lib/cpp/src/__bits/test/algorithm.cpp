@@ -29,11 +29,66 @@
 #include <__bits/test/tests.hpp>
 #include <algorithm>
 #include <array>
+#include <chrono>
+#include <cstdio>
+#include <functional>
 #include <string>
 #include <utility>
+#include <vector>
 
 namespace std::test
 {
+    namespace
+    {
+        /**
+         * Simple LCG so that the sort tests and benchmarks
+         * are reproducible and do not depend on rand().
+         */
+        struct sort_rng
+        {
+            unsigned int state;
+
+            unsigned int operator()()
+            {
+                state = state * 1103515245U + 12345U;
+
+                return state >> 8;
+            }
+        };
+
+        struct sort_record
+        {
+            int key;
+            int order;
+
+            bool operator<(const sort_record& other) const
+            {
+                return key < other.key;
+            }
+        };
+
+        template<class T, class Sort>
+        unsigned long long bench_sort(const std::vector<T>& src, Sort sort)
+        {
+            /**
+             * Note: Element-wise assignment into a default
+             *       constructed vector, so that every run
+             *       gets its own copy of the unsorted data.
+             */
+            std::vector<T> data(src.size());
+            for (std::size_t i = 0; i < src.size(); ++i)
+                data[i] = src[i];
+
+            auto start = std::chrono::steady_clock::now();
+            sort(data);
+            auto end = std::chrono::steady_clock::now();
+
+            return std::chrono::duration_cast<std::chrono::microseconds>(
+                end - start
+            ).count();
+        }
+    }
+
     bool algorithm_test::run(bool report)
     {
         report_ = report;
@@ -41,6 +96,10 @@ namespace std::test
 
         test_non_modifying();
         test_mutating();
+        test_sorting();
+        test_heap();
+        test_binary_search();
+        test_benchmark();
 
         return end();
     }
@@ -293,4 +352,213 @@ namespace std::test
         );
         test_eq("transform pt2", res6, data10.end());
     }
+
+    void algorithm_test::test_sorting()
+    {
+        auto check1 = {1, 2, 3, 4, 5, 6, 7, 8, 9};
+        std::array<int, 9> data1{5, 9, 1, 8, 2, 7, 3, 6, 4};
+
+        std::sort(data1.begin(), data1.end());
+        test_eq(
+            "sort small", check1.begin(), check1.end(),
+            data1.begin(), data1.end()
+        );
+
+        auto check2 = {9, 8, 7, 6, 5, 4, 3, 2, 1};
+        std::sort(data1.begin(), data1.end(), std::greater<int>{});
+        test_eq(
+            "sort comp", check2.begin(), check2.end(),
+            data1.begin(), data1.end()
+        );
+
+        sort_rng rng{42};
+        std::vector<int> data2(1000);
+        for (auto& x: data2)
+            x = rng() % 100;
+        std::sort(data2.begin(), data2.end());
+        test("sort random", std::is_sorted(data2.begin(), data2.end()));
+
+        // Sorted, reversed and constant inputs are the usual quicksort killers.
+        std::vector<int> data3(1000);
+        for (std::size_t i = 0; i < data3.size(); ++i)
+            data3[i] = static_cast<int>(data3.size() - i);
+        std::sort(data3.begin(), data3.end());
+        test("sort reversed", std::is_sorted(data3.begin(), data3.end()));
+
+        std::sort(data3.begin(), data3.end());
+        test("sort sorted", std::is_sorted(data3.begin(), data3.end()));
+
+        std::vector<int> data4(std::size_t{1000}, 7);
+        std::sort(data4.begin(), data4.end());
+        test_eq("sort constant", std::count(data4.begin(), data4.end(), 7), 1000);
+
+        auto check3 = {
+            std::string{"apple"}, std::string{"banana"},
+            std::string{"cherry"}, std::string{"date"}
+        };
+        std::array<std::string, 4> data5{"date", "banana", "apple", "cherry"};
+        std::sort(data5.begin(), data5.end());
+        test_eq(
+            "sort strings", check3.begin(), check3.end(),
+            data5.begin(), data5.end()
+        );
+
+        std::vector<sort_record> data6(500);
+        for (std::size_t i = 0; i < data6.size(); ++i)
+            data6[i] = sort_record{static_cast<int>(rng() % 10), static_cast<int>(i)};
+        std::stable_sort(data6.begin(), data6.end());
+
+        bool stable{true};
+        for (std::size_t i = 1; i < data6.size(); ++i)
+        {
+            if (data6[i].key < data6[i - 1].key)
+                stable = false;
+            else if (data6[i].key == data6[i - 1].key &&
+                     data6[i].order < data6[i - 1].order)
+                stable = false;
+        }
+        test("stable_sort", stable);
+
+        auto check4 = {1, 2, 3, 4};
+        std::array<int, 9> data7{5, 9, 1, 8, 2, 7, 3, 6, 4};
+        std::partial_sort(data7.begin(), data7.begin() + 4, data7.end());
+        test_eq(
+            "partial_sort", check4.begin(), check4.end(),
+            data7.begin(), data7.begin() + 4
+        );
+
+        std::array<int, 9> data8{5, 9, 1, 8, 2, 7, 3, 6, 4};
+        std::array<int, 4> data9{};
+        auto res1 = std::partial_sort_copy(
+            data8.begin(), data8.end(),
+            data9.begin(), data9.end()
+        );
+        test_eq(
+            "partial_sort_copy pt1", check4.begin(), check4.end(),
+            data9.begin(), data9.end()
+        );
+        test_eq("partial_sort_copy pt2", res1, data9.end());
+
+        auto check5 = {1, 2, 3};
+        std::array<int, 3> data10{3, 1, 2};
+        std::array<int, 5> data11{};
+        auto res2 = std::partial_sort_copy(
+            data10.begin(), data10.end(),
+            data11.begin(), data11.end()
+        );
+        test_eq(
+            "partial_sort_copy pt3", check5.begin(), check5.end(),
+            data11.begin(), res2
+        );
+
+        test_eq(
+            "is_sorted_until",
+            std::is_sorted_until(data8.begin(), data8.end()),
+            &data8[2]
+        );
+    }
+
+    void algorithm_test::test_heap()
+    {
+        sort_rng rng{7};
+        std::vector<int> data1(257);
+        for (auto& x: data1)
+            x = rng() % 50;
+
+        std::make_heap(data1.begin(), data1.end());
+        test("make_heap", std::is_heap(data1.begin(), data1.end()));
+
+        data1.push_back(100);
+        std::push_heap(data1.begin(), data1.end());
+        test_eq("push_heap pt1", data1.front(), 100);
+        test("push_heap pt2", std::is_heap(data1.begin(), data1.end()));
+
+        std::pop_heap(data1.begin(), data1.end());
+        test_eq("pop_heap pt1", data1.back(), 100);
+        data1.pop_back();
+        test("pop_heap pt2", std::is_heap(data1.begin(), data1.end()));
+
+        std::sort_heap(data1.begin(), data1.end());
+        test("sort_heap", std::is_sorted(data1.begin(), data1.end()));
+    }
+
+    void algorithm_test::test_binary_search()
+    {
+        std::array<int, 8> data1{1, 2, 2, 2, 4, 5, 7, 9};
+
+        test_eq("lower_bound pt1", std::lower_bound(data1.begin(), data1.end(), 2), &data1[1]);
+        test_eq("lower_bound pt2", std::lower_bound(data1.begin(), data1.end(), 3), &data1[4]);
+        test_eq("lower_bound pt3", std::lower_bound(data1.begin(), data1.end(), 10), data1.end());
+        test_eq("upper_bound pt1", std::upper_bound(data1.begin(), data1.end(), 2), &data1[4]);
+        test_eq("upper_bound pt2", std::upper_bound(data1.begin(), data1.end(), 0), data1.begin());
+
+        auto check1 = {3, 4, 5, 6, 7, 1, 2};
+        std::array<int, 7> data2{1, 2, 3, 4, 5, 6, 7};
+        auto res1 = std::rotate(data2.begin(), data2.begin() + 2, data2.end());
+        test_eq(
+            "rotate pt1", check1.begin(), check1.end(),
+            data2.begin(), data2.end()
+        );
+        test_eq("rotate pt2", res1, &data2[5]);
+    }
+
+    void algorithm_test::test_benchmark()
+    {
+        /**
+         * Compares std::sort with the heap sort it used to be
+         * implemented as (make_heap followed by sort_heap).
+         */
+        constexpr std::size_t int_count{1000000};
+        constexpr std::size_t string_count{100000};
+
+        sort_rng rng{1};
+        std::vector<int> ints(int_count);
+        for (auto& x: ints)
+            x = static_cast<int>(rng());
+
+        std::vector<std::string> strings(string_count);
+        char buffer[16];
+        for (auto& str: strings)
+        {
+            std::snprintf(buffer, sizeof(buffer), "%08x", rng());
+            str = buffer;
+        }
+
+        auto heap_ints = bench_sort(ints, [](auto& data){
+            std::make_heap(data.begin(), data.end());
+            std::sort_heap(data.begin(), data.end());
+        });
+        auto intro_ints = bench_sort(ints, [](auto& data){
+            std::sort(data.begin(), data.end());
+        });
+        auto stable_ints = bench_sort(ints, [](auto& data){
+            std::stable_sort(data.begin(), data.end());
+        });
+
+        auto heap_strings = bench_sort(strings, [](auto& data){
+            std::make_heap(data.begin(), data.end());
+            std::sort_heap(data.begin(), data.end());
+        });
+        auto intro_strings = bench_sort(strings, [](auto& data){
+            std::sort(data.begin(), data.end());
+        });
+        auto stable_strings = bench_sort(strings, [](auto& data){
+            std::stable_sort(data.begin(), data.end());
+        });
+
+        std::sort(ints.begin(), ints.end());
+        test("benchmark ints sorted", std::is_sorted(ints.begin(), ints.end()));
+
+        if (report_)
+        {
+            std::printf(
+                "[%s][benchmark] %zu ints: heap %llu us, sort %llu us, stable_sort %llu us\n",
+                name(), int_count, heap_ints, intro_ints, stable_ints
+            );
+            std::printf(
+                "[%s][benchmark] %zu strings: heap %llu us, sort %llu us, stable_sort %llu us\n",
+                name(), string_count, heap_strings, intro_strings, stable_strings
+            );
+        }
+    }
 }
@@ -34,4 +34,7 @@ namespace std::test
     size_t mock::copy_constructor_calls{};
     size_t mock::destructor_calls{};
     size_t mock::move_constructor_calls{};
+
+    size_t mock_allocator_calls::allocations{};
+    size_t mock_allocator_calls::deallocations{};
 }
@@ -27,9 +27,11 @@
  */
 
 #include <initializer_list>
+#include <__bits/test/mock.hpp>
 #include <__bits/test/tests.hpp>
 #include <string>
 #include <cstdio>
+#include <utility>
 
 namespace std::test
 {
@@ -47,6 +49,8 @@ namespace std::test
         test_find();
         test_substr();
         test_compare();
+        test_capacity();
+        test_allocations();
 
         return end();
     }
@@ -703,4 +707,120 @@ namespace std::test
             res, 0
         );
     }
+
+    void string_test::test_capacity()
+    {
+        std::string check1{"hello"};
+        std::string str1{"hello"};
+
+        str1.reserve(100);
+        test("reserve grows", str1.capacity() >= 100ul);
+        test_eq(
+            "reserve keeps contents",
+            str1.begin(), str1.end(),
+            check1.begin(), check1.end()
+        );
+
+        str1.shrink_to_fit();
+        test("shrink_to_fit", str1.capacity() < 100ul);
+        test_eq(
+            "shrink_to_fit keeps contents",
+            str1.begin(), str1.end(),
+            check1.begin(), check1.end()
+        );
+        test_eq("shrink_to_fit null terminator", str1.c_str()[5], '\0');
+
+        std::string check2{"this string is too long to be stored inline"};
+        std::string str2{check2};
+        std::string str3{"short"};
+
+        str2.swap(str3);
+        test_eq(
+            "swap long into short",
+            str3.begin(), str3.end(),
+            check2.begin(), check2.end()
+        );
+        test_eq("swap short into long", str2, std::string{"short"});
+
+        str2 = str3;
+        test_eq("copy assign long", str2, check2);
+
+        str2 = "tiny";
+        test_eq("assign short over long", str2, std::string{"tiny"});
+
+        str3 = std::move(str2);
+        test_eq("move assign short", str3, std::string{"tiny"});
+        test("move assign source empty", str2.empty());
+
+        std::string str4{};
+        for (int i = 0; i < 100; ++i)
+            str4.push_back('a' + (i % 26));
+        test_eq("push_back grow size", str4.size(), 100ul);
+        test_eq("push_back grow contents", str4[26], 'a');
+
+        str4.resize(3);
+        str4.resize(5, 'x');
+        test_eq("resize", str4, std::string{"abcxx"});
+    }
+
+    void string_test::test_allocations()
+    {
+        using mock_string = std::basic_string<
+            char, std::char_traits<char>, std::test::mock_allocator<char>
+        >;
+
+        mock_allocator_calls::clear();
+        {
+            mock_string str1{};
+            mock_string str2{"short"};
+            mock_string str3{str2};
+            mock_string str4{std::move(str3)};
+
+            str1 = str2;
+            str1.append(" str");
+            str1.push_back('!');
+            str3 = std::move(str1);
+            str3.swap(str4);
+            str4.assign("other");
+            str4.clear();
+
+            test_eq("short strings", str3, mock_string{"short"});
+        }
+        test_eq(
+            "short strings do not allocate",
+            mock_allocator_calls::allocations, 0ul
+        );
+
+        mock_allocator_calls::clear();
+        {
+            mock_string str1{"this string is too long to be stored inline"};
+            test_eq("long string allocates", mock_allocator_calls::allocations, 1ul);
+
+            mock_string str2{std::move(str1)};
+            mock_string str3{"short"};
+            str3.swap(str2);
+            str2 = std::move(str3);
+            test_eq(
+                "long string moves do not allocate",
+                mock_allocator_calls::allocations, 1ul
+            );
+
+            str2.assign("short again");
+            test_eq(
+                "assign reuses buffer",
+                mock_allocator_calls::allocations, 1ul
+            );
+
+            str2.shrink_to_fit();
+            test_eq(
+                "shrink_to_fit into local buffer",
+                mock_allocator_calls::deallocations, 1ul
+            );
+        }
+        test_eq(
+            "allocations balanced",
+            mock_allocator_calls::allocations,
+            mock_allocator_calls::deallocations
+        );
+    }
 }
@@ -27,7 +27,10 @@
  */
 
 #include <__bits/test/tests.hpp>
+#include <chrono>
+#include <cstdio>
 #include <initializer_list>
+#include <iterator>
 #include <unordered_map>
 #include <string>
 #include <sstream>
@@ -35,6 +38,69 @@
 
 namespace std::test
 {
+    namespace
+    {
+        using bench_value = std::pair<const unsigned int, unsigned int>;
+
+        /**
+         * Bare tables for both storage policies, so that
+         * we can compare them with the same element type.
+         */
+        template<class Policy>
+        using bench_table = typename Policy::template table<
+            bench_value, unsigned int,
+            std::aux::key_value_key_extractor<unsigned int, unsigned int>,
+            std::hash<unsigned int>, std::equal_to<unsigned int>,
+            std::allocator<bench_value>, std::size_t,
+            typename Policy::template iterator<
+                bench_value, bench_value&, bench_value*, std::size_t
+            >,
+            typename Policy::template const_iterator<
+                bench_value, const bench_value&, const bench_value*, std::size_t
+            >,
+            typename Policy::template local_iterator<
+                bench_value, bench_value&, bench_value*
+            >,
+            typename Policy::template const_local_iterator<
+                bench_value, const bench_value&, const bench_value*
+            >
+        >;
+
+        template<class Policy>
+        unsigned long long bench_run(unsigned int count, std::size_t& found)
+        {
+            auto start = std::chrono::steady_clock::now();
+
+            bench_table<Policy> table{16};
+            for (unsigned int i = 0; i < count; ++i)
+                table.insert(bench_value{i * 7919U, i});
+
+            // Every other lookup is a miss.
+            for (unsigned int i = 0; i < 2 * count; ++i)
+            {
+                auto it = table.find(i * 7919U / 2);
+                if (it != table.end())
+                    ++found;
+            }
+
+            for (unsigned int i = 0; i < count; i += 2)
+                table.erase(i * 7919U);
+
+            for (unsigned int i = 0; i < count; ++i)
+            {
+                auto it = table.find(i * 7919U);
+                if (it != table.end())
+                    ++found;
+            }
+
+            auto end = std::chrono::steady_clock::now();
+
+            return std::chrono::duration_cast<std::chrono::microseconds>(
+                end - start
+            ).count();
+        }
+    }
+
     bool unordered_map_test::run(bool report)
     {
         report_ = report;
@@ -44,6 +110,9 @@ namespace std::test
         test_histogram();
         test_emplace_insert();
         test_multi();
+        test_rehash_and_reserve();
+        test_buckets();
+        test_benchmark();
 
         return end();
     }
@@ -263,4 +332,149 @@ namespace std::test
         test_eq("multi erase by iterator pt1", res7->first, 7);
         test_eq("multi erase by iterator pt2", mmap.count(7), 1U);
     }
+
+    void unordered_map_test::test_rehash_and_reserve()
+    {
+        std::aux::flat_unordered_map<int, int> map1{};
+
+        map1.reserve(1000);
+        auto buckets = map1.bucket_count();
+        for (int i = 0; i < 1000; ++i)
+            map1.emplace(i, 2 * i);
+        test_eq("reserve size", map1.size(), 1000U);
+        test_eq("reserve prevents rehash", map1.bucket_count(), buckets);
+        test("reserve load factor", map1.load_factor() <= map1.max_load_factor());
+
+        for (int i = 0; i < 1000; i += 2)
+            map1.erase(i);
+        test_eq("erase every other size", map1.size(), 500U);
+
+        bool ok{true};
+        for (int i = 0; i < 1000; ++i)
+        {
+            auto it = map1.find(i);
+            if (i % 2 == 0)
+                ok &= (it == map1.end());
+            else
+                ok &= (it != map1.end() && it->second == 2 * i);
+        }
+        test("lookup after erase", ok);
+
+        map1.rehash(0);
+        test("rehash shrinks", map1.bucket_count() < buckets);
+        test_eq("rehash size", map1.size(), 500U);
+        test_eq(
+            "iteration after rehash",
+            static_cast<std::size_t>(std::distance(map1.begin(), map1.end())), 500U
+        );
+
+        ok = true;
+        for (int i = 1; i < 1000; i += 2)
+            ok &= (map1.count(i) == 1U);
+        test("lookup after rehash", ok);
+
+        /**
+         * Repeated insertions and removals must not
+         * grow the table indefinitely.
+         */
+        buckets = map1.bucket_count();
+        for (int i = 0; i < 10000; ++i)
+        {
+            map1.emplace(-i - 1, i);
+            map1.erase(-i - 1);
+        }
+        test_eq("churn size", map1.size(), 500U);
+        test_eq("churn bucket count", map1.bucket_count(), buckets);
+
+        map1.max_load_factor(0.5f);
+        test("max load factor", map1.load_factor() <= 0.5f);
+        test_eq("max load factor size", map1.size(), 500U);
+
+        /**
+         * Insertions after lowering the maximal load factor
+         * must grow the table rather than fill it up.
+         */
+        for (int i = 1000; i < 3000; ++i)
+            map1.emplace(i, 2 * i);
+        test_eq("insert after max load factor size", map1.size(), 2500U);
+        test(
+            "insert after max load factor load",
+            map1.load_factor() <= 0.5f
+        );
+
+        ok = true;
+        for (int i = 1000; i < 3000; ++i)
+        {
+            auto it = map1.find(i);
+            ok &= (it != map1.end() && it->second == 2 * i);
+        }
+        test("lookup after max load factor", ok);
+
+        /**
+         * The default (chained) table must keep references
+         * to elements valid across rehashing.
+         */
+        std::unordered_map<int, int> map4{};
+        map4[1] = 1;
+        auto ptr = &map4[1];
+        for (int i = 2; i < 1000; ++i)
+            map4[i] = i;
+        test("references survive rehash", ptr == &map4[1] && *ptr == 1);
+
+        std::unordered_map<std::string, std::string> map2{};
+        for (int i = 0; i < 100; ++i)
+            map2[std::to_string(i)] = std::to_string(i * i);
+        auto map3 = map2;
+        map2.clear();
+        test_eq("copy after clear", map3.size(), 100U);
+        test_eq("copy content", map3["12"], std::string{"144"});
+        test_eq("clear keeps table usable", map2.insert_or_assign("a", "b").second, true);
+    }
+
+    void unordered_map_test::test_buckets()
+    {
+        std::unordered_map<int, int> map1{};
+        for (int i = 0; i < 100; ++i)
+            map1.emplace(i, i);
+
+        bool ok{true};
+        std::size_t total{};
+        for (int i = 0; i < 100; ++i)
+        {
+            auto n = map1.bucket(i);
+            ok &= (n < map1.bucket_count());
+
+            bool found{false};
+            for (auto it = map1.begin(n); it != map1.end(n); ++it)
+                found |= (it->first == i);
+            ok &= found;
+        }
+        test("bucket contains key", ok);
+
+        for (std::size_t n = 0; n < map1.bucket_count(); ++n)
+            total += map1.bucket_size(n);
+        test_eq("bucket sizes", total, 100U);
+    }
+
+    void unordered_map_test::test_benchmark()
+    {
+        constexpr unsigned int count{100000};
+
+        std::size_t chained_found{};
+        auto chained = bench_run<std::aux::hash_single_policy>(count, chained_found);
+
+        std::size_t flat_found{};
+        auto flat = bench_run<std::aux::hash_flat_single_policy>(count, flat_found);
+
+        test_eq("benchmark chained lookups", chained_found, count + count / 2);
+        test_eq("benchmark flat lookups", flat_found, count + count / 2);
+
+        if (report_)
+        {
+            std::printf(
+                "[%s][benchmark] %u elements: chained %llu us, flat %llu us\n",
+                name(), count, chained, flat
+            );
+        }
+    }
 }
@@ -42,9 +42,28 @@
 typedef enum {
 	NIC_EV_ADDR_CHANGED = IPC_FIRST_USER_METHOD,
 	NIC_EV_RECEIVED,
-	NIC_EV_DEVICE_STATE
+	NIC_EV_DEVICE_STATE,
+	NIC_EV_RX_BUFFER,
+	NIC_EV_RECEIVED_BATCH
 } nic_event_t;
 
+/** Size of the buffer shared with the client for batched frame delivery */
+#define NIC_RX_BUFFER_SIZE  (256 * 1024)
+
+/** Alignment of frame records in the shared receive buffer */
+#define NIC_RX_FRAME_ALIGN  8
+
+/** Header of a frame record in the shared receive buffer.
+ *
+ * The frame data immediately follow the header. The next record starts
+ * at the next multiple of NIC_RX_FRAME_ALIGN bytes.
+ */
+typedef struct {
+	/** Frame size in bytes */
+	uint32_t size;
+	uint32_t reserved;
+} nic_rx_frame_hdr_t;
+
 extern errno_t nic_send_frame(async_sess_t *, void *, size_t);
 extern errno_t nic_callback_create(async_sess_t *, async_port_handler_t, void *);
 extern errno_t nic_get_state(async_sess_t *, nic_device_state_t *);
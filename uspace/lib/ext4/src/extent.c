@@ -36,6 +36,7 @@
 
 #include <byteorder.h>
 #include <errno.h>
+#include <macros.h>
 #include <mem.h>
 #include <stdlib.h>
 #include "ext4/balloc.h"
@@ -43,6 +44,9 @@
 #include "ext4/inode.h"
 #include "ext4/superblock.h"
 
+/** Number of data blocks of an extent prefetched at once */
+#define EXT4_EXTENT_PREFETCH  16
+
 /** Get logical number of the block covered by extent.
  *
  * @param extent Extent to load number from
@@ -432,6 +436,23 @@ errno_t ext4_extent_find_block(ext4_inode_ref_t *inode_ref, uint32_t iblock,
 		phys_block = ext4_extent_get_start(extent) + iblock - first;
 
 		*fblock = phys_block;
+
+		/*
+		 * Blocks of an extent are contiguous on the device. Whenever
+		 * a new prefetch window of the extent is entered, have the
+		 * rest of the window (within the extent and the i-node size)
+		 * read ahead.
+		 */
+		uint32_t offset = iblock - first;
+		uint32_t count = ext4_extent_get_block_count(extent);
+		if ((offset % EXT4_EXTENT_PREFETCH) == 0 && offset + 1 < count) {
+			uint32_t ahead = min(EXT4_EXTENT_PREFETCH - 1,
+			    min(count - offset - 1, last_idx - iblock));
+			if (ahead > 0) {
+				(void) block_prefetch(inode_ref->fs->device,
+				    phys_block + 1, ahead);
+			}
+		}
 	}
 
 	/* Cleanup */
@@ -36,15 +36,18 @@
 #define _LIBIPCTEST_H_
 
 #include <async.h>
+#include <async_ring.h>
 #include <errno.h>
 
 typedef struct {
 	async_sess_t *sess;
+	async_ring_t *ring;
 } ipc_test_t;
 
 extern errno_t ipc_test_create(ipc_test_t **);
 extern void ipc_test_destroy(ipc_test_t *);
 extern errno_t ipc_test_ping(ipc_test_t *);
+extern errno_t ipc_test_ping_batch(ipc_test_t *, size_t);
 extern errno_t ipc_test_get_ro_area_size(ipc_test_t *, size_t *);
 extern errno_t ipc_test_get_rw_area_size(ipc_test_t *, size_t *);
 extern errno_t ipc_test_share_in_ro(ipc_test_t *, size_t, const void **);
@@ -52,6 +55,8 @@ extern errno_t ipc_test_share_in_rw(ipc_test_t *, size_t, void **);
 extern errno_t ipc_test_set_rw_buf_size(ipc_test_t *, size_t);
 extern errno_t ipc_test_read(ipc_test_t *, void *, size_t);
 extern errno_t ipc_test_write(ipc_test_t *, const void *, size_t);
+extern errno_t ipc_test_ring_open(ipc_test_t *, size_t);
+extern errno_t ipc_test_ring_ping(ipc_test_t *, uint64_t);
 
 #endif
 
@@ -87,6 +87,7 @@ void ipc_test_destroy(ipc_test_t *test)
 	if (test == NULL)
 		return;
 
+	async_ring_destroy(test->ring);
 	async_hangup(test->sess);
 	free(test);
 }
@@ -111,6 +112,56 @@ errno_t ipc_test_ping(ipc_test_t *test)
 	return EOK;
 }
 
+/** Send a batch of pings at once.
+ *
+ * All pings are sent first, using as few system calls as possible, and
+ * only then are the answers waited for.
+ *
+ * @param test IPC test service
+ * @param count Number of pings
+ * @return EOK on success or an error code
+ */
+errno_t ipc_test_ping_batch(ipc_test_t *test, size_t count)
+{
+	async_exch_t *exch;
+	ipc_call_t *reqs;
+	aid_t *aids;
+	errno_t retval;
+	errno_t rc;
+	size_t i;
+
+	reqs = calloc(count, sizeof(ipc_call_t));
+	aids = calloc(count, sizeof(aid_t));
+	if (reqs == NULL || aids == NULL) {
+		free(reqs);
+		free(aids);
+		return ENOMEM;
+	}
+
+	for (i = 0; i < count; i++)
+		ipc_set_imethod(&reqs[i], IPC_TEST_PING);
+
+	exch = async_exchange_begin(test->sess);
+	async_send_batch(exch, count, reqs, NULL, aids);
+	async_exchange_end(exch);
+
+	rc = EOK;
+	for (i = 0; i < count; i++) {
+		if (aids[i] == 0) {
+			rc = ENOMEM;
+			continue;
+		}
+
+		async_wait_for(aids[i], &retval);
+		if (retval != EOK)
+			rc = retval;
+	}
+
+	free(reqs);
+	free(aids);
+	return rc;
+}
+
 /** Get size of shared read-only memory area.
  *
  * @param test IPC test service
@@ -299,5 +350,66 @@ errno_t ipc_test_write(ipc_test_t *test, const void *data, size_t size)
 	return EOK;
 }
 
+/** Open a ring channel to the IPC test service.
+ *
+ * @param test IPC test service
+ * @param entries Number of ring entries (a power of two)
+ * @return EOK on success or an error code
+ */
+errno_t ipc_test_ring_open(ipc_test_t *test, size_t entries)
+{
+	if (test->ring != NULL)
+		return EBUSY;
+
+	return async_ring_create(test->sess, IPC_TEST_RING, entries, 0,
+	    &test->ring);
+}
+
+/** Send pings through the ring channel.
+ *
+ * The ring is kept as full as possible, so the service can serve the
+ * pings without the help of the kernel.
+ *
+ * @param test IPC test service
+ * @param count Number of pings to send
+ * @return EOK on success or an error code
+ */
+errno_t ipc_test_ring_ping(ipc_test_t *test, uint64_t count)
+{
+	async_ring_msg_t *msg;
+	uint64_t sent = 0;
+	uint64_t received = 0;
+	errno_t rc;
+
+	if (test->ring == NULL)
+		return EINVAL;
+
+	while (received < count) {
+		while (sent < count) {
+			msg = async_ring_send_msg(test->ring);
+			if (msg == NULL)
+				break;
+
+			msg->tag = sent++;
+			msg->method = IPC_TEST_PING;
+			msg->size = 0;
+			async_ring_send(test->ring);
+		}
+
+		rc = async_ring_wait(test->ring, &msg);
+		if (rc != EOK)
+			return rc;
+
+		rc = (errno_t) msg->method;
+		async_ring_release(test->ring);
+		if (rc != EOK)
+			return rc;
+
+		received++;
+	}
+
+	return EOK;
+}
+
 /** @}
  */
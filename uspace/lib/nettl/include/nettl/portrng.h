@@ -36,13 +36,17 @@
 #ifndef LIBNETTL_PORTRNG_H_
 #define LIBNETTL_PORTRNG_H_
 
+#include <adt/hash_table.h>
+#include <adt/list.h>
 #include <stdbool.h>
 #include <stdint.h>
 
 /** Allocated port */
 typedef struct {
+	/** Link to portrng_t.list */
+	link_t llist;
 	/** Link to portrng_t.used */
-	link_t lprng;
+	ht_link_t lprng;
 	/** Port number */
 	uint16_t pn;
 	/** User argument */
@@ -50,7 +54,12 @@ typedef struct {
 } portrng_port_t;
 
 typedef struct {
-	list_t used; /* of portrng_port_t */
+	/** Allocated ports, as long as there are only a few */
+	list_t list; /* of portrng_port_t */
+	/** Allocated ports keyed by port number, once there are many */
+	hash_table_t used; /* of portrng_port_t */
+	/** Ports are kept in @c used instead of @c list */
+	bool hashed;
 } portrng_t;
 
 typedef enum {
@@ -47,9 +47,15 @@
  *
  * In the unspecified case only the local port is known and the entry matches
  * all remote and local addresses.
+ *
+ * Entries of the first three kinds are kept in hash tables indexed by their
+ * key, each entry holding a port range indexed by local port number. Finding
+ * a match thus takes a constant number of hash lookups, falling back from
+ * the most specific key to the least specific one.
  */
 
-#include <adt/list.h>
+#include <adt/hash.h>
+#include <adt/hash_table.h>
 #include <errno.h>
 #include <inet/addr.h>
 #include <inet/inet.h>
@@ -74,6 +80,153 @@ static portrng_flags_t aflags_to_pflags(amap_flags_t flags)
 	return pflags;
 }
 
+/** Key of repla entry */
+typedef struct {
+	/** Remote endpoint */
+	inet_ep_t *rep;
+	/** Local address */
+	inet_addr_t *la;
+} amap_repla_key_t;
+
+/** Compute hash of an internet address.
+ *
+ * @param addr Address
+ * @return Hash value
+ */
+static size_t amap_addr_hash(const inet_addr_t *addr)
+{
+	switch (addr->version) {
+	case ip_v4:
+		return hash_combine(ip_v4, hash_mix(addr->addr));
+	case ip_v6:
+		return hash_combine(ip_v6, hash_bytes(addr->addr6,
+		    sizeof(addr128_t)));
+	default:
+		return 0;
+	}
+}
+
+static size_t amap_repla_hash_key(const inet_ep_t *rep, const inet_addr_t *la)
+{
+	size_t hash;
+
+	hash = amap_addr_hash(&rep->addr);
+	hash = hash_combine(hash, hash_mix(rep->port));
+	return hash_combine(hash, amap_addr_hash(la));
+}
+
+static size_t amap_repla_key_hash(const void *key)
+{
+	const amap_repla_key_t *rkey = key;
+	return amap_repla_hash_key(rkey->rep, rkey->la);
+}
+
+static size_t amap_repla_hash(const ht_link_t *item)
+{
+	amap_repla_t *repla = hash_table_get_inst(item, amap_repla_t, lamap);
+	return amap_repla_hash_key(&repla->rep, &repla->laddr);
+}
+
+static bool amap_repla_key_equal(const void *key, size_t hash,
+    const ht_link_t *item)
+{
+	const amap_repla_key_t *rkey = key;
+	amap_repla_t *repla = hash_table_get_inst(item, amap_repla_t, lamap);
+
+	return inet_addr_compare(&repla->rep.addr, &rkey->rep->addr) &&
+	    repla->rep.port == rkey->rep->port &&
+	    inet_addr_compare(&repla->laddr, rkey->la);
+}
+
+static bool amap_repla_equal(const ht_link_t *item1, const ht_link_t *item2)
+{
+	amap_repla_t *repla = hash_table_get_inst(item2, amap_repla_t, lamap);
+	amap_repla_key_t key = {
+		.rep = &repla->rep,
+		.la = &repla->laddr
+	};
+
+	return amap_repla_key_equal(&key, 0, item1);
+}
+
+/** Operations for repla hash table. */
+static const hash_table_ops_t amap_repla_ops = {
+	.hash = amap_repla_hash,
+	.key_hash = amap_repla_key_hash,
+	.key_equal = amap_repla_key_equal,
+	.equal = amap_repla_equal,
+	.remove_callback = NULL
+};
+
+static size_t amap_laddr_key_hash(const void *key)
+{
+	return amap_addr_hash(key);
+}
+
+static size_t amap_laddr_hash(const ht_link_t *item)
+{
+	amap_laddr_t *laddr = hash_table_get_inst(item, amap_laddr_t, lamap);
+	return amap_addr_hash(&laddr->laddr);
+}
+
+static bool amap_laddr_key_equal(const void *key, size_t hash,
+    const ht_link_t *item)
+{
+	amap_laddr_t *laddr = hash_table_get_inst(item, amap_laddr_t, lamap);
+	return inet_addr_compare(&laddr->laddr, key);
+}
+
+static bool amap_laddr_equal(const ht_link_t *item1, const ht_link_t *item2)
+{
+	amap_laddr_t *laddr = hash_table_get_inst(item2, amap_laddr_t, lamap);
+	return amap_laddr_key_equal(&laddr->laddr, 0, item1);
+}
+
+/** Operations for laddr hash table. */
+static const hash_table_ops_t amap_laddr_ops = {
+	.hash = amap_laddr_hash,
+	.key_hash = amap_laddr_key_hash,
+	.key_equal = amap_laddr_key_equal,
+	.equal = amap_laddr_equal,
+	.remove_callback = NULL
+};
+
+static size_t amap_llink_key_hash(const void *key)
+{
+	const sysarg_t *link_id = key;
+	return hash_mix(*link_id);
+}
+
+static size_t amap_llink_hash(const ht_link_t *item)
+{
+	amap_llink_t *llink = hash_table_get_inst(item, amap_llink_t, lamap);
+	return hash_mix(llink->llink);
+}
+
+static bool amap_llink_key_equal(const void *key, size_t hash,
+    const ht_link_t *item)
+{
+	const sysarg_t *link_id = key;
+	amap_llink_t *llink = hash_table_get_inst(item, amap_llink_t, lamap);
+	return llink->llink == *link_id;
+}
+
+static bool amap_llink_equal(const ht_link_t *item1, const ht_link_t *item2)
+{
+	amap_llink_t *llink1 = hash_table_get_inst(item1, amap_llink_t, lamap);
+	amap_llink_t *llink2 = hash_table_get_inst(item2, amap_llink_t, lamap);
+	return llink1->llink == llink2->llink;
+}
+
+/** Operations for llink hash table. */
+static const hash_table_ops_t amap_llink_ops = {
+	.hash = amap_llink_hash,
+	.key_hash = amap_llink_key_hash,
+	.key_equal = amap_llink_key_equal,
+	.equal = amap_llink_equal,
+	.remove_callback = NULL
+};
+
 /** Create association map.
  *
  * @param rmap Place to store pointer to new association map
@@ -90,19 +243,30 @@ errno_t amap_create(amap_t **rmap)
 	if (map == NULL)
 		return ENOMEM;
 
+	if (!hash_table_create(&map->repla, 0, 0, &amap_repla_ops))
+		goto error;
+	if (!hash_table_create(&map->laddr, 0, 0, &amap_laddr_ops))
+		goto error_repla;
+	if (!hash_table_create(&map->llink, 0, 0, &amap_llink_ops))
+		goto error_laddr;
+
 	rc = portrng_create(&map->unspec);
 	if (rc != EOK) {
 		assert(rc == ENOMEM);
-		free(map);
-		return ENOMEM;
+		goto error_llink;
 	}
 
-	list_initialize(&map->repla);
-	list_initialize(&map->laddr);
-	list_initialize(&map->llink);
-
 	*rmap = map;
 	return EOK;
+error_llink:
+	hash_table_destroy(&map->llink);
+error_laddr:
+	hash_table_destroy(&map->laddr);
+error_repla:
+	hash_table_destroy(&map->repla);
+error:
+	free(map);
+	return ENOMEM;
 }
 
 /** Destroy association map.
@@ -113,9 +277,12 @@ void amap_destroy(amap_t *map)
 {
 	log_msg(LOG_DEFAULT, LVL_DEBUG2, "amap_destroy()");
 
-	assert(list_empty(&map->repla));
-	assert(list_empty(&map->laddr));
-	assert(list_empty(&map->llink));
+	assert(hash_table_empty(&map->repla));
+	assert(hash_table_empty(&map->laddr));
+	assert(hash_table_empty(&map->llink));
+	hash_table_destroy(&map->repla);
+	hash_table_destroy(&map->laddr);
+	hash_table_destroy(&map->llink);
 	free(map);
 }
 
@@ -133,34 +300,20 @@ void amap_destroy(amap_t *map)
 static errno_t amap_repla_find(amap_t *map, inet_ep_t *rep, inet_addr_t *la,
     amap_repla_t **rrepla)
 {
-	char *sraddr, *sladdr;
-
-	(void) inet_addr_format(&rep->addr, &sraddr);
-	(void) inet_addr_format(la, &sladdr);
-
-	log_msg(LOG_DEFAULT, LVL_DEBUG2, "amap_repla_find(): rep=(%s,%" PRIu16
-	    ") la=%s", sraddr, rep->port, sladdr);
-	free(sraddr);
-	free(sladdr);
-
-	list_foreach(map->repla, lamap, amap_repla_t, repla) {
-		(void) inet_addr_format(&repla->rep.addr, &sraddr);
-		(void) inet_addr_format(&repla->laddr, &sladdr);
-		log_msg(LOG_DEFAULT, LVL_DEBUG2, "amap_repla_find(): "
-		    "compare to rep=(%s, %" PRIu16 ") la=%s",
-		    sraddr, repla->rep.port, sladdr);
-		free(sraddr);
-		free(sladdr);
-		if (inet_addr_compare(&repla->rep.addr, &rep->addr) &&
-		    repla->rep.port == rep->port &&
-		    inet_addr_compare(&repla->laddr, la)) {
-			*rrepla = repla;
-			return EOK;
-		}
+	amap_repla_key_t key;
+	ht_link_t *link;
+
+	key.rep = rep;
+	key.la = la;
+
+	link = hash_table_find(&map->repla, &key);
+	if (link == NULL) {
+		*rrepla = NULL;
+		return ENOENT;
 	}
 
-	*rrepla = NULL;
-	return ENOENT;
+	*rrepla = hash_table_get_inst(link, amap_repla_t, lamap);
+	return EOK;
 }
 
 /** Insert repla.
@@ -194,7 +347,7 @@ static errno_t amap_repla_insert(amap_t *map, inet_ep_t *rep, inet_addr_t *la,
 
 	repla->rep = *rep;
 	repla->laddr = *la;
-	list_append(&repla->lamap, &map->repla);
+	hash_table_insert(&map->repla, &repla->lamap);
 
 	*rrepla = repla;
 	return EOK;
@@ -209,7 +362,7 @@ static errno_t amap_repla_insert(amap_t *map, inet_ep_t *rep, inet_addr_t *la,
  */
 static void amap_repla_remove(amap_t *map, amap_repla_t *repla)
 {
-	list_remove(&repla->lamap);
+	hash_table_remove_item(&map->repla, &repla->lamap);
 	portrng_destroy(repla->portrng);
 	free(repla);
 }
@@ -227,15 +380,16 @@ static void amap_repla_remove(amap_t *map, amap_repla_t *repla)
 static errno_t amap_laddr_find(amap_t *map, inet_addr_t *addr,
     amap_laddr_t **rladdr)
 {
-	list_foreach(map->laddr, lamap, amap_laddr_t, laddr) {
-		if (inet_addr_compare(&laddr->laddr, addr)) {
-			*rladdr = laddr;
-			return EOK;
-		}
+	ht_link_t *link;
+
+	link = hash_table_find(&map->laddr, addr);
+	if (link == NULL) {
+		*rladdr = NULL;
+		return ENOENT;
 	}
 
-	*rladdr = NULL;
-	return ENOENT;
+	*rladdr = hash_table_get_inst(link, amap_laddr_t, lamap);
+	return EOK;
 }
 
 /** Insert laddr.
@@ -266,7 +420,7 @@ static errno_t amap_laddr_insert(amap_t *map, inet_addr_t *addr,
 	}
 
 	laddr->laddr = *addr;
-	list_append(&laddr->lamap, &map->laddr);
+	hash_table_insert(&map->laddr, &laddr->lamap);
 
 	*rladdr = laddr;
 	return EOK;
@@ -281,7 +435,7 @@ static errno_t amap_laddr_insert(amap_t *map, inet_addr_t *addr,
  */
 static void amap_laddr_remove(amap_t *map, amap_laddr_t *laddr)
 {
-	list_remove(&laddr->lamap);
+	hash_table_remove_item(&map->laddr, &laddr->lamap);
 	portrng_destroy(laddr->portrng);
 	free(laddr);
 }
@@ -299,15 +453,16 @@ static void amap_laddr_remove(amap_t *map, amap_laddr_t *laddr)
 static errno_t amap_llink_find(amap_t *map, sysarg_t link_id,
     amap_llink_t **rllink)
 {
-	list_foreach(map->llink, lamap, amap_llink_t, llink) {
-		if (llink->llink == link_id) {
-			*rllink = llink;
-			return EOK;
-		}
+	ht_link_t *link;
+
+	link = hash_table_find(&map->llink, &link_id);
+	if (link == NULL) {
+		*rllink = NULL;
+		return ENOENT;
 	}
 
-	*rllink = NULL;
-	return ENOENT;
+	*rllink = hash_table_get_inst(link, amap_llink_t, lamap);
+	return EOK;
 }
 
 /** Insert llink.
@@ -338,7 +493,7 @@ static errno_t amap_llink_insert(amap_t *map, sysarg_t link_id,
 	}
 
 	llink->llink = link_id;
-	list_append(&llink->lamap, &map->llink);
+	hash_table_insert(&map->llink, &llink->lamap);
 
 	*rllink = llink;
 	return EOK;
@@ -353,7 +508,7 @@ static errno_t amap_llink_insert(amap_t *map, sysarg_t link_id,
  */
 static void amap_llink_remove(amap_t *map, amap_llink_t *llink)
 {
-	list_remove(&llink->lamap);
+	hash_table_remove_item(&map->llink, &llink->lamap);
 	portrng_destroy(llink->portrng);
 	free(llink);
 }
@@ -755,8 +910,11 @@ errno_t amap_find_match(amap_t *map, inet_ep2_t *epp, void **rarg)
 	}
 
 	/* Local link */
-	rc = amap_llink_find(map, epp->local_link, &llink);
-	if (epp->local_link != 0 && rc == EOK) {
+	if (epp->local_link != 0)
+		rc = amap_llink_find(map, epp->local_link, &llink);
+	else
+		rc = ENOENT;
+	if (rc == EOK) {
 		rc = portrng_find_port(llink->portrng, epp->local.port,
 		    rarg);
 		if (rc == EOK) {
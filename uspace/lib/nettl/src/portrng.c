@@ -36,6 +36,8 @@
  * Allocates port numbers from IETF port number ranges.
  */
 
+#include <adt/hash.h>
+#include <adt/hash_table.h>
 #include <adt/list.h>
 #include <errno.h>
 #include <inet/endpoint.h>
@@ -45,6 +47,100 @@
 
 #include <io/log.h>
 
+/**
+ * Maximum number of ports kept in a list. Most port ranges, such as those of
+ * fully specified connections, only ever hold one port, so the hash table is
+ * only created once a range grows beyond this.
+ */
+#define PORTRNG_LIST_MAX 16
+
+static size_t portrng_key_hash(const void *key)
+{
+	const uint16_t *pn = key;
+	return hash_mix(*pn);
+}
+
+static size_t portrng_hash(const ht_link_t *item)
+{
+	portrng_port_t *port = hash_table_get_inst(item, portrng_port_t, lprng);
+	return hash_mix(port->pn);
+}
+
+static bool portrng_key_equal(const void *key, size_t hash,
+    const ht_link_t *item)
+{
+	const uint16_t *pn = key;
+	portrng_port_t *port = hash_table_get_inst(item, portrng_port_t, lprng);
+	return port->pn == *pn;
+}
+
+static bool portrng_equal(const ht_link_t *item1, const ht_link_t *item2)
+{
+	portrng_port_t *port1 = hash_table_get_inst(item1, portrng_port_t,
+	    lprng);
+	portrng_port_t *port2 = hash_table_get_inst(item2, portrng_port_t,
+	    lprng);
+	return port1->pn == port2->pn;
+}
+
+/** Operations for port range hash table. */
+static const hash_table_ops_t portrng_ops = {
+	.hash = portrng_hash,
+	.key_hash = portrng_key_hash,
+	.key_equal = portrng_key_equal,
+	.equal = portrng_equal,
+	.remove_callback = NULL
+};
+
+/** Find allocated port.
+ *
+ * @param pr   Port range
+ * @param pnum Port number
+ * @return Allocated port or @c NULL if @a pnum is not allocated
+ */
+static portrng_port_t *portrng_port_find(portrng_t *pr, uint16_t pnum)
+{
+	ht_link_t *link;
+
+	if (!pr->hashed) {
+		list_foreach(pr->list, llist, portrng_port_t, port) {
+			if (port->pn == pnum)
+				return port;
+		}
+
+		return NULL;
+	}
+
+	link = hash_table_find(&pr->used, &pnum);
+	if (link == NULL)
+		return NULL;
+
+	return hash_table_get_inst(link, portrng_port_t, lprng);
+}
+
+/** Move allocated ports from the list to the hash table.
+ *
+ * @param pr Port range
+ * @return EOK on success, ENOMEM if out of memory
+ */
+static errno_t portrng_hash_ports(portrng_t *pr)
+{
+	portrng_port_t *port;
+
+	if (!hash_table_create(&pr->used, 0, 0, &portrng_ops))
+		return ENOMEM;
+
+	while (!list_empty(&pr->list)) {
+		port = list_get_instance(list_first(&pr->list), portrng_port_t,
+		    llist);
+		list_remove(&port->llist);
+		hash_table_insert(&pr->used, &port->lprng);
+	}
+
+	pr->hashed = true;
+	return EOK;
+}
+
 /** Create port range.
  *
  * @param rpr Place to store pointer to new port range
@@ -60,7 +156,9 @@ errno_t portrng_create(portrng_t **rpr)
 	if (pr == NULL)
 		return ENOMEM;
 
-	list_initialize(&pr->used);
+	list_initialize(&pr->list);
+	pr->hashed = false;
+
 	*rpr = pr;
 	log_msg(LOG_DEFAULT, LVL_DEBUG2, "portrng_create() - end");
 	return EOK;
@@ -73,7 +171,9 @@ errno_t portrng_create(portrng_t **rpr)
 void portrng_destroy(portrng_t *pr)
 {
 	log_msg(LOG_DEFAULT, LVL_DEBUG2, "portrng_destroy()");
-	assert(list_empty(&pr->used));
+	assert(portrng_empty(pr));
+	if (pr->hashed)
+		hash_table_destroy(&pr->used);
 	free(pr);
 }
 
@@ -97,23 +197,14 @@ errno_t portrng_alloc(portrng_t *pr, uint16_t pnum, void *arg,
 {
 	portrng_port_t *p;
 	uint32_t i;
-	bool found;
+	errno_t rc;
 
 	log_msg(LOG_DEFAULT, LVL_DEBUG2, "portrng_alloc() - begin");
 
 	if (pnum == inet_port_any) {
 
 		for (i = inet_port_dyn_lo; i <= inet_port_dyn_hi; i++) {
-			log_msg(LOG_DEFAULT, LVL_DEBUG2, "trying %" PRIu32, i);
-			found = false;
-			list_foreach(pr->used, lprng, portrng_port_t, port) {
-				if (port->pn == pnum) {
-					found = true;
-					break;
-				}
-			}
-
-			if (!found) {
+			if (portrng_port_find(pr, i) == NULL) {
 				pnum = i;
 				break;
 			}
@@ -133,21 +224,28 @@ errno_t portrng_alloc(portrng_t *pr, uint16_t pnum, void *arg,
 			return EINVAL;
 		}
 
-		list_foreach(pr->used, lprng, portrng_port_t, port) {
-			if (port->pn == pnum) {
-				log_msg(LOG_DEFAULT, LVL_DEBUG2, "port already used");
-				return EEXIST;
-			}
+		if (portrng_port_find(pr, pnum) != NULL) {
+			log_msg(LOG_DEFAULT, LVL_DEBUG2, "port already used");
+			return EEXIST;
 		}
 	}
 
+	if (!pr->hashed && list_count(&pr->list) >= PORTRNG_LIST_MAX) {
+		rc = portrng_hash_ports(pr);
+		if (rc != EOK)
+			return rc;
+	}
+
 	p = calloc(1, sizeof(portrng_port_t));
 	if (p == NULL)
 		return ENOMEM;
 
 	p->pn = pnum;
 	p->arg = arg;
-	list_append(&p->lprng, &pr->used);
+	if (pr->hashed)
+		hash_table_insert(&pr->used, &p->lprng);
+	else
+		list_append(&p->llist, &pr->list);
 	*apnum = pnum;
 	log_msg(LOG_DEFAULT, LVL_DEBUG2, "portrng_alloc() - end OK pn=%" PRIu16,
 	    pnum);
@@ -164,14 +262,14 @@ errno_t portrng_alloc(portrng_t *pr, uint16_t pnum, void *arg,
  */
 errno_t portrng_find_port(portrng_t *pr, uint16_t pnum, void **rarg)
 {
-	list_foreach(pr->used, lprng, portrng_port_t, port) {
-		if (port->pn == pnum) {
-			*rarg = port->arg;
-			return EOK;
-		}
-	}
+	portrng_port_t *port;
+
+	port = portrng_port_find(pr, pnum);
+	if (port == NULL)
+		return ENOENT;
 
-	return ENOENT;
+	*rarg = port->arg;
+	return EOK;
 }
 
 /** Free port in port range.
@@ -181,21 +279,22 @@ errno_t portrng_find_port(portrng_t *pr, uint16_t pnum, void **rarg)
  */
 void portrng_free_port(portrng_t *pr, uint16_t pnum)
 {
+	portrng_port_t *port;
+
 	log_msg(LOG_DEFAULT, LVL_DEBUG2, "portrng_free_port(%u)", pnum);
-	log_msg(LOG_DEFAULT, LVL_DEBUG2, "portrng_free_port() - begin");
-	list_foreach(pr->used, lprng, portrng_port_t, port) {
-		log_msg(LOG_DEFAULT, LVL_DEBUG2, "portrng_free_port - check port %u", port->pn);
-		if (port->pn == pnum) {
-			log_msg(LOG_DEFAULT, LVL_DEBUG2, "portrng_free_port - OK");
-			list_remove(&port->lprng);
-			free(port);
-			log_msg(LOG_DEFAULT, LVL_DEBUG2, "portrng_free_port() - end");
-			return;
-		}
+
+	port = portrng_port_find(pr, pnum);
+	if (port == NULL) {
+		log_msg(LOG_DEFAULT, LVL_DEBUG2, "portrng_free_port - FAIL");
+		assert(false);
+		return;
 	}
 
-	log_msg(LOG_DEFAULT, LVL_DEBUG2, "portrng_free_port - FAIL");
-	assert(false);
+	if (pr->hashed)
+		hash_table_remove_item(&pr->used, &port->lprng);
+	else
+		list_remove(&port->llist);
+	free(port);
 }
 
 /** Determine if port range is empty.
@@ -206,7 +305,10 @@ void portrng_free_port(portrng_t *pr, uint16_t pnum)
 bool portrng_empty(portrng_t *pr)
 {
 	log_msg(LOG_DEFAULT, LVL_DEBUG2, "portrng_empty()");
-	return list_empty(&pr->used);
+	if (!pr->hashed)
+		return list_empty(&pr->list);
+
+	return hash_table_empty(&pr->used);
 }
 
 /**
@@ -69,6 +69,11 @@ typedef struct {
 	link_t link;
 	void *data;
 	size_t size;
+	/**
+	 * Size of the buffer pointed to by @c data, zero if the buffer is
+	 * owned by the driver.
+	 */
+	size_t buf_size;
 } nic_frame_t;
 
 typedef list_t nic_frame_list_t;
@@ -85,6 +90,22 @@ typedef list_t nic_frame_list_t;
  */
 typedef void (*send_frame_handler)(nic_t *, void *, size_t);
 
+/**
+ * Handler for writing frame data to the NIC device which can refuse the
+ * frame. Unlike send_frame_handler, the error is returned to the client,
+ * so a device with several transmit queues can refuse a frame for a full
+ * queue without stalling the others.
+ *
+ * @param nic_data
+ * @param data		Pointer to frame data
+ * @param size		Size of frame data in bytes
+ *
+ * @return EOK if the frame was queued for transmission
+ * @return EBUSY if the device cannot take the frame now
+ * @return Other error code if the frame cannot be sent at all
+ */
+typedef errno_t (*try_send_frame_handler)(nic_t *, void *, size_t);
+
 /**
  * The handler for transitions between driver states.
  * If the handler returns error code, the transition between
@@ -219,6 +240,7 @@ extern void nic_driver_implement(driver_ops_t *, ddf_dev_ops_t *,
 extern errno_t nic_get_resources(nic_t *, hw_res_list_parsed_t *);
 extern void nic_set_specific(nic_t *, void *);
 extern void nic_set_send_frame_handler(nic_t *, send_frame_handler);
+extern void nic_set_try_send_frame_handler(nic_t *, try_send_frame_handler);
 extern void nic_set_state_change_handlers(nic_t *,
     state_change_handler, state_change_handler, state_change_handler);
 extern void nic_set_filtering_change_handlers(nic_t *,
@@ -255,6 +277,7 @@ extern void nic_report_collisions(nic_t *, unsigned);
 
 /* Frame / frame list allocation and deallocation */
 extern nic_frame_t *nic_alloc_frame(nic_t *, size_t);
+extern nic_frame_t *nic_wrap_frame(nic_t *, void *, size_t);
 extern nic_frame_list_t *nic_alloc_frame_list(void);
 extern void nic_frame_list_append(nic_frame_list_t *, nic_frame_t *);
 extern void nic_release_frame(nic_t *, nic_frame_t *);
@@ -127,6 +127,12 @@ struct nic {
 	 * Called with the main_lock locked for reading.
 	 */
 	send_frame_handler send_frame;
+	/**
+	 * Function sending the data which can refuse the frame. If set, it
+	 * is used instead of send_frame and its result is returned to the
+	 * client. Called with the main_lock locked for reading.
+	 */
+	try_send_frame_handler try_send_frame;
 	/**
 	 * Event handler called when device goes to the ACTIVE state.
 	 * The implementation is optional.
@@ -199,6 +205,22 @@ struct nic {
 	/** Packets dumper. */
 	pcap_dumper_t dumper;
 
+	/** Buffer shared with the client for batched frame delivery */
+	void *rx_buffer;
+	/** The client has mapped @c rx_buffer */
+	bool rx_buffer_shared;
+	/** The client does not support batched frame delivery */
+	bool rx_buffer_unsupported;
+	/** Serializes use of @c rx_buffer */
+	fibril_mutex_t rx_buffer_lock;
+
+	/** Pool of received frames with their data buffers */
+	list_t frame_pool;
+	/** Number of frames in @c frame_pool */
+	size_t frame_pool_size;
+	/** Protects @c frame_pool */
+	fibril_mutex_t frame_pool_lock;
+
 	/** Data specific for particular driver */
 	void *specific;
 };
@@ -209,8 +231,6 @@ struct nic {
 typedef struct nic_globals {
 	list_t frame_list_cache;
 	size_t frame_list_cache_size;
-	list_t frame_cache;
-	size_t frame_cache_size;
 	fibril_mutex_t lock;
 } nic_globals_t;
 
@@ -46,6 +46,9 @@
 #include <ddf/interrupt.h>
 #include <ops/nic.h>
 #include <errno.h>
+#include <align.h>
+#include <macros.h>
+#include <nic_iface.h>
 #include <pcapdump_drv_iface.h>
 
 #include "nic_driver.h"
@@ -54,6 +57,14 @@
 
 #define NIC_GLOBALS_MAX_CACHE_SIZE 16
 
+/** Maximum number of frames kept in the frame pool of each NIC */
+#define NIC_FRAME_POOL_SIZE 256
+/**
+ * Size of data buffers of pooled frames. Large enough for any standard
+ * Ethernet frame, larger frames get a buffer of their own.
+ */
+#define NIC_FRAME_POOL_BUF_SIZE 2048
+
 nic_globals_t nic_globals;
 
 /**
@@ -65,8 +76,6 @@ errno_t nic_driver_init(const char *name)
 {
 	list_initialize(&nic_globals.frame_list_cache);
 	nic_globals.frame_list_cache_size = 0;
-	list_initialize(&nic_globals.frame_cache);
-	nic_globals.frame_cache_size = 0;
 	fibril_mutex_initialize(&nic_globals.lock);
 
 	char buffer[256];
@@ -161,6 +170,20 @@ void nic_set_send_frame_handler(nic_t *nic_data, send_frame_handler sffunc)
 	nic_data->send_frame = sffunc;
 }
 
+/**
+ * Setup send frame handler which can refuse frames. It replaces the handler
+ * set by nic_set_send_frame_handler(). Like that, it must only be called in
+ * the add_device handler.
+ *
+ * @param nic_data
+ * @param tsffunc	Function handling the send_frame request
+ */
+void nic_set_try_send_frame_handler(nic_t *nic_data,
+    try_send_frame_handler tsffunc)
+{
+	nic_data->try_send_frame = tsffunc;
+}
+
 /**
  * Setup event handlers for transitions between driver states.
  * This function can be called only in the add_device handler.
@@ -257,6 +280,10 @@ errno_t nic_get_resources(nic_t *nic_data, hw_res_list_parsed_t *resources)
 }
 
 /** Allocate frame
+ *
+ * Frames that fit in NIC_FRAME_POOL_BUF_SIZE bytes are taken from the NIC's
+ * pool together with their data buffer, so that receiving a frame does not
+ * normally require any memory allocation.
  *
  *  @param nic_data 	The NIC driver data
  *  @param size	        Frame size in bytes
@@ -264,34 +291,68 @@ errno_t nic_get_resources(nic_t *nic_data, hw_res_list_parsed_t *resources)
  */
 nic_frame_t *nic_alloc_frame(nic_t *nic_data, size_t size)
 {
-	nic_frame_t *frame;
-	fibril_mutex_lock(&nic_globals.lock);
-	if (nic_globals.frame_cache_size > 0) {
-		link_t *first = list_first(&nic_globals.frame_cache);
-		list_remove(first);
-		nic_globals.frame_cache_size--;
-		frame = list_get_instance(first, nic_frame_t, link);
-		fibril_mutex_unlock(&nic_globals.lock);
-	} else {
-		fibril_mutex_unlock(&nic_globals.lock);
+	nic_frame_t *frame = NULL;
+
+	if (size <= NIC_FRAME_POOL_BUF_SIZE) {
+		fibril_mutex_lock(&nic_data->frame_pool_lock);
+		if (nic_data->frame_pool_size > 0) {
+			link_t *first = list_first(&nic_data->frame_pool);
+			list_remove(first);
+			nic_data->frame_pool_size--;
+			frame = list_get_instance(first, nic_frame_t, link);
+		}
+		fibril_mutex_unlock(&nic_data->frame_pool_lock);
+	}
+
+	if (frame == NULL) {
 		frame = malloc(sizeof(nic_frame_t));
 		if (!frame)
 			return NULL;
 
 		link_initialize(&frame->link);
+
+		frame->buf_size = max(size, NIC_FRAME_POOL_BUF_SIZE);
+		frame->data = malloc(frame->buf_size);
+		if (frame->data == NULL) {
+			free(frame);
+			return NULL;
+		}
 	}
 
-	frame->data = malloc(size);
-	if (frame->data == NULL) {
-		free(frame);
+	assert(frame->buf_size >= size);
+	frame->size = size;
+	return frame;
+}
+
+/** Allocate frame referring to a buffer owned by the driver
+ *
+ * This lets a driver pass received data up without copying it out of its
+ * DMA buffers first. The buffer must remain valid until the frame has been
+ * passed to nic_received_frame() or nic_received_frame_list(), which copy
+ * the data out before returning. Releasing the frame does not free the buffer.
+ *
+ *  @param nic_data 	The NIC driver data
+ *  @param data		Frame data
+ *  @param size	        Frame size in bytes
+ *  @return pointer to allocated frame if success, NULL otherwise
+ */
+nic_frame_t *nic_wrap_frame(nic_t *nic_data, void *data, size_t size)
+{
+	nic_frame_t *frame = malloc(sizeof(nic_frame_t));
+	if (!frame)
 		return NULL;
-	}
 
+	link_initialize(&frame->link);
+	frame->data = data;
 	frame->size = size;
+	frame->buf_size = 0;
 	return frame;
 }
 
 /** Release frame
+ *
+ * Return the frame to the pool if it has a pool-sized buffer and the pool
+ * is not full, otherwise free it.
  *
  * @param nic_data	The driver data
  * @param frame		The frame to release
@@ -301,21 +362,21 @@ void nic_release_frame(nic_t *nic_data, nic_frame_t *frame)
 	if (!frame)
 		return;
 
-	if (frame->data != NULL) {
-		free(frame->data);
-		frame->data = NULL;
-		frame->size = 0;
+	if (frame->data != NULL && frame->buf_size == NIC_FRAME_POOL_BUF_SIZE) {
+		fibril_mutex_lock(&nic_data->frame_pool_lock);
+		if (nic_data->frame_pool_size < NIC_FRAME_POOL_SIZE) {
+			frame->size = 0;
+			list_prepend(&frame->link, &nic_data->frame_pool);
+			nic_data->frame_pool_size++;
+			fibril_mutex_unlock(&nic_data->frame_pool_lock);
+			return;
+		}
+		fibril_mutex_unlock(&nic_data->frame_pool_lock);
 	}
 
-	fibril_mutex_lock(&nic_globals.lock);
-	if (nic_globals.frame_cache_size >= NIC_GLOBALS_MAX_CACHE_SIZE) {
-		fibril_mutex_unlock(&nic_globals.lock);
-		free(frame);
-	} else {
-		list_prepend(&frame->link, &nic_globals.frame_cache);
-		nic_globals.frame_cache_size++;
-		fibril_mutex_unlock(&nic_globals.lock);
-	}
+	if (frame->buf_size != 0)
+		free(frame->data);
+	free(frame);
 }
 
 /**
@@ -508,15 +569,13 @@ void nic_set_tx_busy(nic_t *nic_data, int busy)
 	nic_data->tx_busy = busy;
 }
 
-/**
- * This is the function that the driver should call when it receives a frame.
- * The frame is checked by filters and then sent up to the NIL layer or
- * discarded. The frame is released.
+/** Check received frame against receive filters and update statistics.
  *
  * @param nic_data
  * @param frame		The received frame
+ * @return		@c true if the frame should be passed to the client
  */
-void nic_received_frame(nic_t *nic_data, nic_frame_t *frame)
+static bool nic_rx_check(nic_t *nic_data, nic_frame_t *frame)
 {
 	/*
 	 * Note: this function must not lock main lock, because loopback driver
@@ -545,46 +604,172 @@ void nic_received_frame(nic_t *nic_data, nic_frame_t *frame)
 			break;
 		}
 		fibril_rwlock_write_unlock(&nic_data->stats_lock);
+		return true;
+	}
+
+	switch (frame_type) {
+	case NIC_FRAME_UNICAST:
+		nic_data->stats.receive_filtered_unicast++;
+		break;
+	case NIC_FRAME_MULTICAST:
+		nic_data->stats.receive_filtered_multicast++;
+		break;
+	case NIC_FRAME_BROADCAST:
+		nic_data->stats.receive_filtered_broadcast++;
+		break;
+	}
+	fibril_rwlock_write_unlock(&nic_data->stats_lock);
+	return false;
+}
+
+/**
+ * This is the function that the driver should call when it receives a frame.
+ * The frame is checked by filters and then sent up to the NIL layer or
+ * discarded. The frame is released.
+ *
+ * @param nic_data
+ * @param frame		The received frame
+ */
+void nic_received_frame(nic_t *nic_data, nic_frame_t *frame)
+{
+	if (nic_rx_check(nic_data, frame)) {
 		nic_ev_received(nic_data->client_session, frame->data,
 		    frame->size);
-	} else {
-		switch (frame_type) {
-		case NIC_FRAME_UNICAST:
-			nic_data->stats.receive_filtered_unicast++;
-			break;
-		case NIC_FRAME_MULTICAST:
-			nic_data->stats.receive_filtered_multicast++;
-			break;
-		case NIC_FRAME_BROADCAST:
-			nic_data->stats.receive_filtered_broadcast++;
-			break;
-		}
-		fibril_rwlock_write_unlock(&nic_data->stats_lock);
 	}
-	//pcapdump_packet(nic_get_pcap_dumper(nic_data), frame->data, frame->size);
+
 	nic_release_frame(nic_data, frame);
 }
 
+/** Make sure the receive buffer is shared with the client.
+ *
+ * The buffer is created and offered to the client the first time frames
+ * are delivered in a batch. If the client does not accept it, frames are
+ * delivered one by one until a new client connects.
+ *
+ * Must be called with rx_buffer_lock held.
+ *
+ * @param nic_data
+ * @return EOK if the shared buffer can be used, error code otherwise
+ */
+static errno_t nic_rx_buffer_setup(nic_t *nic_data)
+{
+	void *buf;
+	errno_t rc;
+
+	assert(fibril_mutex_is_locked(&nic_data->rx_buffer_lock));
+
+	if (nic_data->rx_buffer_shared)
+		return EOK;
+
+	if (nic_data->rx_buffer_unsupported || nic_data->client_session == NULL)
+		return ENOTSUP;
+
+	if (nic_data->rx_buffer == NULL) {
+		buf = as_area_create(AS_AREA_ANY, NIC_RX_BUFFER_SIZE,
+		    AS_AREA_READ | AS_AREA_WRITE | AS_AREA_CACHEABLE,
+		    AS_AREA_UNPAGED);
+		if (buf == AS_MAP_FAILED) {
+			nic_data->rx_buffer_unsupported = true;
+			return ENOMEM;
+		}
+
+		nic_data->rx_buffer = buf;
+	}
+
+	rc = nic_ev_rx_buffer(nic_data->client_session, nic_data->rx_buffer);
+	if (rc != EOK) {
+		nic_data->rx_buffer_unsupported = true;
+		return rc;
+	}
+
+	nic_data->rx_buffer_shared = true;
+	return EOK;
+}
+
+/** Pass frames accumulated in the shared receive buffer to the client.
+ *
+ * @param nic_data
+ * @param count		Number of frames in the buffer, reset to zero
+ * @param used		Bytes used in the buffer, reset to zero
+ */
+static void nic_rx_buffer_flush(nic_t *nic_data, size_t *count, size_t *used)
+{
+	if (*count == 0)
+		return;
+
+	(void) nic_ev_received_batch(nic_data->client_session, *count, *used);
+	*count = 0;
+	*used = 0;
+}
+
 /**
  * Some NICs can receive multiple frames during single interrupt. These can
  * send them in whole list of frames (actually nic_frame_t structures), then
- * the list is deallocated and each frame is passed to the
- * nic_received_packet function.
+ * the list is deallocated.
+ *
+ * Frames that pass the receive filters are copied into a buffer shared with
+ * the client and delivered in batches using a single notification each.
+ * If the client does not support this, each frame is passed on separately.
  *
  * @param nic_data
  * @param frames		List of received frames
  */
 void nic_received_frame_list(nic_t *nic_data, nic_frame_list_t *frames)
 {
+	nic_rx_frame_hdr_t *hdr;
+	size_t count = 0;
+	size_t used = 0;
+	size_t rec_size;
+	bool batch;
+
 	if (frames == NULL)
 		return;
+
+	fibril_mutex_lock(&nic_data->rx_buffer_lock);
+	batch = nic_rx_buffer_setup(nic_data) == EOK;
+
 	while (!list_empty(frames)) {
 		nic_frame_t *frame =
 		    list_get_instance(list_first(frames), nic_frame_t, link);
 
 		list_remove(&frame->link);
-		nic_received_frame(nic_data, frame);
+
+		if (!nic_rx_check(nic_data, frame)) {
+			nic_release_frame(nic_data, frame);
+			continue;
+		}
+
+		rec_size = ALIGN_UP(sizeof(nic_rx_frame_hdr_t) + frame->size,
+		    NIC_RX_FRAME_ALIGN);
+
+		if (!batch || rec_size > NIC_RX_BUFFER_SIZE) {
+			/* Keep frames in order */
+			if (batch)
+				nic_rx_buffer_flush(nic_data, &count, &used);
+			nic_ev_received(nic_data->client_session, frame->data,
+			    frame->size);
+			nic_release_frame(nic_data, frame);
+			continue;
+		}
+
+		if (used + rec_size > NIC_RX_BUFFER_SIZE)
+			nic_rx_buffer_flush(nic_data, &count, &used);
+
+		hdr = (nic_rx_frame_hdr_t *) ((uint8_t *) nic_data->rx_buffer +
+		    used);
+		hdr->size = frame->size;
+		hdr->reserved = 0;
+		memcpy(hdr + 1, frame->data, frame->size);
+
+		used += rec_size;
+		count++;
+
+		nic_release_frame(nic_data, frame);
 	}
+
+	nic_rx_buffer_flush(nic_data, &count, &used);
+	fibril_mutex_unlock(&nic_data->rx_buffer_lock);
+
 	nic_driver_release_frame_list(frames);
 }
 
@@ -615,6 +800,7 @@ static nic_t *nic_create(ddf_dev_t *dev)
 	nic_data->poll_mode = NIC_POLL_IMMEDIATE;
 	nic_data->default_poll_mode = NIC_POLL_IMMEDIATE;
 	nic_data->send_frame = NULL;
+	nic_data->try_send_frame = NULL;
 	nic_data->on_activating = NULL;
 	nic_data->on_going_down = NULL;
 	nic_data->on_stopping = NULL;
@@ -625,6 +811,14 @@ static nic_t *nic_create(ddf_dev_t *dev)
 	fibril_rwlock_initialize(&nic_data->rxc_lock);
 	fibril_rwlock_initialize(&nic_data->wv_lock);
 
+	nic_data->rx_buffer = NULL;
+	nic_data->rx_buffer_shared = false;
+	nic_data->rx_buffer_unsupported = false;
+	fibril_mutex_initialize(&nic_data->rx_buffer_lock);
+	list_initialize(&nic_data->frame_pool);
+	nic_data->frame_pool_size = 0;
+	fibril_mutex_initialize(&nic_data->frame_pool_lock);
+
 	memset(&nic_data->mac, 0, sizeof(nic_address_t));
 	memset(&nic_data->default_mac, 0, sizeof(nic_address_t));
 	memset(&nic_data->stats, 0, sizeof(nic_device_stats_t));
@@ -666,6 +860,17 @@ nic_t *nic_create_and_bind(ddf_dev_t *device)
  */
 static void nic_destroy(nic_t *nic_data)
 {
+	if (nic_data->rx_buffer != NULL)
+		as_area_destroy(nic_data->rx_buffer);
+
+	while (!list_empty(&nic_data->frame_pool)) {
+		nic_frame_t *frame = list_get_instance(
+		    list_first(&nic_data->frame_pool), nic_frame_t, link);
+		list_remove(&frame->link);
+		free(frame->data);
+		free(frame);
+	}
+
 	free(nic_data->specific);
 }
 
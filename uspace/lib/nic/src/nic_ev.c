@@ -35,6 +35,7 @@
  * @brief
  */
 
+#include <as.h>
 #include <async.h>
 #include <nic_iface.h>
 #include <errno.h>
@@ -93,5 +94,38 @@ errno_t nic_ev_received(async_sess_t *sess, void *data, size_t size)
 	return retval;
 }
 
+/** Share buffer for batched frame delivery with the client. */
+errno_t nic_ev_rx_buffer(async_sess_t *sess, void *buf)
+{
+	async_exch_t *exch = async_exchange_begin(sess);
+
+	ipc_call_t answer;
+	aid_t req = async_send_0(exch, NIC_EV_RX_BUFFER, &answer);
+	errno_t retval = async_share_out_start(exch, buf,
+	    AS_AREA_READ | AS_AREA_CACHEABLE);
+
+	async_exchange_end(exch);
+
+	if (retval != EOK) {
+		async_forget(req);
+		return retval;
+	}
+
+	async_wait_for(req, &retval);
+	return retval;
+}
+
+/** Frames received into the shared buffer. */
+errno_t nic_ev_received_batch(async_sess_t *sess, size_t count, size_t size)
+{
+	errno_t rc;
+
+	async_exch_t *exch = async_exchange_begin(sess);
+	rc = async_req_2_0(exch, NIC_EV_RECEIVED_BATCH, count, size);
+	async_exchange_end(exch);
+
+	return rc;
+}
+
 /** @}
  */
@@ -169,6 +169,7 @@ errno_t nic_set_state_impl(ddf_fun_t *fun, nic_device_state_t state)
  *
  * @return EOK		If the message was sent
  * @return EBUSY	If the device is not in state when the frame can be sent.
+ * @return Error code returned by the try_send_frame handler otherwise.
  */
 errno_t nic_send_frame_impl(ddf_fun_t *fun, void *data, size_t size)
 {
@@ -179,6 +180,13 @@ errno_t nic_send_frame_impl(ddf_fun_t *fun, void *data, size_t size)
 		fibril_rwlock_read_unlock(&nic_data->main_lock);
 		return EBUSY;
 	}
+	if (nic_data->try_send_frame != NULL) {
+		errno_t rc = nic_data->try_send_frame(nic_data, data, size);
+		if (rc == EOK)
+			pcapdump_packet(nic_get_pcap_dumper(nic_data), data, size);
+		fibril_rwlock_read_unlock(&nic_data->main_lock);
+		return rc;
+	}
 	pcapdump_packet(nic_get_pcap_dumper(nic_data), data, size);
 	nic_data->send_frame(nic_data, data, size);
 	fibril_rwlock_read_unlock(&nic_data->main_lock);
@@ -204,6 +212,12 @@ errno_t nic_callback_create_impl(ddf_fun_t *fun)
 		return ENOMEM;
 	}
 
+	/* Offer the shared receive buffer to the new client */
+	fibril_mutex_lock(&nic->rx_buffer_lock);
+	nic->rx_buffer_shared = false;
+	nic->rx_buffer_unsupported = false;
+	fibril_mutex_unlock(&nic->rx_buffer_lock);
+
 	fibril_rwlock_write_unlock(&nic->main_lock);
 	return EOK;
 }
@@ -218,6 +218,17 @@ _fat_block_get(block_t **block, fat_bs_t *bs, service_id_t service_id,
 
 	rc = block_get(block, service_id, CLBN2PBN(bs, c, bn), flags);
 
+	/*
+	 * The sectors of a cluster are contiguous on the device. When the
+	 * first sector of a cluster is read, have the rest of the cluster
+	 * read ahead.
+	 */
+	if (rc == EOK && !(flags & BLOCK_FLAGS_NOREAD) &&
+	    (bn % SPC(bs)) == 0 && SPC(bs) > 1) {
+		(void) block_prefetch(service_id, CLBN2PBN(bs, c, bn) + 1,
+		    SPC(bs) - 1);
+	}
+
 	if (clp)
 		*clp = c;
 
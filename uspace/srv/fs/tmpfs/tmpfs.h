@@ -36,7 +36,13 @@
 #include <libfs.h>
 #include <stddef.h>
 #include <stdbool.h>
+#include <stdint.h>
 #include <adt/hash_table.h>
+#include <adt/list.h>
+#include <as.h>
+
+/** Size of a file data chunk. */
+#define TMPFS_CHUNK_SIZE	PAGE_SIZE
 
 #define TMPFS_NODE(node)	((node) ? (tmpfs_node_t *)(node)->data : NULL)
 #define FS_NODE(node)		((node) ? (node)->bp : NULL)
@@ -51,11 +57,26 @@ typedef enum {
 struct tmpfs_node;
 
 typedef struct tmpfs_dentry {
-	link_t link;		/**< Linkage for the list of siblings. */
+	ht_link_t dh_link;	/**< Dentries hash table link. */
+	struct tmpfs_node *parent;/**< Directory containing the dentry. */
+	size_t pos;		/**< Position in the parent's children array. */
 	struct tmpfs_node *node;/**< Back pointer to TMPFS node. */
 	char *name;		/**< Name of dentry. */
 } tmpfs_dentry_t;
 
+/** Chunk of file data.
+ *
+ * File contents are kept in chunks of TMPFS_CHUNK_SIZE bytes. Chunks which
+ * were never written to are not allocated at all and read as zeros.
+ */
+typedef struct tmpfs_chunk {
+	ht_link_t ch_link;	/**< Chunks hash table link. */
+	link_t link;		/**< Link in the node's list of chunks. */
+	struct tmpfs_node *node;/**< Node owning the chunk. */
+	aoff64_t index;		/**< Chunk number within the file. */
+	uint8_t data[TMPFS_CHUNK_SIZE];
+} tmpfs_chunk_t;
+
 typedef struct tmpfs_node {
 	fs_node_t *bp;		/**< Back pointer to the FS node. */
 	fs_index_t index;	/**< TMPFS node index. */
@@ -63,9 +84,11 @@ typedef struct tmpfs_node {
 	ht_link_t nh_link;		/**< Nodes hash table link. */
 	tmpfs_dentry_type_t type;
 	unsigned lnkcnt;	/**< Link count. */
-	size_t size;		/**< File size if type is TMPFS_FILE. */
-	void *data;		/**< File content's if type is TMPFS_FILE. */
-	list_t cs_list;		/**< Child's siblings list. */
+	aoff64_t size;		/**< File size if type is TMPFS_FILE. */
+	list_t chunks;		/**< Allocated chunks if type is TMPFS_FILE. */
+	tmpfs_dentry_t **children;/**< Dentries in the order of creation. */
+	size_t children_count;	/**< Number of dentries in children. */
+	size_t children_size;	/**< Allocated size of children. */
 } tmpfs_node_t;
 
 extern vfs_out_ops_t tmpfs_ops;
@@ -79,7 +79,7 @@ static errno_t tmpfs_root_get(fs_node_t **rfn, service_id_t service_id)
 
 static errno_t tmpfs_has_children(bool *has_children, fs_node_t *fn)
 {
-	*has_children = !list_empty(&TMPFS_NODE(fn)->cs_list);
+	*has_children = TMPFS_NODE(fn)->children_count > 0;
 	return EOK;
 }
 
@@ -136,6 +136,17 @@ libfs_ops_t tmpfs_libfs_ops = {
 /** Hash table of all TMPFS nodes. */
 hash_table_t nodes;
 
+/** Hash table of all TMPFS dentries, keyed by parent node and name. */
+static hash_table_t dentries;
+
+/** Hash table of all allocated file chunks, keyed by node and chunk number. */
+static hash_table_t chunks;
+
+/** Contents of chunks which were never written to. */
+static const uint8_t tmpfs_zero_chunk[TMPFS_CHUNK_SIZE];
+
+static void tmpfs_chunks_trim(tmpfs_node_t *, aoff64_t);
+
 /*
  * Implementation of hash table interface for the nodes hash table.
  */
@@ -170,18 +181,19 @@ static void nodes_remove_callback(ht_link_t *item)
 {
 	tmpfs_node_t *nodep = hash_table_get_inst(item, tmpfs_node_t, nh_link);
 
-	while (!list_empty(&nodep->cs_list)) {
-		tmpfs_dentry_t *dentryp = list_get_instance(
-		    list_first(&nodep->cs_list), tmpfs_dentry_t, link);
+	for (size_t i = 0; i < nodep->children_count; i++) {
+		tmpfs_dentry_t *dentryp = nodep->children[i];
 
 		assert(nodep->type == TMPFS_DIRECTORY);
-		list_remove(&dentryp->link);
+		hash_table_remove_item(&dentries, &dentryp->dh_link);
+		free(dentryp->name);
 		free(dentryp);
 	}
+	free(nodep->children);
 
-	if (nodep->data) {
+	if (!list_empty(&nodep->chunks)) {
 		assert(nodep->type == TMPFS_FILE);
-		free(nodep->data);
+		tmpfs_chunks_trim(nodep, 0);
 	}
 	free(nodep->bp);
 	free(nodep);
@@ -196,6 +208,177 @@ const hash_table_ops_t nodes_ops = {
 	.remove_callback = nodes_remove_callback
 };
 
+/*
+ * Implementation of hash table interface for the dentries hash table.
+ */
+
+typedef struct {
+	tmpfs_node_t *parent;
+	const char *name;
+} dentry_key_t;
+
+static size_t dentries_key_hash(const void *k)
+{
+	const dentry_key_t *key = k;
+	return hash_combine((uintptr_t) key->parent, hash_string(key->name));
+}
+
+static size_t dentries_hash(const ht_link_t *item)
+{
+	tmpfs_dentry_t *dentryp = hash_table_get_inst(item, tmpfs_dentry_t,
+	    dh_link);
+	return hash_combine((uintptr_t) dentryp->parent,
+	    hash_string(dentryp->name));
+}
+
+static bool dentries_key_equal(const void *key_arg, size_t hash,
+    const ht_link_t *item)
+{
+	tmpfs_dentry_t *dentryp = hash_table_get_inst(item, tmpfs_dentry_t,
+	    dh_link);
+	const dentry_key_t *key = key_arg;
+
+	return key->parent == dentryp->parent &&
+	    str_cmp(key->name, dentryp->name) == 0;
+}
+
+/** TMPFS dentries hash table operations. */
+static const hash_table_ops_t dentries_ops = {
+	.hash = dentries_hash,
+	.key_hash = dentries_key_hash,
+	.key_equal = dentries_key_equal,
+	.equal = NULL,
+	.remove_callback = NULL
+};
+
+/*
+ * Implementation of hash table interface for the chunks hash table.
+ */
+
+typedef struct {
+	tmpfs_node_t *node;
+	aoff64_t index;
+} chunk_key_t;
+
+static size_t chunks_key_hash(const void *k)
+{
+	const chunk_key_t *key = k;
+	return hash_combine((uintptr_t) key->node, hash_mix(key->index));
+}
+
+static size_t chunks_hash(const ht_link_t *item)
+{
+	tmpfs_chunk_t *chunk = hash_table_get_inst(item, tmpfs_chunk_t,
+	    ch_link);
+	return hash_combine((uintptr_t) chunk->node, hash_mix(chunk->index));
+}
+
+static bool chunks_key_equal(const void *key_arg, size_t hash,
+    const ht_link_t *item)
+{
+	tmpfs_chunk_t *chunk = hash_table_get_inst(item, tmpfs_chunk_t,
+	    ch_link);
+	const chunk_key_t *key = key_arg;
+
+	return key->node == chunk->node && key->index == chunk->index;
+}
+
+/** TMPFS chunks hash table operations. */
+static const hash_table_ops_t chunks_ops = {
+	.hash = chunks_hash,
+	.key_hash = chunks_key_hash,
+	.key_equal = chunks_key_equal,
+	.equal = NULL,
+	.remove_callback = NULL
+};
+
+/** Find an allocated chunk of a file.
+ *
+ * @param nodep		File node.
+ * @param index		Chunk number.
+ *
+ * @return		Chunk or NULL if this part of the file is a hole.
+ */
+static tmpfs_chunk_t *tmpfs_chunk_find(tmpfs_node_t *nodep, aoff64_t index)
+{
+	chunk_key_t key = {
+		.node = nodep,
+		.index = index
+	};
+
+	ht_link_t *lnk = hash_table_find(&chunks, &key);
+	if (!lnk)
+		return NULL;
+
+	return hash_table_get_inst(lnk, tmpfs_chunk_t, ch_link);
+}
+
+/** Find or allocate a chunk of a file.
+ *
+ * Newly allocated chunks are zero-filled.
+ *
+ * @param nodep		File node.
+ * @param index		Chunk number.
+ *
+ * @return		Chunk or NULL if out of memory.
+ */
+static tmpfs_chunk_t *tmpfs_chunk_get(tmpfs_node_t *nodep, aoff64_t index)
+{
+	tmpfs_chunk_t *chunk = tmpfs_chunk_find(nodep, index);
+	if (chunk)
+		return chunk;
+
+	chunk = malloc(sizeof(tmpfs_chunk_t));
+	if (!chunk)
+		return NULL;
+
+	link_initialize(&chunk->link);
+	chunk->node = nodep;
+	chunk->index = index;
+	memset(chunk->data, 0, TMPFS_CHUNK_SIZE);
+
+	hash_table_insert(&chunks, &chunk->ch_link);
+	list_append(&chunk->link, &nodep->chunks);
+	return chunk;
+}
+
+/** Release file data beyond the given size.
+ *
+ * Chunks lying entirely past @a size are freed and the tail of the last
+ * partial chunk is cleared so that the file reads as zeros there if it is
+ * extended again.
+ *
+ * @param nodep		File node.
+ * @param size		New file size.
+ */
+static void tmpfs_chunks_trim(tmpfs_node_t *nodep, aoff64_t size)
+{
+	aoff64_t first = size / TMPFS_CHUNK_SIZE;
+	size_t offset = size % TMPFS_CHUNK_SIZE;
+
+	if (offset != 0)
+		first++;
+
+	list_foreach_safe(nodep->chunks, cur, next) {
+		tmpfs_chunk_t *chunk = list_get_instance(cur, tmpfs_chunk_t,
+		    link);
+
+		if (chunk->index >= first) {
+			hash_table_remove_item(&chunks, &chunk->ch_link);
+			list_remove(&chunk->link);
+			free(chunk);
+		}
+	}
+
+	if (offset != 0) {
+		tmpfs_chunk_t *chunk = tmpfs_chunk_find(nodep, first - 1);
+		if (chunk) {
+			memset(chunk->data + offset, 0,
+			    TMPFS_CHUNK_SIZE - offset);
+		}
+	}
+}
+
 static void tmpfs_node_initialize(tmpfs_node_t *nodep)
 {
 	nodep->bp = NULL;
@@ -204,13 +387,16 @@ static void tmpfs_node_initialize(tmpfs_node_t *nodep)
 	nodep->type = TMPFS_NONE;
 	nodep->lnkcnt = 0;
 	nodep->size = 0;
-	nodep->data = NULL;
-	list_initialize(&nodep->cs_list);
+	list_initialize(&nodep->chunks);
+	nodep->children = NULL;
+	nodep->children_count = 0;
+	nodep->children_size = 0;
 }
 
 static void tmpfs_dentry_initialize(tmpfs_dentry_t *dentryp)
 {
-	link_initialize(&dentryp->link);
+	dentryp->parent = NULL;
+	dentryp->pos = 0;
 	dentryp->name = NULL;
 	dentryp->node = NULL;
 }
@@ -220,9 +406,42 @@ bool tmpfs_init(void)
 	if (!hash_table_create(&nodes, 0, 0, &nodes_ops))
 		return false;
 
+	if (!hash_table_create(&dentries, 0, 0, &dentries_ops)) {
+		hash_table_destroy(&nodes);
+		return false;
+	}
+
+	if (!hash_table_create(&chunks, 0, 0, &chunks_ops)) {
+		hash_table_destroy(&dentries);
+		hash_table_destroy(&nodes);
+		return false;
+	}
+
 	return true;
 }
 
+/** Find a dentry in a directory.
+ *
+ * @param parentp	Directory node.
+ * @param name		Name of the dentry.
+ *
+ * @return		Dentry or NULL if there is no such entry.
+ */
+static tmpfs_dentry_t *tmpfs_dentry_find(tmpfs_node_t *parentp,
+    const char *name)
+{
+	dentry_key_t key = {
+		.parent = parentp,
+		.name = name
+	};
+
+	ht_link_t *lnk = hash_table_find(&dentries, &key);
+	if (!lnk)
+		return NULL;
+
+	return hash_table_get_inst(lnk, tmpfs_dentry_t, dh_link);
+}
+
 static bool tmpfs_instance_init(service_id_t service_id)
 {
 	fs_node_t *rfn;
@@ -253,16 +472,9 @@ static void tmpfs_instance_done(service_id_t service_id)
 
 errno_t tmpfs_match(fs_node_t **rfn, fs_node_t *pfn, const char *component)
 {
-	tmpfs_node_t *parentp = TMPFS_NODE(pfn);
-
-	list_foreach(parentp->cs_list, link, tmpfs_dentry_t, dentryp) {
-		if (!str_cmp(dentryp->name, component)) {
-			*rfn = FS_NODE(dentryp->node);
-			return EOK;
-		}
-	}
+	tmpfs_dentry_t *dentryp = tmpfs_dentry_find(TMPFS_NODE(pfn), component);
 
-	*rfn = NULL;
+	*rfn = dentryp ? FS_NODE(dentryp->node) : NULL;
 	return EOK;
 }
 
@@ -342,7 +554,7 @@ errno_t tmpfs_destroy_node(fs_node_t *fn)
 	tmpfs_node_t *nodep = TMPFS_NODE(fn);
 
 	assert(!nodep->lnkcnt);
-	assert(list_empty(&nodep->cs_list));
+	assert(nodep->children_count == 0);
 
 	hash_table_remove_item(&nodes, &nodep->nh_link);
 
@@ -362,9 +574,18 @@ errno_t tmpfs_link_node(fs_node_t *pfn, fs_node_t *cfn, const char *nm)
 	assert(parentp->type == TMPFS_DIRECTORY);
 
 	/* Check for duplicit entries. */
-	list_foreach(parentp->cs_list, link, tmpfs_dentry_t, dp) {
-		if (!str_cmp(dp->name, nm))
-			return EEXIST;
+	if (tmpfs_dentry_find(parentp, nm))
+		return EEXIST;
+
+	/* Make room in the parent's children array. */
+	if (parentp->children_count == parentp->children_size) {
+		size_t nsize = max(2 * parentp->children_size, 8);
+		tmpfs_dentry_t **nchildren = realloc(parentp->children,
+		    nsize * sizeof(tmpfs_dentry_t *));
+		if (!nchildren)
+			return ENOMEM;
+		parentp->children = nchildren;
+		parentp->children_size = nsize;
 	}
 
 	/* Allocate and initialize the dentry. */
@@ -381,9 +602,13 @@ errno_t tmpfs_link_node(fs_node_t *pfn, fs_node_t *cfn, const char *nm)
 		return ENOMEM;
 	}
 	str_cpy(dentryp->name, size + 1, nm);
+	dentryp->parent = parentp;
 	dentryp->node = childp;
 	childp->lnkcnt++;
-	list_append(&dentryp->link, &parentp->cs_list);
+
+	dentryp->pos = parentp->children_count;
+	parentp->children[parentp->children_count++] = dentryp;
+	hash_table_insert(&dentries, &dentryp->dh_link);
 
 	return EOK;
 }
@@ -397,22 +622,31 @@ errno_t tmpfs_unlink_node(fs_node_t *pfn, fs_node_t *cfn, const char *nm)
 	if (!parentp)
 		return EBUSY;
 
-	list_foreach(parentp->cs_list, link, tmpfs_dentry_t, dp) {
-		if (!str_cmp(dp->name, nm)) {
-			dentryp = dp;
-			childp = dentryp->node;
-			assert(FS_NODE(childp) == cfn);
-			break;
-		}
+	dentryp = tmpfs_dentry_find(parentp, nm);
+	if (dentryp) {
+		childp = dentryp->node;
+		assert(FS_NODE(childp) == cfn);
 	}
 
 	if (!childp)
 		return ENOENT;
 
-	if ((childp->lnkcnt == 1) && !list_empty(&childp->cs_list))
+	if ((childp->lnkcnt == 1) && childp->children_count > 0)
 		return ENOTEMPTY;
 
-	list_remove(&dentryp->link);
+	hash_table_remove_item(&dentries, &dentryp->dh_link);
+
+	/*
+	 * Keep the remaining dentries in the order of creation so that
+	 * directory positions behave as they did with a plain list.
+	 */
+	for (size_t i = dentryp->pos + 1; i < parentp->children_count; i++) {
+		parentp->children[i - 1] = parentp->children[i];
+		parentp->children[i - 1]->pos = i - 1;
+	}
+	parentp->children_count--;
+
+	free(dentryp->name);
 	free(dentryp);
 	childp->lnkcnt--;
 
@@ -491,28 +725,35 @@ static errno_t tmpfs_read(service_id_t service_id, fs_index_t index, aoff64_t po
 
 	size_t bytes;
 	if (nodep->type == TMPFS_FILE) {
-		bytes = min(nodep->size - pos, size);
-		(void) async_data_read_finalize(&call, nodep->data + pos,
-		    bytes);
+		/*
+		 * Serve at most one chunk per request. The client retries
+		 * short reads.
+		 */
+		size_t offset = pos % TMPFS_CHUNK_SIZE;
+		const uint8_t *src = tmpfs_zero_chunk;
+
+		bytes = 0;
+		if (pos < nodep->size)
+			bytes = min(nodep->size - pos, size);
+		bytes = min(bytes, TMPFS_CHUNK_SIZE - offset);
+
+		tmpfs_chunk_t *chunk = tmpfs_chunk_find(nodep,
+		    pos / TMPFS_CHUNK_SIZE);
+		if (chunk)
+			src = chunk->data;
+
+		(void) async_data_read_finalize(&call, src + offset, bytes);
 	} else {
 		tmpfs_dentry_t *dentryp;
-		link_t *lnk;
 
 		assert(nodep->type == TMPFS_DIRECTORY);
 
-		/*
-		 * Yes, we really use O(n) algorithm here.
-		 * If it bothers someone, it could be fixed by introducing a
-		 * hash table.
-		 */
-		lnk = list_nth(&nodep->cs_list, pos);
-
-		if (lnk == NULL) {
+		if (pos >= nodep->children_count) {
 			async_answer_0(&call, ENOENT);
 			return ENOENT;
 		}
 
-		dentryp = list_get_instance(lnk, tmpfs_dentry_t, link);
+		dentryp = nodep->children[pos];
 
 		(void) async_data_read_finalize(&call, dentryp->name,
 		    str_size(dentryp->name) + 1);
@@ -553,33 +794,24 @@ tmpfs_write(service_id_t service_id, fs_index_t index, aoff64_t pos,
 	}
 
 	/*
-	 * Check whether the file needs to grow.
-	 */
-	if (pos + size <= nodep->size) {
-		/* The file size is not changing. */
-		(void) async_data_write_finalize(&call, nodep->data + pos,
-		    size);
-		goto out;
-	}
-	size_t delta = (pos + size) - nodep->size;
-	/*
-	 * At this point, we are deliberately extremely straightforward and
-	 * simply realloc the contents of the file on every write that grows the
-	 * file. In the end, the situation might not be as bad as it may look:
-	 * our heap allocator can save us and just grow the block whenever
-	 * possible.
+	 * Write at most up to the end of the chunk containing pos. The client
+	 * retries short writes. Any skipped-over chunks remain unallocated
+	 * holes.
 	 */
-	void *newdata = realloc(nodep->data, nodep->size + delta);
-	if (!newdata) {
+	size_t offset = pos % TMPFS_CHUNK_SIZE;
+	size = min(size, TMPFS_CHUNK_SIZE - offset);
+
+	tmpfs_chunk_t *chunk = tmpfs_chunk_get(nodep, pos / TMPFS_CHUNK_SIZE);
+	if (!chunk) {
 		async_answer_0(&call, ENOMEM);
 		size = 0;
 		goto out;
 	}
-	/* Clear any newly allocated memory in order to emulate gaps. */
-	memset(newdata + nodep->size, 0, delta);
-	nodep->size += delta;
-	nodep->data = newdata;
-	(void) async_data_write_finalize(&call, nodep->data + pos, size);
+
+	(void) async_data_write_finalize(&call, chunk->data + offset, size);
+
+	if (pos + size > nodep->size)
+		nodep->size = pos + size;
 
 out:
 	*wbytes = size;
@@ -606,20 +838,14 @@ static errno_t tmpfs_truncate(service_id_t service_id, fs_index_t index,
 	if (size == nodep->size)
 		return EOK;
 
-	if (size > SIZE_MAX)
-		return ENOMEM;
-
-	void *newdata = realloc(nodep->data, size);
-	if (!newdata && size)
-		return ENOMEM;
-
-	if (size > nodep->size) {
-		size_t delta = size - nodep->size;
-		memset(newdata + nodep->size, 0, delta);
-	}
+	/*
+	 * Growing the file merely creates a hole. Shrinking it releases
+	 * the chunks past the new end.
+	 */
+	if (size < nodep->size)
+		tmpfs_chunks_trim(nodep, size);
 
 	nodep->size = size;
-	nodep->data = newdata;
 	return EOK;
 }
 
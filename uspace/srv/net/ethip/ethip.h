@@ -63,6 +63,9 @@ typedef struct ethip_nic {
 	/** MAC address */
 	eth_addr_t mac_addr;
 
+	/** Buffer shared with the NIC driver for batched frame delivery */
+	void *rx_buffer;
+
 	/**
 	 * List of IP addresses configured on this link
 	 * (of the type ethip_link_addr_t)
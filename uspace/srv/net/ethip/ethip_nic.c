@@ -35,6 +35,8 @@
  */
 
 #include <adt/list.h>
+#include <align.h>
+#include <as.h>
 #include <async.h>
 #include <errno.h>
 #include <fibril_synch.h>
@@ -138,6 +140,8 @@ static void ethip_nic_delete(ethip_nic_t *nic)
 {
 	if (nic->svc_name != NULL)
 		free(nic->svc_name);
+	if (nic->rx_buffer != NULL)
+		as_area_destroy(nic->rx_buffer);
 
 	free(nic);
 }
@@ -284,6 +288,75 @@ static void ethip_nic_received(ethip_nic_t *nic, ipc_call_t *call)
 	async_answer_0(call, rc);
 }
 
+static void ethip_nic_rx_buffer(ethip_nic_t *nic, ipc_call_t *icall)
+{
+	ipc_call_t call;
+	size_t size;
+	unsigned int flags;
+	void *buf;
+	errno_t rc;
+
+	log_msg(LOG_DEFAULT, LVL_DEBUG, "ethip_nic_rx_buffer()");
+
+	if (!async_share_out_receive(&call, &size, &flags)) {
+		async_answer_0(&call, EINVAL);
+		async_answer_0(icall, EINVAL);
+		return;
+	}
+
+	if (size != NIC_RX_BUFFER_SIZE) {
+		async_answer_0(&call, EINVAL);
+		async_answer_0(icall, EINVAL);
+		return;
+	}
+
+	rc = async_share_out_finalize(&call, &buf);
+	if (rc != EOK || buf == AS_MAP_FAILED) {
+		async_answer_0(icall, ENOMEM);
+		return;
+	}
+
+	/* The driver may share a new buffer after reconnecting */
+	if (nic->rx_buffer != NULL)
+		as_area_destroy(nic->rx_buffer);
+
+	nic->rx_buffer = buf;
+	async_answer_0(icall, EOK);
+}
+
+static void ethip_nic_received_batch(ethip_nic_t *nic, ipc_call_t *call)
+{
+	nic_rx_frame_hdr_t *hdr;
+	size_t count = ipc_get_arg1(call);
+	size_t used = ipc_get_arg2(call);
+	size_t off = 0;
+	size_t i;
+
+	log_msg(LOG_DEFAULT, LVL_DEBUG, "ethip_nic_received_batch() nic=%p "
+	    "count=%zu", nic, count);
+
+	if (nic->rx_buffer == NULL || used > NIC_RX_BUFFER_SIZE) {
+		async_answer_0(call, EINVAL);
+		return;
+	}
+
+	for (i = 0; i < count; i++) {
+		if (off >= used || used - off < sizeof(nic_rx_frame_hdr_t))
+			break;
+
+		hdr = (nic_rx_frame_hdr_t *) ((uint8_t *) nic->rx_buffer + off);
+		if (hdr->size > used - off - sizeof(nic_rx_frame_hdr_t))
+			break;
+
+		(void) ethip_received(&nic->iplink, hdr + 1, hdr->size);
+
+		off += ALIGN_UP(sizeof(nic_rx_frame_hdr_t) + hdr->size,
+		    NIC_RX_FRAME_ALIGN);
+	}
+
+	async_answer_0(call, i == count ? EOK : EINVAL);
+}
+
 static void ethip_nic_device_state(ethip_nic_t *nic, ipc_call_t *call)
 {
 	log_msg(LOG_DEFAULT, LVL_DEBUG, "ethip_nic_device_state()");
@@ -315,6 +388,12 @@ static void ethip_nic_cb_conn(ipc_call_t *icall, void *arg)
 		case NIC_EV_DEVICE_STATE:
 			ethip_nic_device_state(nic, &call);
 			break;
+		case NIC_EV_RX_BUFFER:
+			ethip_nic_rx_buffer(nic, &call);
+			break;
+		case NIC_EV_RECEIVED_BATCH:
+			ethip_nic_received_batch(nic, &call);
+			break;
 		default:
 			log_msg(LOG_DEFAULT, LVL_DEBUG, "unknown IPC method: %" PRIun, ipc_get_imethod(&call));
 			async_answer_0(&call, ENOTSUP);
@@ -0,0 +1,314 @@
+/*
+ * Copyright (c) 2026 The HelenOS Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup inet
+ * @{
+ */
+/**
+ * @file
+ * @brief Path-compressed binary trie for longest-prefix matching
+ *
+ * Each node stores a whole prefix, so a chain of nodes with a single child
+ * never occurs and a lookup visits at most one node per distinct prefix
+ * length on the path to the address.
+ */
+
+#include <assert.h>
+#include <errno.h>
+#include <mem.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include "rtrie.h"
+
+/** Get bit @a i of @a key, counting from the most significant bit. */
+static unsigned rtrie_bit(const uint8_t *key, unsigned i)
+{
+	return (key[i / 8] >> (7 - i % 8)) & 1;
+}
+
+/** Determine whether the first @a bits bits of two keys are equal. */
+static bool rtrie_prefix_match(const uint8_t *a, const uint8_t *b,
+    unsigned bits)
+{
+	unsigned bytes = bits / 8;
+
+	if (memcmp(a, b, bytes) != 0)
+		return false;
+
+	if (bits % 8 == 0)
+		return true;
+
+	uint8_t mask = 0xff << (8 - bits % 8);
+	return ((a[bytes] ^ b[bytes]) & mask) == 0;
+}
+
+/** Determine the length of the common prefix of two keys.
+ *
+ * @param a First key
+ * @param b Second key
+ * @param bits Maximum length to compare in bits
+ * @return Number of leading bits that are equal, at most @a bits
+ */
+static unsigned rtrie_common_bits(const uint8_t *a, const uint8_t *b,
+    unsigned bits)
+{
+	unsigned i = 0;
+
+	while (i < bits && a[i / 8] == b[i / 8])
+		i += 8;
+
+	while (i < bits && rtrie_bit(a, i) == rtrie_bit(b, i))
+		i++;
+
+	return i < bits ? i : bits;
+}
+
+/** Create trie node.
+ *
+ * @param key Key, only the first @a bits bits are used
+ * @param bits Prefix length
+ * @param arg Argument
+ * @return New node or @c NULL if out of memory
+ */
+static rtrie_node_t *rtrie_node_create(const uint8_t *key, unsigned bits,
+    void *arg)
+{
+	rtrie_node_t *node = calloc(1, sizeof(rtrie_node_t));
+	if (node == NULL)
+		return NULL;
+
+	memcpy(node->key, key, (bits + 7) / 8);
+	if (bits % 8 != 0)
+		node->key[bits / 8] &= 0xff << (8 - bits % 8);
+
+	node->bits = bits;
+	node->arg = arg;
+	return node;
+}
+
+/** Destroy subtree. */
+static void rtrie_node_destroy(rtrie_node_t *node)
+{
+	if (node == NULL)
+		return;
+
+	rtrie_node_destroy(node->child[0]);
+	rtrie_node_destroy(node->child[1]);
+	free(node);
+}
+
+/** Initialize trie.
+ *
+ * @param trie Trie
+ * @param key_bits Length of keys in bits
+ */
+void rtrie_init(rtrie_t *trie, uint8_t key_bits)
+{
+	assert(key_bits <= RTRIE_KEY_SIZE * 8);
+
+	trie->root = NULL;
+	trie->key_bits = key_bits;
+	trie->count = 0;
+}
+
+/** Free all nodes of a trie.
+ *
+ * The arguments are not touched.
+ *
+ * @param trie Trie
+ */
+void rtrie_fini(rtrie_t *trie)
+{
+	rtrie_node_destroy(trie->root);
+	trie->root = NULL;
+	trie->count = 0;
+}
+
+/** Insert prefix into trie.
+ *
+ * @param trie Trie
+ * @param key Key, bits past @a bits are ignored
+ * @param bits Prefix length
+ * @param arg Argument to associate with the prefix, must not be @c NULL
+ * @return EOK on success, EEXIST if the prefix is already present,
+ *         ENOMEM if out of memory
+ */
+errno_t rtrie_insert(rtrie_t *trie, const uint8_t *key, uint8_t bits,
+    void *arg)
+{
+	rtrie_node_t **link = &trie->root;
+	rtrie_node_t *node;
+	rtrie_node_t *leaf;
+	rtrie_node_t *join;
+	unsigned common;
+
+	assert(arg != NULL);
+	assert(bits <= trie->key_bits);
+
+	while (true) {
+		node = *link;
+		if (node == NULL) {
+			leaf = rtrie_node_create(key, bits, arg);
+			if (leaf == NULL)
+				return ENOMEM;
+
+			*link = leaf;
+			break;
+		}
+
+		common = rtrie_common_bits(node->key, key,
+		    node->bits < bits ? node->bits : bits);
+
+		if (common == node->bits && common == bits) {
+			/* Same prefix */
+			if (node->arg != NULL)
+				return EEXIST;
+
+			node->arg = arg;
+			break;
+		}
+
+		if (common == node->bits) {
+			/* Node prefix is a prefix of the key, descend */
+			link = &node->child[rtrie_bit(key, node->bits)];
+			continue;
+		}
+
+		leaf = rtrie_node_create(key, bits, arg);
+		if (leaf == NULL)
+			return ENOMEM;
+
+		if (common == bits) {
+			/* Key is a prefix of the node prefix */
+			leaf->child[rtrie_bit(node->key, bits)] = node;
+			*link = leaf;
+			break;
+		}
+
+		/* Prefixes diverge, join them under their common prefix */
+		join = rtrie_node_create(key, common, NULL);
+		if (join == NULL) {
+			free(leaf);
+			return ENOMEM;
+		}
+
+		join->child[rtrie_bit(key, common)] = leaf;
+		join->child[rtrie_bit(node->key, common)] = node;
+		*link = join;
+		break;
+	}
+
+	trie->count++;
+	return EOK;
+}
+
+/** Remove prefix from trie.
+ *
+ * @param trie Trie
+ * @param key Key, bits past @a bits are ignored
+ * @param bits Prefix length
+ * @param arg Argument associated with the prefix
+ * @return EOK on success, ENOENT if the prefix is not present or it is
+ *         associated with a different argument
+ */
+errno_t rtrie_remove(rtrie_t *trie, const uint8_t *key, uint8_t bits,
+    void *arg)
+{
+	rtrie_node_t **plink = NULL;
+	rtrie_node_t **link = &trie->root;
+	rtrie_node_t *node;
+	rtrie_node_t *parent;
+	rtrie_node_t *child;
+
+	while (true) {
+		node = *link;
+		if (node == NULL || node->bits > bits ||
+		    !rtrie_prefix_match(node->key, key, node->bits))
+			return ENOENT;
+
+		if (node->bits == bits)
+			break;
+
+		plink = link;
+		link = &node->child[rtrie_bit(key, node->bits)];
+	}
+
+	if (node->arg != arg)
+		return ENOENT;
+
+	node->arg = NULL;
+	trie->count--;
+
+	/* A node with both subtrees stays to join them */
+	if (node->child[0] != NULL && node->child[1] != NULL)
+		return EOK;
+
+	child = node->child[0] != NULL ? node->child[0] : node->child[1];
+	*link = child;
+	free(node);
+
+	/* The parent may have been left as a joining node with one subtree */
+	if (child == NULL && plink != NULL) {
+		parent = *plink;
+		if (parent->arg == NULL) {
+			*plink = parent->child[0] != NULL ? parent->child[0] :
+			    parent->child[1];
+			free(parent);
+		}
+	}
+
+	return EOK;
+}
+
+/** Find the longest prefix matching an address.
+ *
+ * @param trie Trie
+ * @param addr Address of @c key_bits bits
+ * @return Argument associated with the longest matching prefix or @c NULL
+ *         if there is no match
+ */
+void *rtrie_lookup(rtrie_t *trie, const uint8_t *addr)
+{
+	rtrie_node_t *node = trie->root;
+	void *best = NULL;
+
+	while (node != NULL && rtrie_prefix_match(node->key, addr, node->bits)) {
+		if (node->arg != NULL)
+			best = node->arg;
+
+		if (node->bits >= trie->key_bits)
+			break;
+
+		node = node->child[rtrie_bit(addr, node->bits)];
+	}
+
+	return best;
+}
+
+/** @}
+ */
@@ -0,0 +1,90 @@
+/*
+ * Copyright (c) 2026 The HelenOS Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup inet
+ * @{
+ */
+/**
+ * @file
+ * @brief Path-compressed binary trie for longest-prefix matching
+ */
+
+#ifndef INET_RTRIE_H_
+#define INET_RTRIE_H_
+
+#include <errno.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/** Maximum key length in bytes (IPv6 address) */
+#define RTRIE_KEY_SIZE 16
+
+/** Trie node
+ *
+ * Every node holds a prefix. Nodes without an argument only join two
+ * subtrees whose prefixes differ right after the node's prefix.
+ */
+typedef struct rtrie_node {
+	/** Subtrees, selected by the bit following the prefix */
+	struct rtrie_node *child[2];
+	/** Prefix, bits past @c bits are zero */
+	uint8_t key[RTRIE_KEY_SIZE];
+	/** Prefix length in bits */
+	uint8_t bits;
+	/** Argument or @c NULL if this is a joining node */
+	void *arg;
+} rtrie_node_t;
+
+/** Trie mapping prefixes to arguments */
+typedef struct {
+	/** Root node or @c NULL if the trie is empty */
+	rtrie_node_t *root;
+	/** Length of keys in bits */
+	uint8_t key_bits;
+	/** Number of prefixes in the trie */
+	size_t count;
+} rtrie_t;
+
+/** Initialize a trie with keys of @a bits bits. */
+#define RTRIE_INITIALIZER(bits) \
+	{ \
+		.root = NULL, \
+		.key_bits = (bits), \
+		.count = 0 \
+	}
+
+extern void rtrie_init(rtrie_t *, uint8_t);
+extern void rtrie_fini(rtrie_t *);
+extern errno_t rtrie_insert(rtrie_t *, const uint8_t *, uint8_t, void *);
+extern errno_t rtrie_remove(rtrie_t *, const uint8_t *, uint8_t, void *);
+extern void *rtrie_lookup(rtrie_t *, const uint8_t *);
+
+#endif
+
+/** @}
+ */
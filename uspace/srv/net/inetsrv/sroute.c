@@ -39,18 +39,156 @@
 #include <fibril_synch.h>
 #include <io/log.h>
 #include <ipc/loc.h>
+#include <mem.h>
 #include <sif.h>
+#include <stdatomic.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <str.h>
+#include "rtrie.h"
 #include "sroute.h"
 #include "inetsrv.h"
 #include "inet_link.h"
 
+/** Number of entries in the route cache, must be a power of two */
+#define SROUTE_CACHE_SIZE 64
+
+/** Route cache entry
+ *
+ * Entries are read without locking. A writer makes @c seq odd while it
+ * updates the entry, a reader discards what it read if @c seq changed.
+ */
+typedef struct {
+	/** Sequence number, odd while the entry is being updated */
+	atomic_uint seq;
+	/** Routing table generation the entry belongs to */
+	unsigned gen;
+	/** Destination address */
+	inet_addr_t addr;
+	/** Route to the destination or @c NULL if there is none */
+	inet_sroute_t *sroute;
+} inet_sroute_cache_entry_t;
+
 static FIBRIL_MUTEX_INITIALIZE(sroute_list_lock);
 static LIST_INITIALIZE(sroute_list);
 static sysarg_t sroute_id = 0;
 
+/** Protects the routing tables, taken for writing only to change them */
+static FIBRIL_RWLOCK_INITIALIZE(sroute_table_lock);
+/** Routing tables indexed by destination prefix */
+static rtrie_t sroute_table4 = RTRIE_INITIALIZER(32);
+static rtrie_t sroute_table6 = RTRIE_INITIALIZER(128);
+/** Routing table generation, changed whenever a route is added or removed */
+static atomic_uint sroute_gen = 1;
+/** Recent route lookups */
+static inet_sroute_cache_entry_t sroute_cache[SROUTE_CACHE_SIZE];
+
+/** Convert address to routing table key.
+ *
+ * @param addr Address
+ * @param key Place to store key
+ * @return Routing table for the address family or @c NULL if not supported
+ */
+static rtrie_t *inet_sroute_addr_key(const inet_addr_t *addr, uint8_t *key)
+{
+	addr32_t v4;
+	addr128_t v6;
+
+	switch (inet_addr_get(addr, &v4, &v6)) {
+	case ip_v4:
+		key[0] = v4 >> 24;
+		key[1] = (v4 >> 16) & 0xff;
+		key[2] = (v4 >> 8) & 0xff;
+		key[3] = v4 & 0xff;
+		return &sroute_table4;
+	case ip_v6:
+		memcpy(key, v6, sizeof(addr128_t));
+		return &sroute_table6;
+	default:
+		return NULL;
+	}
+}
+
+/** Convert destination network of a route to routing table key.
+ *
+ * @param sroute Static route
+ * @param key Place to store key, with host bits cleared
+ * @param bits Place to store prefix length
+ * @return Routing table for the address family or @c NULL if not supported
+ */
+static rtrie_t *inet_sroute_dest_key(inet_sroute_t *sroute, uint8_t *key,
+    uint8_t *bits)
+{
+	inet_addr_t addr;
+	rtrie_t *table;
+
+	inet_naddr_addr(&sroute->dest, &addr);
+	table = inet_sroute_addr_key(&addr, key);
+	if (table == NULL)
+		return NULL;
+
+	(void) inet_naddr_get(&sroute->dest, NULL, NULL, bits);
+	if (*bits > table->key_bits)
+		return NULL;
+
+	/* Clear host bits */
+	for (unsigned i = *bits; i < table->key_bits; i++)
+		key[i / 8] &= ~(0x80 >> (i % 8));
+
+	return table;
+}
+
+/** Insert route into routing table.
+ *
+ * If there is a route with the same destination already, it is kept.
+ *
+ * @param sroute Static route
+ */
+static void inet_sroute_table_insert(inet_sroute_t *sroute)
+{
+	uint8_t key[RTRIE_KEY_SIZE];
+	uint8_t bits;
+	rtrie_t *table;
+	errno_t rc;
+
+	table = inet_sroute_dest_key(sroute, key, &bits);
+	if (table == NULL)
+		return;
+
+	rc = rtrie_insert(table, key, bits, sroute);
+	if (rc == ENOMEM) {
+		log_msg(LOG_DEFAULT, LVL_ERROR, "Failed adding static route "
+		    "to routing table. Out of memory.");
+	}
+}
+
+/** Remove route from routing table.
+ *
+ * If another route to the same destination exists, it takes over.
+ *
+ * @param sroute Static route, already removed from the route list
+ */
+static void inet_sroute_table_remove(inet_sroute_t *sroute)
+{
+	uint8_t key[RTRIE_KEY_SIZE];
+	uint8_t okey[RTRIE_KEY_SIZE];
+	uint8_t bits;
+	uint8_t obits;
+	rtrie_t *table;
+
+	table = inet_sroute_dest_key(sroute, key, &bits);
+	if (table == NULL || rtrie_remove(table, key, bits, sroute) != EOK)
+		return;
+
+	list_foreach(sroute_list, sroute_list, inet_sroute_t, other) {
+		if (inet_sroute_dest_key(other, okey, &obits) == table &&
+		    obits == bits && memcmp(okey, key, (bits + 7) / 8) == 0) {
+			inet_sroute_table_insert(other);
+			break;
+		}
+	}
+}
+
 inet_sroute_t *inet_sroute_new(void)
 {
 	inet_sroute_t *sroute = calloc(1, sizeof(inet_sroute_t));
@@ -81,56 +219,83 @@ void inet_sroute_add(inet_sroute_t *sroute)
 	fibril_mutex_lock(&sroute_list_lock);
 	list_append(&sroute->sroute_list, &sroute_list);
 	fibril_mutex_unlock(&sroute_list_lock);
+
+	fibril_rwlock_write_lock(&sroute_table_lock);
+	inet_sroute_table_insert(sroute);
+	atomic_fetch_add(&sroute_gen, 1);
+	fibril_rwlock_write_unlock(&sroute_table_lock);
 }
 
 void inet_sroute_remove(inet_sroute_t *sroute)
 {
+	fibril_rwlock_write_lock(&sroute_table_lock);
 	fibril_mutex_lock(&sroute_list_lock);
 	list_remove(&sroute->sroute_list);
+	inet_sroute_table_remove(sroute);
 	fibril_mutex_unlock(&sroute_list_lock);
+	atomic_fetch_add(&sroute_gen, 1);
+	fibril_rwlock_write_unlock(&sroute_table_lock);
 }
 
 /** Find static route object matching address @a addr.
+ *
+ * The most specific route is looked up in the routing table. Recent
+ * results are cached, so repeated lookups of the same destination take
+ * no lock at all. The cache is invalidated whenever routes change.
  *
  * @param addr	Address
  */
 inet_sroute_t *inet_sroute_find(inet_addr_t *addr)
 {
-	ip_ver_t addr_ver = inet_addr_get(addr, NULL, NULL);
-
-	inet_sroute_t *best = NULL;
-	uint8_t best_bits = 0;
-
-	fibril_mutex_lock(&sroute_list_lock);
-
-	list_foreach(sroute_list, sroute_list, inet_sroute_t, sroute) {
-		uint8_t dest_bits;
-		ip_ver_t dest_ver = inet_naddr_get(&sroute->dest, NULL, NULL,
-		    &dest_bits);
-
-		/* Skip comparison with different address family */
-		if (addr_ver != dest_ver)
-			continue;
-
-		/* Look for the most specific route */
-		if ((best != NULL) && (best_bits >= dest_bits))
-			continue;
-
-		if (inet_naddr_compare_mask(&sroute->dest, addr)) {
-			log_msg(LOG_DEFAULT, LVL_DEBUG, "inet_sroute_find: found candidate %p",
-			    sroute);
+	uint8_t key[RTRIE_KEY_SIZE];
+	inet_sroute_cache_entry_t *entry;
+	inet_sroute_t *sroute;
+	rtrie_t *table;
+	unsigned hash;
+	unsigned seq;
+	unsigned gen;
+	bool hit;
+
+	table = inet_sroute_addr_key(addr, key);
+	if (table == NULL)
+		return NULL;
 
-			best = sroute;
-			best_bits = dest_bits;
-		}
+	hash = 0;
+	for (unsigned i = 0; i < table->key_bits / 8; i++)
+		hash = hash * 31 + key[i];
+
+	entry = &sroute_cache[hash & (SROUTE_CACHE_SIZE - 1)];
+	gen = atomic_load(&sroute_gen);
+	seq = atomic_load_explicit(&entry->seq, memory_order_acquire);
+	if ((seq & 1) == 0) {
+		hit = entry->gen == gen &&
+		    inet_addr_compare(&entry->addr, addr);
+		sroute = entry->sroute;
+		atomic_thread_fence(memory_order_acquire);
+		if (hit && atomic_load_explicit(&entry->seq,
+		    memory_order_relaxed) == seq)
+			return sroute;
 	}
 
-	if (best == NULL)
+	fibril_rwlock_read_lock(&sroute_table_lock);
+	gen = atomic_load(&sroute_gen);
+	sroute = rtrie_lookup(table, key);
+	fibril_rwlock_read_unlock(&sroute_table_lock);
+
+	if (sroute == NULL)
 		log_msg(LOG_DEFAULT, LVL_DEBUG, "inet_sroute_find: Not found");
 
-	fibril_mutex_unlock(&sroute_list_lock);
+	/* Remember the result unless someone else is updating the entry */
+	if ((seq & 1) == 0 && atomic_compare_exchange_strong(&entry->seq,
+	    &seq, seq + 1)) {
+		entry->gen = gen;
+		entry->addr = *addr;
+		entry->sroute = sroute;
+		atomic_store_explicit(&entry->seq, seq + 2,
+		    memory_order_release);
+	}
 
-	return best;
+	return sroute;
 }
 
 /** Find static route with a specific name.
@@ -0,0 +1,321 @@
+/*
+ * Copyright (c) 2026 The HelenOS Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <errno.h>
+#include <mem.h>
+#include <pcut/pcut.h>
+#include <perf.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "../rtrie.h"
+
+PCUT_INIT;
+
+PCUT_TEST_SUITE(rtrie);
+
+enum {
+	/** Number of routes in the benchmark */
+	test_rtrie_nroutes = 10000,
+	/** Number of lookups in the benchmark */
+	test_rtrie_nlookups = 1000
+};
+
+/** Route in the benchmark */
+typedef struct {
+	uint8_t key[4];
+	uint8_t bits;
+	/** Network address and mask in host byte order */
+	uint32_t addr;
+	uint32_t mask;
+} test_rtrie_route_t;
+
+/** Set IPv4 key. */
+static void test_rtrie_key4(uint8_t *key, uint8_t a, uint8_t b, uint8_t c,
+    uint8_t d)
+{
+	key[0] = a;
+	key[1] = b;
+	key[2] = c;
+	key[3] = d;
+}
+
+/** Simple deterministic pseudo-random generator. */
+static uint32_t test_rtrie_rand(uint32_t *state)
+{
+	*state = *state * 1103515245 + 12345;
+	return *state >> 8;
+}
+
+/** Find the most specific route by scanning all routes.
+ *
+ * This is how static routes were looked up before.
+ */
+static test_rtrie_route_t *test_rtrie_scan(test_rtrie_route_t *routes,
+    size_t count, uint32_t addr)
+{
+	test_rtrie_route_t *best = NULL;
+
+	for (size_t i = 0; i < count; i++) {
+		if (best != NULL && best->bits >= routes[i].bits)
+			continue;
+		if ((addr & routes[i].mask) == routes[i].addr)
+			best = &routes[i];
+	}
+
+	return best;
+}
+
+/** Lookup in empty trie finds nothing */
+PCUT_TEST(empty)
+{
+	rtrie_t trie;
+	uint8_t key[4];
+
+	rtrie_init(&trie, 32);
+	test_rtrie_key4(key, 10, 0, 0, 1);
+	PCUT_ASSERT_NULL(rtrie_lookup(&trie, key));
+	PCUT_ASSERT_ERRNO_VAL(ENOENT, rtrie_remove(&trie, key, 32, &trie));
+	rtrie_fini(&trie);
+}
+
+/** The most specific of nested prefixes is found */
+PCUT_TEST(longest_prefix)
+{
+	rtrie_t trie;
+	uint8_t key[4];
+	int r0, r8, r16, r24, r32;
+	errno_t rc;
+
+	rtrie_init(&trie, 32);
+
+	test_rtrie_key4(key, 0, 0, 0, 0);
+	rc = rtrie_insert(&trie, key, 0, &r0);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+	test_rtrie_key4(key, 10, 0, 0, 0);
+	rc = rtrie_insert(&trie, key, 8, &r8);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+	test_rtrie_key4(key, 10, 1, 2, 3);
+	rc = rtrie_insert(&trie, key, 32, &r32);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+	test_rtrie_key4(key, 10, 1, 2, 0);
+	rc = rtrie_insert(&trie, key, 24, &r24);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+	/* Host bits are ignored */
+	test_rtrie_key4(key, 10, 1, 99, 99);
+	rc = rtrie_insert(&trie, key, 16, &r16);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+	PCUT_ASSERT_INT_EQUALS(5, trie.count);
+
+	test_rtrie_key4(key, 10, 1, 2, 3);
+	PCUT_ASSERT_EQUALS(&r32, rtrie_lookup(&trie, key));
+	test_rtrie_key4(key, 10, 1, 2, 4);
+	PCUT_ASSERT_EQUALS(&r24, rtrie_lookup(&trie, key));
+	test_rtrie_key4(key, 10, 1, 3, 3);
+	PCUT_ASSERT_EQUALS(&r16, rtrie_lookup(&trie, key));
+	test_rtrie_key4(key, 10, 2, 2, 3);
+	PCUT_ASSERT_EQUALS(&r8, rtrie_lookup(&trie, key));
+	test_rtrie_key4(key, 11, 1, 2, 3);
+	PCUT_ASSERT_EQUALS(&r0, rtrie_lookup(&trie, key));
+
+	/* Removing a prefix exposes the next less specific one */
+	test_rtrie_key4(key, 10, 1, 2, 0);
+	rc = rtrie_remove(&trie, key, 24, &r24);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+	test_rtrie_key4(key, 10, 1, 2, 4);
+	PCUT_ASSERT_EQUALS(&r16, rtrie_lookup(&trie, key));
+	test_rtrie_key4(key, 10, 1, 2, 3);
+	PCUT_ASSERT_EQUALS(&r32, rtrie_lookup(&trie, key));
+
+	test_rtrie_key4(key, 0, 0, 0, 0);
+	rc = rtrie_remove(&trie, key, 0, &r0);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+	test_rtrie_key4(key, 11, 1, 2, 3);
+	PCUT_ASSERT_NULL(rtrie_lookup(&trie, key));
+
+	rtrie_fini(&trie);
+}
+
+/** Prefix can only be inserted once and removed with its argument */
+PCUT_TEST(duplicate)
+{
+	rtrie_t trie;
+	uint8_t key[4];
+	int a, b;
+	errno_t rc;
+
+	rtrie_init(&trie, 32);
+
+	test_rtrie_key4(key, 192, 168, 0, 0);
+	rc = rtrie_insert(&trie, key, 16, &a);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+	rc = rtrie_insert(&trie, key, 16, &b);
+	PCUT_ASSERT_ERRNO_VAL(EEXIST, rc);
+
+	rc = rtrie_remove(&trie, key, 16, &b);
+	PCUT_ASSERT_ERRNO_VAL(ENOENT, rc);
+	rc = rtrie_remove(&trie, key, 17, &a);
+	PCUT_ASSERT_ERRNO_VAL(ENOENT, rc);
+	rc = rtrie_remove(&trie, key, 16, &a);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+
+	PCUT_ASSERT_INT_EQUALS(0, trie.count);
+	PCUT_ASSERT_NULL(trie.root);
+	rtrie_fini(&trie);
+}
+
+/** Lookup with IPv6 length keys */
+PCUT_TEST(ipv6)
+{
+	rtrie_t trie;
+	uint8_t key[16];
+	int r0, r48, r64;
+	errno_t rc;
+
+	rtrie_init(&trie, 128);
+
+	memset(key, 0, sizeof(key));
+	rc = rtrie_insert(&trie, key, 0, &r0);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+
+	key[0] = 0x20;
+	key[1] = 0x01;
+	key[2] = 0x0d;
+	key[3] = 0xb8;
+	rc = rtrie_insert(&trie, key, 48, &r48);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+	key[7] = 0x01;
+	rc = rtrie_insert(&trie, key, 64, &r64);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+
+	key[15] = 0x01;
+	PCUT_ASSERT_EQUALS(&r64, rtrie_lookup(&trie, key));
+	key[7] = 0x02;
+	PCUT_ASSERT_EQUALS(&r48, rtrie_lookup(&trie, key));
+	key[0] = 0xfe;
+	PCUT_ASSERT_EQUALS(&r0, rtrie_lookup(&trie, key));
+
+	rtrie_fini(&trie);
+}
+
+/** Compare lookups among many routes with scanning all of them */
+PCUT_TEST(benchmark)
+{
+	test_rtrie_route_t *routes;
+	test_rtrie_route_t **scan_found;
+	test_rtrie_route_t **trie_found;
+	uint32_t *addrs;
+	uint8_t key[4];
+	stopwatch_t sw;
+	nsec_t scan_ns;
+	nsec_t trie_ns;
+	uint32_t state = 1;
+	size_t count = 0;
+	rtrie_t trie;
+	errno_t rc;
+
+	routes = calloc(test_rtrie_nroutes, sizeof(test_rtrie_route_t));
+	PCUT_ASSERT_NOT_NULL(routes);
+	addrs = calloc(test_rtrie_nlookups, sizeof(uint32_t));
+	PCUT_ASSERT_NOT_NULL(addrs);
+	scan_found = calloc(test_rtrie_nlookups, sizeof(test_rtrie_route_t *));
+	PCUT_ASSERT_NOT_NULL(scan_found);
+	trie_found = calloc(test_rtrie_nlookups, sizeof(test_rtrie_route_t *));
+	PCUT_ASSERT_NOT_NULL(trie_found);
+
+	rtrie_init(&trie, 32);
+
+	/* Routes to /16 - /28 networks within 10.0.0.0/10 */
+	while (count < test_rtrie_nroutes) {
+		uint32_t v = 0x0a000000 | (test_rtrie_rand(&state) & 0x3fffff);
+		test_rtrie_route_t *route = &routes[count];
+
+		route->bits = 16 + test_rtrie_rand(&state) % 13;
+		route->mask = ~(UINT32_MAX >> route->bits);
+		route->addr = v & route->mask;
+		v = route->addr;
+		test_rtrie_key4(route->key, v >> 24, (v >> 16) & 0xff,
+		    (v >> 8) & 0xff, v & 0xff);
+
+		rc = rtrie_insert(&trie, route->key, route->bits, route);
+		if (rc == EEXIST)
+			continue;
+		PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+		count++;
+	}
+
+	PCUT_ASSERT_INT_EQUALS(test_rtrie_nroutes, trie.count);
+
+	for (size_t i = 0; i < test_rtrie_nlookups; i++)
+		addrs[i] = 0x0a000000 | (test_rtrie_rand(&state) & 0x3fffff);
+
+	stopwatch_init(&sw);
+	stopwatch_start(&sw);
+	for (size_t i = 0; i < test_rtrie_nlookups; i++)
+		scan_found[i] = test_rtrie_scan(routes, count, addrs[i]);
+	stopwatch_stop(&sw);
+	scan_ns = stopwatch_get_nanos(&sw);
+
+	stopwatch_init(&sw);
+	stopwatch_start(&sw);
+	for (size_t i = 0; i < test_rtrie_nlookups; i++) {
+		test_rtrie_key4(key, addrs[i] >> 24, (addrs[i] >> 16) & 0xff,
+		    (addrs[i] >> 8) & 0xff, addrs[i] & 0xff);
+		trie_found[i] = rtrie_lookup(&trie, key);
+	}
+	stopwatch_stop(&sw);
+	trie_ns = stopwatch_get_nanos(&sw);
+
+	printf("rtrie: %d routes, %d lookups: scan %lld ns/lookup, "
+	    "trie %lld ns/lookup\n", test_rtrie_nroutes, test_rtrie_nlookups,
+	    (long long) (scan_ns / test_rtrie_nlookups),
+	    (long long) (trie_ns / test_rtrie_nlookups));
+
+	/* Both must find the same route */
+	for (size_t i = 0; i < test_rtrie_nlookups; i++)
+		PCUT_ASSERT_EQUALS(scan_found[i], trie_found[i]);
+
+	for (size_t i = 0; i < count; i++) {
+		rc = rtrie_remove(&trie, routes[i].key, routes[i].bits,
+		    &routes[i]);
+		PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+	}
+
+	PCUT_ASSERT_INT_EQUALS(0, trie.count);
+	PCUT_ASSERT_NULL(trie.root);
+
+	rtrie_fini(&trie);
+	free(trie_found);
+	free(scan_found);
+	free(addrs);
+	free(routes);
+}
+
+PCUT_EXPORT(rtrie);
@@ -0,0 +1,341 @@
+/*
+ * Copyright (c) 2026 The HelenOS Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup tcp
+ * @{
+ */
+
+/**
+ * @file Congestion control
+ *
+ * Slow start, congestion avoidance, fast retransmit and fast recovery
+ * as per RFC 5681, with the NewReno modification of fast recovery
+ * (RFC 6582). When SACK has been negotiated, the congestion window is not
+ * inflated during fast recovery, since the retransmission queue tracks
+ * the data that has left the network instead.
+ *
+ * Congestion avoidance uses either the standard additive increase or
+ * CUBIC (RFC 8312).
+ */
+
+#include <macros.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "cc.h"
+#include "rtt.h"
+#include "seq_no.h"
+#include "tcp_type.h"
+
+/** Initial slow start threshold (arbitrarily high) */
+#define CC_SSTHRESH_INIT	0x7fffffff
+/** Upper bound on congestion window */
+#define CC_CWND_MAX		(1 << 30)
+/** Number of duplicate ACKs that trigger fast retransmit */
+#define CC_DUPTHRESH		3
+
+/** CUBIC multiplicative decrease factor (in tenths) */
+#define CUBIC_BETA		7
+/** CUBIC scaling constant (in tenths) */
+#define CUBIC_C			4
+/** Upper bound on CUBIC time offset (ms) */
+#define CUBIC_T_MAX		(1 << 16)
+
+/** Congestion control algorithm for new connections */
+tcp_cc_algo_t tcp_cc_default_algo = tcp_cc_newreno;
+
+/** Compute integer cube root.
+ *
+ * @param x Argument
+ * @return Largest integer y such that y^3 <= x
+ */
+static uint64_t tcp_cc_cbrt(uint64_t x)
+{
+	uint64_t y;
+	uint64_t b;
+	int s;
+
+	y = 0;
+	for (s = 63; s >= 0; s -= 3) {
+		y = 2 * y;
+		b = 3 * y * (y + 1) + 1;
+		if ((x >> s) >= b) {
+			x -= b << s;
+			y++;
+		}
+	}
+
+	return y;
+}
+
+/** Get initial congestion window (RFC 5681 section 3.1).
+ *
+ * @param mss Sender maximum segment size
+ * @return Initial window
+ */
+static uint32_t tcp_cc_iw(uint32_t mss)
+{
+	if (mss > 2190)
+		return 2 * mss;
+	else if (mss > 1095)
+		return 3 * mss;
+	else
+		return 4 * mss;
+}
+
+/** Get amount of data in flight.
+ *
+ * @param conn Connection
+ * @return Number of sent, but not yet acknowledged, sequence numbers
+ */
+static uint32_t tcp_cc_flight(tcp_conn_t *conn)
+{
+	return conn->snd_nxt - conn->snd_una;
+}
+
+/** Initialize congestion control state of a connection.
+ *
+ * Must be called again once the sender maximum segment size is known.
+ *
+ * @param conn Connection
+ */
+void tcp_cc_init(tcp_conn_t *conn)
+{
+	conn->cwnd = tcp_cc_iw(conn->snd_mss);
+	conn->ssthresh = CC_SSTHRESH_INIT;
+	conn->dupacks = 0;
+	conn->in_recovery = false;
+	conn->recover = conn->snd_una;
+	conn->cubic_wmax = 0;
+	conn->cubic_epoch_valid = false;
+}
+
+/** Lower slow start threshold in response to congestion.
+ *
+ * @param conn Connection
+ */
+static void tcp_cc_reduce(tcp_conn_t *conn)
+{
+	uint32_t mss = conn->snd_mss;
+
+	switch (conn->cc_algo) {
+	case tcp_cc_newreno:
+		/* ssthresh = max(FlightSize / 2, 2 * SMSS) */
+		conn->ssthresh = max(tcp_cc_flight(conn) / 2, 2 * mss);
+		break;
+	case tcp_cc_cubic:
+		if (conn->cwnd < conn->cubic_wmax) {
+			/* Fast convergence */
+			conn->cubic_wmax = (uint64_t) conn->cwnd *
+			    (10 + CUBIC_BETA) / 20;
+		} else {
+			conn->cubic_wmax = conn->cwnd;
+		}
+
+		conn->ssthresh = max((uint64_t) conn->cwnd * CUBIC_BETA / 10,
+		    2 * mss);
+		conn->cubic_epoch_valid = false;
+		break;
+	}
+}
+
+/** Increase congestion window in congestion avoidance using CUBIC.
+ *
+ * @param conn  Connection
+ * @param acked Number of newly acknowledged sequence numbers
+ */
+static void tcp_cc_cubic_avoid(tcp_conn_t *conn, uint32_t acked)
+{
+	uint32_t mss = conn->snd_mss;
+	uint32_t now;
+	int64_t t;
+	int64_t offs;
+	int64_t target;
+	uint64_t incr;
+
+	now = tcp_rtt_ts_now();
+
+	if (!conn->cubic_epoch_valid) {
+		conn->cubic_epoch = now;
+		conn->cubic_epoch_valid = true;
+		if (conn->cwnd < conn->cubic_wmax) {
+			/* K = cbrt((W_max - cwnd) / C) */
+			conn->cubic_k = tcp_cc_cbrt((uint64_t)
+			    (conn->cubic_wmax - conn->cwnd) *
+			    (10 * 1000 * 1000 * 1000ull / CUBIC_C) / mss);
+			conn->cubic_origin = conn->cubic_wmax;
+		} else {
+			conn->cubic_k = 0;
+			conn->cubic_origin = conn->cwnd;
+		}
+		conn->cubic_west = conn->cwnd;
+	}
+
+	/* Time since epoch start, one RTT ahead, relative to K (ms) */
+	t = (int64_t) (uint32_t) (now - conn->cubic_epoch) +
+	    conn->srtt / 1000 - conn->cubic_k;
+	t = min(max(t, -CUBIC_T_MAX), CUBIC_T_MAX);
+
+	/* W_cubic(t) = C * (t - K)^3 + W_max */
+	offs = t * t * t / (1000 * 1000) * CUBIC_C * mss / (10 * 1000);
+	target = (int64_t) conn->cubic_origin + offs;
+
+	/* Do not grow by more than half of the window per round trip */
+	target = max(target, (int64_t) conn->cwnd);
+	target = min(target, (int64_t) conn->cwnd * 3 / 2);
+
+	if (target > conn->cwnd) {
+		incr = (uint64_t) mss * (target - conn->cwnd) / conn->cwnd;
+		conn->cwnd += max(incr, 1);
+	} else {
+		conn->cwnd += max(mss / 100, 1);
+	}
+
+	/*
+	 * TCP-friendly region. Estimate the window standard TCP would have
+	 * and do not fall behind it.
+	 */
+	conn->cubic_west += (uint64_t) mss * min(acked, mss) *
+	    3 * (10 - CUBIC_BETA) / (10 + CUBIC_BETA) / conn->cwnd;
+	if (conn->cubic_west > conn->cwnd)
+		conn->cwnd = conn->cubic_west;
+}
+
+/** Update congestion control state on new acknowledgement.
+ *
+ * Must be called before SND.UNA is updated.
+ *
+ * @param conn Connection
+ * @param ack  Acceptable acknowledgement number (SEG.ACK)
+ */
+void tcp_cc_ack(tcp_conn_t *conn, uint32_t ack)
+{
+	uint32_t mss = conn->snd_mss;
+	uint32_t acked;
+	uint32_t flight;
+	uint64_t incr;
+
+	acked = ack - conn->snd_una;
+
+	if (conn->in_recovery) {
+		if (seq_no_ack_covers(conn, ack, conn->recover)) {
+			/* Full acknowledgement. Exit fast recovery. */
+			flight = conn->snd_nxt - ack;
+			conn->cwnd = min(conn->ssthresh, max(flight, mss) + mss);
+			conn->in_recovery = false;
+			conn->dupacks = 0;
+		} else if (!conn->sack_ok) {
+			/*
+			 * Partial acknowledgement. Deflate the window by
+			 * the amount of new data acknowledged, add back one
+			 * segment.
+			 */
+			conn->cwnd = conn->cwnd > acked ? conn->cwnd - acked : 0;
+			conn->cwnd += mss;
+		}
+
+		return;
+	}
+
+	conn->dupacks = 0;
+
+	if (conn->cwnd < conn->ssthresh) {
+		/* Slow start */
+		conn->cwnd += min(acked, mss);
+	} else {
+		/* Congestion avoidance */
+		switch (conn->cc_algo) {
+		case tcp_cc_newreno:
+			incr = (uint64_t) mss * mss / conn->cwnd;
+			conn->cwnd += max(incr, 1);
+			break;
+		case tcp_cc_cubic:
+			tcp_cc_cubic_avoid(conn, acked);
+			break;
+		}
+	}
+
+	conn->cwnd = min(conn->cwnd, CC_CWND_MAX);
+}
+
+/** Update congestion control state on duplicate acknowledgement.
+ *
+ * @param conn Connection
+ * @return @c true if fast retransmit should be performed
+ */
+bool tcp_cc_dupack(tcp_conn_t *conn)
+{
+	uint32_t mss = conn->snd_mss;
+
+	++conn->dupacks;
+
+	if (conn->in_recovery) {
+		/* Each duplicate ACK signals a segment has left the network */
+		if (!conn->sack_ok)
+			conn->cwnd = min(conn->cwnd + mss, CC_CWND_MAX);
+		return false;
+	}
+
+	if (conn->dupacks < CC_DUPTHRESH)
+		return false;
+
+	/*
+	 * Do not enter fast retransmit until all data outstanding at the time
+	 * of the last loss recovery episode has been acknowledged.
+	 */
+	if (seq_no_ack_covers(conn, conn->snd_nxt, conn->recover))
+		return false;
+
+	tcp_cc_reduce(conn);
+	conn->recover = conn->snd_nxt;
+	conn->in_recovery = true;
+
+	if (conn->sack_ok)
+		conn->cwnd = conn->ssthresh;
+	else
+		conn->cwnd = conn->ssthresh + CC_DUPTHRESH * mss;
+
+	return true;
+}
+
+/** Update congestion control state on retransmission timeout.
+ *
+ * @param conn Connection
+ */
+void tcp_cc_timeout(tcp_conn_t *conn)
+{
+	tcp_cc_reduce(conn);
+	conn->cwnd = conn->snd_mss;
+	conn->in_recovery = false;
+	conn->dupacks = 0;
+	conn->recover = conn->snd_nxt;
+}
+
+/**
+ * @}
+ */
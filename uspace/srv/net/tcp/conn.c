@@ -42,19 +42,33 @@
 #include <nettl/amap.h>
 #include <stdbool.h>
 #include <stdlib.h>
+#include "cc.h"
 #include "conn.h"
 #include "inet.h"
 #include "iqueue.h"
+#include "ncsim.h"
 #include "pdu.h"
 #include "rqueue.h"
+#include "rtt.h"
 #include "segment.h"
 #include "seq_no.h"
 #include "tcp_type.h"
 #include "tqueue.h"
 #include "ucall.h"
 
-#define RCV_BUF_SIZE 4096/*2*/
-#define SND_BUF_SIZE 4096
+#define RCV_BUF_SIZE (256 * 1024)
+#define SND_BUF_SIZE (64 * 1024)
+
+/** Default send MSS if the peer does not announce one (RFC 9293) */
+#define MSS_DEFAULT	536
+/** Smallest send MSS we accept from the peer */
+#define MSS_MIN		64
+/** MSS we announce over IPv4 (Ethernet MTU less IPv4 and TCP headers) */
+#define MSS_IPV4	1460
+/** MSS we announce over IPv6 (Ethernet MTU less IPv6 and TCP headers) */
+#define MSS_IPV6	1440
+/** Maximum window scale shift (RFC 7323) */
+#define WSCALE_MAX	14
 
 #define MAX_SEGMENT_LIFETIME	(15*1000*1000) //(2*60*1000*1000)
 #define TIME_WAIT_TIMEOUT	(2*MAX_SEGMENT_LIFETIME)
@@ -152,6 +166,26 @@ tcp_conn_t *tcp_conn_new(inet_ep2_t *epp)
 	/* Set up receive window. */
 	conn->rcv_wnd = conn->rcv_buf_size;
 
+	/* Smallest window scale that allows advertising the whole buffer */
+	conn->rcv_wscale = 0;
+	while ((conn->rcv_wnd >> conn->rcv_wscale) > UINT16_MAX &&
+	    conn->rcv_wscale < WSCALE_MAX)
+		++conn->rcv_wscale;
+
+	/*
+	 * Offer window scaling, SACK and timestamps. Whatever the peer
+	 * does not agree to is turned off once its SYN arrives.
+	 */
+	conn->ws_ok = true;
+	conn->sack_ok = true;
+	conn->ts_ok = true;
+
+	/* Set up congestion control and RTT estimation */
+	conn->snd_mss = MSS_DEFAULT;
+	conn->cc_algo = tcp_cc_default_algo;
+	tcp_rtt_init(conn);
+	tcp_cc_init(conn);
+
 	/* Initialize incoming segment queue */
 	tcp_iqueue_init(&conn->incoming, conn);
 
@@ -511,6 +545,60 @@ bool tcp_conn_got_syn(tcp_conn_t *conn)
 	assert(false);
 }
 
+/** Get maximum segment size we are able to receive.
+ *
+ * @param conn Connection
+ * @return Maximum segment size to announce to the peer
+ */
+uint16_t tcp_conn_rcv_mss(tcp_conn_t *conn)
+{
+	if (conn->ident.local.addr.version == ip_v6)
+		return MSS_IPV6;
+
+	return MSS_IPV4;
+}
+
+/** Process options of received SYN segment.
+ *
+ * Options that we offered but the peer did not are turned off and
+ * the send MSS is determined.
+ *
+ * @param conn		Connection
+ * @param seg		SYN segment
+ */
+static void tcp_conn_syn_opts(tcp_conn_t *conn, tcp_segment_t *seg)
+{
+	tcp_seg_opts_t *opts = &seg->opts;
+	uint16_t mss;
+
+	conn->ws_ok = conn->ws_ok && (opts->flags & TOPT_WSCALE) != 0;
+	conn->sack_ok = conn->sack_ok && (opts->flags & TOPT_SACK_PERM) != 0;
+	conn->ts_ok = conn->ts_ok && (opts->flags & TOPT_TS) != 0;
+
+	if (conn->ws_ok)
+		conn->snd_wscale = min(opts->wscale, WSCALE_MAX);
+
+	if (conn->ts_ok)
+		conn->ts_recent = opts->tsval;
+
+	mss = (opts->flags & TOPT_MSS) != 0 ? opts->mss : MSS_DEFAULT;
+	mss = min(mss, tcp_conn_rcv_mss(conn));
+
+	/*
+	 * Timestamp option is present in every segment. Clamp first so that
+	 * a tiny advertised MSS cannot make the subtraction wrap around.
+	 */
+	if (conn->ts_ok)
+		mss = max(mss, MSS_MIN + OPT_TIMESTAMP_LEN + 2) -
+		    (OPT_TIMESTAMP_LEN + 2);
+
+	conn->snd_mss = max(mss, MSS_MIN);
+
+	log_msg(LOG_DEFAULT, LVL_DEBUG, "%s: MSS=%" PRIu32 " WS=%d(%u) SACK=%d "
+	    "TS=%d", conn->name, conn->snd_mss, conn->ws_ok,
+	    (unsigned) conn->snd_wscale, conn->sack_ok, conn->ts_ok);
+}
+
 /** Segment arrived in Listen state.
  *
  * @param conn		Connection
@@ -560,6 +648,9 @@ static void tcp_conn_sa_listen(tcp_conn_t *conn, tcp_segment_t *seg)
 	conn->snd_wl1 = seg->seq;
 	conn->snd_wl2 = seg->seq;
 
+	tcp_conn_syn_opts(conn, seg);
+	tcp_cc_init(conn);
+
 	tcp_conn_state_set(conn, st_syn_received);
 
 	tcp_tqueue_ctrl_seg(conn, CTL_SYN | CTL_ACK /* XXX */);
@@ -615,8 +706,12 @@ static void tcp_conn_sa_syn_sent(tcp_conn_t *conn, tcp_segment_t *seg)
 	conn->rcv_nxt = seg->seq + 1;
 	conn->irs = seg->seq;
 
+	tcp_conn_syn_opts(conn, seg);
+
 	if ((seg->ctrl & CTL_ACK) != 0) {
+		tcp_rtt_ack(conn, seg);
 		conn->snd_una = seg->ack;
+		tcp_cc_init(conn);
 
 		/*
 		 * Prune acked segments from retransmission queue and
@@ -662,6 +757,9 @@ static void tcp_conn_sa_syn_sent(tcp_conn_t *conn, tcp_segment_t *seg)
 static void tcp_conn_sa_queue(tcp_conn_t *conn, tcp_segment_t *seg)
 {
 	tcp_segment_t *pseg;
+	uint32_t rcv_nxt_old;
+	uint32_t seg_seq;
+	uint32_t seg_len;
 
 	log_msg(LOG_DEFAULT, LVL_DEBUG, "tcp_conn_sa_seq(%p, %p)", conn, seg);
 
@@ -673,6 +771,19 @@ static void tcp_conn_sa_queue(tcp_conn_t *conn, tcp_segment_t *seg)
 		return;
 	}
 
+	/*
+	 * Remember timestamp to echo (RFC 7323). The segment must not
+	 * start beyond what we have last acknowledged.
+	 */
+	if (conn->ts_ok && (seg->opts.flags & TOPT_TS) != 0 &&
+	    (int32_t) (seg->opts.tsval - conn->ts_recent) >= 0 &&
+	    (int32_t) (seg->seq - conn->rcv_ack_sent) <= 0)
+		conn->ts_recent = seg->opts.tsval;
+
+	rcv_nxt_old = conn->rcv_nxt;
+	seg_seq = seg->seq;
+	seg_len = seg->len;
+
 	/* Queue for processing */
 	tcp_iqueue_insert_seg(&conn->incoming, seg);
 
@@ -684,6 +795,22 @@ static void tcp_conn_sa_queue(tcp_conn_t *conn, tcp_segment_t *seg)
 	 */
 	while (tcp_iqueue_get_ready_seg(&conn->incoming, &pseg) == EOK)
 		tcp_conn_seg_process(conn, pseg);
+
+	if (conn->cstate == st_closed)
+		return;
+
+	/*
+	 * Segment arrived out of order. Acknowledge immediately so that
+	 * the sender can detect the loss (duplicate ACK, SACK).
+	 */
+	if (seg_len > 0 && conn->rcv_nxt == rcv_nxt_old) {
+		conn->rcv_sack_last = seg_seq;
+		conn->rcv_ack_pending = true;
+	}
+
+	/* Acknowledge all text processed above with a single ACK */
+	if (conn->rcv_ack_pending)
+		tcp_tqueue_ctrl_seg(conn, CTL_ACK);
 }
 
 /** Process segment RST field.
@@ -811,8 +938,22 @@ static cproc_t tcp_conn_seg_proc_ack_sr(tcp_conn_t *conn, tcp_segment_t *seg)
  */
 static cproc_t tcp_conn_seg_proc_ack_est(tcp_conn_t *conn, tcp_segment_t *seg)
 {
+	uint32_t wnd;
+	bool dupack;
+
 	log_msg(LOG_DEFAULT, LVL_DEBUG, "tcp_conn_seg_proc_ack_est(%p, %p)", conn, seg);
 
+	wnd = seg->wnd;
+	if (conn->ws_ok)
+		wnd <<= conn->snd_wscale;
+
+	/* Duplicate acknowledgement as defined by RFC 5681 */
+	dupack = seg->ack == conn->snd_una &&
+	    conn->snd_nxt != conn->snd_una &&
+	    tcp_segment_text_size(seg) == 0 &&
+	    (seg->ctrl & (CTL_SYN | CTL_FIN)) == 0 &&
+	    wnd == conn->snd_wnd;
+
 	log_msg(LOG_DEFAULT, LVL_DEBUG, "SEG.ACK=%u, SND.UNA=%u, SND.NXT=%u",
 	    (unsigned)seg->ack, (unsigned)conn->snd_una,
 	    (unsigned)conn->snd_nxt);
@@ -830,12 +971,16 @@ static cproc_t tcp_conn_seg_proc_ack_est(tcp_conn_t *conn, tcp_segment_t *seg)
 			log_msg(LOG_DEFAULT, LVL_DEBUG, "Ignoring duplicate ACK.");
 		}
 	} else {
+		/* Update RTT estimate and congestion window */
+		tcp_rtt_ack(conn, seg);
+		tcp_cc_ack(conn, seg->ack);
+
 		/* Update SND.UNA */
 		conn->snd_una = seg->ack;
 	}
 
 	if (seq_no_new_wnd_update(conn, seg)) {
-		conn->snd_wnd = seg->wnd;
+		conn->snd_wnd = wnd;
 		conn->snd_wl1 = seg->seq;
 		conn->snd_wl2 = seg->ack;
 
@@ -844,9 +989,16 @@ static cproc_t tcp_conn_seg_proc_ack_est(tcp_conn_t *conn, tcp_segment_t *seg)
 		    conn->snd_wnd, conn->snd_wl1, conn->snd_wl2);
 	}
 
+	tcp_tqueue_sack_received(conn, seg);
+
+	if (dupack && tcp_cc_dupack(conn)) {
+		log_msg(LOG_DEFAULT, LVL_DEBUG, "%s: Fast retransmit", conn->name);
+		tcp_tqueue_enter_recovery(conn);
+	}
+
 	/*
 	 * Prune acked segments from retransmission queue and
-	 * possibly transmit more data.
+	 * possibly transmit (or retransmit) more data.
 	 */
 	tcp_tqueue_ack_received(conn);
 
@@ -1076,12 +1228,15 @@ static cproc_t tcp_conn_seg_proc_text(tcp_conn_t *conn, tcp_segment_t *seg)
 	/* Advance RCV.NXT */
 	conn->rcv_nxt += xfer_size;
 
-	/* Update receive window. XXX Not an efficient strategy. */
+	/*
+	 * Update receive window. It is opened again as the user reads
+	 * data from the receive buffer.
+	 */
 	conn->rcv_wnd -= xfer_size;
 
-	/* Send ACK */
+	/* ACK is sent once all ready segments have been processed */
 	if (xfer_size > 0)
-		tcp_tqueue_ctrl_seg(conn, CTL_ACK);
+		conn->rcv_ack_pending = true;
 
 	if (xfer_size < seg->len) {
 		/* Trim part of segment which we just received */
@@ -1409,11 +1564,16 @@ static void tcp_transmit_segment(inet_ep2_t *epp, tcp_segment_t *seg)
 
 	tcp_segment_dump(seg);
 
+	if (tcp_conn_lb == tcp_lb_ncsim) {
+		/* Loop back segment through network condition simulator */
+		dseg = tcp_segment_dup(seg);
+		if (dseg != NULL)
+			tcp_ncsim_bounce_seg(epp, dseg);
+		return;
+	}
+
 	if (tcp_conn_lb == tcp_lb_segment) {
 		/* Loop back segment */
-#if 0
-		tcp_ncsim_bounce_seg(sp, seg);
-#endif
 
 		/* Reverse the identification */
 		tcp_ep2_flipped(epp, &rident);
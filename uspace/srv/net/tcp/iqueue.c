@@ -186,6 +186,88 @@ errno_t tcp_iqueue_get_ready_seg(tcp_iqueue_t *iqueue, tcp_segment_t **seg)
 	return EOK;
 }
 
+/** Add SACK block to list of blocks to report.
+ *
+ * The block containing the most recently received out-of-order segment
+ * is placed first, the others follow in order of sequence number.
+ *
+ * @param conn Connection
+ * @param blk  Array of blocks
+ * @param n    Place holding number of blocks in @a blk, updated
+ * @param max  Maximum number of blocks
+ * @param cur  Block to add
+ */
+static void tcp_iqueue_sack_add(tcp_conn_t *conn, tcp_sack_blk_t *blk,
+    size_t *n, size_t max, tcp_sack_blk_t *cur)
+{
+	size_t i;
+
+	if (seq_no_rcv_le(conn, cur->left, conn->rcv_sack_last) &&
+	    !seq_no_rcv_le(conn, cur->right, conn->rcv_sack_last)) {
+		i = *n < max ? *n : max - 1;
+		while (i > 0) {
+			blk[i] = blk[i - 1];
+			--i;
+		}
+
+		blk[0] = *cur;
+		if (*n < max)
+			++*n;
+	} else if (*n < max) {
+		blk[(*n)++] = *cur;
+	}
+}
+
+/** Compute SACK blocks describing out-of-order data in incoming queue.
+ *
+ * Contiguous out-of-order segments are merged into blocks (RFC 2018).
+ *
+ * @param iqueue	Incoming queue
+ * @param blk		Array to store blocks to
+ * @param max		Maximum number of blocks to store
+ * @return		Number of blocks stored
+ */
+size_t tcp_iqueue_sack_blocks(tcp_iqueue_t *iqueue, tcp_sack_blk_t *blk,
+    size_t max)
+{
+	tcp_conn_t *conn = iqueue->conn;
+	tcp_sack_blk_t cur;
+	bool have_cur = false;
+	uint32_t seg_end;
+	size_t n = 0;
+
+	if (max == 0)
+		return 0;
+
+	list_foreach(iqueue->list, link, tcp_iqueue_entry_t, iqe) {
+		if (iqe->seg->len == 0 ||
+		    !seq_no_segment_acceptable(conn, iqe->seg) ||
+		    seq_no_segment_ready(conn, iqe->seg))
+			continue;
+
+		seg_end = iqe->seg->seq + iqe->seg->len;
+
+		if (have_cur && seq_no_rcv_le(conn, iqe->seg->seq, cur.right)) {
+			/* Extend current block */
+			if (!seq_no_rcv_le(conn, seg_end, cur.right))
+				cur.right = seg_end;
+			continue;
+		}
+
+		if (have_cur)
+			tcp_iqueue_sack_add(conn, blk, &n, max, &cur);
+
+		cur.left = iqe->seg->seq;
+		cur.right = seg_end;
+		have_cur = true;
+	}
+
+	if (have_cur)
+		tcp_iqueue_sack_add(conn, blk, &n, max, &cur);
+
+	return n;
+}
+
 /**
  * @}
  */
@@ -43,17 +43,24 @@
 #include <errno.h>
 #include <inet/endpoint.h>
 #include <io/log.h>
+#include <stdbool.h>
 #include <stdlib.h>
 #include <fibril.h>
 #include "conn.h"
 #include "ncsim.h"
 #include "rqueue.h"
+#include "rtt.h"
 #include "segment.h"
 #include "tcp_type.h"
 
+/** Segments in flight, sorted by time of delivery */
 static list_t sim_queue;
 static fibril_mutex_t sim_queue_lock;
 static fibril_condvar_t sim_queue_cv;
+/** Simulated network conditions */
+static tcp_ncsim_cond_t sim_cond;
+static bool fibril_active;
+static bool fibril_quit;
 
 /** Initialize segment receive queue. */
 void tcp_ncsim_init(void)
@@ -61,12 +68,44 @@ void tcp_ncsim_init(void)
 	list_initialize(&sim_queue);
 	fibril_mutex_initialize(&sim_queue_lock);
 	fibril_condvar_initialize(&sim_queue_cv);
+	fibril_active = false;
+	fibril_quit = false;
+}
+
+/** Finalize simulator.
+ *
+ * Stop the handler fibril. Segments still in flight are dropped.
+ */
+void tcp_ncsim_fini(void)
+{
+	fibril_mutex_lock(&sim_queue_lock);
+	fibril_quit = true;
+	fibril_condvar_broadcast(&sim_queue_cv);
+
+	while (fibril_active)
+		fibril_condvar_wait(&sim_queue_cv, &sim_queue_lock);
+
+	fibril_mutex_unlock(&sim_queue_lock);
+}
+
+/** Set simulated network conditions.
+ *
+ * With all conditions zero segments are passed to the receive queue
+ * directly.
+ *
+ * @param cond	Network conditions
+ */
+void tcp_ncsim_set_cond(tcp_ncsim_cond_t *cond)
+{
+	fibril_mutex_lock(&sim_queue_lock);
+	sim_cond = *cond;
+	fibril_mutex_unlock(&sim_queue_lock);
 }
 
 /** Bounce segment through simulator into receive queue.
  *
  * @param epp	Endpoint pair, oriented for transmission
- * @param seg	Segment
+ * @param seg	Segment (ownership transferred to simulator)
  */
 void tcp_ncsim_bounce_seg(inet_ep2_t *epp, tcp_segment_t *seg)
 {
@@ -74,48 +113,57 @@ void tcp_ncsim_bounce_seg(inet_ep2_t *epp, tcp_segment_t *seg)
 	tcp_squeue_entry_t *old_qe;
 	inet_ep2_t rident;
 	link_t *link;
+	usec_t delay;
 
 	log_msg(LOG_DEFAULT, LVL_DEBUG, "tcp_ncsim_bounce_seg()");
-	tcp_ep2_flipped(epp, &rident);
-	tcp_rqueue_insert_seg(&rident, seg);
-	return;
 
-	if (0 /* rand() % 4 == 3 */) {
+	fibril_mutex_lock(&sim_queue_lock);
+
+	if (sim_cond.delay == 0 && sim_cond.jitter == 0 && sim_cond.loss == 0) {
+		fibril_mutex_unlock(&sim_queue_lock);
+		tcp_ep2_flipped(epp, &rident);
+		tcp_rqueue_insert_seg(&rident, seg);
+		return;
+	}
+
+	if ((unsigned) rand() % 1000 < sim_cond.loss) {
 		/* Drop segment */
-		log_msg(LOG_DEFAULT, LVL_ERROR, "NCSim dropping segment");
+		fibril_mutex_unlock(&sim_queue_lock);
+		log_msg(LOG_DEFAULT, LVL_DEBUG, "NCSim dropping segment");
 		tcp_segment_delete(seg);
 		return;
 	}
 
+	delay = sim_cond.delay;
+	if (sim_cond.jitter > 0)
+		delay += rand() % sim_cond.jitter;
+
 	sqe = calloc(1, sizeof(tcp_squeue_entry_t));
 	if (sqe == NULL) {
+		fibril_mutex_unlock(&sim_queue_lock);
 		log_msg(LOG_DEFAULT, LVL_ERROR, "Failed allocating SQE.");
+		tcp_segment_delete(seg);
 		return;
 	}
 
-	sqe->delay = rand() % (1000 * 1000);
+	sqe->due = tcp_rtt_now() + delay;
 	sqe->epp = *epp;
 	sqe->seg = seg;
 
-	fibril_mutex_lock(&sim_queue_lock);
-
-	link = list_first(&sim_queue);
-	while (link != NULL && sqe->delay > 0) {
+	/* Keep the queue sorted by time of delivery */
+	link = list_last(&sim_queue);
+	while (link != NULL) {
 		old_qe = list_get_instance(link, tcp_squeue_entry_t, link);
-		if (sqe->delay < old_qe->delay)
+		if (old_qe->due <= sqe->due)
 			break;
 
-		sqe->delay -= old_qe->delay;
-
-		link = link->next;
-		if (link == &sim_queue.head)
-			link = NULL;
+		link = list_prev(link, &sim_queue);
 	}
 
 	if (link != NULL)
 		list_insert_after(&sqe->link, link);
 	else
-		list_append(&sqe->link, &sim_queue);
+		list_prepend(&sqe->link, &sim_queue);
 
 	fibril_condvar_broadcast(&sim_queue_cv);
 	fibril_mutex_unlock(&sim_queue_lock);
@@ -127,35 +175,56 @@ static errno_t tcp_ncsim_fibril(void *arg)
 	link_t *link;
 	tcp_squeue_entry_t *sqe;
 	inet_ep2_t rident;
-	errno_t rc;
+	usec_t now;
 
 	log_msg(LOG_DEFAULT, LVL_DEBUG, "tcp_ncsim_fibril()");
 
-	while (true) {
-		fibril_mutex_lock(&sim_queue_lock);
+	fibril_mutex_lock(&sim_queue_lock);
 
-		while (list_empty(&sim_queue))
+	while (!fibril_quit) {
+		if (list_empty(&sim_queue)) {
 			fibril_condvar_wait(&sim_queue_cv, &sim_queue_lock);
+			continue;
+		}
 
-		do {
-			link = list_first(&sim_queue);
-			sqe = list_get_instance(link, tcp_squeue_entry_t, link);
+		link = list_first(&sim_queue);
+		sqe = list_get_instance(link, tcp_squeue_entry_t, link);
 
-			log_msg(LOG_DEFAULT, LVL_DEBUG, "NCSim - Sleep");
-			rc = fibril_condvar_wait_timeout(&sim_queue_cv,
-			    &sim_queue_lock, sqe->delay);
-		} while (rc != ETIMEOUT);
+		now = tcp_rtt_now();
+		if (sqe->due > now) {
+			/* Sleep until due or until the queue changes */
+			log_msg(LOG_DEFAULT, LVL_DEBUG2, "NCSim - Sleep");
+			(void) fibril_condvar_wait_timeout(&sim_queue_cv,
+			    &sim_queue_lock, sqe->due - now);
+			continue;
+		}
 
 		list_remove(link);
 		fibril_mutex_unlock(&sim_queue_lock);
 
-		log_msg(LOG_DEFAULT, LVL_DEBUG, "NCSim - End Sleep");
+		log_msg(LOG_DEFAULT, LVL_DEBUG2, "NCSim - Deliver");
 		tcp_ep2_flipped(&sqe->epp, &rident);
 		tcp_rqueue_insert_seg(&rident, sqe->seg);
 		free(sqe);
+
+		fibril_mutex_lock(&sim_queue_lock);
 	}
 
-	/* Not reached */
+	/* Drop segments still in flight */
+	while (!list_empty(&sim_queue)) {
+		link = list_first(&sim_queue);
+		sqe = list_get_instance(link, tcp_squeue_entry_t, link);
+		list_remove(link);
+		tcp_segment_delete(sqe->seg);
+		free(sqe);
+	}
+
+	log_msg(LOG_DEFAULT, LVL_DEBUG2, "tcp_ncsim_fibril() exiting");
+
+	fibril_active = false;
+	fibril_condvar_broadcast(&sim_queue_cv);
+	fibril_mutex_unlock(&sim_queue_lock);
+
 	return 0;
 }
 
@@ -172,6 +241,11 @@ void tcp_ncsim_fibril_start(void)
 		return;
 	}
 
+	fibril_mutex_lock(&sim_queue_lock);
+	fibril_quit = false;
+	fibril_active = true;
+	fibril_mutex_unlock(&sim_queue_lock);
+
 	fibril_add_ready(fid);
 }
 
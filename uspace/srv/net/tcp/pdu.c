@@ -34,10 +34,12 @@
  * @file TCP header encoding and decoding
  */
 
+#include <assert.h>
 #include <bitops.h>
 #include <byteorder.h>
 #include <errno.h>
 #include <inet/endpoint.h>
+#include <macros.h>
 #include <mem.h>
 #include <stdlib.h>
 #include "pdu.h"
@@ -125,7 +127,182 @@ static void tcp_header_encode_flags(tcp_control_t ctl, uint16_t doff_flags0,
 	*rdoff_flags = doff_flags;
 }
 
-static void tcp_header_setup(inet_ep2_t *epp, tcp_segment_t *seg, tcp_header_t *hdr)
+/** Store 16-bit value to option buffer in network byte order. */
+static void tcp_opt_put16(uint8_t *buf, uint16_t val)
+{
+	buf[0] = val >> 8;
+	buf[1] = val & 0xff;
+}
+
+/** Store 32-bit value to option buffer in network byte order. */
+static void tcp_opt_put32(uint8_t *buf, uint32_t val)
+{
+	tcp_opt_put16(buf, val >> 16);
+	tcp_opt_put16(buf + 2, val & 0xffff);
+}
+
+/** Load 16-bit value in network byte order from option buffer. */
+static uint16_t tcp_opt_get16(uint8_t *buf)
+{
+	return ((uint16_t) buf[0] << 8) | buf[1];
+}
+
+/** Load 32-bit value in network byte order from option buffer. */
+static uint32_t tcp_opt_get32(uint8_t *buf)
+{
+	return ((uint32_t) tcp_opt_get16(buf) << 16) | tcp_opt_get16(buf + 2);
+}
+
+/** Encode TCP options.
+ *
+ * Each option is preceded by enough NOPs for the options area to remain
+ * a multiple of four bytes long.
+ *
+ * @param opts Options
+ * @param buf  Buffer, at least TCP_OPTS_MAX_SIZE bytes long
+ * @return Size of encoded options in bytes
+ */
+static size_t tcp_opts_encode(tcp_seg_opts_t *opts, uint8_t *buf)
+{
+	size_t off = 0;
+	size_t i;
+
+	if ((opts->flags & TOPT_MSS) != 0) {
+		buf[off] = OPT_MAX_SEG_SIZE;
+		buf[off + 1] = OPT_MAX_SEG_SIZE_LEN;
+		tcp_opt_put16(buf + off + 2, opts->mss);
+		off += OPT_MAX_SEG_SIZE_LEN;
+	}
+
+	if ((opts->flags & TOPT_WSCALE) != 0) {
+		buf[off++] = OPT_NOP;
+		buf[off] = OPT_WSCALE;
+		buf[off + 1] = OPT_WSCALE_LEN;
+		buf[off + 2] = opts->wscale;
+		off += OPT_WSCALE_LEN;
+	}
+
+	if ((opts->flags & TOPT_SACK_PERM) != 0) {
+		buf[off++] = OPT_NOP;
+		buf[off++] = OPT_NOP;
+		buf[off] = OPT_SACK_PERM;
+		buf[off + 1] = OPT_SACK_PERM_LEN;
+		off += OPT_SACK_PERM_LEN;
+	}
+
+	if ((opts->flags & TOPT_TS) != 0) {
+		buf[off++] = OPT_NOP;
+		buf[off++] = OPT_NOP;
+		buf[off] = OPT_TIMESTAMP;
+		buf[off + 1] = OPT_TIMESTAMP_LEN;
+		tcp_opt_put32(buf + off + 2, opts->tsval);
+		tcp_opt_put32(buf + off + 6, opts->tsecr);
+		off += OPT_TIMESTAMP_LEN;
+	}
+
+	if ((opts->flags & TOPT_SACK) != 0 && opts->sack_cnt > 0) {
+		assert(off + 4 + opts->sack_cnt * OPT_SACK_BLK_LEN <=
+		    TCP_OPTS_MAX_SIZE);
+
+		buf[off++] = OPT_NOP;
+		buf[off++] = OPT_NOP;
+		buf[off] = OPT_SACK;
+		buf[off + 1] = 2 + opts->sack_cnt * OPT_SACK_BLK_LEN;
+		off += 2;
+
+		for (i = 0; i < opts->sack_cnt; i++) {
+			tcp_opt_put32(buf + off, opts->sack[i].left);
+			tcp_opt_put32(buf + off + 4, opts->sack[i].right);
+			off += OPT_SACK_BLK_LEN;
+		}
+	}
+
+	assert(off % sizeof(uint32_t) == 0);
+	return off;
+}
+
+/** Decode TCP options.
+ *
+ * Unknown options are skipped. Decoding stops at the first malformed
+ * option.
+ *
+ * @param buf  Options area of TCP header
+ * @param size Size of options area in bytes
+ * @param opts Place to store decoded options
+ */
+static void tcp_opts_decode(uint8_t *buf, size_t size, tcp_seg_opts_t *opts)
+{
+	size_t off = 0;
+	size_t len;
+	size_t i;
+
+	opts->flags = 0;
+
+	while (off < size) {
+		if (buf[off] == OPT_END_LIST)
+			break;
+
+		if (buf[off] == OPT_NOP) {
+			++off;
+			continue;
+		}
+
+		if (off + 1 >= size)
+			break;
+
+		len = buf[off + 1];
+		if (len < 2 || off + len > size)
+			break;
+
+		switch (buf[off]) {
+		case OPT_MAX_SEG_SIZE:
+			if (len != OPT_MAX_SEG_SIZE_LEN)
+				break;
+			opts->flags |= TOPT_MSS;
+			opts->mss = tcp_opt_get16(buf + off + 2);
+			break;
+		case OPT_WSCALE:
+			if (len != OPT_WSCALE_LEN)
+				break;
+			opts->flags |= TOPT_WSCALE;
+			opts->wscale = buf[off + 2];
+			break;
+		case OPT_SACK_PERM:
+			if (len != OPT_SACK_PERM_LEN)
+				break;
+			opts->flags |= TOPT_SACK_PERM;
+			break;
+		case OPT_TIMESTAMP:
+			if (len != OPT_TIMESTAMP_LEN)
+				break;
+			opts->flags |= TOPT_TS;
+			opts->tsval = tcp_opt_get32(buf + off + 2);
+			opts->tsecr = tcp_opt_get32(buf + off + 6);
+			break;
+		case OPT_SACK:
+			if (len < 2 + OPT_SACK_BLK_LEN ||
+			    (len - 2) % OPT_SACK_BLK_LEN != 0)
+				break;
+			opts->flags |= TOPT_SACK;
+			opts->sack_cnt = min((len - 2) / OPT_SACK_BLK_LEN,
+			    TCP_SACK_BLOCKS_MAX);
+			for (i = 0; i < opts->sack_cnt; i++) {
+				opts->sack[i].left = tcp_opt_get32(buf + off +
+				    2 + i * OPT_SACK_BLK_LEN);
+				opts->sack[i].right = tcp_opt_get32(buf + off +
+				    6 + i * OPT_SACK_BLK_LEN);
+			}
+			break;
+		default:
+			break;
+		}
+
+		off += len;
+	}
+}
+
+static void tcp_header_setup(inet_ep2_t *epp, tcp_segment_t *seg,
+    tcp_header_t *hdr, size_t hdr_size)
 {
 	uint16_t doff_flags;
 	uint16_t doff;
@@ -135,7 +312,7 @@ static void tcp_header_setup(inet_ep2_t *epp, tcp_segment_t *seg, tcp_header_t *
 	hdr->seq = host2uint32_t_be(seg->seq);
 	hdr->ack = host2uint32_t_be(seg->ack);
 
-	doff = (sizeof(tcp_header_t) / sizeof(uint32_t)) << DF_DATA_OFFSET_l;
+	doff = (hdr_size / sizeof(uint32_t)) << DF_DATA_OFFSET_l;
 	tcp_header_encode_flags(seg->ctrl, doff, &doff_flags);
 
 	hdr->doff_flags = host2uint16_t_be(doff_flags);
@@ -194,14 +371,20 @@ static errno_t tcp_header_encode(inet_ep2_t *epp, tcp_segment_t *seg,
     void **header, size_t *size)
 {
 	tcp_header_t *hdr;
+	uint8_t opts[TCP_OPTS_MAX_SIZE];
+	size_t opts_size;
 
-	hdr = calloc(1, sizeof(tcp_header_t));
+	opts_size = tcp_opts_encode(&seg->opts, opts);
+
+	hdr = calloc(1, sizeof(tcp_header_t) + opts_size);
 	if (hdr == NULL)
 		return ENOMEM;
 
-	tcp_header_setup(epp, seg, hdr);
+	tcp_header_setup(epp, seg, hdr, sizeof(tcp_header_t) + opts_size);
+	memcpy(hdr + 1, opts, opts_size);
+
 	*header = hdr;
-	*size = sizeof(tcp_header_t);
+	*size = sizeof(tcp_header_t) + opts_size;
 
 	return EOK;
 }
@@ -308,6 +491,11 @@ errno_t tcp_pdu_decode(tcp_pdu_t *pdu, inet_ep2_t *epp, tcp_segment_t **seg)
 
 	hdr = (tcp_header_t *)pdu->header;
 
+	if (pdu->header_size > sizeof(tcp_header_t)) {
+		tcp_opts_decode((uint8_t *)(hdr + 1),
+		    pdu->header_size - sizeof(tcp_header_t), &nseg->opts);
+	}
+
 	epp->local.port = uint16_t_be2host(hdr->dest_port);
 	epp->local.addr = pdu->dest;
 	epp->remote.port = uint16_t_be2host(hdr->src_port);
@@ -0,0 +1,180 @@
+/*
+ * Copyright (c) 2026 The HelenOS Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/** @addtogroup tcp
+ * @{
+ */
+
+/**
+ * @file Round-trip time estimation
+ *
+ * Estimate round-trip time and compute the retransmission timeout
+ * as per RFC 6298. Samples are taken from the timestamp option (RFC 7323)
+ * if it has been negotiated, otherwise one segment per round trip is timed.
+ * Following Karn's algorithm, retransmitted segments are never timed.
+ */
+
+#include <macros.h>
+#include <stdint.h>
+#include <time.h>
+
+#include "rtt.h"
+#include "seq_no.h"
+#include "tcp_type.h"
+
+/** Initial retransmission timeout */
+#define RTO_INIT	(1000 * 1000)
+/** Lower bound on retransmission timeout */
+#define RTO_MIN		(200 * 1000)
+/** Upper bound on retransmission timeout */
+#define RTO_MAX		(60 * 1000 * 1000)
+/** Clock granularity */
+#define RTT_CLOCK_G	(1000)
+
+/** Initialize round-trip time estimator of a connection.
+ *
+ * @param conn Connection
+ */
+void tcp_rtt_init(tcp_conn_t *conn)
+{
+	conn->srtt = 0;
+	conn->rttvar = 0;
+	conn->rto = RTO_INIT;
+	conn->rtt_timing = false;
+}
+
+/** Get current time for round-trip time measurement.
+ *
+ * @return Current time (usec)
+ */
+usec_t tcp_rtt_now(void)
+{
+	struct timespec ts;
+
+	getuptime(&ts);
+	return SEC2USEC(ts.tv_sec) + NSEC2USEC(ts.tv_nsec);
+}
+
+/** Get current value of the timestamp clock.
+ *
+ * @return Current timestamp clock value (ms)
+ */
+uint32_t tcp_rtt_ts_now(void)
+{
+	struct timespec ts;
+
+	getuptime(&ts);
+	return (uint32_t) (SEC2MSEC(ts.tv_sec) + NSEC2MSEC(ts.tv_nsec));
+}
+
+/** Update round-trip time estimate with a new sample.
+ *
+ * @param conn Connection
+ * @param rtt  Measured round-trip time (usec)
+ */
+void tcp_rtt_sample(tcp_conn_t *conn, usec_t rtt)
+{
+	usec_t delta;
+
+	if (rtt < 0)
+		return;
+
+	if (conn->srtt == 0) {
+		/* First measurement */
+		conn->srtt = max(rtt, 1);
+		conn->rttvar = rtt / 2;
+	} else {
+		delta = conn->srtt > rtt ? conn->srtt - rtt : rtt - conn->srtt;
+		/* RTTVAR := 3/4 RTTVAR + 1/4 |SRTT - R'| */
+		conn->rttvar = conn->rttvar - conn->rttvar / 4 + delta / 4;
+		/* SRTT := 7/8 SRTT + 1/8 R' */
+		conn->srtt = max(conn->srtt - conn->srtt / 8 + rtt / 8, 1);
+	}
+
+	/* RTO := SRTT + max(G, 4 * RTTVAR) */
+	conn->rto = conn->srtt + max(RTT_CLOCK_G, 4 * conn->rttvar);
+	conn->rto = min(max(conn->rto, RTO_MIN), RTO_MAX);
+}
+
+/** Note that a new segment is being transmitted.
+ *
+ * Start timing the segment unless a measurement is already in progress
+ * or timestamps are used instead.
+ *
+ * @param conn Connection
+ * @param seg  Segment being sent for the first time
+ */
+void tcp_rtt_seg_sent(tcp_conn_t *conn, tcp_segment_t *seg)
+{
+	if (conn->ts_ok || conn->rtt_timing)
+		return;
+
+	conn->rtt_timing = true;
+	conn->rtt_seq = seg->seq + seg->len;
+	conn->rtt_start = tcp_rtt_now();
+}
+
+/** Take round-trip time sample from an acknowledgement.
+ *
+ * Must be called before SND.UNA is updated.
+ *
+ * @param conn Connection
+ * @param seg  Segment with acceptable (new) acknowledgement
+ */
+void tcp_rtt_ack(tcp_conn_t *conn, tcp_segment_t *seg)
+{
+	if (conn->ts_ok) {
+		if ((seg->opts.flags & TOPT_TS) != 0 && seg->opts.tsecr != 0) {
+			tcp_rtt_sample(conn, MSEC2USEC((uint32_t)
+			    (tcp_rtt_ts_now() - seg->opts.tsecr)));
+		}
+		return;
+	}
+
+	if (conn->rtt_timing && seq_no_ack_covers(conn, seg->ack,
+	    conn->rtt_seq)) {
+		tcp_rtt_sample(conn, tcp_rtt_now() - conn->rtt_start);
+		conn->rtt_timing = false;
+	}
+}
+
+/** Back off retransmission timer after a retransmission timeout.
+ *
+ * Also abandons any measurement in progress (Karn's algorithm).
+ *
+ * @param conn Connection
+ */
+void tcp_rtt_backoff(tcp_conn_t *conn)
+{
+	conn->rto = min(2 * conn->rto, RTO_MAX);
+	conn->rtt_timing = false;
+}
+
+/**
+ * @}
+ */
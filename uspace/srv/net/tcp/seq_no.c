@@ -195,6 +195,94 @@ bool seq_no_segment_acceptable(tcp_conn_t *conn, tcp_segment_t *seg)
 	}
 }
 
+/** Determine whether acknowledgement covers a sequence number.
+ *
+ * @param conn Connection
+ * @param ack  Acceptable acknowledgement number (SEG.ACK)
+ * @param sn   Sequence number
+ * @return @c true if SND.UNA < @a sn <= @a ack
+ */
+bool seq_no_ack_covers(tcp_conn_t *conn, uint32_t ack, uint32_t sn)
+{
+	return seq_no_lt_le(conn->snd_una, sn, ack);
+}
+
+/** Determine whether SACK block is acceptable.
+ *
+ * A SACK block is acceptable if it is not empty and lies within the
+ * unacknowledged part of the sequence space.
+ *
+ * @param conn Connection
+ * @param blk  SACK block
+ * @return @c true if SND.UNA <= left < right <= SND.NXT
+ */
+bool seq_no_sack_acceptable(tcp_conn_t *conn, tcp_sack_blk_t *blk)
+{
+	return seq_no_le_lt(conn->snd_una, blk->left, blk->right) &&
+	    seq_no_lt_le(conn->snd_una, blk->right, conn->snd_nxt);
+}
+
+/** Determine whether segment is covered by a SACK block.
+ *
+ * @param conn Connection
+ * @param seg  Segment
+ * @param blk  Acceptable SACK block
+ * @return @c true if the whole segment lies within @a blk
+ */
+bool seq_no_segment_sacked(tcp_conn_t *conn, tcp_segment_t *seg,
+    tcp_sack_blk_t *blk)
+{
+	assert(seg->len > 0);
+	return seq_no_le_lt(blk->left, seg->seq, blk->right) &&
+	    seq_no_lt_le(seg->seq, seg->seq + seg->len, blk->right);
+}
+
+/** Determine whether sequence number extends highest SACKed sequence number.
+ *
+ * @param conn Connection
+ * @param sn   Sequence number
+ * @return @c true if SND.SACK_HIGH < @a sn <= SND.NXT
+ */
+bool seq_no_sack_extends(tcp_conn_t *conn, uint32_t sn)
+{
+	return seq_no_lt_le(conn->snd_sack_high, sn, conn->snd_nxt);
+}
+
+/** Determine whether highest SACKed sequence number is still meaningful.
+ *
+ * @param conn Connection
+ * @return @c true if SND.UNA <= SND.SACK_HIGH <= SND.NXT
+ */
+bool seq_no_sack_high_valid(tcp_conn_t *conn)
+{
+	return seq_no_le_lt(conn->snd_una, conn->snd_sack_high,
+	    conn->snd_nxt + 1);
+}
+
+/** Determine whether segment lies below highest SACKed sequence number.
+ *
+ * @param conn Connection
+ * @param seg  Unacknowledged segment
+ * @return @c true if the segment ends at or before SND.SACK_HIGH
+ */
+bool seq_no_segment_below_sack(tcp_conn_t *conn, tcp_segment_t *seg)
+{
+	return seq_no_lt_le(conn->snd_una, seg->seq + seg->len,
+	    conn->snd_sack_high);
+}
+
+/** Compare two sequence numbers at or beyond RCV.NXT.
+ *
+ * @param conn Connection
+ * @param a    Sequence number
+ * @param b    Sequence number
+ * @return @c true if @a a <= @a b
+ */
+bool seq_no_rcv_le(tcp_conn_t *conn, uint32_t a, uint32_t b)
+{
+	return (a - conn->rcv_nxt) <= (b - conn->rcv_nxt);
+}
+
 /** Determine size that control bits occupy in sequence space.
  *
  * @param ctrl Control bits combination
@@ -49,6 +49,14 @@ extern bool seq_no_segment_acceptable(tcp_conn_t *, tcp_segment_t *);
 extern void seq_no_seg_trim_calc(tcp_conn_t *, tcp_segment_t *, uint32_t *,
     uint32_t *);
 extern int seq_no_seg_cmp(tcp_conn_t *, tcp_segment_t *, tcp_segment_t *);
+extern bool seq_no_ack_covers(tcp_conn_t *, uint32_t, uint32_t);
+extern bool seq_no_sack_acceptable(tcp_conn_t *, tcp_sack_blk_t *);
+extern bool seq_no_segment_sacked(tcp_conn_t *, tcp_segment_t *,
+    tcp_sack_blk_t *);
+extern bool seq_no_sack_extends(tcp_conn_t *, uint32_t);
+extern bool seq_no_sack_high_valid(tcp_conn_t *);
+extern bool seq_no_segment_below_sack(tcp_conn_t *, tcp_segment_t *);
+extern bool seq_no_rcv_le(tcp_conn_t *, uint32_t, uint32_t);
 
 extern uint32_t seq_no_control_len(tcp_control_t);
 
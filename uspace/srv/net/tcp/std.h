@@ -109,9 +109,29 @@ enum opt_kind {
 	/** No-operation */
 	OPT_NOP			= 1,
 	/** Maximum segment size */
-	OPT_MAX_SEG_SIZE	= 2
+	OPT_MAX_SEG_SIZE	= 2,
+	/** Window scale */
+	OPT_WSCALE		= 3,
+	/** SACK permitted */
+	OPT_SACK_PERM		= 4,
+	/** Selective acknowledgement */
+	OPT_SACK		= 5,
+	/** Timestamps */
+	OPT_TIMESTAMP		= 8
 };
 
+/** Option lengths */
+enum opt_len {
+	OPT_MAX_SEG_SIZE_LEN	= 4,
+	OPT_WSCALE_LEN		= 3,
+	OPT_SACK_PERM_LEN	= 2,
+	OPT_SACK_BLK_LEN	= 8,
+	OPT_TIMESTAMP_LEN	= 10
+};
+
+/** Maximum size of TCP options */
+#define TCP_OPTS_MAX_SIZE	40
+
 #endif
 
 /** @}
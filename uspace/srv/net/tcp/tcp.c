@@ -38,8 +38,10 @@
 #include <errno.h>
 #include <io/log.h>
 #include <stdio.h>
+#include <str.h>
 #include <task.h>
 
+#include "cc.h"
 #include "conn.h"
 #include "inet.h"
 #include "ncsim.h"
@@ -89,12 +91,26 @@ static errno_t tcp_init(void)
 	return EOK;
 }
 
+static void print_syntax(void)
+{
+	printf("Syntax: %s [--cubic]\n", NAME);
+	printf("\t--cubic\tUse CUBIC congestion control instead of NewReno\n");
+}
+
 int main(int argc, char **argv)
 {
 	errno_t rc;
 
 	printf(NAME ": TCP (Transmission Control Protocol) network module\n");
 
+	if (argc > 2 || (argc == 2 && str_cmp(argv[1], "--cubic") != 0)) {
+		print_syntax();
+		return 1;
+	}
+
+	if (argc == 2)
+		tcp_cc_default_algo = tcp_cc_cubic;
+
 	rc = log_init(NAME);
 	if (rc != EOK) {
 		printf(NAME ": Failed to initialize log.\n");
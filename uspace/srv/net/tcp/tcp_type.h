@@ -45,6 +45,7 @@
 #include <stdint.h>
 #include <inet/addr.h>
 #include <inet/endpoint.h>
+#include <time.h>
 
 struct tcp_conn;
 
@@ -139,6 +140,14 @@ typedef enum {
 
 typedef struct tcp_conn tcp_conn_t;
 
+/** Congestion control algorithm */
+typedef enum {
+	/** NewReno (RFC 5681, RFC 6582) */
+	tcp_cc_newreno,
+	/** CUBIC (RFC 8312) */
+	tcp_cc_cubic
+} tcp_cc_algo_t;
+
 /** Connection state change callback function */
 typedef void (*tcp_cstate_cb_t)(tcp_conn_t *, void *);
 
@@ -154,6 +163,52 @@ typedef struct {
 	tcp_cstate_t cstate;
 } tcp_conn_status_t;
 
+/** Maximum number of SACK blocks in a segment */
+#define TCP_SACK_BLOCKS_MAX 4
+
+/** Segment options present */
+typedef enum {
+	/** Maximum segment size */
+	TOPT_MSS	= 0x1,
+	/** Window scale */
+	TOPT_WSCALE	= 0x2,
+	/** SACK permitted */
+	TOPT_SACK_PERM	= 0x4,
+	/** SACK blocks */
+	TOPT_SACK	= 0x8,
+	/** Timestamps */
+	TOPT_TS		= 0x10
+} tcp_opt_flags_t;
+
+/** SACK block */
+typedef struct {
+	/** First sequence number of the block */
+	uint32_t left;
+	/** Sequence number immediately following the block */
+	uint32_t right;
+} tcp_sack_blk_t;
+
+/** Segment options
+ *
+ * Note this is not the actual on-the-wire encoding
+ */
+typedef struct {
+	/** Options present */
+	tcp_opt_flags_t flags;
+	/** Maximum segment size */
+	uint16_t mss;
+	/** Window scale shift count */
+	uint8_t wscale;
+	/** Timestamp value */
+	uint32_t tsval;
+	/** Timestamp echo reply */
+	uint32_t tsecr;
+	/** Number of SACK blocks */
+	size_t sack_cnt;
+	/** SACK blocks */
+	tcp_sack_blk_t sack[TCP_SACK_BLOCKS_MAX];
+} tcp_seg_opts_t;
+
 typedef struct {
 	/** SYN, FIN */
 	tcp_control_t ctrl;
@@ -168,6 +223,8 @@ typedef struct {
 	uint32_t wnd;
 	/** Segment urgent pointer */
 	uint32_t up;
+	/** Segment options */
+	tcp_seg_opts_t opts;
 
 	/** Segment data, may be moved when trimming segment */
 	void *data;
@@ -191,11 +248,22 @@ typedef struct {
 /** NCSim queue entry */
 typedef struct {
 	link_t link;
-	usec_t delay;
+	/** Time of delivery */
+	usec_t due;
 	inet_ep2_t epp;
 	tcp_segment_t *seg;
 } tcp_squeue_entry_t;
 
+/** Network conditions simulated by NCSim */
+typedef struct {
+	/** Fixed one-way delay */
+	usec_t delay;
+	/** Maximum additional random delay */
+	usec_t jitter;
+	/** Probability of dropping a segment in units of 1/1000 */
+	unsigned loss;
+} tcp_ncsim_cond_t;
+
 /** Incoming queue entry */
 typedef struct {
 	link_t link;
@@ -207,6 +275,12 @@ typedef struct {
 	link_t link;
 	tcp_conn_t *conn;
 	tcp_segment_t *seg;
+	/** Segment has been selectively acknowledged */
+	bool sacked;
+	/** Segment was declared lost by retransmission timeout */
+	bool lost;
+	/** Segment has been retransmitted during current loss recovery */
+	bool rexmit;
 } tcp_tqueue_entry_t;
 
 /** Retransmission queue callbacks */
@@ -307,6 +381,12 @@ struct tcp_conn {
 	uint32_t snd_wl2;
 	/** Initial send sequence number */
 	uint32_t iss;
+	/** Send maximum segment size (payload bytes per segment) */
+	uint32_t snd_mss;
+	/** Send window scale shift count */
+	uint8_t snd_wscale;
+	/** Highest sequence number selectively acknowledged by peer */
+	uint32_t snd_sack_high;
 
 	/** Receive next */
 	uint32_t rcv_nxt;
@@ -316,6 +396,63 @@ struct tcp_conn {
 	uint32_t rcv_up;
 	/** Initial receive sequence number */
 	uint32_t irs;
+	/** Receive window scale shift count */
+	uint8_t rcv_wscale;
+	/** Right edge of the receive window last advertised to peer */
+	uint32_t rcv_adv;
+	/** Acknowledgement number last sent to peer */
+	uint32_t rcv_ack_sent;
+	/** An acknowledgement should be sent to peer */
+	bool rcv_ack_pending;
+	/** Start of the out-of-order segment received last (for SACK) */
+	uint32_t rcv_sack_last;
+
+	/** Window scaling negotiated */
+	bool ws_ok;
+	/** Selective acknowledgements negotiated */
+	bool sack_ok;
+	/** Timestamps negotiated */
+	bool ts_ok;
+	/** Most recent timestamp received from peer */
+	uint32_t ts_recent;
+
+	/** Congestion control algorithm */
+	tcp_cc_algo_t cc_algo;
+	/** Congestion window */
+	uint32_t cwnd;
+	/** Slow start threshold */
+	uint32_t ssthresh;
+	/** Number of consecutive duplicate acknowledgements */
+	unsigned dupacks;
+	/** In fast recovery */
+	bool in_recovery;
+	/** SND.NXT when entering loss recovery */
+	uint32_t recover;
+	/** CUBIC: window size just before last reduction */
+	uint32_t cubic_wmax;
+	/** CUBIC: time when current congestion avoidance epoch started (ms) */
+	uint32_t cubic_epoch;
+	/** CUBIC: @c cubic_epoch is valid */
+	bool cubic_epoch_valid;
+	/** CUBIC: time to reach the origin point from epoch start (ms) */
+	uint32_t cubic_k;
+	/** CUBIC: origin point of the cubic function */
+	uint32_t cubic_origin;
+	/** CUBIC: estimated window of standard TCP */
+	uint32_t cubic_west;
+
+	/** Smoothed round-trip time (usec) */
+	usec_t srtt;
+	/** Round-trip time variation (usec) */
+	usec_t rttvar;
+	/** Retransmission timeout (usec) */
+	usec_t rto;
+	/** Timing a segment for round-trip time measurement */
+	bool rtt_timing;
+	/** Acknowledgement number that completes the measurement */
+	uint32_t rtt_seq;
+	/** Time when the timed segment was sent (usec) */
+	usec_t rtt_start;
 };
 
 /** Continuation of processing.
@@ -386,7 +523,9 @@ typedef enum {
 	/** Segment loopback */
 	tcp_lb_segment,
 	/** PDU loopback */
-	tcp_lb_pdu
+	tcp_lb_pdu,
+	/** Segment loopback through network condition simulator */
+	tcp_lb_ncsim
 } tcp_lb_t;
 
 #endif
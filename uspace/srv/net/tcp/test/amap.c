@@ -0,0 +1,250 @@
+/*
+ * Copyright (c) 2026 The HelenOS Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <errno.h>
+#include <inet/addr.h>
+#include <inet/endpoint.h>
+#include <io/log.h>
+#include <nettl/amap.h>
+#include <pcut/pcut.h>
+#include <stdint.h>
+
+PCUT_INIT;
+
+PCUT_TEST_SUITE(amap);
+
+enum {
+	/** Number of connections in demultiplexing test */
+	test_amap_nconn = 10000,
+	/** Local port of connections and listener */
+	test_amap_lport = 80,
+	/** Local port of unspecified listener */
+	test_amap_uport = 22,
+	/** Number of listeners on one local address in port range test */
+	test_amap_nports = 100
+};
+
+/** Argument of listener with local address */
+static int test_amap_laddr_arg;
+/** Argument of unspecified listener */
+static int test_amap_unspec_arg;
+
+/** Fill in endpoint pair of connection number @a i.
+ *
+ * @param i   Connection number
+ * @param epp Endpoint pair to fill in
+ */
+static void test_amap_conn_epp(unsigned i, inet_ep2_t *epp)
+{
+	inet_ep2_init(epp);
+	inet_addr(&epp->local.addr, 10, 0, 0, 1);
+	epp->local.port = test_amap_lport;
+	inet_addr(&epp->remote.addr, 10, 1 + i / 65536, (i / 256) % 256,
+	    i % 256);
+	epp->remote.port = inet_port_user_lo + i % 1000;
+}
+
+PCUT_TEST_BEFORE
+{
+	errno_t rc;
+
+	/* We will be calling functions that perform logging */
+	rc = log_init("test-amap");
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+}
+
+/** Test demultiplexing among many connections and listeners */
+PCUT_TEST(demux_many)
+{
+	amap_t *map;
+	inet_ep2_t epp, aepp;
+	void *arg;
+	unsigned i;
+	errno_t rc;
+
+	rc = amap_create(&map);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+
+	/* Listener on local address */
+	inet_ep2_init(&epp);
+	inet_addr(&epp.local.addr, 10, 0, 0, 1);
+	epp.local.port = test_amap_lport;
+	rc = amap_insert(map, &epp, &test_amap_laddr_arg, af_allow_system,
+	    &aepp);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+
+	/* Listener with nothing specified */
+	inet_ep2_init(&epp);
+	epp.local.port = test_amap_uport;
+	rc = amap_insert(map, &epp, &test_amap_unspec_arg, af_allow_system,
+	    &aepp);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+
+	/* Connections accepted by the first listener */
+	for (i = 0; i < test_amap_nconn; i++) {
+		test_amap_conn_epp(i, &epp);
+		rc = amap_insert(map, &epp, (void *)(uintptr_t)(i + 1),
+		    af_allow_system, &aepp);
+		PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+	}
+
+	/* The same endpoint pair cannot be inserted twice */
+	test_amap_conn_epp(0, &epp);
+	rc = amap_insert(map, &epp, NULL, af_allow_system, &aepp);
+	PCUT_ASSERT_ERRNO_VAL(EEXIST, rc);
+
+	/* Each connection must be matched exactly */
+	for (i = 0; i < test_amap_nconn; i++) {
+		test_amap_conn_epp(i, &epp);
+		rc = amap_find_match(map, &epp, &arg);
+		PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+		PCUT_ASSERT_EQUALS((void *)(uintptr_t)(i + 1), arg);
+	}
+
+	/* Unknown remote endpoint falls back to the listener */
+	test_amap_conn_epp(test_amap_nconn, &epp);
+	rc = amap_find_match(map, &epp, &arg);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+	PCUT_ASSERT_EQUALS(&test_amap_laddr_arg, arg);
+
+	/* Other local port falls back to the unspecified listener */
+	epp.local.port = test_amap_uport;
+	rc = amap_find_match(map, &epp, &arg);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+	PCUT_ASSERT_EQUALS(&test_amap_unspec_arg, arg);
+
+	/* Nobody listens on this port */
+	epp.local.port = test_amap_uport + 1;
+	rc = amap_find_match(map, &epp, &arg);
+	PCUT_ASSERT_ERRNO_VAL(ENOENT, rc);
+
+	for (i = 0; i < test_amap_nconn; i++) {
+		test_amap_conn_epp(i, &epp);
+		amap_remove(map, &epp);
+	}
+
+	/* Removed connections fall back to the listener */
+	test_amap_conn_epp(0, &epp);
+	rc = amap_find_match(map, &epp, &arg);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+	PCUT_ASSERT_EQUALS(&test_amap_laddr_arg, arg);
+
+	inet_ep2_init(&epp);
+	inet_addr(&epp.local.addr, 10, 0, 0, 1);
+	epp.local.port = test_amap_lport;
+	amap_remove(map, &epp);
+
+	inet_ep2_init(&epp);
+	epp.local.port = test_amap_uport;
+	amap_remove(map, &epp);
+
+	amap_destroy(map);
+}
+
+/** Test dynamic port allocation */
+PCUT_TEST(alloc_dynamic)
+{
+	amap_t *map;
+	inet_ep2_t epp, aepp1, aepp2;
+	errno_t rc;
+
+	rc = amap_create(&map);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+
+	inet_ep2_init(&epp);
+	inet_addr(&epp.local.addr, 10, 0, 0, 1);
+
+	rc = amap_insert(map, &epp, NULL, 0, &aepp1);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+	PCUT_ASSERT_TRUE(aepp1.local.port >= inet_port_dyn_lo);
+
+	rc = amap_insert(map, &epp, NULL, 0, &aepp2);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+	PCUT_ASSERT_TRUE(aepp2.local.port >= inet_port_dyn_lo);
+	PCUT_ASSERT_TRUE(aepp1.local.port != aepp2.local.port);
+
+	amap_remove(map, &aepp1);
+	amap_remove(map, &aepp2);
+	amap_destroy(map);
+}
+
+/** Test many ports in one port range.
+ *
+ * The port range starts as a list and switches to a hash table as it
+ * grows, ports must be found and removed in either state.
+ */
+PCUT_TEST(many_ports)
+{
+	amap_t *map;
+	inet_ep2_t epp, aepp;
+	void *arg;
+	unsigned i;
+	errno_t rc;
+
+	rc = amap_create(&map);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+
+	for (i = 0; i < test_amap_nports; i++) {
+		inet_ep2_init(&epp);
+		inet_addr(&epp.local.addr, 10, 0, 0, 1);
+		epp.local.port = inet_port_user_lo + i;
+		rc = amap_insert(map, &epp, (void *)(uintptr_t)(i + 1), 0,
+		    &aepp);
+		PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+	}
+
+	for (i = 0; i < test_amap_nports; i++) {
+		inet_ep2_init(&epp);
+		inet_addr(&epp.local.addr, 10, 0, 0, 1);
+		epp.local.port = inet_port_user_lo + i;
+		inet_addr(&epp.remote.addr, 10, 1, 0, 1);
+		epp.remote.port = inet_port_dyn_lo;
+		rc = amap_find_match(map, &epp, &arg);
+		PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+		PCUT_ASSERT_EQUALS((void *)(uintptr_t)(i + 1), arg);
+	}
+
+	for (i = 0; i < test_amap_nports; i++) {
+		inet_ep2_init(&epp);
+		inet_addr(&epp.local.addr, 10, 0, 0, 1);
+		epp.local.port = inet_port_user_lo + i;
+		amap_remove(map, &epp);
+	}
+
+	inet_ep2_init(&epp);
+	inet_addr(&epp.local.addr, 10, 0, 0, 1);
+	epp.local.port = inet_port_user_lo;
+	inet_addr(&epp.remote.addr, 10, 1, 0, 1);
+	epp.remote.port = inet_port_dyn_lo;
+	rc = amap_find_match(map, &epp, &arg);
+	PCUT_ASSERT_ERRNO_VAL(ENOENT, rc);
+
+	amap_destroy(map);
+}
+
+PCUT_EXPORT(amap);
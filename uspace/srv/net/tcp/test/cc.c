@@ -0,0 +1,235 @@
+/*
+ * Copyright (c) 2026 The HelenOS Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <errno.h>
+#include <inet/endpoint.h>
+#include <pcut/pcut.h>
+
+#include "../cc.h"
+#include "../conn.h"
+
+PCUT_INIT;
+
+PCUT_TEST_SUITE(cc);
+
+enum {
+	test_mss = 1000
+};
+
+/** Create connection with congestion control initialized for testing.
+ *
+ * @param algo Congestion control algorithm
+ * @return New connection
+ */
+static tcp_conn_t *test_cc_conn(tcp_cc_algo_t algo)
+{
+	tcp_conn_t *conn;
+	inet_ep2_t epp;
+
+	inet_ep2_init(&epp);
+	conn = tcp_conn_new(&epp);
+	PCUT_ASSERT_NOT_NULL(conn);
+
+	conn->snd_una = 1000;
+	conn->snd_nxt = 1000;
+	conn->snd_mss = test_mss;
+	conn->sack_ok = false;
+	conn->cc_algo = algo;
+	tcp_cc_init(conn);
+
+	return conn;
+}
+
+/** Acknowledge sequence numbers as the connection would. */
+static void test_cc_ack(tcp_conn_t *conn, uint32_t ack)
+{
+	tcp_cc_ack(conn, ack);
+	conn->snd_una = ack;
+}
+
+/** Test initial window */
+PCUT_TEST(init)
+{
+	tcp_conn_t *conn;
+
+	conn = test_cc_conn(tcp_cc_newreno);
+	PCUT_ASSERT_INT_EQUALS(4 * test_mss, conn->cwnd);
+	PCUT_ASSERT_FALSE(conn->in_recovery);
+
+	conn->snd_mss = 1460;
+	tcp_cc_init(conn);
+	PCUT_ASSERT_INT_EQUALS(3 * 1460, conn->cwnd);
+
+	tcp_conn_delete(conn);
+}
+
+/** Test slow start and congestion avoidance */
+PCUT_TEST(slow_start_avoid)
+{
+	tcp_conn_t *conn;
+	uint32_t cwnd;
+
+	conn = test_cc_conn(tcp_cc_newreno);
+
+	/* Slow start: one MSS per ACK */
+	conn->snd_nxt = conn->snd_una + 4 * test_mss;
+	test_cc_ack(conn, conn->snd_una + test_mss);
+	PCUT_ASSERT_INT_EQUALS(5 * test_mss, conn->cwnd);
+	test_cc_ack(conn, conn->snd_una + 3 * test_mss);
+	PCUT_ASSERT_INT_EQUALS(6 * test_mss, conn->cwnd);
+
+	/* Congestion avoidance: MSS * MSS / cwnd per ACK */
+	conn->ssthresh = conn->cwnd;
+	conn->snd_nxt = conn->snd_una + 6 * test_mss;
+	cwnd = conn->cwnd;
+	test_cc_ack(conn, conn->snd_una + test_mss);
+	PCUT_ASSERT_INT_EQUALS(cwnd + test_mss * test_mss / cwnd, conn->cwnd);
+
+	tcp_conn_delete(conn);
+}
+
+/** Test NewReno fast retransmit and fast recovery */
+PCUT_TEST(fast_recovery)
+{
+	tcp_conn_t *conn;
+	uint32_t snd_nxt;
+
+	conn = test_cc_conn(tcp_cc_newreno);
+	conn->cwnd = 10 * test_mss;
+	conn->snd_nxt = conn->snd_una + 10 * test_mss;
+	snd_nxt = conn->snd_nxt;
+
+	/* Third duplicate ACK triggers fast retransmit */
+	PCUT_ASSERT_FALSE(tcp_cc_dupack(conn));
+	PCUT_ASSERT_FALSE(tcp_cc_dupack(conn));
+	PCUT_ASSERT_TRUE(tcp_cc_dupack(conn));
+
+	PCUT_ASSERT_TRUE(conn->in_recovery);
+	PCUT_ASSERT_INT_EQUALS(5 * test_mss, conn->ssthresh);
+	PCUT_ASSERT_INT_EQUALS(8 * test_mss, conn->cwnd);
+
+	/* Further duplicate ACKs inflate the window */
+	PCUT_ASSERT_FALSE(tcp_cc_dupack(conn));
+	PCUT_ASSERT_INT_EQUALS(9 * test_mss, conn->cwnd);
+
+	/* Partial ACK deflates the window */
+	test_cc_ack(conn, conn->snd_una + 2 * test_mss);
+	PCUT_ASSERT_TRUE(conn->in_recovery);
+	PCUT_ASSERT_INT_EQUALS(8 * test_mss, conn->cwnd);
+
+	/* Full ACK ends recovery */
+	test_cc_ack(conn, snd_nxt);
+	PCUT_ASSERT_FALSE(conn->in_recovery);
+	PCUT_ASSERT_INT_EQUALS(2 * test_mss, conn->cwnd);
+
+	tcp_conn_delete(conn);
+}
+
+/** Test fast recovery with SACK does not inflate the window */
+PCUT_TEST(fast_recovery_sack)
+{
+	tcp_conn_t *conn;
+
+	conn = test_cc_conn(tcp_cc_newreno);
+	conn->sack_ok = true;
+	conn->cwnd = 10 * test_mss;
+	conn->snd_nxt = conn->snd_una + 10 * test_mss;
+
+	PCUT_ASSERT_FALSE(tcp_cc_dupack(conn));
+	PCUT_ASSERT_FALSE(tcp_cc_dupack(conn));
+	PCUT_ASSERT_TRUE(tcp_cc_dupack(conn));
+	PCUT_ASSERT_INT_EQUALS(5 * test_mss, conn->cwnd);
+
+	PCUT_ASSERT_FALSE(tcp_cc_dupack(conn));
+	PCUT_ASSERT_INT_EQUALS(5 * test_mss, conn->cwnd);
+
+	tcp_conn_delete(conn);
+}
+
+/** Test retransmission timeout */
+PCUT_TEST(timeout)
+{
+	tcp_conn_t *conn;
+
+	conn = test_cc_conn(tcp_cc_newreno);
+	conn->cwnd = 10 * test_mss;
+	conn->snd_nxt = conn->snd_una + 8 * test_mss;
+
+	tcp_cc_timeout(conn);
+	PCUT_ASSERT_INT_EQUALS(test_mss, conn->cwnd);
+	PCUT_ASSERT_INT_EQUALS(4 * test_mss, conn->ssthresh);
+
+	/*
+	 * Duplicate ACKs for data sent before the timeout do not trigger
+	 * another fast retransmit.
+	 */
+	PCUT_ASSERT_FALSE(tcp_cc_dupack(conn));
+	PCUT_ASSERT_FALSE(tcp_cc_dupack(conn));
+	PCUT_ASSERT_FALSE(tcp_cc_dupack(conn));
+	PCUT_ASSERT_FALSE(conn->in_recovery);
+
+	tcp_conn_delete(conn);
+}
+
+/** Test CUBIC window reduction and growth */
+PCUT_TEST(cubic)
+{
+	tcp_conn_t *conn;
+	uint32_t cwnd;
+	int i;
+
+	conn = test_cc_conn(tcp_cc_cubic);
+	conn->cwnd = 100 * test_mss;
+	conn->snd_nxt = conn->snd_una + 100 * test_mss;
+
+	PCUT_ASSERT_FALSE(tcp_cc_dupack(conn));
+	PCUT_ASSERT_FALSE(tcp_cc_dupack(conn));
+	PCUT_ASSERT_TRUE(tcp_cc_dupack(conn));
+
+	/* Multiplicative decrease by beta = 0.7 */
+	PCUT_ASSERT_INT_EQUALS(70 * test_mss, conn->ssthresh);
+
+	test_cc_ack(conn, conn->snd_nxt);
+	PCUT_ASSERT_FALSE(conn->in_recovery);
+
+	/* Window grows again in congestion avoidance */
+	conn->cwnd = conn->ssthresh;
+	cwnd = conn->cwnd;
+
+	for (i = 0; i < 100; i++) {
+		conn->snd_nxt = conn->snd_una + conn->cwnd;
+		test_cc_ack(conn, conn->snd_una + test_mss);
+	}
+
+	PCUT_ASSERT_TRUE(conn->cwnd > cwnd);
+	PCUT_ASSERT_TRUE(conn->cwnd <= conn->cubic_wmax);
+
+	tcp_conn_delete(conn);
+}
+
+PCUT_EXPORT(cc);
@@ -56,10 +56,14 @@ void test_seg_same(tcp_segment_t *a, tcp_segment_t *b)
 
 PCUT_INIT;
 
+PCUT_IMPORT(amap);
+PCUT_IMPORT(cc);
 PCUT_IMPORT(conn);
 PCUT_IMPORT(iqueue);
+PCUT_IMPORT(ncsim);
 PCUT_IMPORT(pdu);
 PCUT_IMPORT(rqueue);
+PCUT_IMPORT(rtt);
 PCUT_IMPORT(segment);
 PCUT_IMPORT(seq_no);
 PCUT_IMPORT(tqueue);
@@ -0,0 +1,182 @@
+/*
+ * Copyright (c) 2026 The HelenOS Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <errno.h>
+#include <inet/endpoint.h>
+#include <io/log.h>
+#include <mem.h>
+#include <pcut/pcut.h>
+#include <stdlib.h>
+
+#include "../conn.h"
+#include "../ncsim.h"
+#include "../rqueue.h"
+#include "../ucall.h"
+
+PCUT_INIT;
+
+PCUT_TEST_SUITE(ncsim);
+
+enum {
+	/** Amount of data to transfer, fits in the receive buffer */
+	test_xfer_size = 128 * 1024
+};
+
+static tcp_rqueue_cb_t test_rqueue_cb = {
+	.seg_received = tcp_as_segment_arrived
+};
+
+PCUT_TEST_BEFORE
+{
+	errno_t rc;
+
+	/* We will be calling functions that perform logging */
+	rc = log_init("test-tcp");
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+
+	rc = tcp_conns_init();
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+
+	tcp_rqueue_init(&test_rqueue_cb);
+	tcp_rqueue_fibril_start();
+
+	tcp_ncsim_init();
+	tcp_ncsim_fibril_start();
+
+	/* Loop segments back through the network condition simulator */
+	tcp_conn_lb = tcp_lb_ncsim;
+}
+
+PCUT_TEST_AFTER
+{
+	tcp_ncsim_cond_t cond = { 0 };
+
+	tcp_ncsim_set_cond(&cond);
+	tcp_ncsim_fini();
+	tcp_rqueue_fini();
+	tcp_conns_fini();
+}
+
+/** Transfer data over a link with delay, reordering and loss.
+ *
+ * All data must arrive intact and the sender must have detected
+ * at least one loss and recovered from it.
+ */
+PCUT_TEST(lossy_transfer)
+{
+	tcp_conn_t *cconn, *sconn;
+	inet_ep2_t cepp, sepp;
+	tcp_ncsim_cond_t cond;
+	tcp_error_t trc;
+	xflags_t xflags;
+	uint8_t *sbuf;
+	uint8_t *rbuf;
+	size_t rcvd;
+	size_t total;
+	size_t i;
+
+	cond.delay = 1000;
+	cond.jitter = 500;
+	cond.loss = 50;
+	tcp_ncsim_set_cond(&cond);
+
+	sbuf = malloc(test_xfer_size);
+	PCUT_ASSERT_NOT_NULL(sbuf);
+	rbuf = malloc(test_xfer_size);
+	PCUT_ASSERT_NOT_NULL(rbuf);
+
+	for (i = 0; i < test_xfer_size; i++)
+		sbuf[i] = (uint8_t) (i * 7 + i / 251);
+
+	/* Client EPP */
+	inet_ep2_init(&cepp);
+	inet_addr(&cepp.local.addr, 127, 0, 0, 1);
+	inet_addr(&cepp.remote.addr, 127, 0, 0, 1);
+	cepp.remote.port = inet_port_user_lo;
+
+	/* Server EPP */
+	inet_ep2_init(&sepp);
+	inet_addr(&sepp.local.addr, 127, 0, 0, 1);
+	sepp.local.port = inet_port_user_lo;
+
+	sconn = NULL;
+	trc = tcp_uc_open(&sepp, ap_passive, tcp_open_nonblock, &sconn);
+	PCUT_ASSERT_INT_EQUALS(TCP_EOK, trc);
+	PCUT_ASSERT_NOT_NULL(sconn);
+
+	cconn = NULL;
+	trc = tcp_uc_open(&cepp, ap_active, 0, &cconn);
+	PCUT_ASSERT_INT_EQUALS(TCP_EOK, trc);
+	PCUT_ASSERT_NOT_NULL(cconn);
+
+	tcp_conn_lock(sconn);
+	while (sconn->cstate == st_listen || sconn->cstate == st_syn_received)
+		fibril_condvar_wait(&sconn->cstate_cv, &sconn->lock);
+	PCUT_ASSERT_INT_EQUALS(st_established, sconn->cstate);
+	tcp_conn_unlock(sconn);
+
+	PCUT_ASSERT_TRUE(cconn->sack_ok);
+
+	/*
+	 * The receive buffer can hold all of the data, so the sender
+	 * is never blocked waiting for us to read it.
+	 */
+	trc = tcp_uc_send(cconn, sbuf, test_xfer_size, 0);
+	PCUT_ASSERT_INT_EQUALS(TCP_EOK, trc);
+
+	total = 0;
+	while (total < test_xfer_size) {
+		tcp_conn_lock(sconn);
+		while (sconn->rcv_buf_used == 0 && !sconn->reset)
+			fibril_condvar_wait(&sconn->rcv_buf_cv, &sconn->lock);
+		tcp_conn_unlock(sconn);
+
+		trc = tcp_uc_receive(sconn, rbuf + total,
+		    test_xfer_size - total, &rcvd, &xflags);
+		PCUT_ASSERT_INT_EQUALS(TCP_EOK, trc);
+		total += rcvd;
+	}
+
+	PCUT_ASSERT_INT_EQUALS(0, memcmp(sbuf, rbuf, test_xfer_size));
+
+	/* A detected loss reduces the slow start threshold */
+	tcp_conn_lock(cconn);
+	PCUT_ASSERT_TRUE(cconn->ssthresh < cconn->snd_buf_size);
+	tcp_conn_unlock(cconn);
+
+	tcp_uc_abort(cconn);
+	tcp_uc_delete(cconn);
+
+	tcp_uc_abort(sconn);
+	tcp_uc_delete(sconn);
+
+	free(sbuf);
+	free(rbuf);
+}
+
+PCUT_EXPORT(ncsim);
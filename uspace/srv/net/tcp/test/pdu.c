@@ -108,4 +108,82 @@ PCUT_TEST(encdec_data)
 	free(data);
 }
 
+/** Test encode/decode round trip for PDU with options */
+PCUT_TEST(encdec_opts)
+{
+	tcp_segment_t *seg, *dseg;
+	tcp_pdu_t *pdu;
+	inet_ep2_t epp, depp;
+	size_t i;
+	errno_t rc;
+
+	inet_ep2_init(&epp);
+	inet_addr(&epp.local.addr, 1, 2, 3, 4);
+	inet_addr(&epp.remote.addr, 5, 6, 7, 8);
+
+	/* SYN with all options */
+	seg = tcp_segment_make_ctrl(CTL_SYN);
+	PCUT_ASSERT_NOT_NULL(seg);
+
+	seg->seq = 20;
+	seg->opts.flags = TOPT_MSS | TOPT_WSCALE | TOPT_SACK_PERM | TOPT_TS;
+	seg->opts.mss = 1460;
+	seg->opts.wscale = 7;
+	seg->opts.tsval = 0x12345678;
+	seg->opts.tsecr = 0;
+
+	rc = tcp_pdu_encode(&epp, seg, &pdu);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+	PCUT_ASSERT_INT_EQUALS(0, pdu->header_size % 4);
+	rc = tcp_pdu_decode(pdu, &depp, &dseg);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+
+	test_seg_same(seg, dseg);
+	PCUT_ASSERT_INT_EQUALS(seg->opts.flags, dseg->opts.flags);
+	PCUT_ASSERT_INT_EQUALS(1460, dseg->opts.mss);
+	PCUT_ASSERT_INT_EQUALS(7, dseg->opts.wscale);
+	PCUT_ASSERT_INT_EQUALS(0x12345678, dseg->opts.tsval);
+	PCUT_ASSERT_INT_EQUALS(0, dseg->opts.tsecr);
+
+	tcp_pdu_delete(pdu);
+	tcp_segment_delete(dseg);
+	tcp_segment_delete(seg);
+
+	/* ACK with timestamp and as many SACK blocks as fit */
+	seg = tcp_segment_make_ctrl(CTL_ACK);
+	PCUT_ASSERT_NOT_NULL(seg);
+
+	seg->seq = 20;
+	seg->ack = 1000;
+	seg->opts.flags = TOPT_TS | TOPT_SACK;
+	seg->opts.tsval = 1;
+	seg->opts.tsecr = 2;
+	seg->opts.sack_cnt = TCP_SACK_BLOCKS_MAX - 1;
+	for (i = 0; i < seg->opts.sack_cnt; i++) {
+		seg->opts.sack[i].left = 2000 + 1000 * i;
+		seg->opts.sack[i].right = 2500 + 1000 * i;
+	}
+
+	rc = tcp_pdu_encode(&epp, seg, &pdu);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+	rc = tcp_pdu_decode(pdu, &depp, &dseg);
+	PCUT_ASSERT_ERRNO_VAL(EOK, rc);
+
+	test_seg_same(seg, dseg);
+	PCUT_ASSERT_INT_EQUALS(seg->opts.flags, dseg->opts.flags);
+	PCUT_ASSERT_INT_EQUALS(1, dseg->opts.tsval);
+	PCUT_ASSERT_INT_EQUALS(2, dseg->opts.tsecr);
+	PCUT_ASSERT_INT_EQUALS(seg->opts.sack_cnt, dseg->opts.sack_cnt);
+	for (i = 0; i < seg->opts.sack_cnt; i++) {
+		PCUT_ASSERT_INT_EQUALS(seg->opts.sack[i].left,
+		    dseg->opts.sack[i].left);
+		PCUT_ASSERT_INT_EQUALS(seg->opts.sack[i].right,
+		    dseg->opts.sack[i].right);
+	}
+
+	tcp_pdu_delete(pdu);
+	tcp_segment_delete(dseg);
+	tcp_segment_delete(seg);
+}
+
 PCUT_EXPORT(pdu);
@@ -0,0 +1,97 @@
+/*
+ * Copyright (c) 2026 The HelenOS Project
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in the
+ *   documentation and/or other materials provided with the distribution.
+ * - The name of the author may not be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <errno.h>
+#include <inet/endpoint.h>
+#include <pcut/pcut.h>
+
+#include "../conn.h"
+#include "../rtt.h"
+
+PCUT_INIT;
+
+PCUT_TEST_SUITE(rtt);
+
+/** Test retransmission timeout computation */
+PCUT_TEST(sample)
+{
+	tcp_conn_t *conn;
+	inet_ep2_t epp;
+
+	inet_ep2_init(&epp);
+	conn = tcp_conn_new(&epp);
+	PCUT_ASSERT_NOT_NULL(conn);
+
+	/* Initial RTO is one second */
+	PCUT_ASSERT_INT_EQUALS(1000 * 1000, conn->rto);
+
+	/* First sample: SRTT = R, RTTVAR = R / 2, RTO = SRTT + 4 * RTTVAR */
+	tcp_rtt_sample(conn, 100 * 1000);
+	PCUT_ASSERT_INT_EQUALS(100 * 1000, conn->srtt);
+	PCUT_ASSERT_INT_EQUALS(50 * 1000, conn->rttvar);
+	PCUT_ASSERT_INT_EQUALS(300 * 1000, conn->rto);
+
+	/* Same sample again: variance decays */
+	tcp_rtt_sample(conn, 100 * 1000);
+	PCUT_ASSERT_INT_EQUALS(100 * 1000, conn->srtt);
+	PCUT_ASSERT_INT_EQUALS(37500, conn->rttvar);
+	PCUT_ASSERT_INT_EQUALS(250 * 1000, conn->rto);
+
+	/* RTO never drops below minimum */
+	tcp_rtt_init(conn);
+	tcp_rtt_sample(conn, 1000);
+	PCUT_ASSERT_INT_EQUALS(200 * 1000, conn->rto);
+
+	tcp_conn_delete(conn);
+}
+
+/** Test exponential backoff */
+PCUT_TEST(backoff)
+{
+	tcp_conn_t *conn;
+	inet_ep2_t epp;
+	int i;
+
+	inet_ep2_init(&epp);
+	conn = tcp_conn_new(&epp);
+	PCUT_ASSERT_NOT_NULL(conn);
+
+	conn->rtt_timing = true;
+	tcp_rtt_backoff(conn);
+	PCUT_ASSERT_INT_EQUALS(2 * 1000 * 1000, conn->rto);
+	PCUT_ASSERT_FALSE(conn->rtt_timing);
+
+	/* RTO is bounded by 60 seconds */
+	for (i = 0; i < 10; i++)
+		tcp_rtt_backoff(conn);
+	PCUT_ASSERT_INT_EQUALS(60 * 1000 * 1000, conn->rto);
+
+	tcp_conn_delete(conn);
+}
+
+PCUT_EXPORT(rtt);
@@ -43,17 +43,18 @@
 #include <mem.h>
 #include <stdlib.h>
 
+#include "cc.h"
 #include "conn.h"
 #include "inet.h"
+#include "iqueue.h"
 #include "ncsim.h"
 #include "rqueue.h"
+#include "rtt.h"
 #include "segment.h"
 #include "seq_no.h"
 #include "tqueue.h"
 #include "tcp_type.h"
 
-#define RETRANSMIT_TIMEOUT	(2*1000*1000)
-
 static void retransmit_timeout_func(void *);
 static void tcp_tqueue_timer_set(tcp_conn_t *);
 static void tcp_tqueue_timer_clear(tcp_conn_t *);
@@ -118,6 +119,7 @@ static void tcp_tqueue_seg(tcp_conn_t *conn, tcp_segment_t *seg)
 {
 	tcp_segment_t *rt_seg;
 	tcp_tqueue_entry_t *tqe;
+	bool start_timer;
 
 	assert(fibril_mutex_is_locked(&conn->lock));
 
@@ -129,6 +131,8 @@ static void tcp_tqueue_seg(tcp_conn_t *conn, tcp_segment_t *seg)
 	 */
 
 	if (seg->len > 0) {
+		start_timer = list_empty(&conn->retransmit.list);
+
 		rt_seg = tcp_segment_dup(seg);
 		if (rt_seg == NULL) {
 			log_msg(LOG_DEFAULT, LVL_ERROR, "Memory allocation failed.");
@@ -148,14 +152,174 @@ static void tcp_tqueue_seg(tcp_conn_t *conn, tcp_segment_t *seg)
 		rt_seg->seq = conn->snd_nxt;
 
 		list_append(&tqe->link, &conn->retransmit.list);
+		tcp_rtt_seg_sent(conn, rt_seg);
 
-		/* Set retransmission timer */
-		tcp_tqueue_timer_set(conn);
+		/* Set retransmission timer unless it is already running */
+		if (start_timer)
+			tcp_tqueue_timer_set(conn);
 	}
 
 	tcp_prepare_transmit_segment(conn, seg);
 }
 
+/** Determine whether segment in retransmission queue is considered lost.
+ *
+ * Segments are declared lost by retransmission timeout. During fast
+ * recovery the first unacknowledged segment is considered lost, and,
+ * if SACK is in use, so is any segment which has not been selectively
+ * acknowledged but lies below a segment that has.
+ *
+ * @param conn Connection
+ * @param tqe  Retransmission queue entry
+ * @return @c true if segment is considered lost
+ */
+static bool tcp_tqueue_entry_lost(tcp_conn_t *conn, tcp_tqueue_entry_t *tqe)
+{
+	if (tqe->sacked)
+		return false;
+
+	if (tqe->lost)
+		return true;
+
+	if (!conn->in_recovery)
+		return false;
+
+	if (&tqe->link == list_first(&conn->retransmit.list))
+		return true;
+
+	return conn->sack_ok && seq_no_segment_below_sack(conn, tqe->seg);
+}
+
+/** Estimate amount of data in the network.
+ *
+ * This is the 'pipe' of RFC 6675. Segments that have been selectively
+ * acknowledged or that are considered lost (and have not been retransmitted
+ * yet) have left the network.
+ *
+ * @param conn Connection
+ * @return Number of sequence numbers believed to be in the network
+ */
+static uint32_t tcp_tqueue_pipe(tcp_conn_t *conn)
+{
+	uint32_t pipe = 0;
+
+	list_foreach(conn->retransmit.list, link, tcp_tqueue_entry_t, tqe) {
+		if (tqe->sacked)
+			continue;
+		if (!tqe->rexmit && tcp_tqueue_entry_lost(conn, tqe))
+			continue;
+		pipe += tqe->seg->len;
+	}
+
+	return pipe;
+}
+
+/** Retransmit segment from retransmission queue.
+ *
+ * @param conn Connection
+ * @param tqe  Retransmission queue entry
+ * @return EOK on success, ENOMEM if out of memory
+ */
+static errno_t tcp_tqueue_rexmit(tcp_conn_t *conn, tcp_tqueue_entry_t *tqe)
+{
+	tcp_segment_t *rt_seg;
+
+	rt_seg = tcp_segment_dup(tqe->seg);
+	if (rt_seg == NULL) {
+		log_msg(LOG_DEFAULT, LVL_ERROR, "Memory allocation failed.");
+		return ENOMEM;
+	}
+
+	log_msg(LOG_DEFAULT, LVL_DEBUG, "%s: retransmitting segment SEG.SEQ=%"
+	    PRIu32, conn->name, rt_seg->seq);
+
+	tqe->rexmit = true;
+
+	/* Never time retransmitted segments (Karn's algorithm) */
+	conn->rtt_timing = false;
+
+	tcp_conn_transmit_segment(conn, rt_seg);
+	tcp_segment_delete(rt_seg);
+	return EOK;
+}
+
+/** Retransmit segments that are considered lost.
+ *
+ * The first unacknowledged segment is retransmitted immediately when it is
+ * lost during fast recovery (fast retransmit, NewReno partial
+ * acknowledgement). Other segments are only retransmitted as far as
+ * the congestion window permits.
+ *
+ * @param conn Connection
+ * @param pipe Place holding amount of data in the network, updated
+ */
+static void tcp_tqueue_rexmit_lost(tcp_conn_t *conn, uint32_t *pipe)
+{
+	bool first = true;
+
+	list_foreach(conn->retransmit.list, link, tcp_tqueue_entry_t, tqe) {
+		if (!tqe->rexmit && tcp_tqueue_entry_lost(conn, tqe)) {
+			if (*pipe >= conn->cwnd &&
+			    !(first && conn->in_recovery))
+				break;
+
+			if (tcp_tqueue_rexmit(conn, tqe) != EOK)
+				break;
+
+			*pipe += tqe->seg->len;
+		}
+
+		first = false;
+	}
+}
+
+/** Fast recovery has been entered.
+ *
+ * Segments retransmitted earlier may have been lost again and become
+ * eligible for retransmission.
+ *
+ * @param conn Connection
+ */
+void tcp_tqueue_enter_recovery(tcp_conn_t *conn)
+{
+	list_foreach(conn->retransmit.list, link, tcp_tqueue_entry_t, tqe)
+		tqe->rexmit = false;
+}
+
+/** Process SACK blocks received from peer.
+ *
+ * Mark segments in the retransmission queue which have been selectively
+ * acknowledged.
+ *
+ * @param conn Connection
+ * @param seg  Received segment
+ */
+void tcp_tqueue_sack_received(tcp_conn_t *conn, tcp_segment_t *seg)
+{
+	tcp_sack_blk_t *blk;
+	size_t i;
+
+	if (!conn->sack_ok || (seg->opts.flags & TOPT_SACK) == 0)
+		return;
+
+	for (i = 0; i < seg->opts.sack_cnt; i++) {
+		blk = &seg->opts.sack[i];
+		if (!seq_no_sack_acceptable(conn, blk))
+			continue;
+
+		list_foreach(conn->retransmit.list, link, tcp_tqueue_entry_t,
+		    tqe) {
+			if (!tqe->sacked &&
+			    seq_no_segment_sacked(conn, tqe->seg, blk))
+				tqe->sacked = true;
+		}
+
+		if (!seq_no_sack_high_valid(conn) ||
+		    seq_no_sack_extends(conn, blk->right))
+			conn->snd_sack_high = blk->right;
+	}
+}
+
 static void tcp_prepare_transmit_segment(tcp_conn_t *conn, tcp_segment_t *seg)
 {
 	/*
@@ -173,14 +337,19 @@ static void tcp_prepare_transmit_segment(tcp_conn_t *conn, tcp_segment_t *seg)
 }
 
 /** Transmit data from the send buffer.
+ *
+ * Retransmit any segments considered lost, then send as much new data
+ * as both the send window and the congestion window allow, in segments
+ * no larger than the send maximum segment size.
  *
  * @param conn	Connection
  */
 void tcp_tqueue_new_data(tcp_conn_t *conn)
 {
-	size_t avail_wnd;
-	size_t xfer_seqlen;
-	size_t snd_buf_seqlen;
+	uint32_t pipe;
+	uint32_t flight;
+	uint32_t avail_wnd;
+	size_t data_off;
 	size_t data_size;
 	tcp_control_t ctrl;
 	bool send_fin;
@@ -189,52 +358,77 @@ void tcp_tqueue_new_data(tcp_conn_t *conn)
 
 	log_msg(LOG_DEFAULT, LVL_DEBUG, "%s: tcp_tqueue_new_data()", conn->name);
 
-	/* Number of free sequence numbers in send window */
-	avail_wnd = (conn->snd_una + conn->snd_wnd) - conn->snd_nxt;
-	snd_buf_seqlen = conn->snd_buf_used + (conn->snd_buf_fin ? 1 : 0);
+	pipe = tcp_tqueue_pipe(conn);
+	tcp_tqueue_rexmit_lost(conn, &pipe);
 
-	xfer_seqlen = min(snd_buf_seqlen, avail_wnd);
-	log_msg(LOG_DEFAULT, LVL_DEBUG, "%s: snd_buf_seqlen = %zu, SND.WND = %" PRIu32 ", "
-	    "xfer_seqlen = %zu", conn->name, snd_buf_seqlen, conn->snd_wnd,
-	    xfer_seqlen);
+	data_off = 0;
 
-	if (xfer_seqlen == 0)
-		return;
+	while (true) {
+		/* Number of free sequence numbers in send window */
+		flight = conn->snd_nxt - conn->snd_una;
+		avail_wnd = flight < conn->snd_wnd ? conn->snd_wnd - flight : 0;
 
-	/* XXX Do not always send immediately */
+		/* Limit by congestion window */
+		avail_wnd = min(avail_wnd, pipe < conn->cwnd ?
+		    conn->cwnd - pipe : 0);
 
-	send_fin = conn->snd_buf_fin && xfer_seqlen == snd_buf_seqlen;
-	data_size = xfer_seqlen - (send_fin ? 1 : 0);
+		data_size = min(conn->snd_buf_used - data_off, avail_wnd);
+		data_size = min(data_size, conn->snd_mss);
 
-	if (send_fin) {
-		log_msg(LOG_DEFAULT, LVL_DEBUG, "%s: Sending out FIN.", conn->name);
-		/* We are sending out FIN */
-		ctrl = CTL_FIN;
-	} else {
-		ctrl = 0;
+		send_fin = conn->snd_buf_fin &&
+		    data_off + data_size == conn->snd_buf_used &&
+		    data_size < avail_wnd;
+
+		log_msg(LOG_DEFAULT, LVL_DEBUG, "%s: snd_buf_used = %zu, "
+		    "SND.WND = %" PRIu32 ", cwnd = %" PRIu32 ", pipe = %"
+		    PRIu32 ", data_size = %zu", conn->name,
+		    conn->snd_buf_used - data_off, conn->snd_wnd, conn->cwnd,
+		    pipe, data_size);
+
+		if (data_size == 0 && !send_fin)
+			break;
+
+		/* XXX Do not always send immediately */
+
+		if (send_fin) {
+			log_msg(LOG_DEFAULT, LVL_DEBUG, "%s: Sending out FIN.", conn->name);
+			/* We are sending out FIN */
+			ctrl = CTL_FIN;
+		} else {
+			ctrl = 0;
+		}
+
+		seg = tcp_segment_make_data(ctrl, conn->snd_buf + data_off,
+		    data_size);
+		if (seg == NULL) {
+			log_msg(LOG_DEFAULT, LVL_ERROR, "Memory allocation failure.");
+			break;
+		}
+
+		data_off += data_size;
+
+		if (send_fin) {
+			conn->snd_buf_fin = false;
+			tcp_conn_fin_sent(conn);
+		}
+
+		pipe += seg->len;
+		tcp_tqueue_seg(conn, seg);
+		tcp_segment_delete(seg);
+
+		if (send_fin)
+			break;
 	}
 
-	seg = tcp_segment_make_data(ctrl, conn->snd_buf, data_size);
-	if (seg == NULL) {
-		log_msg(LOG_DEFAULT, LVL_ERROR, "Memory allocation failure.");
+	if (data_off == 0)
 		return;
-	}
 
 	/* Remove data from send buffer */
-	memmove(conn->snd_buf, conn->snd_buf + data_size,
-	    conn->snd_buf_used - data_size);
-	conn->snd_buf_used -= data_size;
-
-	if (send_fin)
-		conn->snd_buf_fin = false;
+	memmove(conn->snd_buf, conn->snd_buf + data_off,
+	    conn->snd_buf_used - data_off);
+	conn->snd_buf_used -= data_off;
 
 	fibril_condvar_broadcast(&conn->snd_buf_cv);
-
-	if (send_fin)
-		tcp_conn_fin_sent(conn);
-
-	tcp_tqueue_seg(conn, seg);
-	tcp_segment_delete(seg);
 }
 
 /** Remove ACKed segments from retransmission queue and possibly transmit
@@ -284,22 +478,86 @@ void tcp_tqueue_ack_received(tcp_conn_t *conn)
 	if (list_empty(&conn->retransmit.list))
 		tcp_tqueue_timer_clear(conn);
 
+	/* Forget SACK information that has been overtaken by SND.UNA */
+	if (!seq_no_sack_high_valid(conn))
+		conn->snd_sack_high = conn->snd_una;
+
 	/* Possibly transmit more data */
 	tcp_tqueue_new_data(conn);
 }
 
+/** Fill in options of outgoing segment.
+ *
+ * A SYN segment carries all options we offer (or have accepted from
+ * the peer's SYN). Timestamps are sent in every segment once negotiated.
+ * SACK blocks are only sent in segments without text so that they cannot
+ * push the segment over the maximum segment size.
+ *
+ * @param conn Connection
+ * @param seg  Outgoing segment
+ */
+static void tcp_tqueue_set_opts(tcp_conn_t *conn, tcp_segment_t *seg)
+{
+	tcp_seg_opts_t *opts = &seg->opts;
+	size_t max_blocks;
+
+	opts->flags = 0;
+
+	if ((seg->ctrl & CTL_SYN) != 0) {
+		opts->flags |= TOPT_MSS;
+		opts->mss = tcp_conn_rcv_mss(conn);
+
+		if (conn->ws_ok) {
+			opts->flags |= TOPT_WSCALE;
+			opts->wscale = conn->rcv_wscale;
+		}
+
+		if (conn->sack_ok)
+			opts->flags |= TOPT_SACK_PERM;
+	}
+
+	if (conn->ts_ok) {
+		opts->flags |= TOPT_TS;
+		opts->tsval = tcp_rtt_ts_now();
+		opts->tsecr = (seg->ctrl & CTL_ACK) != 0 ? conn->ts_recent : 0;
+	}
+
+	if (conn->sack_ok && (seg->ctrl & (CTL_SYN | CTL_ACK)) == CTL_ACK &&
+	    tcp_segment_text_size(seg) == 0) {
+		max_blocks = conn->ts_ok ? TCP_SACK_BLOCKS_MAX - 1 :
+		    TCP_SACK_BLOCKS_MAX;
+		opts->sack_cnt = tcp_iqueue_sack_blocks(&conn->incoming,
+		    opts->sack, max_blocks);
+		if (opts->sack_cnt > 0)
+			opts->flags |= TOPT_SACK;
+	}
+}
+
 static void tcp_conn_transmit_segment(tcp_conn_t *conn, tcp_segment_t *seg)
 {
+	uint8_t wscale;
+
 	log_msg(LOG_DEFAULT, LVL_DEBUG, "%s: tcp_conn_transmit_segment(%p, %p)",
 	    conn->name, conn, seg);
 
-	seg->wnd = conn->rcv_wnd;
+	/* Window field in SYN segments is never scaled */
+	if ((seg->ctrl & CTL_SYN) == 0 && conn->ws_ok)
+		wscale = conn->rcv_wscale;
+	else
+		wscale = 0;
+
+	seg->wnd = min(conn->rcv_wnd >> wscale, UINT16_MAX);
+	conn->rcv_adv = conn->rcv_nxt + (seg->wnd << wscale);
 
-	if ((seg->ctrl & CTL_ACK) != 0)
+	if ((seg->ctrl & CTL_ACK) != 0) {
 		seg->ack = conn->rcv_nxt;
-	else
+		conn->rcv_ack_sent = conn->rcv_nxt;
+		conn->rcv_ack_pending = false;
+	} else {
 		seg->ack = 0;
+	}
 
+	tcp_tqueue_set_opts(conn, seg);
 	tcp_tqueue_send_immed(conn, seg);
 }
 
@@ -321,7 +579,6 @@ static void retransmit_timeout_func(void *arg)
 {
 	tcp_conn_t *conn = (tcp_conn_t *) arg;
 	tcp_tqueue_entry_t *tqe;
-	tcp_segment_t *rt_seg;
 	link_t *link;
 
 	log_msg(LOG_DEFAULT, LVL_DEBUG, "### %s: retransmit_timeout_func(%p)", conn->name, conn);
@@ -343,22 +600,27 @@ static void retransmit_timeout_func(void *arg)
 		return;
 	}
 
-	tqe = list_get_instance(link, tcp_tqueue_entry_t, link);
+	/*
+	 * Collapse the congestion window and back off the timer. Everything
+	 * that has not been selectively acknowledged is considered lost
+	 * and will be retransmitted as the congestion window opens again.
+	 */
+	tcp_cc_timeout(conn);
+	tcp_rtt_backoff(conn);
 
-	rt_seg = tcp_segment_dup(tqe->seg);
-	if (rt_seg == NULL) {
-		log_msg(LOG_DEFAULT, LVL_ERROR, "Memory allocation failed.");
-		tcp_conn_unlock(conn);
-		tcp_conn_delref(conn);
-		/* XXX Handle properly */
-		return;
+	list_foreach(conn->retransmit.list, link, tcp_tqueue_entry_t, e) {
+		e->lost = !e->sacked;
+		e->rexmit = false;
 	}
 
+	tqe = list_get_instance(link, tcp_tqueue_entry_t, link);
+
 	log_msg(LOG_DEFAULT, LVL_DEBUG, "### %s: retransmitting segment", conn->name);
-	tcp_conn_transmit_segment(tqe->conn, rt_seg);
+	/* XXX Handle memory allocation failure properly */
+	(void) tcp_tqueue_rexmit(conn, tqe);
 
 	/* Reset retransmission timer */
-	fibril_timer_set_locked(conn->retransmit.timer, RETRANSMIT_TIMEOUT,
+	fibril_timer_set_locked(conn->retransmit.timer, conn->rto,
 	    retransmit_timeout_func, (void *) conn);
 
 	tcp_conn_unlock(conn);
@@ -377,7 +639,7 @@ static void tcp_tqueue_timer_set(tcp_conn_t *conn)
 	tcp_tqueue_timer_clear(conn);
 
 	tcp_conn_addref(conn);
-	fibril_timer_set_locked(conn->retransmit.timer, RETRANSMIT_TIMEOUT,
+	fibril_timer_set_locked(conn->retransmit.timer, conn->rto,
 	    retransmit_timeout_func, (void *) conn);
 
 	log_msg(LOG_DEFAULT, LVL_DEBUG, "### %s: tcp_tqueue_timer_set() end", conn->name);
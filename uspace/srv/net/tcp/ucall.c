@@ -229,8 +229,14 @@ tcp_error_t tcp_uc_receive(tcp_conn_t *conn, void *buf, size_t size,
 	/* TODO */
 	*xflags = 0;
 
-	/* Send new size of receive window */
-	tcp_tqueue_ctrl_seg(conn, CTL_ACK);
+	/*
+	 * Send new size of receive window, but only once it has opened
+	 * substantially so as not to advertise tiny windows (receiver side
+	 * silly window syndrome avoidance, RFC 1122 4.2.3.3).
+	 */
+	if (conn->rcv_nxt + conn->rcv_wnd - conn->rcv_adv >=
+	    min(conn->rcv_buf_size / 2, tcp_conn_rcv_mss(conn)))
+		tcp_tqueue_ctrl_seg(conn, CTL_ACK);
 
 	log_msg(LOG_DEFAULT, LVL_DEBUG, "%s: tcp_uc_receive() - returning %zu bytes",
 	    conn->name, xfer_size);
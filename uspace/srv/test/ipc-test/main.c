@@ -39,6 +39,7 @@
 
 #include <as.h>
 #include <async.h>
+#include <async_ring.h>
 #include <errno.h>
 #include <str_error.h>
 #include <io/log.h>
@@ -55,7 +56,7 @@
 static service_id_t svc_id;
 
 enum {
-	max_rw_buf_size = 16384,
+	max_rw_buf_size = DATA_XFER_LIMIT,
 };
 
 /** Object in read-only memory area that will be shared.
@@ -293,16 +294,75 @@ static void ipc_test_write_srv(ipc_call_t *icall)
 	async_answer_0(icall, EOK);
 }
 
+static void ipc_test_ring_srv(ipc_call_t *icall, async_ring_t **ring)
+{
+	async_ring_t *nring;
+	errno_t rc;
+
+	log_msg(LOG_DEFAULT, LVL_DEBUG, "ipc_test_ring_srv");
+
+	if (*ring != NULL) {
+		async_answer_0(icall, EBUSY);
+		return;
+	}
+
+	rc = async_ring_accept(icall, &nring);
+	if (rc != EOK) {
+		log_msg(LOG_DEFAULT, LVL_ERROR, "Failed accepting ring: %s.",
+		    str_error(rc));
+		return;
+	}
+
+	*ring = nring;
+}
+
+static void ipc_test_ring_msg_srv(async_ring_t *ring, async_ring_msg_t *msg)
+{
+	async_ring_msg_t *answer;
+
+	answer = async_ring_answer_msg(ring);
+	answer->size = 0;
+
+	switch (msg->method) {
+	case IPC_TEST_PING:
+		async_ring_answer(ring, EOK);
+		break;
+	default:
+		async_ring_answer(ring, ENOTSUP);
+		break;
+	}
+}
+
 static void ipc_test_connection(ipc_call_t *icall, void *arg)
 {
+	async_ring_t *ring = NULL;
+	async_ring_msg_t *msg;
+	errno_t rc;
+
 	/* Accept connection */
 	async_accept_0(icall);
 
 	while (true) {
 		ipc_call_t call;
-		async_get_call(&call);
+
+		if (ring != NULL) {
+			rc = async_ring_receive(ring, &msg, &call);
+			if (rc == EOK) {
+				ipc_test_ring_msg_srv(ring, msg);
+				continue;
+			}
+
+			if (rc != ENOENT) {
+				async_ring_destroy(ring);
+				ring = NULL;
+				continue;
+			}
+		} else {
+			async_get_call(&call);
+		}
 
 		if (!ipc_get_imethod(&call)) {
+			async_ring_destroy(ring);
 			async_answer_0(&call, EOK);
 			break;
 		}
@@ -332,6 +392,9 @@ static void ipc_test_connection(ipc_call_t *icall, void *arg)
 		case IPC_TEST_WRITE:
 			ipc_test_write_srv(&call);
 			break;
+		case IPC_TEST_RING:
+			ipc_test_ring_srv(&call, &ring);
+			break;
 		default:
 			async_answer_0(&call, ENOTSUP);
 			break;
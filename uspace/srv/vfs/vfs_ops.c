@@ -79,6 +79,9 @@ static size_t shared_path(char *a, char *b)
 /* This call destroys the file if and only if there are no hard links left. */
 static void out_destroy(vfs_triplet_t *file)
 {
+	/* The index may be reused for a new file. */
+	vfs_page_cache_invalidate(file, 0, (aoff64_t) -1);
+
 	async_exch_t *exch = vfs_exchange_grab(file->fs_handle);
 	async_msg_2(exch, VFS_OUT_DESTROY, (sysarg_t) file->service_id,
 	    (sysarg_t) file->index);
@@ -480,6 +483,17 @@ static errno_t vfs_rdwr(int fd, aoff64_t pos, bool read, rdwr_ipc_cb_t ipc_cb,
 
 	vfs_exchange_release(fs_exch);
 
+	if (!read && rc == EOK) {
+		vfs_triplet_t triplet = {
+			.fs_handle = file->node->fs_handle,
+			.service_id = file->node->service_id,
+			.index = file->node->index
+		};
+
+		vfs_page_cache_invalidate(&triplet, pos,
+		    pos + ipc_get_arg1(&answer));
+	}
+
 	if (file->node->type == VFS_NODE_DIRECTORY)
 		fibril_rwlock_read_unlock(&namespace_rwlock);
 
@@ -626,8 +640,16 @@ errno_t vfs_op_resize(int fd, int64_t size)
 
 	errno_t rc = vfs_truncate_internal(file->node->fs_handle,
 	    file->node->service_id, file->node->index, size);
-	if (rc == EOK)
+	if (rc == EOK) {
+		vfs_triplet_t triplet = {
+			.fs_handle = file->node->fs_handle,
+			.service_id = file->node->service_id,
+			.index = file->node->index
+		};
+
+		vfs_page_cache_invalidate(&triplet, size, (aoff64_t) -1);
 		file->node->size = size;
+	}
 
 	fibril_rwlock_write_unlock(&file->node->contents_rwlock);
 	vfs_file_put(file);
@@ -822,6 +844,8 @@ errno_t vfs_op_unmount(int mpfd)
 		return rc;
 	}
 
+	vfs_page_cache_purge(mp->node->mount->fs_handle,
+	    mp->node->mount->service_id);
 	vfs_node_forget(mp->node->mount);
 	vfs_node_put(mp->node);
 	mp->node->mount = NULL;
@@ -36,24 +36,380 @@
  */
 
 #include "vfs.h"
+#include <adt/hash.h>
+#include <adt/hash_table.h>
+#include <adt/list.h>
+#include <align.h>
+#include <assert.h>
 #include <async.h>
 #include <fibril_synch.h>
 #include <errno.h>
 #include <as.h>
+#include <stats.h>
+#include <stdlib.h>
+
+/*
+ * Pages read on behalf of the user pager are kept in a page cache shared by
+ * all clients. The same physical frame is handed out to every client which
+ * maps the same page of the same file read-only. Writable areas never map the
+ * cached frame itself, because the kernel gives them a private copy of the
+ * page when it is paged in.
+ *
+ * The cache holds one reference to the frame by keeping the page mapped in
+ * the VFS address space, each client mapping holds another one (taken by the
+ * kernel when the page-in request is answered). Evicting a page from the cache
+ * therefore never affects existing mappings.
+ */
+
+/** Maximal number of pages kept in the page cache */
+#define PAGE_CACHE_MAX_PAGES  1024
+
+/** Number of insertions between checks of free physical memory */
+#define PAGE_CACHE_PRESSURE_INTERVAL  64
+
+/**
+ * Reclaim half of the page cache when less than 1/PAGE_CACHE_PRESSURE_RATIO
+ * of the physical memory is free.
+ */
+#define PAGE_CACHE_PRESSURE_RATIO  16
+
+typedef struct {
+	vfs_triplet_t triplet;
+	aoff64_t offset;
+} page_key_t;
+
+typedef struct {
+	/** Link to page_cache */
+	ht_link_t link;
+	/** Link to page_lru */
+	link_t lru_link;
+	page_key_t key;
+	/** Page in the VFS address space or NULL while the page is being read */
+	void *page;
+	/** Number of page-in requests currently answered with this page */
+	unsigned refcnt;
+	/** True while the page is in page_cache and page_lru */
+	bool cached;
+} vfs_page_t;
+
+/** Mutex protecting the page cache. */
+static FIBRIL_MUTEX_INITIALIZE(page_cache_lock);
+
+/** Cached pages, keyed by node triplet and offset. */
+static hash_table_t page_cache;
+
+/** Cached pages, least recently used first. */
+static LIST_INITIALIZE(page_lru);
+
+/** Number of cached pages. */
+static size_t page_count = 0;
+
+/** Number of insertions since the last check of free memory. */
+static unsigned page_inserts = 0;
+
+static size_t page_key_hash(const void *key)
+{
+	const page_key_t *pk = key;
+	size_t hash = hash_combine(pk->triplet.fs_handle, pk->triplet.index);
+	hash = hash_combine(hash, pk->triplet.service_id);
+	return hash_combine(hash, pk->offset / PAGE_SIZE);
+}
+
+static size_t page_hash(const ht_link_t *item)
+{
+	vfs_page_t *p = hash_table_get_inst(item, vfs_page_t, link);
+	return page_key_hash(&p->key);
+}
+
+static bool page_key_equal(const void *key, size_t hash, const ht_link_t *item)
+{
+	const page_key_t *pk = key;
+	vfs_page_t *p = hash_table_get_inst(item, vfs_page_t, link);
+	return p->key.triplet.fs_handle == pk->triplet.fs_handle &&
+	    p->key.triplet.service_id == pk->triplet.service_id &&
+	    p->key.triplet.index == pk->triplet.index &&
+	    p->key.offset == pk->offset;
+}
+
+static const hash_table_ops_t page_cache_ops = {
+	.hash = page_hash,
+	.key_hash = page_key_hash,
+	.key_equal = page_key_equal,
+	.equal = NULL,
+	.remove_callback = NULL
+};
+
+/** Initialize the VFS page cache.
+ *
+ * @return		Return true on success, false on failure.
+ */
+bool vfs_page_cache_init(void)
+{
+	return hash_table_create(&page_cache, 0, 0, &page_cache_ops);
+}
+
+static void page_destroy(vfs_page_t *p)
+{
+	if (p->page != NULL)
+		as_area_destroy(p->page);
+	free(p);
+}
+
+/** Remove a page from the cache.
+ *
+ * The page is destroyed once the last page-in request using it is answered.
+ * Should be called with page_cache_lock held.
+ */
+static void page_evict(vfs_page_t *p)
+{
+	assert(p->cached);
+
+	hash_table_remove_item(&page_cache, &p->link);
+	list_remove(&p->lru_link);
+	p->cached = false;
+	page_count--;
+
+	if (p->refcnt == 0)
+		page_destroy(p);
+}
+
+/** Evict least recently used pages until at most @a target pages remain.
+ *
+ * Should be called with page_cache_lock held.
+ */
+static void page_reclaim(size_t target)
+{
+	list_foreach_safe(page_lru, cur, next) {
+		if (page_count <= target)
+			break;
+
+		vfs_page_t *p = list_get_instance(cur, vfs_page_t, lru_link);
+		if (p->refcnt == 0)
+			page_evict(p);
+	}
+}
+
+/** Shrink the cache if the system is running low on physical memory.
+ *
+ * Should be called with page_cache_lock held.
+ */
+static void page_check_pressure(void)
+{
+	if (++page_inserts < PAGE_CACHE_PRESSURE_INTERVAL)
+		return;
+	page_inserts = 0;
+
+	stats_physmem_t *mem = stats_get_physmem();
+	if (mem == NULL)
+		return;
+
+	if (mem->free < mem->total / PAGE_CACHE_PRESSURE_RATIO)
+		page_reclaim(page_count / 2);
+
+	free(mem);
+}
+
+/** Look up a cached page and take a reference to it.
+ *
+ * Should be called with page_cache_lock held.
+ */
+static vfs_page_t *page_find(page_key_t *key)
+{
+	ht_link_t *link = hash_table_find(&page_cache, key);
+	if (link == NULL)
+		return NULL;
+
+	vfs_page_t *p = hash_table_get_inst(link, vfs_page_t, link);
+	p->refcnt++;
+
+	/* Move the page to the most recently used end. */
+	list_remove(&p->lru_link);
+	list_append(&p->lru_link, &page_lru);
+
+	return p;
+}
+
+/** Look up a page in the cache or insert an entry for reading it.
+ *
+ * A new entry is inserted without the page. The caller is expected to read
+ * the page and set it unless the entry was evicted meanwhile, which happens
+ * if the page is invalidated while being read.
+ *
+ * Should be called with page_cache_lock held.
+ *
+ * @param key		Key of the page.
+ * @param[out] load	Set to true if a new entry was inserted for the
+ *			caller to fill.
+ *
+ * @return		Referenced cache entry or NULL if out of memory.
+ */
+static vfs_page_t *page_lookup(page_key_t *key, bool *load)
+{
+	vfs_page_t *p = page_find(key);
+	if (p != NULL) {
+		*load = false;
+		return p;
+	}
+
+	p = malloc(sizeof(vfs_page_t));
+	if (p == NULL)
+		return NULL;
+
+	p->key = *key;
+	p->page = NULL;
+	p->refcnt = 1;
+	p->cached = true;
+	link_initialize(&p->lru_link);
+	hash_table_insert(&page_cache, &p->link);
+	list_append(&p->lru_link, &page_lru);
+	page_count++;
+
+	if (page_count > PAGE_CACHE_MAX_PAGES)
+		page_reclaim(PAGE_CACHE_MAX_PAGES);
+	page_check_pressure();
+
+	*load = true;
+	return p;
+}
+
+/** Drop a reference taken by page_find() or page_lookup(). */
+static void page_release(vfs_page_t *p)
+{
+	fibril_mutex_lock(&page_cache_lock);
+	assert(p->refcnt > 0);
+	if (--p->refcnt == 0 && !p->cached)
+		page_destroy(p);
+	fibril_mutex_unlock(&page_cache_lock);
+}
+
+/** Invalidate cached pages of a file overlapping a byte range.
+ *
+ * Called whenever the contents of the file change, i.e. on write, truncate
+ * and destruction of the file.
+ *
+ * @param triplet	File whose pages are to be invalidated.
+ * @param start		First byte of the range.
+ * @param end		First byte past the range.
+ */
+void vfs_page_cache_invalidate(vfs_triplet_t *triplet, aoff64_t start,
+    aoff64_t end)
+{
+	fibril_mutex_lock(&page_cache_lock);
+
+	if (start >= end || page_count == 0) {
+		fibril_mutex_unlock(&page_cache_lock);
+		return;
+	}
+
+	aoff64_t first = ALIGN_DOWN(start, PAGE_SIZE);
+
+	if ((end - first) / PAGE_SIZE <= page_count) {
+		/* Short range, look up the individual pages. */
+		page_key_t key = {
+			.triplet = *triplet
+		};
+
+		for (key.offset = first; key.offset < end;
+		    key.offset += PAGE_SIZE) {
+			ht_link_t *link = hash_table_find(&page_cache, &key);
+			if (link != NULL)
+				page_evict(hash_table_get_inst(link, vfs_page_t, link));
+		}
+	} else {
+		list_foreach_safe(page_lru, cur, next) {
+			vfs_page_t *p = list_get_instance(cur, vfs_page_t,
+			    lru_link);
+
+			if (p->key.triplet.fs_handle == triplet->fs_handle &&
+			    p->key.triplet.service_id == triplet->service_id &&
+			    p->key.triplet.index == triplet->index &&
+			    p->key.offset < end &&
+			    p->key.offset + PAGE_SIZE > start)
+				page_evict(p);
+		}
+	}
+
+	fibril_mutex_unlock(&page_cache_lock);
+}
+
+/** Invalidate all cached pages of a file system instance.
+ *
+ * @param fs_handle	File system handle.
+ * @param service_id	Service ID of the file system instance.
+ */
+void vfs_page_cache_purge(fs_handle_t fs_handle, service_id_t service_id)
+{
+	fibril_mutex_lock(&page_cache_lock);
+
+	list_foreach_safe(page_lru, cur, next) {
+		vfs_page_t *p = list_get_instance(cur, vfs_page_t, lru_link);
+
+		if (p->key.triplet.fs_handle == fs_handle &&
+		    p->key.triplet.service_id == service_id)
+			page_evict(p);
+	}
+
+	fibril_mutex_unlock(&page_cache_lock);
+}
 
 void vfs_page_in(ipc_call_t *req)
 {
 	aoff64_t offset = ipc_get_arg1(req);
 	size_t page_size = ipc_get_arg2(req);
 	int fd = ipc_get_arg3(req);
+	bool cacheable = false;
+	vfs_page_t *p = NULL;
+	page_key_t key;
 	void *page;
 	errno_t rc;
 
+	vfs_file_t *file = vfs_file_get(fd);
+	if (file != NULL) {
+		key.triplet.fs_handle = file->node->fs_handle;
+		key.triplet.service_id = file->node->service_id;
+		key.triplet.index = file->node->index;
+		key.offset = offset;
+		cacheable = (file->node->type == VFS_NODE_FILE) &&
+		    (page_size == PAGE_SIZE) && (offset % PAGE_SIZE == 0);
+		vfs_file_put(file);
+	}
+
+	if (cacheable) {
+		bool load = false;
+
+		fibril_mutex_lock(&page_cache_lock);
+		p = page_lookup(&key, &load);
+		page = (p != NULL) ? p->page : NULL;
+		fibril_mutex_unlock(&page_cache_lock);
+
+		if (page != NULL) {
+			async_answer_1(req, EOK, (sysarg_t) page);
+			page_release(p);
+			return;
+		}
+
+		if (p != NULL && !load) {
+			/*
+			 * Somebody else is reading the page right now, read
+			 * our own copy instead of waiting.
+			 */
+			page_release(p);
+			p = NULL;
+		}
+	}
+
 	page = as_area_create(AS_AREA_ANY, page_size,
 	    AS_AREA_READ | AS_AREA_WRITE | AS_AREA_CACHEABLE,
 	    AS_AREA_UNPAGED);
 
 	if (page == AS_MAP_FAILED) {
+		if (p != NULL) {
+			fibril_mutex_lock(&page_cache_lock);
+			if (p->cached)
+				page_evict(p);
+			fibril_mutex_unlock(&page_cache_lock);
+			page_release(p);
+		}
 		async_answer_0(req, ENOMEM);
 		return;
 	}
@@ -77,14 +433,35 @@ void vfs_page_in(ipc_call_t *req)
 		chunk.size = page_size - total;
 	} while (total < page_size);
 
-	async_answer_1(req, rc, (sysarg_t) page);
+	if (p != NULL) {
+		fibril_mutex_lock(&page_cache_lock);
+
+		if (rc == EOK && p->cached) {
+			p->page = page;
+			fibril_mutex_unlock(&page_cache_lock);
+
+			async_answer_1(req, EOK, (sysarg_t) page);
+			page_release(p);
+			return;
+		}
+
+		/*
+		 * The page could not be read or it has been invalidated while
+		 * being read, in which case the data may be stale for later
+		 * faults.
+		 */
+		if (p->cached)
+			page_evict(p);
+
+		fibril_mutex_unlock(&page_cache_lock);
+		page_release(p);
+	}
 
 	/*
-	 * FIXME:
-	 * This is just for now until we implement proper page cache
-	 * management.  Not keeping the pages around in a cache results in
-	 * inherently non-coherent private mappings.
+	 * The page is not cached. Hand it out and let the client mapping hold
+	 * the only reference to the frame.
 	 */
+	async_answer_1(req, rc, (sysarg_t) page);
 	as_area_destroy(page);
 }
 